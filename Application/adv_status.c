@@ -0,0 +1,84 @@
+#include "adv_status.h"
+
+#include <string.h>
+
+#include "bcomdef.h"
+#include "gap.h"
+#include "peripheral.h"
+
+/*
+ * Signer status in the advertising data.
+ *
+ * A gateway had to connect and read the Response Status to find out whether the device
+ * could take a challenge. The advertisement now carries a manufacturer specific field
+ * with the signer state, the jobs waiting, the sessions left and the id of the loaded
+ * key, so a gateway can pick an idle device with the right key, or come back later,
+ * without connecting. The field is only rewritten when one of them changed.
+ */
+
+static uint8_t advData[B_MAX_ADV_LEN];
+static uint8_t fixedLen = 0;
+static bool isInitialized = false;
+
+static adv_status_stats_t statusStats;
+
+static void encode(const adv_status_t *status, uint8_t *ad) {
+    ad[0] = ADV_STATUS_AD_LEN - 1;
+    ad[1] = GAP_ADTYPE_MANUFACTURER_SPECIFIC;
+    ad[2] = LO_UINT16(ADV_STATUS_COMPANY_ID);
+    ad[3] = HI_UINT16(ADV_STATUS_COMPANY_ID);
+    ad[4] = ADV_STATUS_VERSION;
+    ad[5] = status->state;
+    ad[6] = status->queued;
+    ad[7] = status->free_sessions;
+    ad[8] = LO_UINT16(status->key_id);
+    ad[9] = HI_UINT16(status->key_id);
+}
+
+static bool publish() {
+    if (GAPRole_SetParameter(GAPROLE_ADVERT_DATA, fixedLen + ADV_STATUS_AD_LEN, advData) != SUCCESS) {
+        statusStats.failures++;
+        return false;
+    }
+    statusStats.updates++;
+    return true;
+}
+
+bool adv_status_init(const uint8_t *data, uint8_t len, const adv_status_t *status) {
+    if ((!data) || (!status) || ((len + ADV_STATUS_AD_LEN) > B_MAX_ADV_LEN)) {
+        return false;
+    }
+
+    memcpy(advData, data, len);
+    fixedLen = len;
+    encode(status, &advData[fixedLen]);
+    isInitialized = true;
+    return publish();
+}
+
+bool adv_status_update(const adv_status_t *status) {
+    uint8_t ad[ADV_STATUS_AD_LEN];
+
+    if ((!isInitialized) || (!status)) {
+        return false;
+    }
+
+    encode(status, ad);
+    if (memcmp(ad, &advData[fixedLen], ADV_STATUS_AD_LEN) == 0) {
+        statusStats.skipped++;
+        return true;
+    }
+    memcpy(&advData[fixedLen], ad, ADV_STATUS_AD_LEN);
+    return publish();
+}
+
+void adv_status_get_stats(adv_status_stats_t *stats) {
+    if (!stats) {
+        return;
+    }
+    memcpy(stats, &statusStats, sizeof(adv_status_stats_t));
+}
+
+void adv_status_reset_stats() {
+    memset(&statusStats, 0, sizeof(adv_status_stats_t));
+}
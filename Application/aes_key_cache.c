@@ -0,0 +1,324 @@
+#include "aes_key_cache.h"
+
+#include <string.h>
+#include <stdbool.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/drivers/crypto/CryptoCC26XX.h>
+
+#include "crypto_engine.h"
+#include "trace.h"
+
+/*
+ * Cache of AES keys loaded in the crypto engine key RAM.
+ *
+ * mbedtls_aes_setkey_enc() used to release and allocate a key RAM entry on every call.
+ * The CTR_DRBG re-keys for every update, so most of these loads were for a key that was
+ * loaded a moment ago. Slots are reference counted per AES context; an unreferenced slot
+ * keeps its key until the least recently used one is needed for a new key.
+ */
+
+typedef struct aes_key_slot {
+    int32_t  keyIndex;   // Index in the key RAM, CRYPTOCC26XX_STATUS_ERROR if not allocated
+    uint32_t digest;     // Digest of the key, checked before the full compare
+    uint32_t lastUse;    // Value of useClock at the last acquire
+    uint16_t refCount;   // Number of AES contexts using this slot
+    unsigned char key[AES_KEY_CACHE_KEY_LEN]; // Needed to rule out digest collisions
+} aes_key_slot_t;
+
+static aes_key_slot_t keySlots[AES_KEY_CACHE_SLOTS];
+static bool isCacheInitialized = false;
+static uint32_t useClock = 0;
+static aes_key_cache_stats_t cacheStats;
+
+// Shared engine handle used to allocate, load and release key RAM entries
+static CryptoCC26XX_Handle keyStoreHandle = NULL;
+
+/* Implementation that should never be optimized out by the compiler */
+static void key_cache_zeroize(void *v, size_t n) {
+    volatile unsigned char *p = v; while( n-- ) *p++ = 0;
+}
+
+// FNV-1a over the key bytes. Only used to skip most of the memcmp calls.
+static uint32_t key_digest(const unsigned char *key) {
+    uint32_t hash = 2166136261u;
+    int i;
+    for (i = 0; i < AES_KEY_CACHE_KEY_LEN; i++) {
+        hash ^= key[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static bool key_cache_init() {
+    int i;
+    if (isCacheInitialized) {
+        return true;
+    }
+
+    // The cache stays attached to the engine for as long as it holds keys
+    keyStoreHandle = crypto_engine_acquire();
+    if (!keyStoreHandle) {
+        return false;
+    }
+
+    for (i = 0; i < AES_KEY_CACHE_SLOTS; i++) {
+        memset(&keySlots[i], 0, sizeof(aes_key_slot_t));
+        keySlots[i].keyIndex = CRYPTOCC26XX_STATUS_ERROR;
+    }
+    isCacheInitialized = true;
+    return true;
+}
+
+static aes_key_slot_t *find_slot_by_index(int32_t keyIndex) {
+    int i;
+    for (i = 0; i < AES_KEY_CACHE_SLOTS; i++) {
+        if (keySlots[i].keyIndex == keyIndex) {
+            return &keySlots[i];
+        }
+    }
+    return NULL;
+}
+
+static aes_key_slot_t *find_slot_by_key(const unsigned char *key, uint32_t digest) {
+    int i;
+    for (i = 0; i < AES_KEY_CACHE_SLOTS; i++) {
+        if ((keySlots[i].keyIndex != CRYPTOCC26XX_STATUS_ERROR) &&
+            (keySlots[i].digest == digest) &&
+            (memcmp(keySlots[i].key, key, AES_KEY_CACHE_KEY_LEN) == 0)) {
+            return &keySlots[i];
+        }
+    }
+    return NULL;
+}
+
+int32_t aes_key_cache_acquire(const unsigned char *key) {
+    aes_key_slot_t *slot = NULL;
+    aes_key_slot_t *freeSlot = NULL;
+    aes_key_slot_t *lruSlot = NULL;
+    int32_t keyIndex = CRYPTOCC26XX_STATUS_ERROR;
+    uint32_t digest;
+    UInt taskKey;
+    int i;
+
+    if (key == NULL) {
+        return CRYPTOCC26XX_STATUS_ERROR;
+    }
+
+    digest = key_digest(key);
+
+    // Key loads go through the engine, keep them away from running jobs
+    crypto_engine_lock();
+    taskKey = Task_disable();
+    if (!key_cache_init()) {
+        cacheStats.failures++;
+        Task_restore(taskKey);
+        crypto_engine_unlock();
+        return CRYPTOCC26XX_STATUS_ERROR;
+    }
+    useClock++;
+
+    for (i = 0; i < AES_KEY_CACHE_SLOTS; i++) {
+        aes_key_slot_t *cur = &keySlots[i];
+        if (cur->keyIndex == CRYPTOCC26XX_STATUS_ERROR) {
+            if (!freeSlot) {
+                freeSlot = cur;
+            }
+            continue;
+        }
+        if ((cur->digest == digest) && (memcmp(cur->key, key, AES_KEY_CACHE_KEY_LEN) == 0)) {
+            slot = cur;
+            break;
+        }
+        if ((cur->refCount == 0) && ((!lruSlot) || (cur->lastUse < lruSlot->lastUse))) {
+            lruSlot = cur;
+        }
+    }
+
+    if (slot) {
+        // The key is already in the key RAM
+        cacheStats.hits++;
+    }
+    else if (freeSlot) {
+        cacheStats.misses++;
+        freeSlot->keyIndex = CryptoCC26XX_allocateKey(keyStoreHandle,
+                                                      CRYPTOCC26XX_KEY_ANY,
+                                                      (const uint32_t *) key);
+        if (freeSlot->keyIndex != CRYPTOCC26XX_STATUS_ERROR) {
+            slot = freeSlot;
+        }
+    }
+    else if (lruSlot) {
+        // Reuse the key RAM entry of the least recently used key, no need to release it
+        cacheStats.misses++;
+        cacheStats.evictions++;
+        if (CryptoCC26XX_loadKey(keyStoreHandle, lruSlot->keyIndex,
+                                 (const uint32_t *) key) == CRYPTOCC26XX_STATUS_SUCCESS) {
+            slot = lruSlot;
+        }
+        else {
+            // The entry content is unknown now, give it back
+            CryptoCC26XX_releaseKey(keyStoreHandle, (int32_t *)&lruSlot->keyIndex);
+            key_cache_zeroize(lruSlot->key, AES_KEY_CACHE_KEY_LEN);
+            lruSlot->keyIndex = CRYPTOCC26XX_STATUS_ERROR;
+            lruSlot->digest = 0;
+        }
+    }
+    else {
+        cacheStats.misses++;
+    }
+
+    if (slot) {
+        if (slot->refCount == 0) {
+            memcpy(slot->key, key, AES_KEY_CACHE_KEY_LEN);
+            slot->digest = digest;
+        }
+        slot->refCount++;
+        slot->lastUse = useClock;
+        keyIndex = slot->keyIndex;
+    }
+    else {
+        cacheStats.failures++;
+    }
+    Task_restore(taskKey);
+    crypto_engine_unlock();
+
+    if (keyIndex == CRYPTOCC26XX_STATUS_ERROR) {
+        TRACE(TRACE_KEY_CACHE_FULL);
+    }
+    return keyIndex;
+}
+
+void aes_key_cache_release(int32_t keyIndex) {
+    aes_key_slot_t *slot;
+    UInt taskKey;
+
+    if (keyIndex == CRYPTOCC26XX_STATUS_ERROR) {
+        return;
+    }
+
+    taskKey = Task_disable();
+    slot = find_slot_by_index(keyIndex);
+    if (slot && (slot->refCount > 0)) {
+        slot->refCount--;
+    }
+    Task_restore(taskKey);
+}
+
+int32_t aes_key_cache_replace(int32_t keyIndex, const unsigned char *key) {
+    aes_key_slot_t *slot = NULL;
+    int32_t newKeyIndex;
+    uint32_t digest;
+    UInt taskKey;
+
+    if (key == NULL) {
+        aes_key_cache_release(keyIndex);
+        return CRYPTOCC26XX_STATUS_ERROR;
+    }
+    if (keyIndex == CRYPTOCC26XX_STATUS_ERROR) {
+        return aes_key_cache_acquire(key);
+    }
+
+    digest = key_digest(key);
+
+    crypto_engine_lock();
+    taskKey = Task_disable();
+    if (isCacheInitialized && !find_slot_by_key(key, digest)) {
+        slot = find_slot_by_index(keyIndex);
+        if (slot && (slot->refCount != 1)) {
+            // Other contexts still use the old key
+            slot = NULL;
+        }
+    }
+
+    if (slot) {
+        useClock++;
+        cacheStats.reloads++;
+        if (CryptoCC26XX_loadKey(keyStoreHandle, slot->keyIndex,
+                                 (const uint32_t *) key) == CRYPTOCC26XX_STATUS_SUCCESS) {
+            memcpy(slot->key, key, AES_KEY_CACHE_KEY_LEN);
+            slot->digest = digest;
+            slot->lastUse = useClock;
+            newKeyIndex = slot->keyIndex;
+        }
+        else {
+            // The entry content is unknown now, give it back
+            cacheStats.failures++;
+            CryptoCC26XX_releaseKey(keyStoreHandle, (int32_t *)&slot->keyIndex);
+            key_cache_zeroize(slot->key, AES_KEY_CACHE_KEY_LEN);
+            slot->keyIndex = CRYPTOCC26XX_STATUS_ERROR;
+            slot->digest = 0;
+            slot->refCount = 0;
+            newKeyIndex = CRYPTOCC26XX_STATUS_ERROR;
+        }
+    }
+    Task_restore(taskKey);
+    crypto_engine_unlock();
+
+    if (slot) {
+        return newKeyIndex;
+    }
+
+    // The new key is cached already or the old slot is shared.
+    // Acquire before releasing so that setting the same key again never evicts it.
+    newKeyIndex = aes_key_cache_acquire(key);
+    aes_key_cache_release(keyIndex);
+    return newKeyIndex;
+}
+
+void aes_key_cache_flush() {
+    UInt taskKey;
+    int i;
+
+    crypto_engine_lock();
+    taskKey = Task_disable();
+    if (isCacheInitialized) {
+        for (i = 0; i < AES_KEY_CACHE_SLOTS; i++) {
+            aes_key_slot_t *cur = &keySlots[i];
+            if ((cur->keyIndex == CRYPTOCC26XX_STATUS_ERROR) || (cur->refCount != 0)) {
+                continue;
+            }
+            CryptoCC26XX_releaseKey(keyStoreHandle, (int32_t *)&cur->keyIndex);
+            key_cache_zeroize(cur->key, AES_KEY_CACHE_KEY_LEN);
+            cur->keyIndex = CRYPTOCC26XX_STATUS_ERROR;
+            cur->digest = 0;
+        }
+    }
+    Task_restore(taskKey);
+    crypto_engine_unlock();
+}
+
+void aes_key_cache_get_stats(aes_key_cache_stats_t *stats) {
+    UInt taskKey;
+    int i;
+
+    if (!stats) {
+        return;
+    }
+
+    taskKey = Task_disable();
+    memcpy(stats, &cacheStats, sizeof(aes_key_cache_stats_t));
+    stats->in_use = 0;
+    stats->loaded = 0;
+    if (isCacheInitialized) {
+        for (i = 0; i < AES_KEY_CACHE_SLOTS; i++) {
+            if (keySlots[i].keyIndex == CRYPTOCC26XX_STATUS_ERROR) {
+                continue;
+            }
+            stats->loaded++;
+            if (keySlots[i].refCount) {
+                stats->in_use++;
+            }
+        }
+    }
+    Task_restore(taskKey);
+}
+
+void aes_key_cache_reset_stats() {
+    UInt taskKey = Task_disable();
+    cacheStats.hits = 0;
+    cacheStats.misses = 0;
+    cacheStats.evictions = 0;
+    cacheStats.failures = 0;
+    cacheStats.reloads = 0;
+    Task_restore(taskKey);
+}
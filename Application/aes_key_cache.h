@@ -0,0 +1,61 @@
+#ifndef APPLICATION_AES_KEY_CACHE_H_
+#define APPLICATION_AES_KEY_CACHE_H_
+
+#include <stdint.h>
+
+// How many entries of the crypto engine key RAM the cache may own.
+// The key store has 8 entries in total, keep a few free for other users.
+#ifndef AES_KEY_CACHE_SLOTS
+#define AES_KEY_CACHE_SLOTS 4
+#endif
+
+// Only AES-128 keys can be loaded into the key RAM
+#define AES_KEY_CACHE_KEY_LEN 16
+
+typedef struct aes_key_cache_stats {
+    uint32_t hits;       // setkey found the key already loaded
+    uint32_t misses;     // setkey had to load the key into the key RAM
+    uint32_t evictions;  // a loaded key was replaced to make room
+    uint32_t failures;   // no slot could be found or the driver failed
+    uint32_t reloads;    // a new key was loaded over the only user's previous key
+    uint8_t  in_use;     // slots currently referenced by a context
+    uint8_t  loaded;     // slots holding a key (referenced or not)
+} aes_key_cache_stats_t;
+
+/*
+ * Returns the key RAM index holding the given 128 bit key, loading it if needed.
+ * Every successful acquire must be matched with aes_key_cache_release().
+ * Returns CRYPTOCC26XX_STATUS_ERROR if all slots are referenced.
+ */
+int32_t aes_key_cache_acquire(const unsigned char *key);
+
+/*
+ * Drops a reference taken by aes_key_cache_acquire().
+ * The key stays loaded so that the next setkey with the same key is a hit.
+ */
+void aes_key_cache_release(int32_t keyIndex);
+
+/*
+ * Drops the reference on keyIndex and returns the index holding the new key.
+ * A slot only referenced by the caller is reloaded in place, so a context that
+ * re-keys often (like the CTR_DRBG) keeps a single key RAM entry.
+ * Returns CRYPTOCC26XX_STATUS_ERROR on failure, the old reference is dropped anyway.
+ */
+int32_t aes_key_cache_replace(int32_t keyIndex, const unsigned char *key);
+
+/*
+ * Releases every unreferenced slot back to the driver and wipes the cached keys.
+ */
+void aes_key_cache_flush();
+
+/*
+ * Copies the cache statistics into stats
+ */
+void aes_key_cache_get_stats(aes_key_cache_stats_t *stats);
+
+/*
+ * Clears the hit, miss, eviction, failure and reload counters
+ */
+void aes_key_cache_reset_stats();
+
+#endif /* APPLICATION_AES_KEY_CACHE_H_ */
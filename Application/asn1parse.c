@@ -235,6 +235,60 @@ int mbedtls_asn1_get_bitstring_null( unsigned char **p, const unsigned char *end
 
 
 
+/*
+ * Cursor over the elements of a constructed value. The elements are
+ * returned as pointers into the input, nothing is copied or allocated.
+ */
+int mbedtls_asn1_cursor_init( mbedtls_asn1_cursor *cur,
+                              unsigned char **p,
+                              const unsigned char *end,
+                              int tag )
+{
+    int ret;
+    size_t len;
+
+    if( ( ret = mbedtls_asn1_get_tag( p, end, &len, tag ) ) != 0 )
+        return( ret );
+
+    cur->p = *p;
+    cur->end = *p + len;
+    *p += len;
+
+    return( 0 );
+}
+
+void mbedtls_asn1_cursor_enter( mbedtls_asn1_cursor *cur,
+                                const mbedtls_asn1_buf *elem )
+{
+    cur->p = elem->p;
+    cur->end = elem->p + elem->len;
+}
+
+int mbedtls_asn1_cursor_done( const mbedtls_asn1_cursor *cur )
+{
+    return( cur->p >= cur->end );
+}
+
+int mbedtls_asn1_cursor_next( mbedtls_asn1_cursor *cur,
+                              mbedtls_asn1_buf *elem )
+{
+    int ret;
+    unsigned char *p = cur->p;
+
+    if( ( cur->end - p ) < 1 )
+        return( MBEDTLS_ERR_ASN1_OUT_OF_DATA );
+
+    elem->tag = *p++;
+
+    if( ( ret = mbedtls_asn1_get_len( &p, cur->end, &elem->len ) ) != 0 )
+        return( ret );
+
+    elem->p = p;
+    cur->p = p + elem->len;
+
+    return( 0 );
+}
+
 /*
  *  Parses and splits an ASN.1 "SEQUENCE OF <tag>"
  */
@@ -244,30 +298,26 @@ int mbedtls_asn1_get_sequence_of( unsigned char **p,
                           int tag)
 {
     int ret;
-    size_t len;
-    mbedtls_asn1_buf *buf;
+    mbedtls_asn1_cursor seq;
 
     /* Get main sequence tag */
-    if( ( ret = mbedtls_asn1_get_tag( p, end, &len,
+    if( ( ret = mbedtls_asn1_cursor_init( &seq, p, end,
             MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE ) ) != 0 )
         return( ret );
 
-    if( *p + len != end )
+    if( seq.end != end )
         return( MBEDTLS_ERR_ASN1_LENGTH_MISMATCH );
 
-    while( *p < end )
+    while( !mbedtls_asn1_cursor_done( &seq ) )
     {
-        buf = &(cur->buf);
-        buf->tag = **p;
-
-        if( ( ret = mbedtls_asn1_get_tag( p, end, &buf->len, tag ) ) != 0 )
+        if( ( ret = mbedtls_asn1_cursor_next( &seq, &cur->buf ) ) != 0 )
             return( ret );
 
-        buf->p = *p;
-        *p += buf->len;
+        if( cur->buf.tag != tag )
+            return( MBEDTLS_ERR_ASN1_UNEXPECTED_TAG );
 
         /* Allocate and assign next pointer */
-        if( *p < end )
+        if( !mbedtls_asn1_cursor_done( &seq ) )
         {
             cur->next = (mbedtls_asn1_sequence*)mbedtls_calloc( 1,
                                             sizeof( mbedtls_asn1_sequence ) );
@@ -282,9 +332,6 @@ int mbedtls_asn1_get_sequence_of( unsigned char **p,
     /* Set final sequence entry's next pointer to NULL */
     cur->next = NULL;
 
-    if( *p != end )
-        return( MBEDTLS_ERR_ASN1_LENGTH_MISMATCH );
-
     return( 0 );
 }
 
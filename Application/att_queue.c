@@ -0,0 +1,357 @@
+#include "att_queue.h"
+
+#include <string.h>
+#include <ti/sysbios/knl/Task.h>
+
+#include "conn_notice.h"
+#include "icall.h"
+#include "icall_apimsg.h"
+
+/*
+ * Queue of ATT messages waiting for an HCI buffer.
+ *
+ * The application used to hold on to one response the server could not send and
+ * retried it on the next connection events. A second one that ran out of buffers in
+ * the meantime replaced it, and a notification that found no buffer was lost. Now
+ * up to ATT_QUEUE_DEPTH responses and notifications wait, and every connection event
+ * sends as many of them as the stack has buffers for. Signatures and their status
+ * go first: the 128 byte response is read with a Read request and Read Blob
+ * requests, so those responses are the ones carrying it. A response is never dropped
+ * to make room: the client waits for it before its next request, and without it the
+ * link stalls until the ATT timeout ends it. A link has one request outstanding at
+ * most, so one slot per link is kept for its response and notifications share the
+ * other ATT_QUEUE_NOTI_SLOTS. With those full a signature notification replaces the
+ * oldest normal one, a normal one is dropped. A queued notification only ever carries
+ * the latest value of its attribute, a newer one replaces it and one sent directly
+ * drops it, so a client never gets an old status after a new one.
+ */
+
+typedef struct att_queue_entry {
+    bool isUsed;
+    uint8_t priority;
+    uint8_t method;        // ATT_HANDLE_VALUE_NOTI or the response opcode
+    uint16_t connHandle;
+    uint32_t order;        // Messages of the same priority go out first come first served
+    uint32_t retries;
+    gattMsgEvent_t *pMsg;  // The response, NULL for a notification
+    uint16_t handle;
+    uint16_t len;
+    uint8_t value[ATT_QUEUE_NOTI_LEN];
+} att_queue_entry_t;
+
+static att_queue_entry_t entries[ATT_QUEUE_DEPTH];
+static uint32_t nextOrder = 0;
+
+static att_queue_stats_t queueStats;
+
+static uint8_t count_entries(uint16_t connHandle) {
+    uint8_t count = 0;
+    uint8_t i;
+
+    for (i = 0; i < ATT_QUEUE_DEPTH; i++) {
+        if (entries[i].isUsed &&
+            ((connHandle == INVALID_CONNHANDLE) || (entries[i].connHandle == connHandle))) {
+            count++;
+        }
+    }
+    return count;
+}
+
+static uint8_t count_notifications() {
+    uint8_t count = 0;
+    uint8_t i;
+
+    for (i = 0; i < ATT_QUEUE_DEPTH; i++) {
+        if (entries[i].isUsed && (!entries[i].pMsg)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// The oldest message of the highest priority
+static att_queue_entry_t *find_next() {
+    att_queue_entry_t *next = NULL;
+    uint8_t i;
+
+    for (i = 0; i < ATT_QUEUE_DEPTH; i++) {
+        if (!entries[i].isUsed) {
+            continue;
+        }
+        if ((!next) || (entries[i].priority > next->priority) ||
+            ((entries[i].priority == next->priority) && ((int32_t) (entries[i].order - next->order) < 0))) {
+            next = &entries[i];
+        }
+    }
+    return next;
+}
+
+// The oldest normal notification, what a signature notification replaces
+static att_queue_entry_t *find_victim() {
+    att_queue_entry_t *victim = NULL;
+    uint8_t i;
+
+    for (i = 0; i < ATT_QUEUE_DEPTH; i++) {
+        if (entries[i].isUsed && (!entries[i].pMsg) && (entries[i].priority == ATT_QUEUE_NORMAL) &&
+            ((!victim) || ((int32_t) (entries[i].order - victim->order) < 0))) {
+            victim = &entries[i];
+        }
+    }
+    return victim;
+}
+
+static att_queue_entry_t *find_notification(uint16_t connHandle, uint16_t handle) {
+    uint8_t i;
+
+    for (i = 0; i < ATT_QUEUE_DEPTH; i++) {
+        if (entries[i].isUsed && (!entries[i].pMsg) &&
+            (entries[i].connHandle == connHandle) && (entries[i].handle == handle)) {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+// Frees the entry, the caller stops the link's connection event notice if it is idle
+static void discard(att_queue_entry_t *entry, bool isSent) {
+    UInt taskKey;
+
+    if (entry->pMsg) {
+        // Once sent the stack owns the payload, otherwise it is ours to free
+        if (!isSent) {
+            GATT_bm_free(&entry->pMsg->msg, entry->pMsg->method);
+        }
+        ICall_freeMsg(entry->pMsg);
+    }
+
+    taskKey = Task_disable();
+    if (entry->retries > queueStats.max_retries) {
+        queueStats.max_retries = entry->retries;
+    }
+    memset(entry, 0, sizeof(att_queue_entry_t));
+    Task_restore(taskKey);
+}
+
+static void release(att_queue_entry_t *entry, bool isSent) {
+    uint16_t connHandle = entry->connHandle;
+
+    discard(entry, isSent);
+
+    // Nothing left to retry on this link
+    if (count_entries(connHandle) == 0) {
+        conn_notice_release(connHandle, CONN_NOTICE_ATT_QUEUE);
+    }
+}
+
+static att_queue_entry_t *allocate(uint16_t connHandle, uint8_t priority, bool isResponse) {
+    att_queue_entry_t *entry = NULL;
+    bool isVictim = false;
+    uint16_t victimHandle;
+    UInt taskKey;
+    uint8_t depth;
+    uint8_t i;
+
+    // Notifications leave every link the slot for its response
+    if (isResponse || (count_notifications() < ATT_QUEUE_NOTI_SLOTS)) {
+        for (i = 0; i < ATT_QUEUE_DEPTH; i++) {
+            if (!entries[i].isUsed) {
+                entry = &entries[i];
+                break;
+            }
+        }
+    }
+    if ((!entry) && (!isResponse) && (priority > ATT_QUEUE_NORMAL)) {
+        entry = find_victim();
+        isVictim = (entry != NULL);
+    }
+    if (!entry) {
+        queueStats.dropped_full++;
+        return NULL;
+    }
+
+    // Ask for the end of the link's connection events while something waits on it,
+    // nothing is dropped for a message that could not be queued after all
+    if (!conn_notice_request(connHandle, CONN_NOTICE_ATT_QUEUE)) {
+        queueStats.failed++;
+        return NULL;
+    }
+
+    if (isVictim) {
+        victimHandle = entry->connHandle;
+        discard(entry, false);
+        queueStats.dropped_full++;
+        if ((victimHandle != connHandle) && (count_entries(victimHandle) == 0)) {
+            conn_notice_release(victimHandle, CONN_NOTICE_ATT_QUEUE);
+        }
+    }
+
+    taskKey = Task_disable();
+    entry->isUsed = true;
+    entry->connHandle = connHandle;
+    entry->priority = priority;
+    entry->order = nextOrder++;
+    entry->retries = 0;
+    queueStats.queued[priority]++;
+    depth = count_entries(INVALID_CONNHANDLE);
+    if (depth > queueStats.max_depth) {
+        queueStats.max_depth = depth;
+    }
+    Task_restore(taskKey);
+    return entry;
+}
+
+// Returns false if the stack is out of buffers
+static bool send_entry(att_queue_entry_t *entry) {
+    attHandleValueNoti_t noti;
+    uint8_t status;
+
+    if (entry->pMsg) {
+        status = GATT_SendRsp(entry->connHandle, entry->method, &(entry->pMsg->msg));
+    }
+    else {
+        noti.pValue = (uint8 *) GATT_bm_alloc(entry->connHandle, ATT_HANDLE_VALUE_NOTI, entry->len, NULL);
+        if (!noti.pValue) {
+            status = MSG_BUFFER_NOT_AVAIL;
+        }
+        else {
+            noti.handle = entry->handle;
+            noti.len = entry->len;
+            memcpy(noti.pValue, entry->value, entry->len);
+            status = GATT_Notification(entry->connHandle, &noti, FALSE);
+            if (status != SUCCESS) {
+                GATT_bm_free((gattMsg_t *) &noti, ATT_HANDLE_VALUE_NOTI);
+            }
+        }
+    }
+
+    if ((status == blePending) || (status == MSG_BUFFER_NOT_AVAIL)) {
+        entry->retries++;
+        queueStats.retries++;
+        return false;
+    }
+
+    if (status == SUCCESS) {
+        queueStats.sent++;
+    }
+    else {
+        queueStats.failed++;
+    }
+    release(entry, status == SUCCESS);
+    return true;
+}
+
+bool att_queue_response(gattMsgEvent_t *pMsg) {
+    att_queue_entry_t *entry;
+    uint8_t priority = ATT_QUEUE_NORMAL;
+
+    if (!pMsg) {
+        return false;
+    }
+
+    if ((pMsg->method == ATT_READ_RSP) || (pMsg->method == ATT_READ_BLOB_RSP)) {
+        priority = ATT_QUEUE_SIGNATURE;
+    }
+    entry = allocate(pMsg->connHandle, priority, true);
+    if (!entry) {
+        return false;
+    }
+    entry->method = pMsg->method;
+    entry->pMsg = pMsg;
+    return true;
+}
+
+bool att_queue_notification(uint16_t connHandle, uint16_t handle, const uint8_t *pValue,
+                            uint16_t len, att_queue_priority_t priority) {
+    att_queue_entry_t *entry;
+    UInt taskKey;
+
+    if ((!pValue) || (len > ATT_QUEUE_NOTI_LEN) || (priority >= ATT_QUEUE_PRIORITIES)) {
+        return false;
+    }
+
+    // Only the latest value is worth sending, it takes the place of the older one
+    entry = find_notification(connHandle, handle);
+    if (entry) {
+        taskKey = Task_disable();
+        if (priority > entry->priority) {
+            entry->priority = priority;
+        }
+        entry->len = len;
+        memcpy(entry->value, pValue, len);
+        queueStats.superseded++;
+        Task_restore(taskKey);
+        return true;
+    }
+
+    entry = allocate(connHandle, priority, false);
+    if (!entry) {
+        return false;
+    }
+    entry->method = ATT_HANDLE_VALUE_NOTI;
+    entry->handle = handle;
+    entry->len = len;
+    memcpy(entry->value, pValue, len);
+    return true;
+}
+
+void att_queue_send() {
+    att_queue_entry_t *entry;
+
+    // The buffers are shared by all links, the first send that finds none ends the round
+    while ((entry = find_next()) != NULL) {
+        if (!send_entry(entry)) {
+            break;
+        }
+    }
+
+    // The messages behind the one that did not fit waited a connection event as well
+    if (entry) {
+        uint8_t i;
+
+        for (i = 0; i < ATT_QUEUE_DEPTH; i++) {
+            if (entries[i].isUsed && (&entries[i] != entry)) {
+                entries[i].retries++;
+            }
+        }
+    }
+}
+
+void att_queue_sent(uint16_t connHandle, uint16_t handle) {
+    att_queue_entry_t *entry = find_notification(connHandle, handle);
+
+    if (entry) {
+        queueStats.superseded++;
+        release(entry, false);
+    }
+}
+
+void att_queue_flush(uint16_t connHandle) {
+    uint8_t i;
+
+    for (i = 0; i < ATT_QUEUE_DEPTH; i++) {
+        if (entries[i].isUsed &&
+            ((connHandle == INVALID_CONNHANDLE) || (entries[i].connHandle == connHandle))) {
+            queueStats.dropped_link++;
+            release(&entries[i], false);
+        }
+    }
+}
+
+void att_queue_get_stats(att_queue_stats_t *stats) {
+    UInt taskKey;
+
+    if (!stats) {
+        return;
+    }
+
+    taskKey = Task_disable();
+    memcpy(stats, &queueStats, sizeof(att_queue_stats_t));
+    stats->depth = count_entries(INVALID_CONNHANDLE);
+    Task_restore(taskKey);
+}
+
+void att_queue_reset_stats() {
+    UInt taskKey = Task_disable();
+    memset(&queueStats, 0, sizeof(att_queue_stats_t));
+    Task_restore(taskKey);
+}
@@ -0,0 +1,90 @@
+#ifndef APPLICATION_ATT_QUEUE_H_
+#define APPLICATION_ATT_QUEUE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bcomdef.h"
+#include "gatt.h"
+
+// ATT responses and notifications waiting for an HCI buffer, over all links
+#ifndef ATT_QUEUE_DEPTH
+#define ATT_QUEUE_DEPTH 8
+#endif
+
+// Links that may have a response waiting, a link has one request outstanding at most
+#ifndef ATT_QUEUE_MAX_CONNS
+#ifdef MAX_NUM_BLE_CONNS
+#define ATT_QUEUE_MAX_CONNS MAX_NUM_BLE_CONNS
+#else
+#error "Define MAX_NUM_BLE_CONNS as in the stack's build_config.opt (or ATT_QUEUE_MAX_CONNS)"
+#endif
+#endif
+
+// Notifications never take the slot kept for every link's response
+#if ATT_QUEUE_DEPTH <= ATT_QUEUE_MAX_CONNS
+#error "ATT_QUEUE_DEPTH has no room for notifications next to a response per link"
+#endif
+#define ATT_QUEUE_NOTI_SLOTS (ATT_QUEUE_DEPTH - ATT_QUEUE_MAX_CONNS)
+
+// Longest notification value that can be queued, what fits the default MTU
+#define ATT_QUEUE_NOTI_LEN (ATT_MTU_SIZE - 3)
+
+typedef enum att_queue_priority {
+    ATT_QUEUE_NORMAL = 0,
+    ATT_QUEUE_SIGNATURE,   // Carries a signature or its status, sent first
+    ATT_QUEUE_PRIORITIES
+} att_queue_priority_t;
+
+typedef struct att_queue_stats {
+    uint32_t queued[ATT_QUEUE_PRIORITIES]; // Messages that had to wait for a buffer
+    uint32_t sent;          // Queued messages the stack took on a later connection event
+    uint32_t retries;       // Sends that found no buffer again
+    uint32_t max_retries;   // Most connection events one message waited
+    uint32_t dropped_full;  // Notifications dropped because their slots were full
+    uint32_t dropped_link;  // Messages dropped because their link went down
+    uint32_t superseded;    // Queued notifications a newer value replaced
+    uint32_t failed;        // Messages the stack refused for good
+    uint8_t  depth;         // Messages waiting now
+    uint8_t  max_depth;
+} att_queue_stats_t;
+
+/*
+ * Takes over a GATT response the server could not send (status blePending). A
+ * queued response is never dropped for another message, only with its link.
+ * Returns false if the response could not be queued, the caller then still owns
+ * and frees it.
+ */
+bool att_queue_response(gattMsgEvent_t *pMsg);
+
+/*
+ * Queues a copy of a notification that could not be sent. One already waiting for
+ * the same attribute on the link gets the new value instead. With all
+ * ATT_QUEUE_NOTI_SLOTS taken, a signature notification replaces the oldest normal
+ * one and a normal one is dropped.
+ */
+bool att_queue_notification(uint16_t connHandle, uint16_t handle, const uint8_t *pValue,
+                            uint16_t len, att_queue_priority_t priority);
+
+/*
+ * Drops the queued notification of the attribute once a newer value of it was
+ * sent directly, so the old one does not follow.
+ */
+void att_queue_sent(uint16_t connHandle, uint16_t handle);
+
+/*
+ * Sends as many queued messages as the stack has buffers for, signatures first.
+ * Call it at the end of every connection event, the queue holds the link's
+ * conn_notice while something waits.
+ */
+void att_queue_send();
+
+/*
+ * Drops the messages of a link that went down, INVALID_CONNHANDLE drops all of them.
+ */
+void att_queue_flush(uint16_t connHandle);
+
+void att_queue_get_stats(att_queue_stats_t *stats);
+void att_queue_reset_stats();
+
+#endif /* APPLICATION_ATT_QUEUE_H_ */
@@ -30,9 +30,9 @@
 #include "mbedtls/base64.h"
 
 #include <stdint.h>
+#include <string.h>
 
 #if defined(MBEDTLS_SELF_TEST)
-#include <string.h>
 #if defined(MBEDTLS_PLATFORM_C)
 #include "mbedtls/platform.h"
 #else
@@ -139,92 +139,144 @@ int mbedtls_base64_encode( unsigned char *dst, size_t dlen, size_t *olen,
 }
 
 /*
- * Decode a base64-formatted buffer
+ * Line state of the streaming decoder
  */
-int mbedtls_base64_decode( unsigned char *dst, size_t dlen, size_t *olen,
-                   const unsigned char *src, size_t slen )
+#define BASE64_DEC_SPACE    0x01    /* spaces since the last character   */
+#define BASE64_DEC_CR       0x02    /* CR still waiting for its LF       */
+
+void mbedtls_base64_dec_init( mbedtls_base64_dec_context *ctx )
 {
-    size_t i, n;
-    uint32_t j, x;
-    unsigned char *p;
+    memset( ctx, 0, sizeof( mbedtls_base64_dec_context ) );
+}
 
-    /* First pass: check for validity and get output length */
-    for( i = n = j = 0; i < slen; i++ )
+/*
+ * Decode the next chunk of a base64-formatted buffer in a single pass.
+ *
+ * Each character is checked as it is read and every complete quantum is
+ * written out at once, so nothing has to be scanned twice. The output of
+ * a quantum is never longer than its input, which lets dst overlap src
+ * for in-place decoding as long as dst does not start after src.
+ */
+int mbedtls_base64_dec_update( mbedtls_base64_dec_context *ctx,
+                               unsigned char *dst, size_t dlen, size_t *olen,
+                               const unsigned char *src, size_t slen )
+{
+    int ret = 0;
+    size_t i, n, m;
+    unsigned char c, x;
+
+    for( i = n = 0; i < slen; i++ )
     {
-        /* Skip spaces before checking for EOL */
-        x = 0;
-        while( i < slen && src[i] == ' ' )
+        c = src[i];
+
+        /* A CR only ends a line together with the LF after it */
+        if( ( ctx->state & BASE64_DEC_CR ) != 0 )
         {
-            ++i;
-            ++x;
+            if( c != '\n' )
+                return( MBEDTLS_ERR_BASE64_INVALID_CHARACTER );
+
+            ctx->state = 0;
+            continue;
         }
 
-        /* Spaces at end of buffer are OK */
-        if( i == slen )
-            break;
+        if( c == '\n' )
+        {
+            ctx->state = 0;
+            continue;
+        }
 
-        if( ( slen - i ) >= 2 &&
-            src[i] == '\r' && src[i + 1] == '\n' )
+        if( c == '\r' )
+        {
+            ctx->state |= BASE64_DEC_CR;
             continue;
+        }
 
-        if( src[i] == '\n' )
+        /* Spaces are OK at the end of a line or of the buffer */
+        if( c == ' ' )
+        {
+            ctx->state |= BASE64_DEC_SPACE;
             continue;
+        }
 
         /* Space inside a line is an error */
-        if( x != 0 )
+        if( ctx->state != 0 )
             return( MBEDTLS_ERR_BASE64_INVALID_CHARACTER );
 
-        if( src[i] == '=' && ++j > 2 )
+        if( c > 127 || ( x = base64_dec_map[c] ) == 127 )
             return( MBEDTLS_ERR_BASE64_INVALID_CHARACTER );
 
-        if( src[i] > 127 || base64_dec_map[src[i]] == 127 )
+        /* Padding only ends the data, at most two characters of it */
+        if( x == 64 )
+        {
+            if( ++ctx->pad > 2 )
+                return( MBEDTLS_ERR_BASE64_INVALID_CHARACTER );
+        }
+        else if( ctx->pad != 0 )
             return( MBEDTLS_ERR_BASE64_INVALID_CHARACTER );
 
-        if( base64_dec_map[src[i]] < 64 && j != 0 )
-            return( MBEDTLS_ERR_BASE64_INVALID_CHARACTER );
+        ctx->carry = ( ctx->carry << 6 ) | ( x & 0x3F );
 
-        n++;
-    }
+        if( ++ctx->count < 4 )
+            continue;
 
-    if( n == 0 )
-    {
-        *olen = 0;
-        return( 0 );
-    }
+        /*
+         * Complete quantum. Once one did not fit nothing more is written,
+         * but the rest is still checked and counted.
+         */
+        m = 3 - ctx->pad;
 
-    /* The following expression is to calculate the following formula without
-     * risk of integer overflow in n:
-     *     n = ( ( n * 6 ) + 7 ) >> 3;
-     */
-    n = ( 6 * ( n >> 3 ) ) + ( ( 6 * ( n & 0x7 ) + 7 ) >> 3 );
-    n -= j;
+        if( dst != NULL && n <= dlen && dlen - n >= m )
+        {
+            dst[n] = (unsigned char)( ctx->carry >> 16 );
+            if( m > 1 ) dst[n + 1] = (unsigned char)( ctx->carry >> 8 );
+            if( m > 2 ) dst[n + 2] = (unsigned char)( ctx->carry      );
+        }
+        else
+            ret = MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL;
 
-    if( dst == NULL || dlen < n )
-    {
-        *olen = n;
-        return( MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL );
+        n += m;
+        ctx->carry = 0;
+        ctx->count = 0;
     }
 
-   for( j = 3, n = x = 0, p = dst; i > 0; i--, src++ )
-   {
-        if( *src == '\r' || *src == '\n' || *src == ' ' )
-            continue;
+    *olen = n;
 
-        j -= ( base64_dec_map[*src] == 64 );
-        x  = ( x << 6 ) | ( base64_dec_map[*src] & 0x3F );
+    return( ret );
+}
 
-        if( ++n == 4 )
-        {
-            n = 0;
-            if( j > 0 ) *p++ = (unsigned char)( x >> 16 );
-            if( j > 1 ) *p++ = (unsigned char)( x >>  8 );
-            if( j > 2 ) *p++ = (unsigned char)( x       );
-        }
-    }
+int mbedtls_base64_dec_finish( mbedtls_base64_dec_context *ctx )
+{
+    int ret = 0;
 
-    *olen = p - dst;
+    /* The input has to end on a quantum and not in the middle of a CRLF */
+    if( ctx->count != 0 || ( ctx->state & BASE64_DEC_CR ) != 0 )
+        ret = MBEDTLS_ERR_BASE64_INVALID_CHARACTER;
 
-    return( 0 );
+    /* The carry holds decoded data */
+    memset( ctx, 0, sizeof( mbedtls_base64_dec_context ) );
+
+    return( ret );
+}
+
+/*
+ * Decode a base64-formatted buffer
+ */
+int mbedtls_base64_decode( unsigned char *dst, size_t dlen, size_t *olen,
+                   const unsigned char *src, size_t slen )
+{
+    int ret, fin;
+    mbedtls_base64_dec_context ctx;
+
+    mbedtls_base64_dec_init( &ctx );
+
+    ret = mbedtls_base64_dec_update( &ctx, dst, dlen, olen, src, slen );
+    fin = mbedtls_base64_dec_finish( &ctx );
+
+    /* An invalid input is reported before a short buffer */
+    if( ret == MBEDTLS_ERR_BASE64_INVALID_CHARACTER || fin != 0 )
+        return( MBEDTLS_ERR_BASE64_INVALID_CHARACTER );
+
+    return( ret );
 }
 
 #if defined(MBEDTLS_SELF_TEST)
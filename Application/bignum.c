@@ -47,7 +47,7 @@
 #include "mbedtls/bn_mul.h"
 
 #include <string.h>
-#include <xdc/runtime/system.h>
+#include "trace.h"
 
 #if defined(MBEDTLS_PLATFORM_C)
 #include "mbedtls/platform.h"
@@ -1616,7 +1616,7 @@ int mbedtls_mpi_exp_mod( mbedtls_mpi *X, const mbedtls_mpi *A, const mbedtls_mpi
     mbedtls_mpi RR, T, Apos;
 
     mbedtls_mpi *W;
-    W = calloc(sizeof(mbedtls_mpi),  (2 << MBEDTLS_MPI_WINDOW_SIZE)  );
+    W = mbedtls_calloc(sizeof(mbedtls_mpi),  (2 << MBEDTLS_MPI_WINDOW_SIZE)  );
     if (!W) {
         return MBEDTLS_ERR_MPI_ALLOC_FAILED;
     }
@@ -1624,12 +1624,12 @@ int mbedtls_mpi_exp_mod( mbedtls_mpi *X, const mbedtls_mpi *A, const mbedtls_mpi
     int neg;
 
     if( mbedtls_mpi_cmp_int( N, 0 ) < 0 || ( N->p[0] & 1 ) == 0 ){
-        free(W);
+        mbedtls_free(W);
         return( MBEDTLS_ERR_MPI_BAD_INPUT_DATA );
     }
 
     if( mbedtls_mpi_cmp_int( E, 0 ) < 0 ) {
-        free(W);
+        mbedtls_free(W);
         return( MBEDTLS_ERR_MPI_BAD_INPUT_DATA );
     }
 
@@ -1816,7 +1816,7 @@ cleanup:
 
     mbedtls_mpi_free( &W[1] ); mbedtls_mpi_free( &T ); mbedtls_mpi_free( &Apos );
     if (W)
-        free(W);
+        mbedtls_free(W);
 
     if( _RR == NULL || _RR->p == NULL )
         mbedtls_mpi_free( &RR );
@@ -1889,14 +1889,14 @@ int mbedtls_mpi_fill_random( mbedtls_mpi *X, size_t size,
 {
     int ret;
     unsigned char *buf;
-    buf = calloc(1, MBEDTLS_MPI_MAX_SIZE);
+    buf = mbedtls_calloc(1, MBEDTLS_MPI_MAX_SIZE);
     if ( !buf ) {
-        System_printf("Failed to allocate buffer for random fill\n");
+        TRACE(TRACE_MPI_RANDOM_NO_MEM);
         return MBEDTLS_ERR_MPI_ALLOC_FAILED;
     }
 
     if( size > MBEDTLS_MPI_MAX_SIZE ) {
-        free(buf);
+        mbedtls_free(buf);
         return( MBEDTLS_ERR_MPI_BAD_INPUT_DATA );
     }
 
@@ -1904,7 +1904,7 @@ int mbedtls_mpi_fill_random( mbedtls_mpi *X, size_t size,
     MBEDTLS_MPI_CHK( mbedtls_mpi_read_binary( X, buf, size ) );
 
 cleanup:
-    free(buf);
+    mbedtls_free(buf);
     return( ret );
 }
 
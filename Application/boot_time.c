@@ -0,0 +1,53 @@
+#include "boot_time.h"
+
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Task.h>
+#include <inc/hw_types.h>
+#include <inc/hw_memmap.h>
+#include <inc/hw_cpu_dwt.h>
+#include <inc/hw_cpu_scs.h>
+#include "latency.h"
+#include "trace.h"
+
+/*
+ * How long it takes from power on until the signer is of use.
+ *
+ * The Clock only starts counting with BIOS_start(), so up to there the cycle counter
+ * times the boot. From there on the Clock takes over, the cycle counter stops whenever
+ * the device sleeps between advertisements. Times count from main(), the C startup
+ * before it only copies and clears RAM.
+ */
+
+static uint32_t marks[BOOT_MARK_COUNT];
+
+void boot_time_init() {
+    HWREG(CPU_SCS_BASE + CPU_SCS_O_DEMCR) |= CPU_SCS_DEMCR_TRCENA;
+    HWREG(CPU_DWT_BASE + CPU_DWT_O_CYCCNT) = 0;
+    HWREG(CPU_DWT_BASE + CPU_DWT_O_CTRL) |= CPU_DWT_CTRL_CYCCNTENA;
+}
+
+void boot_time_mark(boot_mark_t mark) {
+    uint32_t us;
+    UInt taskKey;
+
+    if (mark == BOOT_BIOS_START) {
+        us = HWREG(CPU_DWT_BASE + CPU_DWT_O_CYCCNT) / LATENCY_CPU_MHZ;
+    }
+    else {
+        us = marks[BOOT_BIOS_START] + Clock_getTicks() * Clock_tickPeriod;
+    }
+
+    taskKey = Task_disable();
+    if (marks[mark] != 0) {
+        Task_restore(taskKey);
+        return;
+    }
+    marks[mark] = us;
+    Task_restore(taskKey);
+
+    TRACE(TRACE_BOOT_MARK, mark, us);
+}
+
+uint32_t boot_time_get(boot_mark_t mark) {
+    return (mark < BOOT_MARK_COUNT) ? marks[mark] : 0;
+}
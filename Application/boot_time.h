@@ -0,0 +1,29 @@
+#ifndef APPLICATION_BOOT_TIME_H_
+#define APPLICATION_BOOT_TIME_H_
+
+#include <stdint.h>
+
+typedef enum boot_mark {
+    BOOT_BIOS_START = 0,    // main() handed over to BIOS_start()
+    BOOT_STACK_READY,       // The GAP Role started
+    BOOT_FIRST_ADVERT,      // Advertising began
+    BOOT_KEY_READY,         // The private key is loaded and signatures can be made
+    BOOT_MARK_COUNT
+} boot_mark_t;
+
+/*
+ * Starts the boot clock, the first thing main() does
+ */
+void boot_time_init();
+
+/*
+ * Notes when a step of the boot was reached, only the first time counts
+ */
+void boot_time_mark(boot_mark_t mark);
+
+/*
+ * Microseconds from main() to the mark, 0 while it was not reached
+ */
+uint32_t boot_time_get(boot_mark_t mark);
+
+#endif /* APPLICATION_BOOT_TIME_H_ */
@@ -0,0 +1,470 @@
+#include "bulk_channel.h"
+
+#ifdef BULK_CHANNEL_ENABLED
+
+#include <string.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Clock.h>
+
+#include "osal_bufmgr.h"
+#include "icall.h"
+#include "conn_notice.h"
+#include "msg_pool.h"
+#include "sign_session.h"
+
+/*
+ * Bulk data over an L2CAP connection oriented channel.
+ *
+ * Messages to sign, signature batches and image blocks used to go through GATT, 16 to
+ * 20 bytes per write or read with an ATT round trip for most of them. A central that
+ * opens a channel on BULK_CHANNEL_PSM sends whole requests as single SDUs instead and
+ * the stack splits them over as many LE frames as the peer's credits allow. The GATT
+ * characteristics stay as they are, for control and for centrals without the channel.
+ *
+ * The central gets BULK_CHANNEL_CREDITS frames at a time. While a sign request waits
+ * for the user its top up is held back, so a central can not pile up requests the
+ * device has no memory for. Replies queue per channel since the stack takes one SDU
+ * at a time.
+ *
+ * The held request and the replies used to come from the BIOS heap, and a reply that
+ * found no L2CAP buffer waited until the central sent something again. Now a request
+ * takes one of the static blocks kept per channel and a reply one of a shared pool,
+ * both fall back to the ICall heap like the other pools. A reply the stack could not
+ * take yet is tried again at the end of every connection event of its link.
+ *
+ * The stats give the throughput of the last and the best transfer as seen by the
+ * device, a central streaming echo or image requests measures the link with them.
+ */
+
+#define BULK_CHANNEL_MAX SIGN_SESSION_MAX
+
+typedef struct bulk_tx {
+    uint16_t len;
+    uint8_t *data;
+} bulk_tx_t;
+
+typedef struct bulk_chan {
+    uint16_t connHandle;
+    uint16_t CID;
+    uint16_t peerMtu;
+    bool isSending;         // The stack is busy with an SDU of ours
+    bool creditsOwed;       // A top up was held back
+    uint8_t *request;       // Held sign request, [op][id][data]
+    uint16_t requestLen;
+    bulk_tx_t tx[BULK_CHANNEL_TX_DEPTH];
+    uint8_t txHead;
+    uint8_t txCount;
+    UInt32 rxStart;         // The transfer in progress
+    UInt32 rxLast;
+    uint32_t rxBytes;
+} bulk_chan_t;
+
+static bulk_chan_t channels[BULK_CHANNEL_MAX];
+static bulk_channel_request_cb_t pfnRequest = NULL;
+
+// One held request per channel, the credits held back keep a central from sending more
+MSG_POOL_STORAGE(requestStorage, BULK_CHANNEL_MTU, BULK_CHANNEL_MAX);
+static msg_pool_t requestPool;
+
+MSG_POOL_STORAGE(replyStorage, BULK_CHANNEL_REPLY_LEN, BULK_CHANNEL_REPLY_BLOCKS);
+static msg_pool_t replyPool;
+
+static bulk_channel_stats_t channelStats;
+
+static bulk_chan_t *find_channel(uint16_t connHandle, uint16_t CID) {
+    uint8_t i;
+
+    for (i = 0; i < BULK_CHANNEL_MAX; i++) {
+        if ((channels[i].CID != 0) &&
+            ((CID != 0) ? (channels[i].CID == CID) : (channels[i].connHandle == connHandle))) {
+            return &channels[i];
+        }
+    }
+    return NULL;
+}
+
+static bulk_chan_t *find_free() {
+    uint8_t i;
+
+    for (i = 0; i < BULK_CHANNEL_MAX; i++) {
+        if (channels[i].CID == 0) {
+            return &channels[i];
+        }
+    }
+    return NULL;
+}
+
+static void grant_credits(bulk_chan_t *chan) {
+    if (L2CAP_FlowCtrlCredit(chan->CID, BULK_CHANNEL_CREDITS) == SUCCESS) {
+        channelStats.credits_granted += BULK_CHANNEL_CREDITS;
+    }
+    chan->creditsOwed = false;
+}
+
+static void free_reply(bulk_tx_t *tx) {
+    msg_pool_free(&replyPool, tx->data);
+    tx->data = NULL;
+}
+
+// Hands the replies to the stack one after the other, unless it is still busy with one
+static void send_next(bulk_chan_t *chan) {
+    bulk_tx_t *tx;
+    l2capPacket_t pkt;
+    uint8_t status;
+
+    while ((!chan->isSending) && (chan->txCount > 0)) {
+        tx = &chan->tx[chan->txHead];
+
+        pkt.pPayload = L2CAP_bm_alloc(tx->len);
+        status = (pkt.pPayload != NULL) ? SUCCESS : MSG_BUFFER_NOT_AVAIL;
+        if (status == SUCCESS) {
+            pkt.CID = chan->CID;
+            pkt.len = tx->len;
+            memcpy(pkt.pPayload, tx->data, tx->len);
+
+            status = L2CAP_SendSDU(&pkt);
+            if (status != SUCCESS) {
+                osal_bm_free(pkt.pPayload);
+            }
+        }
+
+        if ((status == MSG_BUFFER_NOT_AVAIL) || (status == blePending)) {
+            // Tried again at the end of the link's next connection event, or with the
+            // next SDU that comes in should the stack refuse the notice
+            channelStats.tx_retries++;
+            conn_notice_request(chan->connHandle, CONN_NOTICE_BULK_CHANNEL);
+            return;
+        }
+
+        if (status == SUCCESS) {
+            chan->isSending = true;
+            channelStats.sdus_tx++;
+            channelStats.bytes_tx += tx->len;
+        }
+        else {
+            channelStats.tx_dropped++;
+        }
+
+        free_reply(tx);
+        chan->txHead = (chan->txHead + 1) % BULK_CHANNEL_TX_DEPTH;
+        chan->txCount--;
+    }
+
+    // Nothing waits for a buffer, the rest goes out once the stack is done with the SDU
+    conn_notice_release(chan->connHandle, CONN_NOTICE_BULK_CHANNEL);
+}
+
+static void reset_channel(bulk_chan_t *chan) {
+    while (chan->txCount > 0) {
+        free_reply(&chan->tx[chan->txHead]);
+        chan->txHead = (chan->txHead + 1) % BULK_CHANNEL_TX_DEPTH;
+        chan->txCount--;
+    }
+    if (chan->request) {
+        memset(chan->request, 0, chan->requestLen);
+        msg_pool_free(&requestPool, chan->request);
+    }
+    conn_notice_release(chan->connHandle, CONN_NOTICE_BULK_CHANNEL);
+    memset(chan, 0, sizeof(bulk_chan_t));
+}
+
+// Books the SDU on the transfer in progress or closes that and starts a new one
+static void account_rx(bulk_chan_t *chan, uint16_t len) {
+    UInt32 now = Clock_getTicks();
+    UInt32 gap = (BULK_CHANNEL_TRANSFER_GAP_MS * 1000) / Clock_tickPeriod;
+    UInt taskKey = Task_disable();
+
+    channelStats.sdus_rx++;
+    channelStats.bytes_rx += len;
+
+    if ((chan->rxBytes == 0) || ((now - chan->rxLast) > gap)) {
+        chan->rxStart = now;
+        chan->rxBytes = 0;
+    }
+    chan->rxBytes += len;
+    chan->rxLast = now;
+
+    // The first SDU only marks the start, its air time is not part of the span
+    channelStats.last_bytes = chan->rxBytes;
+    channelStats.last_ticks = now - chan->rxStart;
+    if (channelStats.last_ticks > 0) {
+        channelStats.last_rate = (uint32_t) (((uint64_t) (chan->rxBytes - len) * 1000000) /
+                                             ((uint64_t) channelStats.last_ticks * Clock_tickPeriod));
+        if (channelStats.last_rate > channelStats.best_rate) {
+            channelStats.best_rate = channelStats.last_rate;
+        }
+    }
+    Task_restore(taskKey);
+}
+
+static void process_sdu(uint16_t connHandle, bulk_chan_t *chan, const uint8_t *pData, uint16_t len) {
+    uint8_t op;
+    uint8_t id;
+
+    if (len < 2) {
+        channelStats.invalid++;
+        return;
+    }
+    op = pData[0];
+    id = pData[1];
+
+    switch (op) {
+        case BULK_OP_ECHO:
+            bulk_channel_reply(connHandle, op, id, 0, BULK_STATUS_OK, &pData[2], len - 2);
+            break;
+
+        case BULK_OP_SIGN:
+        case BULK_OP_SIGN_BATCH:
+            if (chan->request) {
+                channelStats.busy++;
+                bulk_channel_reply(connHandle, op, id, 0, BULK_STATUS_BUSY, NULL, 0);
+                break;
+            }
+            chan->request = msg_pool_alloc(&requestPool);
+            if (!chan->request) {
+                bulk_channel_reply(connHandle, op, id, 0, BULK_STATUS_BUSY, NULL, 0);
+                break;
+            }
+            memcpy(chan->request, pData, len);
+            chan->requestLen = len;
+            channelStats.requests++;
+            if (pfnRequest) {
+                pfnRequest(connHandle, op, id, &chan->request[2], len - 2);
+            }
+            break;
+
+        case BULK_OP_IMAGE:
+            if (pfnRequest) {
+                pfnRequest(connHandle, op, id, &pData[2], len - 2);
+            }
+            break;
+
+        default:
+            channelStats.invalid++;
+            bulk_channel_reply(connHandle, op, id, 0, BULK_STATUS_INVALID, NULL, 0);
+            break;
+    }
+}
+
+bStatus_t bulk_channel_init(uint8_t taskId, bulk_channel_request_cb_t requestCB) {
+    l2capPsm_t psm;
+
+    pfnRequest = requestCB;
+    msg_pool_init(&requestPool, requestStorage, BULK_CHANNEL_MTU, BULK_CHANNEL_MAX);
+    msg_pool_init(&replyPool, replyStorage, BULK_CHANNEL_REPLY_LEN, BULK_CHANNEL_REPLY_BLOCKS);
+
+    memset(&psm, 0, sizeof(psm));
+    psm.psm = BULK_CHANNEL_PSM;
+    psm.mtu = BULK_CHANNEL_MTU;
+    psm.initPeerCredits = BULK_CHANNEL_CREDITS;
+    // Asks for the top up with a frame to spare so the central does not stall
+    psm.peerCreditThreshold = 1;
+    psm.maxNumChannels = BULK_CHANNEL_MAX;
+    psm.pfnVerifySecCB = NULL;
+    psm.taskId = taskId;
+    return L2CAP_RegisterPsm(&psm);
+}
+
+void bulk_channel_process_signal(l2capSignalEvent_t *pMsg) {
+    bulk_chan_t *chan;
+
+    switch (pMsg->opcode) {
+        case L2CAP_CHANNEL_ESTABLISHED_EVT:
+            if ((pMsg->cmd.channelEstEvt.result != L2CAP_CONN_SUCCESS) ||
+                (pMsg->cmd.channelEstEvt.info.psm != BULK_CHANNEL_PSM)) {
+                break;
+            }
+            chan = find_free();
+            if (!chan) {
+                L2CAP_DisconnectReq(pMsg->cmd.channelEstEvt.CID);
+                break;
+            }
+            memset(chan, 0, sizeof(bulk_chan_t));
+            chan->connHandle = pMsg->connHandle;
+            chan->CID = pMsg->cmd.channelEstEvt.CID;
+            chan->peerMtu = pMsg->cmd.channelEstEvt.info.peerMtu;
+            channelStats.opened++;
+            break;
+
+        case L2CAP_CHANNEL_TERMINATED_EVT:
+            chan = find_channel(pMsg->connHandle, pMsg->cmd.channelTermEvt.CID);
+            if (chan) {
+                reset_channel(chan);
+            }
+            break;
+
+        case L2CAP_PEER_CREDIT_THRESHOLD_EVT:
+            chan = find_channel(pMsg->connHandle, pMsg->cmd.creditEvt.CID);
+            if (!chan) {
+                break;
+            }
+            if (chan->request) {
+                chan->creditsOwed = true;
+                channelStats.credits_deferred++;
+            }
+            else {
+                grant_credits(chan);
+            }
+            break;
+
+        case L2CAP_OUT_OF_CREDIT_EVT:
+            chan = find_channel(pMsg->connHandle, pMsg->cmd.creditEvt.CID);
+            if (chan) {
+                channelStats.out_of_credit++;
+            }
+            break;
+
+        case L2CAP_SEND_SDU_DONE_EVT:
+            chan = find_channel(pMsg->connHandle, pMsg->cmd.sendSduDoneEvt.CID);
+            if (chan) {
+                chan->isSending = false;
+                send_next(chan);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void bulk_channel_process_data(l2capDataEvent_t *pMsg) {
+    bulk_chan_t *chan = find_channel(pMsg->connHandle, pMsg->pkt.CID);
+
+    if (chan) {
+        account_rx(chan, pMsg->pkt.len);
+        process_sdu(pMsg->connHandle, chan, pMsg->pkt.pPayload, pMsg->pkt.len);
+        // A reply that found no buffer earlier gets another chance
+        send_next(chan);
+    }
+    if (pMsg->pkt.pPayload) {
+        osal_bm_free(pMsg->pkt.pPayload);
+    }
+}
+
+bool bulk_channel_request(uint16_t connHandle, uint8_t *op, uint8_t *id,
+                          const uint8_t **pData, uint16_t *len) {
+    bulk_chan_t *chan = find_channel(connHandle, 0);
+
+    if ((!chan) || (!chan->request) || (!op) || (!id) || (!pData) || (!len)) {
+        return false;
+    }
+    *op = chan->request[0];
+    *id = chan->request[1];
+    *pData = &chan->request[2];
+    *len = chan->requestLen - 2;
+    return true;
+}
+
+bool bulk_channel_batch_next(const uint8_t **pData, uint16_t *len,
+                             const uint8_t **pMsg, uint16_t *msgLen) {
+    uint8_t msgSize;
+
+    if ((!pData) || (!len) || (*len < 1)) {
+        return false;
+    }
+    msgSize = (*pData)[0];
+    if ((msgSize == 0) || (msgSize > (*len - 1))) {
+        return false;
+    }
+    *pMsg = &(*pData)[1];
+    *msgLen = msgSize;
+    *pData += 1 + msgSize;
+    *len -= 1 + msgSize;
+    return true;
+}
+
+bool bulk_channel_reply(uint16_t connHandle, uint8_t op, uint8_t id, uint8_t index,
+                        uint8_t status, const uint8_t *pData, uint16_t len) {
+    bulk_chan_t *chan = find_channel(connHandle, 0);
+    bulk_tx_t *tx;
+    uint16_t size = BULK_REPLY_HDR_LEN + len;
+
+    if (!chan) {
+        return false;
+    }
+    if ((chan->txCount >= BULK_CHANNEL_TX_DEPTH) || (size > chan->peerMtu)) {
+        channelStats.tx_dropped++;
+        return false;
+    }
+
+    tx = &chan->tx[(chan->txHead + chan->txCount) % BULK_CHANNEL_TX_DEPTH];
+    tx->data = (size <= BULK_CHANNEL_REPLY_LEN) ? msg_pool_alloc(&replyPool) : ICall_malloc(size);
+    if (!tx->data) {
+        channelStats.tx_dropped++;
+        return false;
+    }
+    tx->len = size;
+    tx->data[0] = op | BULK_OP_REPLY;
+    tx->data[1] = id;
+    tx->data[2] = index;
+    tx->data[3] = status;
+    if (len > 0) {
+        memcpy(&tx->data[BULK_REPLY_HDR_LEN], pData, len);
+    }
+    chan->txCount++;
+
+    send_next(chan);
+    return true;
+}
+
+void bulk_channel_send() {
+    uint8_t i;
+
+    for (i = 0; i < BULK_CHANNEL_MAX; i++) {
+        if (channels[i].CID != 0) {
+            send_next(&channels[i]);
+        }
+    }
+}
+
+void bulk_channel_finish(uint16_t connHandle) {
+    bulk_chan_t *chan = find_channel(connHandle, 0);
+
+    if ((!chan) || (!chan->request)) {
+        return;
+    }
+    memset(chan->request, 0, chan->requestLen);
+    msg_pool_free(&requestPool, chan->request);
+    chan->request = NULL;
+    chan->requestLen = 0;
+
+    if (chan->creditsOwed) {
+        grant_credits(chan);
+    }
+}
+
+void bulk_channel_close(uint16_t connHandle) {
+    bulk_chan_t *chan;
+
+    while ((chan = find_channel(connHandle, 0)) != NULL) {
+        reset_channel(chan);
+    }
+}
+
+void bulk_channel_get_stats(bulk_channel_stats_t *stats) {
+    UInt taskKey;
+    uint8_t i;
+
+    if (!stats) {
+        return;
+    }
+
+    taskKey = Task_disable();
+    memcpy(stats, &channelStats, sizeof(bulk_channel_stats_t));
+    stats->channels = 0;
+    for (i = 0; i < BULK_CHANNEL_MAX; i++) {
+        if (channels[i].CID != 0) {
+            stats->channels++;
+        }
+    }
+    stats->tick_period_us = Clock_tickPeriod;
+    Task_restore(taskKey);
+}
+
+void bulk_channel_reset_stats() {
+    UInt taskKey = Task_disable();
+    memset(&channelStats, 0, sizeof(bulk_channel_stats_t));
+    Task_restore(taskKey);
+}
+
+#endif /* BULK_CHANNEL_ENABLED */
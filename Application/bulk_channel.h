@@ -0,0 +1,152 @@
+#ifndef APPLICATION_BULK_CHANNEL_H_
+#define APPLICATION_BULK_CHANNEL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bcomdef.h"
+#include "l2cap.h"
+
+// BULK_CHANNEL in the predefined symbols builds the channel in, it needs a stack
+// built with L2CAP_COC_CFG in BLE_V41_FEATURES (build_config.opt)
+#ifdef BULK_CHANNEL
+#if !defined(BLE_V41_FEATURES) || !(BLE_V41_FEATURES & L2CAP_COC_CFG)
+#error "BULK_CHANNEL needs -DBLE_V41_FEATURES=L2CAP_COC_CFG in the stack's build_config.opt, or drop BULK_CHANNEL"
+#endif
+#define BULK_CHANNEL_ENABLED
+#endif
+
+// LE protocol/service multiplexer the central connects to, from the dynamic range
+#define BULK_CHANNEL_PSM 0x0081
+
+// Largest SDU either side sends, one request or one reply
+#ifndef BULK_CHANNEL_MTU
+#define BULK_CHANNEL_MTU 512
+#endif
+
+// Credits (LE frames) the central gets up front and with every top up
+#ifndef BULK_CHANNEL_CREDITS
+#define BULK_CHANNEL_CREDITS 16
+#endif
+
+// Replies waiting for the previous SDU to go out, per channel
+#define BULK_CHANNEL_TX_DEPTH 4
+
+// Most messages in one batch, each gets its own reply
+#define BULK_CHANNEL_MAX_BATCH BULK_CHANNEL_TX_DEPTH
+
+// SDUs further apart than this start a new transfer in the throughput figures
+#define BULK_CHANNEL_TRANSFER_GAP_MS 500
+
+// Every SDU starts with an op code and a request id the central picks
+typedef enum bulk_channel_op {
+    BULK_OP_SIGN = 0x01,        // [op][id][message], the reply carries the signature
+    BULK_OP_SIGN_BATCH = 0x02,  // [op][id]([len][message])*, one confirmation, one reply each
+    BULK_OP_IMAGE = 0x03,       // [op][id]([block lo][block hi][16 bytes])*, OAD image blocks
+    BULK_OP_ECHO = 0x7F         // [op][id][anything], sent back as is, to measure the link
+} bulk_channel_op_t;
+
+// Replies are [op | BULK_OP_REPLY][id][index][status][data]
+#define BULK_OP_REPLY 0x80
+#define BULK_REPLY_HDR_LEN 4
+
+// Replies up to this long wait in a static pool, a signature of the 1024 bit key fits,
+// longer echoes come from the ICall heap
+#ifndef BULK_CHANNEL_REPLY_LEN
+#define BULK_CHANNEL_REPLY_LEN (BULK_REPLY_HDR_LEN + 128)
+#endif
+
+// Reply blocks in the pool, for all channels
+#ifndef BULK_CHANNEL_REPLY_BLOCKS
+#define BULK_CHANNEL_REPLY_BLOCKS BULK_CHANNEL_TX_DEPTH
+#endif
+
+typedef enum bulk_channel_status {
+    BULK_STATUS_OK = 0,
+    BULK_STATUS_BUSY,       // A sign request of this channel is still being served
+    BULK_STATUS_INVALID,    // Unknown op or malformed request
+    BULK_STATUS_REJECTED,   // No sign session left or the user did not confirm
+    BULK_STATUS_FAILED      // Signing failed, the data holds the error code
+} bulk_channel_status_t;
+
+typedef struct bulk_channel_stats {
+    uint32_t sdus_rx;
+    uint32_t bytes_rx;
+    uint32_t sdus_tx;
+    uint32_t bytes_tx;
+    uint32_t requests;         // Sign requests held for the signer
+    uint32_t busy;             // Requests refused because one was held already
+    uint32_t invalid;          // SDUs that were not a valid request
+    uint32_t tx_dropped;       // Replies dropped, the queue was full or the stack refused them
+    uint32_t tx_retries;       // Sends that found no buffer and waited for a connection event
+    uint32_t credits_granted;
+    uint32_t credits_deferred; // Top ups held back until a request was served
+    uint32_t out_of_credit;    // Times a reply waited for the central to give credits
+    uint32_t opened;           // Channels the centrals opened
+    uint32_t last_bytes;       // Bytes received in the last transfer
+    uint32_t last_ticks;       // From its first to its last SDU
+    uint32_t last_rate;        // Its throughput in bytes per second
+    uint32_t best_rate;
+    uint8_t  channels;         // Channels open now
+    uint32_t tick_period_us;   // Length of one Clock tick
+} bulk_channel_stats_t;
+
+/*
+ * Called with every request but echoes. Sign requests stay with the channel until
+ * bulk_channel_finish(), other data is only valid during the call.
+ */
+typedef void (*bulk_channel_request_cb_t)(uint16_t connHandle, uint8_t op, uint8_t id,
+                                          const uint8_t *pData, uint16_t len);
+
+/*
+ * Registers BULK_CHANNEL_PSM for the application task, taskId being its local
+ * BLE message entity.
+ */
+bStatus_t bulk_channel_init(uint8_t taskId, bulk_channel_request_cb_t requestCB);
+
+/*
+ * Forward L2CAP_SIGNAL_EVENT and L2CAP_DATA_EVENT messages here.
+ * The payload of a data event is freed.
+ */
+void bulk_channel_process_signal(l2capSignalEvent_t *pMsg);
+void bulk_channel_process_data(l2capDataEvent_t *pMsg);
+
+/*
+ * The sign request connHandle's channel holds. Returns false if there is none.
+ */
+bool bulk_channel_request(uint16_t connHandle, uint8_t *op, uint8_t *id,
+                          const uint8_t **pData, uint16_t *len);
+
+/*
+ * Steps through the messages of a batch, pData and len are advanced past each one.
+ * Returns false once they ran out or the rest is malformed.
+ */
+bool bulk_channel_batch_next(const uint8_t **pData, uint16_t *len,
+                             const uint8_t **pMsg, uint16_t *msgLen);
+
+/*
+ * Queues a reply on connHandle's channel.
+ */
+bool bulk_channel_reply(uint16_t connHandle, uint8_t op, uint8_t id, uint8_t index,
+                        uint8_t status, const uint8_t *pData, uint16_t len);
+
+/*
+ * Sends the replies that found no buffer before. Call it at the end of every
+ * connection event, a channel holds its link's conn_notice while one waits.
+ */
+void bulk_channel_send();
+
+/*
+ * Releases the held sign request and gives the central the credits it waited for.
+ */
+void bulk_channel_finish(uint16_t connHandle);
+
+/*
+ * Forgets the channel of a link that went down.
+ */
+void bulk_channel_close(uint16_t connHandle);
+
+void bulk_channel_get_stats(bulk_channel_stats_t *stats);
+void bulk_channel_reset_stats();
+
+#endif /* APPLICATION_BULK_CHANNEL_H_ */
@@ -0,0 +1,258 @@
+#include "button.h"
+
+#include <string.h>
+#include <stdbool.h>
+#include <ti/drivers/pin/PINCC26XX.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include <xdc/runtime/system.h>
+
+#include "board.h"
+
+/*
+ * Button debouncing without waiting in the interrupt.
+ *
+ * The pin callback used to busy wait 50ms before it sampled the pin, and every interrupt
+ * of the same or a lower priority, the radio's included, waited with it. Now the
+ * callback only notes the time of the edge and (re)arms a one shot Clock. The level is
+ * sampled once it held for BUTTON_DEBOUNCE_MS, from the Clock Swi. The same clock then
+ * times the long press. A press is reported when the button is let go, no longer on the
+ * falling edge as before, since only then is it known not to be a long press, which
+ * declines a signature. A long press is reported while the button is still held, and a
+ * second press right after a short one as a double press. The stats and the button
+ * state are shared by the pin callback and the Clock Swi, they change with interrupts
+ * disabled.
+ */
+
+#define BUTTON_COUNT 2
+
+typedef enum button_timer {
+    BUTTON_TIMER_NONE = 0,
+    BUTTON_TIMER_DEBOUNCE,
+    BUTTON_TIMER_LONG
+} button_timer_t;
+
+typedef struct button {
+    PIN_Id pin;
+    Clock_Struct clock;
+    uint8_t timer;          // button_timer_t the clock runs for
+    bool isPressed;         // Debounced level
+    bool isLongReported;
+    bool isDouble;          // This press started within the double press window
+    bool hasClick;          // The last press was a short one
+    UInt32 edgeTick;        // First edge of the bounces being waited out
+    UInt32 pressTick;
+    UInt32 releaseTick;
+} button_t;
+
+static PIN_Handle buttonPinHandle;
+static PIN_State buttonPinState;
+
+/*
+ * Application button pin configuration table:
+ *   - Buttons interrupts are configured to trigger on both edges.
+ */
+PIN_Config buttonPinTable[] = {
+    Board_PIN_BUTTON0  | PIN_INPUT_EN | PIN_PULLUP | PIN_IRQ_BOTHEDGES,
+    Board_PIN_BUTTON1  | PIN_INPUT_EN | PIN_PULLUP | PIN_IRQ_BOTHEDGES,
+    PIN_TERMINATE
+};
+
+static button_t buttons[BUTTON_COUNT];
+static button_event_cb_t pfnEvent = NULL;
+static volatile uint8_t lastEvent = BUTTON_NONE;
+
+static button_stats_t buttonStats;
+
+static void count(uint32_t *counter) {
+    UInt hwiKey = Hwi_disable();
+    (*counter)++;
+    Hwi_restore(hwiKey);
+}
+
+static UInt32 ms_to_ticks(uint32_t ms) {
+    return (ms * 1000) / Clock_tickPeriod;
+}
+
+static void arm(button_t *button, button_timer_t timer, UInt32 ticks) {
+    Clock_Handle clock = Clock_handle(&button->clock);
+
+    Clock_stop(clock);
+    button->timer = timer;
+    // A zero timeout would never fire
+    Clock_setTimeout(clock, (ticks > 0) ? ticks : 1);
+    Clock_start(clock);
+}
+
+static void report(button_t *button, button_event_t event) {
+    switch (event) {
+        case BUTTON_PRESS:
+            count(&buttonStats.presses);
+            break;
+        case BUTTON_LONG_PRESS:
+            count(&buttonStats.long_presses);
+            break;
+        case BUTTON_DOUBLE_PRESS:
+            count(&buttonStats.double_presses);
+            break;
+        default:
+            return;
+    }
+
+    lastEvent = event;
+    if (pfnEvent) {
+        pfnEvent(button->pin, event);
+    }
+}
+
+static void on_press(button_t *button, UInt32 tick) {
+    button->isPressed = true;
+    button->isLongReported = false;
+    button->isDouble = button->hasClick &&
+                       ((tick - button->releaseTick) <= ms_to_ticks(BUTTON_DOUBLE_PRESS_MS));
+    button->pressTick = tick;
+}
+
+static void on_release(button_t *button, UInt32 tick) {
+    button->isPressed = false;
+    if (button->isLongReported) {
+        button->hasClick = false;
+        return;
+    }
+
+    if (button->isDouble) {
+        button->hasClick = false;
+        report(button, BUTTON_DOUBLE_PRESS);
+    }
+    else {
+        button->hasClick = true;
+        button->releaseTick = tick;
+        report(button, BUTTON_PRESS);
+    }
+}
+
+static void button_clock_fxn(UArg arg) {
+    button_t *button = &buttons[arg];
+    UInt32 now = Clock_getTicks();
+    UInt32 edgeTick;
+    UInt32 held;
+    UInt hwiKey;
+    uint8_t timer;
+    bool isPressed;
+
+    // A new edge from the pin callback can come in at any point
+    hwiKey = Hwi_disable();
+    timer = button->timer;
+    edgeTick = button->edgeTick;
+    button->timer = BUTTON_TIMER_NONE;
+    Hwi_restore(hwiKey);
+
+    switch (timer) {
+        case BUTTON_TIMER_DEBOUNCE:
+            // The buttons pull the pin low
+            isPressed = !PIN_getInputValue(button->pin);
+            if (isPressed == button->isPressed) {
+                count(&buttonStats.bounces);
+            }
+            else if (isPressed) {
+                // The press started with the first edge, not once it settled
+                on_press(button, edgeTick);
+            }
+            else {
+                on_release(button, edgeTick);
+            }
+            break;
+
+        case BUTTON_TIMER_LONG:
+            if (button->isPressed && (!button->isLongReported)) {
+                button->isLongReported = true;
+                report(button, BUTTON_LONG_PRESS);
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    hwiKey = Hwi_disable();
+    // Unless an edge armed the debounce again in the meantime
+    if ((button->timer == BUTTON_TIMER_NONE) && button->isPressed && (!button->isLongReported)) {
+        held = now - button->pressTick;
+        arm(button, BUTTON_TIMER_LONG,
+            (held < ms_to_ticks(BUTTON_LONG_PRESS_MS)) ? (ms_to_ticks(BUTTON_LONG_PRESS_MS) - held) : 0);
+    }
+    Hwi_restore(hwiKey);
+}
+
+void buttonCallbackFxn(PIN_Handle handle, PIN_Id pinId) {
+    UInt hwiKey;
+    uint8_t i;
+
+    for (i = 0; i < BUTTON_COUNT; i++) {
+        if (buttons[i].pin != pinId) {
+            continue;
+        }
+
+        hwiKey = Hwi_disable();
+        buttonStats.edges++;
+        // Every edge restarts the wait, the first one of a burst keeps its time
+        if (buttons[i].timer != BUTTON_TIMER_DEBOUNCE) {
+            buttons[i].edgeTick = Clock_getTicks();
+        }
+        arm(&buttons[i], BUTTON_TIMER_DEBOUNCE, ms_to_ticks(BUTTON_DEBOUNCE_MS));
+        Hwi_restore(hwiKey);
+        break;
+    }
+}
+
+void init_buttons() {
+    Clock_Params clockParams;
+    uint8_t i;
+
+    buttonPinHandle = PIN_open(&buttonPinState, buttonPinTable);
+    if(!buttonPinHandle) {
+        /* Error initializing button pins */
+        System_abort("Button Failure");
+    }
+
+    for (i = 0; i < BUTTON_COUNT; i++) {
+        memset(&buttons[i], 0, sizeof(button_t));
+        buttons[i].pin = PIN_ID(buttonPinTable[i]);
+        Clock_Params_init(&clockParams);
+        clockParams.arg = i;
+        clockParams.startFlag = FALSE;
+        Clock_construct(&buttons[i].clock, button_clock_fxn, 1, &clockParams);
+    }
+
+    /* Setup callback for button pins */
+    if (PIN_registerIntCb(buttonPinHandle, &buttonCallbackFxn) != 0) {
+        /* Error registering button callback function */
+        System_abort("Button callback failure");
+    }
+}
+
+void button_register_cb(button_event_cb_t eventCB) {
+    pfnEvent = eventCB;
+}
+
+button_event_t button_last_event() {
+    return (button_event_t) lastEvent;
+}
+
+void button_get_stats(button_stats_t *stats) {
+    UInt hwiKey;
+
+    if (!stats) {
+        return;
+    }
+
+    hwiKey = Hwi_disable();
+    memcpy(stats, &buttonStats, sizeof(button_stats_t));
+    Hwi_restore(hwiKey);
+}
+
+void button_reset_stats() {
+    UInt hwiKey = Hwi_disable();
+    memset(&buttonStats, 0, sizeof(button_stats_t));
+    Hwi_restore(hwiKey);
+}
@@ -0,0 +1,60 @@
+#ifndef APPLICATION_BUTTON_H_
+#define APPLICATION_BUTTON_H_
+
+#include <stdint.h>
+#include <ti/drivers/PIN.h>
+
+// How long we wait for the user to press the button before we indicate too long has passed
+#define SIGN_BUTTON_TIMEOUT_MS 50000
+
+// The level has to stay this long after the last edge to count
+#ifndef BUTTON_DEBOUNCE_MS
+#define BUTTON_DEBOUNCE_MS 20
+#endif
+
+// Held this long, a press is a long press
+#ifndef BUTTON_LONG_PRESS_MS
+#define BUTTON_LONG_PRESS_MS 1500
+#endif
+
+// A press starting this soon after a short press ended makes a double press
+#ifndef BUTTON_DOUBLE_PRESS_MS
+#define BUTTON_DOUBLE_PRESS_MS 400
+#endif
+
+typedef enum button_event {
+    BUTTON_NONE = 0,
+    BUTTON_PRESS,         // Released before the long press time, reported on release
+    BUTTON_LONG_PRESS,    // Reported while still held
+    BUTTON_DOUBLE_PRESS   // Reported instead of the second BUTTON_PRESS
+} button_event_t;
+
+typedef struct button_stats {
+    uint32_t edges;      // Pin interrupts
+    uint32_t bounces;    // Debounce windows that ended on the level they started from
+    uint32_t presses;
+    uint32_t long_presses;
+    uint32_t double_presses;
+} button_stats_t;
+
+/*
+ * Called from the Clock Swi with every event, the sign flow is answered through it
+ */
+typedef void (*button_event_cb_t)(PIN_Id pin, button_event_t event);
+
+/*
+ * Opens the button pins and sets up their debounce clocks
+ */
+void init_buttons();
+
+void button_register_cb(button_event_cb_t eventCB);
+
+/*
+ * The event reported last
+ */
+button_event_t button_last_event();
+
+void button_get_stats(button_stats_t *stats);
+void button_reset_stats();
+
+#endif /* APPLICATION_BUTTON_H_ */
@@ -0,0 +1,687 @@
+/*
+ *  NIST SP800-38C compliant CCM implementation
+ *
+ *  Copyright (C) 2006-2015, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  This file is part of mbed TLS (https://tls.mbed.org)
+ */
+
+/*
+ * Definition of CCM:
+ * http://csrc.nist.gov/publications/nistpubs/800-38C/SP800-38C_updated-July20_2007.pdf
+ * RFC 3610 "Counter with CBC-MAC (CCM)"
+ *
+ * Related:
+ * RFC 5116 "An Interface and Algorithms for Authenticated Encryption"
+ */
+
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Clock.h>
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#if defined(MBEDTLS_CCM_C)
+
+#include "mbedtls/ccm.h"
+
+#include <string.h>
+
+#if defined(MBEDTLS_SELF_TEST) && defined(MBEDTLS_AES_C)
+#if defined(MBEDTLS_PLATFORM_C)
+#include "mbedtls/platform.h"
+#else
+#include <stdio.h>
+#define mbedtls_printf printf
+#endif /* MBEDTLS_PLATFORM_C */
+#endif /* MBEDTLS_SELF_TEST && MBEDTLS_AES_C */
+
+#if defined(MBEDTLS_CCM_ALT)
+
+#include "crypto_engine.h"
+
+#if defined(MBEDTLS_PLATFORM_C)
+#include "mbedtls/platform.h"
+#else
+#include <stdlib.h>
+#define mbedtls_calloc    calloc
+#define mbedtls_free      free
+#endif
+
+/*
+ * The engine decrypts the ciphertext and the tag from one buffer, and encrypts in
+ * place, so decryption and in place encryption go through a bounce buffer. The input
+ * then stays intact for the software path if the engine fails. Short messages bounce
+ * on the stack, longer ones through a buffer from the crypto arena, and only when the
+ * arena has no room left does the message take the software path.
+ */
+#ifndef CCM_HW_BOUNCE_STACK_LEN
+#define CCM_HW_BOUNCE_STACK_LEN 32
+#endif
+
+/* Implementation that should never be optimized out by the compiler */
+static void mbedtls_zeroize( void *v, size_t n ) {
+    volatile unsigned char *p = v; while( n-- ) *p++ = 0;
+}
+
+#define CCM_ENCRYPT 0
+#define CCM_DECRYPT 1
+
+static mbedtls_ccm_stats ccm_stats;
+
+/*
+ * Initialize context
+ */
+void mbedtls_ccm_init( mbedtls_ccm_context *ctx )
+{
+    memset( ctx, 0, sizeof( mbedtls_ccm_context ) );
+    mbedtls_aes_init( &ctx->aes_ctx );
+    ctx->use_hardware = 1;
+}
+
+int mbedtls_ccm_setkey( mbedtls_ccm_context *ctx,
+                        mbedtls_cipher_id_t cipher,
+                        const unsigned char *key,
+                        unsigned int keybits )
+{
+    // The key RAM only holds AES-128 keys
+    if( cipher != MBEDTLS_CIPHER_ID_AES || keybits != 128 )
+        return( MBEDTLS_ERR_CCM_BAD_INPUT );
+
+    return( mbedtls_aes_setkey_enc( &ctx->aes_ctx, key, keybits ) );
+}
+
+/*
+ * Free context
+ */
+void mbedtls_ccm_free( mbedtls_ccm_context *ctx )
+{
+    mbedtls_aes_free( &ctx->aes_ctx );
+    mbedtls_zeroize( ctx, sizeof( mbedtls_ccm_context ) );
+}
+
+void mbedtls_ccm_set_hardware( mbedtls_ccm_context *ctx, int enable )
+{
+    ctx->use_hardware = enable;
+}
+
+void mbedtls_ccm_get_stats( mbedtls_ccm_stats *stats )
+{
+    UInt taskKey = Task_disable();
+    memcpy( stats, &ccm_stats, sizeof( mbedtls_ccm_stats ) );
+    Task_restore( taskKey );
+}
+
+void mbedtls_ccm_reset_stats( void )
+{
+    UInt taskKey = Task_disable();
+    memset( &ccm_stats, 0, sizeof( mbedtls_ccm_stats ) );
+    Task_restore( taskKey );
+}
+
+static void ccm_count_op( int hardware, size_t length, UInt32 start )
+{
+    UInt32 ticks = Clock_getTicks() - start;
+    UInt taskKey = Task_disable();
+
+    if( hardware )
+    {
+        ccm_stats.hw_ops++;
+        ccm_stats.hw_bytes += length;
+        ccm_stats.hw_ticks += ticks;
+    }
+    else
+    {
+        ccm_stats.sw_ops++;
+        ccm_stats.sw_bytes += length;
+        ccm_stats.sw_ticks += ticks;
+    }
+    Task_restore( taskKey );
+}
+
+static void ccm_count_fallback( void )
+{
+    UInt taskKey = Task_disable();
+    ccm_stats.fallbacks++;
+    Task_restore( taskKey );
+}
+
+static int ccm_check_params( size_t length, size_t iv_len, size_t add_len,
+                             size_t tag_len )
+{
+    if( tag_len < 4 || tag_len > 16 || tag_len % 2 != 0 )
+        return( MBEDTLS_ERR_CCM_BAD_INPUT );
+
+    /* Also implies q is within bounds */
+    if( iv_len < 7 || iv_len > 13 )
+        return( MBEDTLS_ERR_CCM_BAD_INPUT );
+
+    if( add_len > 0xFF00 )
+        return( MBEDTLS_ERR_CCM_BAD_INPUT );
+
+    /* The length field is 15 - iv_len bytes wide, at least 2 */
+    if( iv_len == 13 && length > 0xFFFF )
+        return( MBEDTLS_ERR_CCM_BAD_INPUT );
+
+    return( 0 );
+}
+
+/*
+ * The engine only supports a 2 or 3 byte length field (13 or 12 byte nonce)
+ * and its message length register is 16 bits wide.
+ */
+static int ccm_hw_supported( mbedtls_ccm_context *ctx, size_t length, size_t iv_len )
+{
+    if( !ctx->use_hardware || ctx->aes_ctx.keyLocation == CRYPTOCC26XX_STATUS_ERROR )
+        return( 0 );
+
+    if( iv_len != 12 && iv_len != 13 )
+        return( 0 );
+
+    if( length == 0 || length > 0xFFFF - 16 )
+        return( 0 );
+
+    return( 1 );
+}
+
+/*
+ * Run the whole operation as a single engine job.
+ * Returns MBEDTLS_ERR_CCM_AUTH_FAILED for any engine failure; the caller
+ * retries those in software, which also tells a bad tag from a driver error.
+ */
+static int ccm_hw_auth_crypt( mbedtls_ccm_context *ctx, int mode, size_t length,
+                              const unsigned char *iv, size_t iv_len,
+                              const unsigned char *add, size_t add_len,
+                              const unsigned char *input, unsigned char *output,
+                              unsigned char *tag, size_t tag_len )
+{
+    CryptoCC26XX_AESCCM_Transaction trans;
+    unsigned char nonce[13];
+    unsigned char mic[16];
+    unsigned char stack_bounce[CCM_HW_BOUNCE_STACK_LEN + 16];
+    unsigned char *bounce = stack_bounce;
+    size_t bounce_len = sizeof( stack_bounce );
+    unsigned char *msg;
+    int status;
+
+    if( ( mode == CCM_DECRYPT || output == input ) &&
+        length + tag_len > sizeof( stack_bounce ) )
+    {
+        bounce_len = length + tag_len;
+        if( ( bounce = mbedtls_calloc( 1, bounce_len ) ) == NULL )
+            return( MBEDTLS_ERR_CCM_AUTH_FAILED );
+    }
+
+    memcpy( nonce, iv, iv_len );
+
+    if( mode == CCM_ENCRYPT )
+    {
+        // The engine encrypts in place, the tag goes to msgOut
+        if( output == input )
+        {
+            memcpy( bounce, input, length );
+            msg = bounce;
+        }
+        else
+        {
+            memmove( output, input, length );
+            msg = output;
+        }
+        CryptoCC26XX_Transac_init( (CryptoCC26XX_Transaction *) &trans,
+                                   CRYPTOCC26XX_OP_AES_CCM_ENCRYPT );
+        trans.msgInLength = (uint16_t) length;
+    }
+    else
+    {
+        // The engine expects the tag right after the ciphertext
+        memcpy( bounce, input, length );
+        memcpy( bounce + length, tag, tag_len );
+        msg = bounce;
+        CryptoCC26XX_Transac_init( (CryptoCC26XX_Transaction *) &trans,
+                                   CRYPTOCC26XX_OP_AES_CCM_DECRYPT );
+        trans.msgInLength = (uint16_t)( length + tag_len );
+    }
+
+    trans.keyIndex     = (uint8_t) ctx->aes_ctx.keyLocation;
+    trans.authLength   = (uint8_t) tag_len;
+    trans.nonce        = (char *) nonce;
+    trans.header       = (char *) add;
+    trans.headerLength = (uint16_t) add_len;
+    trans.msgIn        = (char *) msg;
+    trans.msgOut       = mic;
+    trans.fieldLength  = (uint8_t)( 15 - iv_len );
+
+    status = crypto_engine_transact( (CryptoCC26XX_Transaction *) &trans,
+                                     crypto_engine_mode_for_length( length + add_len ) );
+
+    if( status == CRYPTOCC26XX_STATUS_SUCCESS )
+    {
+        if( mode == CCM_DECRYPT || msg == bounce )
+            memcpy( output, bounce, length );
+        if( mode == CCM_ENCRYPT )
+            memcpy( tag, mic, tag_len );
+    }
+
+    mbedtls_zeroize( bounce, bounce_len );
+    mbedtls_zeroize( mic, sizeof( mic ) );
+    if( bounce != stack_bounce )
+        mbedtls_free( bounce );
+
+    if( status != CRYPTOCC26XX_STATUS_SUCCESS )
+        return( MBEDTLS_ERR_CCM_AUTH_FAILED );
+
+    return( 0 );
+}
+
+/*
+ * Macros for common operations.
+ * Results in smaller compiled code than static inline functions.
+ */
+
+/*
+ * Update the CBC-MAC state in y using a block in b
+ * (Always using b as the source helps the compiler optimise a bit better.)
+ */
+#define UPDATE_CBC_MAC                                                      \
+    for( i = 0; i < 16; i++ )                                               \
+        y[i] ^= b[i];                                                       \
+                                                                            \
+    if( ( ret = mbedtls_aes_crypt_ecb( &ctx->aes_ctx, MBEDTLS_AES_ENCRYPT,  \
+                                       y, y ) ) != 0 )                      \
+        return( ret );
+
+/*
+ * Encrypt or decrypt a partial block with CTR
+ * Warning: using b for temporary storage! src and dst must not be b!
+ * This avoids allocating one more 16 bytes buffer while allowing src == dst.
+ */
+#define CTR_CRYPT( dst, src, len  )                                         \
+    if( ( ret = mbedtls_aes_crypt_ecb( &ctx->aes_ctx, MBEDTLS_AES_ENCRYPT,  \
+                                       ctr, b ) ) != 0 )                    \
+        return( ret );                                                      \
+                                                                            \
+    for( i = 0; i < len; i++ )                                              \
+        dst[i] = src[i] ^ b[i];
+
+/*
+ * Authenticated encryption or decryption with the ECB construction
+ */
+static int ccm_sw_auth_crypt( mbedtls_ccm_context *ctx, int mode, size_t length,
+                              const unsigned char *iv, size_t iv_len,
+                              const unsigned char *add, size_t add_len,
+                              const unsigned char *input, unsigned char *output,
+                              unsigned char *tag, size_t tag_len )
+{
+    int ret;
+    unsigned char i;
+    unsigned char q;
+    size_t len_left;
+    unsigned char b[16];
+    unsigned char y[16];
+    unsigned char ctr[16];
+    const unsigned char *src;
+    unsigned char *dst;
+
+    q = 16 - 1 - (unsigned char) iv_len;
+
+    /*
+     * First block B_0:
+     * 0        .. 0        flags
+     * 1        .. iv_len   nonce (aka iv)
+     * iv_len+1 .. 15       length
+     *
+     * With flags as (bits):
+     * 7        0
+     * 6        add present?
+     * 5 .. 3   (t - 2) / 2
+     * 2 .. 0   q - 1
+     */
+    b[0] = 0;
+    b[0] |= ( add_len > 0 ) << 6;
+    b[0] |= ( ( tag_len - 2 ) / 2 ) << 3;
+    b[0] |= q - 1;
+
+    memcpy( b + 1, iv, iv_len );
+
+    for( i = 0, len_left = length; i < q; i++, len_left >>= 8 )
+        b[15-i] = (unsigned char)( len_left & 0xFF );
+
+    if( len_left > 0 )
+        return( MBEDTLS_ERR_CCM_BAD_INPUT );
+
+
+    /* Start CBC-MAC with first block */
+    memset( y, 0, 16 );
+    UPDATE_CBC_MAC;
+
+    /*
+     * If there is additional data, update CBC-MAC with
+     * add_len, add, 0 (padding to a block boundary)
+     */
+    if( add_len > 0 )
+    {
+        size_t use_len;
+        len_left = add_len;
+        src = add;
+
+        memset( b, 0, 16 );
+        b[0] = (unsigned char)( ( add_len >> 8 ) & 0xFF );
+        b[1] = (unsigned char)( ( add_len      ) & 0xFF );
+
+        use_len = len_left < 16 - 2 ? len_left : 16 - 2;
+        memcpy( b + 2, src, use_len );
+        len_left -= use_len;
+        src += use_len;
+
+        UPDATE_CBC_MAC;
+
+        while( len_left > 0 )
+        {
+            use_len = len_left > 16 ? 16 : len_left;
+
+            memset( b, 0, 16 );
+            memcpy( b, src, use_len );
+            UPDATE_CBC_MAC;
+
+            len_left -= use_len;
+            src += use_len;
+        }
+    }
+
+    /*
+     * Prepare counter block for encryption:
+     * 0        .. 0        flags
+     * 1        .. iv_len   nonce (aka iv)
+     * iv_len+1 .. 15       counter (initially 1)
+     *
+     * With flags as (bits):
+     * 7 .. 3   0
+     * 2 .. 0   q - 1
+     */
+    ctr[0] = q - 1;
+    memcpy( ctr + 1, iv, iv_len );
+    memset( ctr + 1 + iv_len, 0, q );
+    ctr[15] = 1;
+
+    /*
+     * Authenticate and {en,de}crypt the message.
+     *
+     * The only difference between encryption and decryption is
+     * the respective order of authentication and {en,de}cryption.
+     */
+    len_left = length;
+    src = input;
+    dst = output;
+
+    while( len_left > 0 )
+    {
+        size_t use_len = len_left > 16 ? 16 : len_left;
+
+        if( mode == CCM_ENCRYPT )
+        {
+            memset( b, 0, 16 );
+            memcpy( b, src, use_len );
+            UPDATE_CBC_MAC;
+        }
+
+        CTR_CRYPT( dst, src, use_len );
+
+        if( mode == CCM_DECRYPT )
+        {
+            memset( b, 0, 16 );
+            memcpy( b, dst, use_len );
+            UPDATE_CBC_MAC;
+        }
+
+        dst += use_len;
+        src += use_len;
+        len_left -= use_len;
+
+        /*
+         * Increment counter.
+         * No need to check for overflow thanks to the length check above.
+         */
+        for( i = 0; i < q; i++ )
+            if( ++ctr[15-i] != 0 )
+                break;
+    }
+
+    /*
+     * Authentication: reset counter and crypt/mask internal tag
+     */
+    for( i = 0; i < q; i++ )
+        ctr[15-i] = 0;
+
+    CTR_CRYPT( y, y, 16 );
+    memcpy( tag, y, tag_len );
+
+    return( 0 );
+}
+
+/*
+ * Authenticated encryption
+ */
+int mbedtls_ccm_encrypt_and_tag( mbedtls_ccm_context *ctx, size_t length,
+                         const unsigned char *iv, size_t iv_len,
+                         const unsigned char *add, size_t add_len,
+                         const unsigned char *input, unsigned char *output,
+                         unsigned char *tag, size_t tag_len )
+{
+    int ret;
+    UInt32 start = Clock_getTicks();
+
+    if( ( ret = ccm_check_params( length, iv_len, add_len, tag_len ) ) != 0 )
+        return( ret );
+
+    if( ccm_hw_supported( ctx, length, iv_len ) )
+    {
+        ret = ccm_hw_auth_crypt( ctx, CCM_ENCRYPT, length, iv, iv_len, add, add_len,
+                                 input, output, tag, tag_len );
+        if( ret == 0 )
+        {
+            ccm_count_op( 1, length, start );
+            return( 0 );
+        }
+
+        // The input is untouched, an in place message went through a bounce buffer
+        ccm_count_fallback();
+        start = Clock_getTicks();
+    }
+
+    ret = ccm_sw_auth_crypt( ctx, CCM_ENCRYPT, length, iv, iv_len, add, add_len,
+                             input, output, tag, tag_len );
+    if( ret == 0 )
+        ccm_count_op( 0, length, start );
+
+    return( ret );
+}
+
+/*
+ * Authenticated decryption
+ */
+int mbedtls_ccm_auth_decrypt( mbedtls_ccm_context *ctx, size_t length,
+                      const unsigned char *iv, size_t iv_len,
+                      const unsigned char *add, size_t add_len,
+                      const unsigned char *input, unsigned char *output,
+                      const unsigned char *tag, size_t tag_len )
+{
+    int ret;
+    unsigned char check_tag[16];
+    unsigned char i;
+    int diff;
+    UInt32 start = Clock_getTicks();
+
+    if( ( ret = ccm_check_params( length, iv_len, add_len, tag_len ) ) != 0 )
+        return( ret );
+
+    if( ccm_hw_supported( ctx, length, iv_len ) )
+    {
+        ret = ccm_hw_auth_crypt( ctx, CCM_DECRYPT, length, iv, iv_len, add, add_len,
+                                 input, output, (unsigned char *) tag, tag_len );
+        if( ret == 0 )
+        {
+            ccm_count_op( 1, length, start );
+            return( 0 );
+        }
+
+        // A forged tag and a driver error look the same, let the software path decide
+        ccm_count_fallback();
+        start = Clock_getTicks();
+    }
+
+    if( ( ret = ccm_sw_auth_crypt( ctx, CCM_DECRYPT, length,
+                                   iv, iv_len, add, add_len,
+                                   input, output, check_tag, tag_len ) ) != 0 )
+    {
+        return( ret );
+    }
+
+    /* Check tag in "constant-time" */
+    for( diff = 0, i = 0; i < tag_len; i++ )
+        diff |= tag[i] ^ check_tag[i];
+
+    if( diff != 0 )
+    {
+        mbedtls_zeroize( output, length );
+        return( MBEDTLS_ERR_CCM_AUTH_FAILED );
+    }
+
+    ccm_count_op( 0, length, start );
+
+    return( 0 );
+}
+
+#endif /* MBEDTLS_CCM_ALT */
+
+#if defined(MBEDTLS_SELF_TEST) && defined(MBEDTLS_AES_C)
+/*
+ * Examples 1 to 3 from SP800-38C Appendix C
+ */
+
+#define NB_TESTS 3
+
+/*
+ * The data is the same for all tests, only the used length changes
+ */
+static const unsigned char key[] = {
+    0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47,
+    0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e, 0x4f
+};
+
+static const unsigned char iv[] = {
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+    0x18, 0x19, 0x1a, 0x1b, 0x1c
+};
+
+static const unsigned char ad[] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+    0x10, 0x11, 0x12, 0x13
+};
+
+static const unsigned char msg[] = {
+    0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27,
+    0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f,
+    0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37,
+};
+
+static const size_t iv_len [NB_TESTS] = { 7, 8,  12 };
+static const size_t add_len[NB_TESTS] = { 8, 16, 20 };
+static const size_t msg_len[NB_TESTS] = { 4, 16, 24 };
+static const size_t tag_len[NB_TESTS] = { 4, 6,  8  };
+
+static const unsigned char res[NB_TESTS][32] = {
+    {   0x71, 0x62, 0x01, 0x5b, 0x4d, 0xac, 0x25, 0x5d },
+    {   0xd2, 0xa1, 0xf0, 0xe0, 0x51, 0xea, 0x5f, 0x62,
+        0x08, 0x1a, 0x77, 0x92, 0x07, 0x3d, 0x59, 0x3d,
+        0x1f, 0xc6, 0x4f, 0xbf, 0xac, 0xcd },
+    {   0xe3, 0xb2, 0x01, 0xa9, 0xf5, 0xb7, 0x1a, 0x7a,
+        0x9b, 0x1c, 0xea, 0xec, 0xcd, 0x97, 0xe7, 0x0b,
+        0x61, 0x76, 0xaa, 0xd9, 0xa4, 0x42, 0x8a, 0xa5,
+        0x48, 0x43, 0x92, 0xfb, 0xc1, 0xb0, 0x99, 0x51 }
+};
+
+int mbedtls_ccm_self_test( int verbose )
+{
+    mbedtls_ccm_context ctx;
+    unsigned char out[32];
+    size_t i;
+    int ret;
+
+    mbedtls_ccm_init( &ctx );
+
+    if( mbedtls_ccm_setkey( &ctx, MBEDTLS_CIPHER_ID_AES, key, 8 * sizeof key ) != 0 )
+    {
+        if( verbose != 0 )
+            mbedtls_printf( "  CCM: setup failed" );
+
+        mbedtls_ccm_free( &ctx );
+        return( 1 );
+    }
+
+    for( i = 0; i < NB_TESTS; i++ )
+    {
+        if( verbose != 0 )
+            mbedtls_printf( "  CCM-AES #%u: ", (unsigned int) i + 1 );
+
+        ret = mbedtls_ccm_encrypt_and_tag( &ctx, msg_len[i],
+                                   iv, iv_len[i], ad, add_len[i],
+                                   msg, out,
+                                   out + msg_len[i], tag_len[i] );
+
+        if( ret != 0 ||
+            memcmp( out, res[i], msg_len[i] + tag_len[i] ) != 0 )
+        {
+            if( verbose != 0 )
+                mbedtls_printf( "failed\n" );
+
+            mbedtls_ccm_free( &ctx );
+            return( 1 );
+        }
+
+        ret = mbedtls_ccm_auth_decrypt( &ctx, msg_len[i],
+                                iv, iv_len[i], ad, add_len[i],
+                                res[i], out,
+                                res[i] + msg_len[i], tag_len[i] );
+
+        if( ret != 0 ||
+            memcmp( out, msg, msg_len[i] ) != 0 )
+        {
+            if( verbose != 0 )
+                mbedtls_printf( "failed\n" );
+
+            mbedtls_ccm_free( &ctx );
+            return( 1 );
+        }
+
+        if( verbose != 0 )
+            mbedtls_printf( "passed\n" );
+    }
+
+    mbedtls_ccm_free( &ctx );
+
+    if( verbose != 0 )
+        mbedtls_printf( "\n" );
+
+    return( 0 );
+}
+
+#endif /* MBEDTLS_SELF_TEST && MBEDTLS_AES_C */
+
+#endif /* MBEDTLS_CCM_C */
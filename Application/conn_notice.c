@@ -0,0 +1,96 @@
+#include "conn_notice.h"
+
+#include <string.h>
+#include <ti/sysbios/knl/Task.h>
+
+#include "hci.h"
+
+/*
+ * Shares the connection event notice of a link between the modules that retry on it.
+ *
+ * The stack reports the end of a link's connection events to one entity with one event,
+ * and the att_queue and the bulk channel both wait for it when the stack had no buffer
+ * for them. Each used to switch the notice off once it had nothing left, even while the
+ * other still waited for it. Now every user holds its bit of the link, and the notice is
+ * switched off when the last one lets go.
+ */
+
+typedef struct conn_notice_link {
+    uint16_t connHandle;
+    uint8_t users;          // conn_notice_user_t bits that hold the notice, 0 if free
+} conn_notice_link_t;
+
+static conn_notice_link_t links[CONN_NOTICE_LINKS];
+static uint8_t noticeEntity;
+static uint16_t noticeEvent;
+
+static conn_notice_link_t *find_link(uint16_t connHandle) {
+    uint8_t i;
+
+    for (i = 0; i < CONN_NOTICE_LINKS; i++) {
+        if ((links[i].users != 0) && (links[i].connHandle == connHandle)) {
+            return &links[i];
+        }
+    }
+    return NULL;
+}
+
+void conn_notice_init(uint8_t entity, uint16_t event) {
+    noticeEntity = entity;
+    noticeEvent = event;
+    memset(links, 0, sizeof(links));
+}
+
+bool conn_notice_request(uint16_t connHandle, uint8_t user) {
+    conn_notice_link_t *link = find_link(connHandle);
+    UInt taskKey;
+    uint8_t i;
+
+    if (link) {
+        taskKey = Task_disable();
+        link->users |= user;
+        Task_restore(taskKey);
+        return true;
+    }
+
+    for (i = 0; i < CONN_NOTICE_LINKS; i++) {
+        if (links[i].users == 0) {
+            link = &links[i];
+            break;
+        }
+    }
+    if ((!link) || (HCI_EXT_ConnEventNoticeCmd(connHandle, noticeEntity, noticeEvent) != SUCCESS)) {
+        return false;
+    }
+
+    taskKey = Task_disable();
+    link->connHandle = connHandle;
+    link->users = user;
+    Task_restore(taskKey);
+    return true;
+}
+
+void conn_notice_release(uint16_t connHandle, uint8_t user) {
+    conn_notice_link_t *link;
+    UInt taskKey;
+    uint8_t i;
+
+    for (i = 0; i < CONN_NOTICE_LINKS; i++) {
+        link = &links[i];
+        if ((link->users & user) &&
+            ((connHandle == INVALID_CONNHANDLE) || (link->connHandle == connHandle))) {
+            taskKey = Task_disable();
+            link->users &= ~user;
+            Task_restore(taskKey);
+            if (link->users == 0) {
+                HCI_EXT_ConnEventNoticeCmd(link->connHandle, noticeEntity, 0);
+            }
+        }
+    }
+}
+
+bool conn_notice_held(uint16_t connHandle, uint8_t user) {
+    conn_notice_link_t *link = find_link(connHandle);
+
+    return (link != NULL) && ((link->users & user) != 0);
+}
@@ -0,0 +1,47 @@
+#ifndef APPLICATION_CONN_NOTICE_H_
+#define APPLICATION_CONN_NOTICE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bcomdef.h"
+
+// Links that can have the notice at once
+#ifndef CONN_NOTICE_LINKS
+#ifdef MAX_NUM_BLE_CONNS
+#define CONN_NOTICE_LINKS MAX_NUM_BLE_CONNS
+#else
+#error "Define MAX_NUM_BLE_CONNS as in the stack's build_config.opt (or CONN_NOTICE_LINKS)"
+#endif
+#endif
+
+// Modules that retry at the end of a connection event, one bit each
+typedef enum conn_notice_user {
+    CONN_NOTICE_ATT_QUEUE = 0x01,
+    CONN_NOTICE_BULK_CHANNEL = 0x02
+} conn_notice_user_t;
+
+/*
+ * entity and event are what HCI_EXT_ConnEventNoticeCmd() reports the end of a
+ * connection event with, the application hands that event to every user.
+ */
+void conn_notice_init(uint8_t entity, uint16_t event);
+
+/*
+ * Asks for the end of connHandle's connection events on behalf of user.
+ * Returns false if the stack or the table of links refused.
+ */
+bool conn_notice_request(uint16_t connHandle, uint8_t user);
+
+/*
+ * user is done with connHandle, the notice stops once no user needs it.
+ * INVALID_CONNHANDLE releases every link.
+ */
+void conn_notice_release(uint16_t connHandle, uint8_t user);
+
+/*
+ * True while user has the notice of connHandle
+ */
+bool conn_notice_held(uint16_t connHandle, uint8_t user);
+
+#endif /* APPLICATION_CONN_NOTICE_H_ */
@@ -0,0 +1,357 @@
+#include "conn_policy.h"
+
+#include <string.h>
+#include <ti/sysbios/knl/Task.h>
+
+#include "bcomdef.h"
+#include "peripheral.h"
+#include "util.h"
+
+/*
+ * Connection parameter policy.
+ *
+ * The link used to run at a 10 ms interval without slave latency for as long as it was
+ * up, although it only carries traffic for the few seconds around a challenge. Now a
+ * transaction asks for the fast parameters when it starts, and the link falls back to a
+ * long interval with slave latency once nothing happened for CONN_POLICY_IDLE_TIMEOUT_MS.
+ * The timeout is the hysteresis: back to back challenges keep the link fast instead of
+ * renegotiating it for each one. Every request is answered by an update, a rejection or
+ * a timeout, and only then is the next one sent.
+ *
+ * The stats give the connected time per mode, the connection events the device had to
+ * listen to (the radio duty cycle) and how long a transaction waited for the fast link.
+ */
+
+static Clock_Struct policyClock;
+
+static bool isConnected = false;
+static bool isPending = false;
+static bool isSwitching = false;
+static bool needsRetry = false;
+static uint8_t currentMode = CONN_POLICY_MODE_IDLE;
+static uint8_t wantedMode = CONN_POLICY_MODE_IDLE;
+static uint8_t pendingMode = CONN_POLICY_MODE_IDLE;
+static uint8_t retries = 0;
+static uint16_t connInterval = 0;
+static uint16_t connLatency = 0;
+
+static UInt32 lastActivity;
+static UInt32 switchStart;
+static UInt32 retryAt;
+static UInt32 accountTick;
+static uint32_t eventRemainderUs = 0;
+
+static conn_policy_stats_t policyStats;
+
+static UInt32 ms_to_ticks(uint32_t ms) {
+    return (ms * 1000) / Clock_tickPeriod;
+}
+
+// Parameters in between, e.g. the central's defaults, count as idle but are replaced
+static bool is_fast(uint16_t interval, uint16_t latency) {
+    return (interval <= CONN_POLICY_FAST_MAX_INTERVAL) && (latency == CONN_POLICY_FAST_SLAVE_LATENCY);
+}
+
+static bool is_idle(uint16_t interval, uint16_t latency) {
+    return (interval >= CONN_POLICY_IDLE_MIN_INTERVAL) && (interval <= CONN_POLICY_IDLE_MAX_INTERVAL) &&
+           (latency == CONN_POLICY_IDLE_SLAVE_LATENCY);
+}
+
+// Books the time since the last call on the parameters that were in use
+static void account(UInt32 now) {
+    UInt32 elapsed = now - accountTick;
+    uint64_t elapsedUs;
+    uint32_t eventUs;
+    UInt taskKey = Task_disable();
+
+    if (isConnected && (connInterval != 0)) {
+        if (currentMode == CONN_POLICY_MODE_FAST) {
+            policyStats.fast_ticks += elapsed;
+        }
+        else {
+            policyStats.idle_ticks += elapsed;
+        }
+
+        // The device skips `latency` events after every one it listens to
+        eventUs = (uint32_t) connInterval * 1250 * (connLatency + 1);
+        elapsedUs = ((uint64_t) elapsed * Clock_tickPeriod) + eventRemainderUs;
+        policyStats.conn_events += (uint32_t) (elapsedUs / eventUs);
+        eventRemainderUs = (uint32_t) (elapsedUs % eventUs);
+    }
+    accountTick = now;
+    Task_restore(taskKey);
+}
+
+// Arms the clock for whichever comes first, the idle timeout or a retry
+static void schedule(UInt32 now) {
+    UInt32 wait = 0;
+    UInt32 left;
+    bool isDue = false;
+
+    if (isConnected && (wantedMode == CONN_POLICY_MODE_FAST)) {
+        left = ms_to_ticks(CONN_POLICY_IDLE_TIMEOUT_MS) - (now - lastActivity);
+        if ((int32_t) left < 0) {
+            left = 0;
+        }
+        wait = left;
+        isDue = true;
+    }
+    if (isConnected && needsRetry) {
+        left = retryAt - now;
+        if ((int32_t) left < 0) {
+            left = 0;
+        }
+        if ((!isDue) || (left < wait)) {
+            wait = left;
+        }
+        isDue = true;
+    }
+
+    if (!isDue) {
+        Util_stopClock(&policyClock);
+        return;
+    }
+    // A zero timeout would never fire
+    Util_restartClock(&policyClock, ((wait * Clock_tickPeriod) / 1000) + 1);
+}
+
+static void retry_later(UInt32 now) {
+    if (retries >= CONN_POLICY_MAX_RETRIES) {
+        needsRetry = false;
+        return;
+    }
+    retries++;
+    needsRetry = true;
+    retryAt = now + ms_to_ticks(CONN_POLICY_RETRY_MS);
+}
+
+static void request(uint8_t mode, UInt32 now) {
+    bStatus_t status;
+
+    needsRetry = false;
+    if ((!isConnected) || isPending) {
+        // Sent once the outstanding request is answered
+        return;
+    }
+
+    if (mode == CONN_POLICY_MODE_FAST) {
+        status = GAPRole_SendUpdateParam(CONN_POLICY_FAST_MIN_INTERVAL, CONN_POLICY_FAST_MAX_INTERVAL,
+                                         CONN_POLICY_FAST_SLAVE_LATENCY, CONN_POLICY_CONN_TIMEOUT,
+                                         GAPROLE_NO_ACTION);
+    }
+    else {
+        status = GAPRole_SendUpdateParam(CONN_POLICY_IDLE_MIN_INTERVAL, CONN_POLICY_IDLE_MAX_INTERVAL,
+                                         CONN_POLICY_IDLE_SLAVE_LATENCY, CONN_POLICY_CONN_TIMEOUT,
+                                         GAPROLE_NO_ACTION);
+    }
+
+    switch (status) {
+        case SUCCESS:
+            isPending = true;
+            pendingMode = mode;
+            policyStats.requests++;
+            break;
+        case bleInvalidRange:
+            // The link already runs on parameters inside the requested range
+            currentMode = mode;
+            isSwitching = false;
+            break;
+        default:
+            policyStats.send_errors++;
+            retry_later(now);
+            break;
+    }
+}
+
+// Called once a request is answered or the central changed the parameters by itself
+static void follow_up(bool wasPending, UInt32 now) {
+    bool isMet;
+
+    if (wantedMode == CONN_POLICY_MODE_FAST) {
+        isMet = (currentMode == CONN_POLICY_MODE_FAST);
+    }
+    else {
+        isMet = is_idle(connInterval, connLatency);
+    }
+
+    if (isMet) {
+        needsRetry = false;
+    }
+    else if (wasPending && (pendingMode != wantedMode)) {
+        // That was the answer to the previous mode, ask for the current one right away
+        request(wantedMode, now);
+    }
+    else {
+        retry_later(now);
+    }
+}
+
+void conn_policy_init(Clock_FuncPtr clockHandler, UArg arg) {
+    Util_constructClock(&policyClock, clockHandler, CONN_POLICY_IDLE_TIMEOUT_MS, 0, false, arg);
+    accountTick = Clock_getTicks();
+}
+
+void conn_policy_connected(uint16_t interval, uint16_t latency) {
+    UInt32 now = Clock_getTicks();
+
+    account(now);
+    isConnected = true;
+    isPending = false;
+    isSwitching = false;
+    needsRetry = false;
+    retries = 0;
+    connInterval = interval;
+    connLatency = latency;
+    eventRemainderUs = 0;
+    currentMode = is_fast(interval, latency) ? CONN_POLICY_MODE_FAST : CONN_POLICY_MODE_IDLE;
+    // The GAP Role asks for the idle parameters by itself a few seconds into the connection
+    wantedMode = CONN_POLICY_MODE_IDLE;
+    schedule(now);
+}
+
+void conn_policy_disconnected() {
+    account(Clock_getTicks());
+    isConnected = false;
+    isPending = false;
+    isSwitching = false;
+    needsRetry = false;
+    wantedMode = CONN_POLICY_MODE_IDLE;
+    connInterval = 0;
+    connLatency = 0;
+    Util_stopClock(&policyClock);
+}
+
+void conn_policy_activity(conn_policy_reason_t reason) {
+    UInt32 now = Clock_getTicks();
+
+    if (reason < CONN_POLICY_REASONS) {
+        policyStats.activities[reason]++;
+    }
+    if (!isConnected) {
+        return;
+    }
+
+    lastActivity = now;
+    if (wantedMode != CONN_POLICY_MODE_FAST) {
+        wantedMode = CONN_POLICY_MODE_FAST;
+        retries = 0;
+        if (currentMode != CONN_POLICY_MODE_FAST) {
+            switchStart = now;
+            isSwitching = true;
+            request(CONN_POLICY_MODE_FAST, now);
+        }
+        else if (isPending && (pendingMode != CONN_POLICY_MODE_FAST)) {
+            // Still fast, but the idle parameters are on the way and the fast ones come after
+            switchStart = now;
+            isSwitching = true;
+        }
+    }
+    schedule(now);
+}
+
+void conn_policy_process() {
+    UInt32 now = Clock_getTicks();
+
+    if (!isConnected) {
+        return;
+    }
+
+    // Activity after the clock fired pushed the timeout further out
+    if ((wantedMode == CONN_POLICY_MODE_FAST) &&
+        ((now - lastActivity) >= ms_to_ticks(CONN_POLICY_IDLE_TIMEOUT_MS))) {
+        wantedMode = CONN_POLICY_MODE_IDLE;
+        retries = 0;
+        isSwitching = false;
+        request(CONN_POLICY_MODE_IDLE, now);
+    }
+    else if (needsRetry && ((int32_t) (now - retryAt) >= 0)) {
+        request(wantedMode, now);
+    }
+    schedule(now);
+}
+
+void conn_policy_param_updated(uint16_t interval, uint16_t latency) {
+    UInt32 now = Clock_getTicks();
+    UInt32 ticks;
+    UInt taskKey;
+    bool wasPending;
+
+    account(now);
+    connInterval = interval;
+    connLatency = latency;
+    // Events on the new parameters count from the update, not from the last old one
+    eventRemainderUs = 0;
+    // The stack stops waiting for an answer on any update, the central may pick other values
+    wasPending = isPending;
+    isPending = false;
+
+    if (is_fast(interval, latency)) {
+        currentMode = CONN_POLICY_MODE_FAST;
+    }
+    else {
+        currentMode = CONN_POLICY_MODE_IDLE;
+    }
+
+    taskKey = Task_disable();
+    policyStats.updates++;
+    if ((currentMode == CONN_POLICY_MODE_FAST) && isSwitching) {
+        ticks = now - switchStart;
+        policyStats.last_switch_ticks = ticks;
+        if (ticks > policyStats.max_switch_ticks) {
+            policyStats.max_switch_ticks = ticks;
+        }
+        isSwitching = false;
+    }
+    Task_restore(taskKey);
+
+    follow_up(wasPending, now);
+    schedule(now);
+}
+
+void conn_policy_param_update_failed(bool rejected) {
+    UInt32 now = Clock_getTicks();
+    bool wasPending = isPending;
+
+    isPending = false;
+    if (rejected) {
+        policyStats.rejections++;
+    }
+    else {
+        policyStats.timeouts++;
+    }
+
+    if (!isConnected) {
+        return;
+    }
+    follow_up(wasPending, now);
+    schedule(now);
+}
+
+void conn_policy_get_stats(conn_policy_stats_t *stats) {
+    UInt taskKey;
+
+    if (!stats) {
+        return;
+    }
+
+    account(Clock_getTicks());
+
+    taskKey = Task_disable();
+    memcpy(stats, &policyStats, sizeof(conn_policy_stats_t));
+    stats->interval = connInterval;
+    stats->latency = connLatency;
+    stats->wake_latency_us = isConnected ? ((uint32_t) connInterval * 1250 * (connLatency + 1)) : 0;
+    stats->mode = currentMode;
+    stats->wanted = wantedMode;
+    stats->pending = isPending;
+    stats->tick_period_us = Clock_tickPeriod;
+    Task_restore(taskKey);
+}
+
+void conn_policy_reset_stats() {
+    UInt taskKey = Task_disable();
+    memset(&policyStats, 0, sizeof(conn_policy_stats_t));
+    accountTick = Clock_getTicks();
+    eventRemainderUs = 0;
+    Task_restore(taskKey);
+}
@@ -0,0 +1,101 @@
+#ifndef APPLICATION_CONN_POLICY_H_
+#define APPLICATION_CONN_POLICY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <ti/sysbios/knl/Clock.h>
+
+// Parameters while a transaction is running (units of 1.25ms, 8=10ms)
+#define CONN_POLICY_FAST_MIN_INTERVAL 8
+#define CONN_POLICY_FAST_MAX_INTERVAL 12
+#define CONN_POLICY_FAST_SLAVE_LATENCY 0
+
+// Parameters of an idle link (units of 1.25ms, 80=100ms). With the slave latency the
+// device only has to listen every 0.5 to 1 seconds.
+#define CONN_POLICY_IDLE_MIN_INTERVAL 80
+#define CONN_POLICY_IDLE_MAX_INTERVAL 160
+#define CONN_POLICY_IDLE_SLAVE_LATENCY 4
+
+// Supervision timeout (units of 10ms), must stay above 2 * (1 + latency) * max interval
+#define CONN_POLICY_CONN_TIMEOUT 1000
+
+// The link stays fast for this long after the last activity, so a response read or the
+// next challenge right after one does not pay for another parameter update
+#ifndef CONN_POLICY_IDLE_TIMEOUT_MS
+#define CONN_POLICY_IDLE_TIMEOUT_MS 3000
+#endif
+
+// A rejected or timed out request is retried after this long, at most
+// CONN_POLICY_MAX_RETRIES times until the wanted parameters change again
+#ifndef CONN_POLICY_RETRY_MS
+#define CONN_POLICY_RETRY_MS 5000
+#endif
+#define CONN_POLICY_MAX_RETRIES 3
+
+typedef enum conn_policy_reason {
+    CONN_POLICY_SIGN = 0,  // A challenge was written
+    CONN_POLICY_BATCH,     // Several challenges are being signed back to back
+    CONN_POLICY_OAD,       // An image block was written
+    CONN_POLICY_REASONS
+} conn_policy_reason_t;
+
+typedef enum conn_policy_mode {
+    CONN_POLICY_MODE_IDLE = 0,
+    CONN_POLICY_MODE_FAST
+} conn_policy_mode_t;
+
+typedef struct conn_policy_stats {
+    uint32_t activities[CONN_POLICY_REASONS];  // conn_policy_activity() calls per reason
+    uint32_t requests;          // Requests sent with GAPRole_SendUpdateParam()
+    uint32_t send_errors;       // Requests the stack refused to send
+    uint32_t rejections;        // Requests the central rejected
+    uint32_t timeouts;          // Requests that were neither rejected nor applied in time
+    uint32_t updates;           // Parameter changes reported by the stack
+    uint32_t fast_ticks;        // Connected time on the fast parameters
+    uint32_t idle_ticks;        // Connected time on any other parameters
+    uint32_t conn_events;       // Connection events the device had to listen to
+    uint32_t last_switch_ticks; // From the activity to the fast parameters being applied
+    uint32_t max_switch_ticks;
+    uint32_t wake_latency_us;   // Worst case until a central write is heard on the current parameters
+    uint16_t interval;          // Current connection interval, units of 1.25ms
+    uint16_t latency;           // Current slave latency
+    uint8_t  mode;              // conn_policy_mode_t the current parameters match
+    uint8_t  wanted;            // conn_policy_mode_t the policy asks for
+    uint8_t  pending;           // A request is waiting for an answer
+    uint32_t tick_period_us;    // Length of one Clock tick
+} conn_policy_stats_t;
+
+/*
+ * Sets up the idle timer. clockHandler(arg) is called from the Clock Swi when
+ * conn_policy_process() has to run, the same way the application's other clocks work.
+ */
+void conn_policy_init(Clock_FuncPtr clockHandler, UArg arg);
+
+/*
+ * The link came up with the given parameters (units of 1.25ms).
+ */
+void conn_policy_connected(uint16_t interval, uint16_t latency);
+void conn_policy_disconnected();
+
+/*
+ * A transaction needs the link. Asks for the fast parameters if the link is not on them
+ * already and restarts the idle timer.
+ */
+void conn_policy_activity(conn_policy_reason_t reason);
+
+/*
+ * Runs the idle timer and the retries, call it from the application task
+ * when the clock handler fired.
+ */
+void conn_policy_process();
+
+/*
+ * Forward the GAP Role parameter callbacks here, from the application task.
+ */
+void conn_policy_param_updated(uint16_t interval, uint16_t latency);
+void conn_policy_param_update_failed(bool rejected);
+
+void conn_policy_get_stats(conn_policy_stats_t *stats);
+void conn_policy_reset_stats();
+
+#endif /* APPLICATION_CONN_POLICY_H_ */
@@ -0,0 +1,180 @@
+#include "crypto_arena.h"
+
+#include <string.h>
+#include <stdbool.h>
+#include <ti/sysbios/knl/Task.h>
+
+/*
+ * A heap of its own for mbedTLS.
+ *
+ * The big numbers of a signature came from the same heap as the BLE stack's messages,
+ * and after a while of connections coming and going there was no hole left that fit
+ * them, so a sign failed with an allocation error while plenty of memory was free.
+ * The crypto now allocates from a static arena nothing else touches. Blocks carry a
+ * header with their size and the size of the block before them, so a freed block
+ * merges with free neighbours on both sides and the arena is whole again after every
+ * signature. The arena is small and holds a handful of blocks, a first fit walk is
+ * all it needs.
+ */
+
+#define ARENA_ALIGN     CRYPTO_ARENA_ALIGN
+#define ARENA_USED      0x0001
+
+typedef struct arena_block {
+    uint16_t size;      // Whole block, header included, ARENA_USED in the low bit
+    uint16_t prevSize;  // Size of the block before it, 0 for the first one
+} arena_block_t;
+
+// Rounded up so the memory after it stays aligned
+#define ARENA_HDR       (((sizeof(arena_block_t) + ARENA_ALIGN - 1) / ARENA_ALIGN) * ARENA_ALIGN)
+// Splitting off less than this would leave a block nothing fits in
+#define ARENA_MIN_SPLIT (ARENA_HDR + 4 * ARENA_ALIGN)
+#define ARENA_BYTES     ((CRYPTO_ARENA_SIZE / ARENA_ALIGN) * ARENA_ALIGN)
+
+static uint64_t arena[(ARENA_BYTES + sizeof(uint64_t) - 1) / sizeof(uint64_t)];
+static bool isInitialized = false;
+
+static crypto_arena_stats_t arenaStats;
+
+static uint16_t block_size(const arena_block_t *block) {
+    return block->size & ~ARENA_USED;
+}
+
+static arena_block_t *next_block(arena_block_t *block) {
+    uint8_t *next = (uint8_t *) block + block_size(block);
+
+    return (next < (uint8_t *) arena + ARENA_BYTES) ? (arena_block_t *) next : NULL;
+}
+
+static arena_block_t *prev_block(arena_block_t *block) {
+    return block->prevSize ? (arena_block_t *) ((uint8_t *) block - block->prevSize) : NULL;
+}
+
+static void arena_init() {
+    arena_block_t *first = (arena_block_t *) arena;
+
+    first->size = ARENA_BYTES;
+    first->prevSize = 0;
+    arenaStats.size = ARENA_BYTES;
+    isInitialized = true;
+}
+
+void *crypto_arena_calloc(size_t n, size_t size) {
+    arena_block_t *block;
+    arena_block_t *rest;
+    arena_block_t *next;
+    uint32_t need;
+    void *ptr = NULL;
+    UInt taskKey;
+
+    if ((n == 0) || (size == 0) || (n > ARENA_BYTES / size)) {
+        return NULL;
+    }
+    need = ((n * size + ARENA_ALIGN - 1) / ARENA_ALIGN) * ARENA_ALIGN + ARENA_HDR;
+
+    taskKey = Task_disable();
+    if (!isInitialized) {
+        arena_init();
+    }
+
+    for (block = (arena_block_t *) arena; block; block = next_block(block)) {
+        if ((block->size & ARENA_USED) || (block->size < need)) {
+            continue;
+        }
+
+        if (block->size - need >= ARENA_MIN_SPLIT) {
+            rest = (arena_block_t *) ((uint8_t *) block + need);
+            rest->size = block->size - need;
+            rest->prevSize = need;
+            next = next_block(rest);
+            if (next) {
+                next->prevSize = rest->size;
+            }
+            block->size = need;
+        }
+        block->size |= ARENA_USED;
+
+        arenaStats.used += block_size(block);
+        if (arenaStats.used > arenaStats.peak) {
+            arenaStats.peak = arenaStats.used;
+        }
+        arenaStats.allocs++;
+        ptr = (uint8_t *) block + ARENA_HDR;
+        break;
+    }
+
+    if (!ptr) {
+        arenaStats.failures++;
+    }
+    Task_restore(taskKey);
+
+    if (ptr) {
+        memset(ptr, 0, n * size);
+    }
+    return ptr;
+}
+
+void crypto_arena_free(void *ptr) {
+    arena_block_t *block;
+    arena_block_t *other;
+    UInt taskKey;
+
+    if (!ptr) {
+        return;
+    }
+
+    block = (arena_block_t *) ((uint8_t *) ptr - ARENA_HDR);
+
+    taskKey = Task_disable();
+    arenaStats.used -= block_size(block);
+    arenaStats.frees++;
+    block->size &= ~ARENA_USED;
+
+    // Swallow a free block after it
+    other = next_block(block);
+    if (other && (!(other->size & ARENA_USED))) {
+        block->size += other->size;
+    }
+
+    // And be swallowed by a free block before it
+    other = prev_block(block);
+    if (other && (!(other->size & ARENA_USED))) {
+        other->size += block->size;
+        block = other;
+    }
+
+    other = next_block(block);
+    if (other) {
+        other->prevSize = block->size;
+    }
+    Task_restore(taskKey);
+}
+
+void crypto_arena_reset_peak() {
+    UInt taskKey = Task_disable();
+    arenaStats.peak = arenaStats.used;
+    Task_restore(taskKey);
+}
+
+void crypto_arena_get_stats(crypto_arena_stats_t *stats) {
+    arena_block_t *block;
+    UInt taskKey;
+
+    if (!stats) {
+        return;
+    }
+
+    taskKey = Task_disable();
+    if (!isInitialized) {
+        arena_init();
+    }
+
+    arenaStats.largest_free = 0;
+    for (block = (arena_block_t *) arena; block; block = next_block(block)) {
+        if ((!(block->size & ARENA_USED)) && (block->size - ARENA_HDR > arenaStats.largest_free)) {
+            arenaStats.largest_free = block->size - ARENA_HDR;
+        }
+    }
+    memcpy(stats, &arenaStats, sizeof(crypto_arena_stats_t));
+    Task_restore(taskKey);
+}
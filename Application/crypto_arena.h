@@ -0,0 +1,42 @@
+#ifndef APPLICATION_CRYPTO_ARENA_H_
+#define APPLICATION_CRYPTO_ARENA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Bytes set aside for mbedTLS and the signature buffer of the application, a
+// signature peaked at about 4.6 KB on the host, the buffer adds MBEDTLS_MPI_MAX_SIZE
+#ifndef CRYPTO_ARENA_SIZE
+#define CRYPTO_ARENA_SIZE 5632
+#endif
+
+// Alignment of the blocks, a word is all the Cortex-M3 needs. A 64 bit host build of
+// mbedTLS needs 8.
+#ifndef CRYPTO_ARENA_ALIGN
+#define CRYPTO_ARENA_ALIGN 4
+#endif
+
+typedef struct crypto_arena_stats {
+    uint16_t size;           // Bytes the arena can hand out, headers included
+    uint16_t used;           // Bytes handed out right now, headers included
+    uint16_t peak;           // Most used since boot or crypto_arena_reset_peak()
+    uint16_t largest_free;   // Biggest block a request could still get
+    uint32_t allocs;
+    uint32_t frees;
+    uint32_t failures;       // Requests nothing was left for
+} crypto_arena_stats_t;
+
+/*
+ * mbedtls_calloc() and mbedtls_free(), see MBEDTLS_PLATFORM_CALLOC_MACRO in config.h
+ */
+void *crypto_arena_calloc(size_t n, size_t size);
+void crypto_arena_free(void *ptr);
+
+/*
+ * Starts the peak over from what is in use now, so it covers the next operation only
+ */
+void crypto_arena_reset_peak();
+
+void crypto_arena_get_stats(crypto_arena_stats_t *stats);
+
+#endif /* APPLICATION_CRYPTO_ARENA_H_ */
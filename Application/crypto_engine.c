@@ -0,0 +1,220 @@
+#include "crypto_engine.h"
+
+#include <string.h>
+#include <stdbool.h>
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Semaphore.h>
+
+#include "Board.h"
+#include "trace.h"
+
+/*
+ * One CryptoCC26XX handle shared by every AES context.
+ *
+ * Opening and closing the driver sets up and tears down the power dependency on the
+ * crypto domain, and the DRBG, PEM decryption and AES_encrypt() each used to do that for
+ * a couple of blocks. The handle is now opened once and jobs are serialized with a
+ * binary semaphore.
+ */
+
+static CryptoCC26XX_Handle engineHandle = NULL;
+static bool isEngineInitialized = false;
+static uint16_t engineUsers = 0;
+
+static Semaphore_Struct engineLockStruct;
+static Semaphore_Handle engineLock;
+
+static crypto_engine_stats_t engineStats;
+
+static void crypto_engine_init() {
+    Semaphore_Params lockParams;
+
+    if (isEngineInitialized) {
+        return;
+    }
+
+    CryptoCC26XX_init();
+
+    Semaphore_Params_init(&lockParams);
+    lockParams.mode = Semaphore_Mode_BINARY;
+    Semaphore_construct(&engineLockStruct, 1, &lockParams);
+    engineLock = Semaphore_handle(&engineLockStruct);
+
+    isEngineInitialized = true;
+}
+
+CryptoCC26XX_Handle crypto_engine_acquire() {
+    CryptoCC26XX_Handle handle;
+    UInt taskKey = Task_disable();
+
+    crypto_engine_init();
+    if (!engineHandle) {
+        engineHandle = CryptoCC26XX_open(Board_CRYPTO0, false, NULL);
+        if (engineHandle) {
+            engineStats.opens++;
+        }
+    }
+    if (engineHandle) {
+        engineUsers++;
+        engineStats.acquires++;
+    }
+    handle = engineHandle;
+    Task_restore(taskKey);
+
+    if (!handle) {
+        TRACE(TRACE_CRYPTO_OPEN_FAILED);
+    }
+    return handle;
+}
+
+void crypto_engine_release() {
+    UInt taskKey = Task_disable();
+    if (engineUsers > 0) {
+        engineUsers--;
+        engineStats.releases++;
+    }
+    Task_restore(taskKey);
+}
+
+void crypto_engine_shutdown() {
+    UInt taskKey;
+
+    if (!isEngineInitialized) {
+        return;
+    }
+
+    // Wait for a running job before closing under it
+    Semaphore_pend(engineLock, BIOS_WAIT_FOREVER);
+    taskKey = Task_disable();
+    if (engineHandle && (engineUsers == 0)) {
+        CryptoCC26XX_close(engineHandle);
+        engineHandle = NULL;
+        engineStats.closes++;
+    }
+    Task_restore(taskKey);
+    Semaphore_post(engineLock);
+}
+
+crypto_engine_mode_t crypto_engine_mode_for_length(size_t len) {
+    if (len <= CRYPTO_ENGINE_POLLING_MAX_BYTES) {
+        return crypto_engine_polling;
+    }
+    return crypto_engine_blocking;
+}
+
+void crypto_engine_lock() {
+    UInt taskKey = Task_disable();
+    crypto_engine_init();
+    Task_restore(taskKey);
+
+    Semaphore_pend(engineLock, BIOS_WAIT_FOREVER);
+}
+
+void crypto_engine_unlock() {
+    Semaphore_post(engineLock);
+}
+
+// Unsigned subtraction handles the tick counter wrapping
+static void record_job(crypto_engine_mode_t mode, int status,
+                       UInt32 waitStart, UInt32 jobStart, UInt32 jobEnd) {
+    UInt taskKey = Task_disable();
+    if (mode == crypto_engine_polling) {
+        engineStats.polling_jobs++;
+    }
+    else {
+        engineStats.blocking_jobs++;
+    }
+    if (status != CRYPTOCC26XX_STATUS_SUCCESS) {
+        engineStats.failed_jobs++;
+    }
+    engineStats.job_ticks_total += jobEnd - jobStart;
+    if ((jobEnd - jobStart) > engineStats.job_ticks_max) {
+        engineStats.job_ticks_max = jobEnd - jobStart;
+    }
+    engineStats.wait_ticks_total += jobStart - waitStart;
+    if ((jobStart - waitStart) > engineStats.wait_ticks_max) {
+        engineStats.wait_ticks_max = jobStart - waitStart;
+    }
+    Task_restore(taskKey);
+}
+
+int crypto_engine_transact(CryptoCC26XX_Transaction *trans, crypto_engine_mode_t mode) {
+    int status;
+    UInt32 waitStart, jobStart, jobEnd;
+
+    if ((!trans) || (!engineHandle)) {
+        return CRYPTOCC26XX_STATUS_ERROR;
+    }
+
+    waitStart = Clock_getTicks();
+    Semaphore_pend(engineLock, BIOS_WAIT_FOREVER);
+    jobStart = Clock_getTicks();
+
+    if (mode == crypto_engine_polling) {
+        status = CryptoCC26XX_transactPolling(engineHandle, trans);
+    }
+    else {
+        status = CryptoCC26XX_transact(engineHandle, trans);
+    }
+
+    jobEnd = Clock_getTicks();
+    Semaphore_post(engineLock);
+
+    record_job(mode, status, waitStart, jobStart, jobEnd);
+    return status;
+}
+
+int crypto_engine_transact_ecb(CryptoCC26XX_AESECB_Transaction *trans,
+                               const unsigned char *input, unsigned char *output,
+                               size_t blocks) {
+    int status = CRYPTOCC26XX_STATUS_SUCCESS;
+    UInt32 waitStart, jobStart, jobEnd;
+    UInt taskKey;
+    size_t i;
+
+    if ((!trans) || (!engineHandle)) {
+        return CRYPTOCC26XX_STATUS_ERROR;
+    }
+
+    waitStart = Clock_getTicks();
+    Semaphore_pend(engineLock, BIOS_WAIT_FOREVER);
+    jobStart = Clock_getTicks();
+
+    // The engine takes one block per ECB operation, keep it for the whole run
+    for (i = 0; (i < blocks) && (status == CRYPTOCC26XX_STATUS_SUCCESS); i++) {
+        trans->msgIn  = (uint32_t *) (input + (i * 16));
+        trans->msgOut = (uint32_t *) (output + (i * 16));
+        status = CryptoCC26XX_transactPolling(engineHandle, (CryptoCC26XX_Transaction *) trans);
+    }
+
+    jobEnd = Clock_getTicks();
+    Semaphore_post(engineLock);
+
+    record_job(crypto_engine_polling, status, waitStart, jobStart, jobEnd);
+    taskKey = Task_disable();
+    engineStats.ecb_blocks += i;
+    Task_restore(taskKey);
+    return status;
+}
+
+void crypto_engine_get_stats(crypto_engine_stats_t *stats) {
+    UInt taskKey;
+
+    if (!stats) {
+        return;
+    }
+
+    taskKey = Task_disable();
+    memcpy(stats, &engineStats, sizeof(crypto_engine_stats_t));
+    stats->users = engineUsers;
+    stats->tick_period_us = Clock_tickPeriod;
+    Task_restore(taskKey);
+}
+
+void crypto_engine_reset_stats() {
+    UInt taskKey = Task_disable();
+    memset(&engineStats, 0, sizeof(crypto_engine_stats_t));
+    Task_restore(taskKey);
+}
@@ -0,0 +1,79 @@
+#ifndef APPLICATION_CRYPTO_ENGINE_H_
+#define APPLICATION_CRYPTO_ENGINE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <ti/drivers/crypto/CryptoCC26XX.h>
+
+// Jobs up to this many bytes finish faster than a task switch, poll for them
+#ifndef CRYPTO_ENGINE_POLLING_MAX_BYTES
+#define CRYPTO_ENGINE_POLLING_MAX_BYTES 64
+#endif
+
+typedef enum crypto_engine_mode {
+    crypto_engine_polling = 0,  // Busy wait on the engine, for single blocks and short jobs
+    crypto_engine_blocking      // Pend until the engine interrupt completes the job
+} crypto_engine_mode_t;
+
+typedef struct crypto_engine_stats {
+    uint32_t opens;            // CryptoCC26XX_open calls, should stay at 1
+    uint32_t closes;           // CryptoCC26XX_close calls
+    uint32_t acquires;         // Users that attached to the shared handle
+    uint32_t releases;         // Users that detached from the shared handle
+    uint16_t users;            // Users currently attached
+    uint32_t polling_jobs;
+    uint32_t blocking_jobs;
+    uint32_t failed_jobs;
+    uint32_t ecb_blocks;       // Blocks run through crypto_engine_transact_ecb()
+    uint32_t job_ticks_total;  // Clock ticks spent inside CryptoCC26XX_transact*
+    uint32_t job_ticks_max;
+    uint32_t wait_ticks_total; // Clock ticks spent waiting for another job to finish
+    uint32_t wait_ticks_max;
+    uint32_t tick_period_us;   // Length of one Clock tick
+} crypto_engine_stats_t;
+
+/*
+ * Attaches to the process wide crypto handle, opening it on first use.
+ * Returns NULL if the driver could not be opened.
+ */
+CryptoCC26XX_Handle crypto_engine_acquire();
+
+/*
+ * Detaches from the shared handle. The handle stays open for the next user.
+ */
+void crypto_engine_release();
+
+/*
+ * Closes the shared handle if nobody is attached, e.g. before a long sleep.
+ */
+void crypto_engine_shutdown();
+
+/*
+ * Runs a transaction on the shared handle. Only one job runs at a time.
+ */
+int crypto_engine_transact(CryptoCC26XX_Transaction *trans, crypto_engine_mode_t mode);
+
+/*
+ * Runs an ECB transaction over consecutive 16 byte blocks as one polled job,
+ * so the lock is taken once instead of once per block. input may equal output.
+ */
+int crypto_engine_transact_ecb(CryptoCC26XX_AESECB_Transaction *trans,
+                               const unsigned char *input, unsigned char *output,
+                               size_t blocks);
+
+/*
+ * Picks polling for short jobs and blocking mode for long ones
+ */
+crypto_engine_mode_t crypto_engine_mode_for_length(size_t len);
+
+/*
+ * Serializes driver calls that are not transactions, like key loading.
+ * Must not be held around crypto_engine_transact().
+ */
+void crypto_engine_lock();
+void crypto_engine_unlock();
+
+void crypto_engine_get_stats(crypto_engine_stats_t *stats);
+void crypto_engine_reset_stats();
+
+#endif /* APPLICATION_CRYPTO_ENGINE_H_ */
@@ -35,7 +35,8 @@
 #include "mbedtls/ctr_drbg.h"
 
 #include <string.h>
-#include <stdlib.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Clock.h>
 
 #if defined(MBEDTLS_FS_IO)
 #include <stdio.h>
@@ -55,6 +56,8 @@ static void mbedtls_zeroize( void *v, size_t n ) {
     volatile unsigned char *p = v; while( n-- ) *p++ = 0;
 }
 
+static mbedtls_ctr_drbg_stats ctr_drbg_stats;
+
 /*
  * CTR_DRBG context initialization
  */
@@ -140,104 +143,199 @@ void mbedtls_ctr_drbg_set_reseed_interval( mbedtls_ctr_drbg_context *ctx, int in
     ctx->reseed_interval = interval;
 }
 
-static int block_cipher_df( unsigned char *output,
-                            const unsigned char *data, size_t data_len )
+/*
+ * Run consecutive blocks through the engine as one job
+ */
+static int ctr_drbg_crypt_blocks( mbedtls_aes_context *aes_ctx, size_t blocks,
+                                  const unsigned char *input, unsigned char *output )
 {
-    unsigned char buf[MBEDTLS_CTR_DRBG_MAX_SEED_INPUT + MBEDTLS_CTR_DRBG_BLOCKSIZE + 16];
-    unsigned char tmp[MBEDTLS_CTR_DRBG_SEEDLEN];
-    unsigned char key[MBEDTLS_CTR_DRBG_KEYSIZE];
-    unsigned char chain[MBEDTLS_CTR_DRBG_BLOCKSIZE];
-    unsigned char *p, *iv;
-    mbedtls_aes_context aes_ctx;
+#if defined(MBEDTLS_AES_ALT)
+    return( mbedtls_aes_crypt_ecb_blocks( aes_ctx, MBEDTLS_AES_ENCRYPT, blocks,
+                                          input, output ) );
+#else
+    int ret;
+    size_t i;
+
+    for( i = 0; i < blocks; i++ )
+        if( ( ret = mbedtls_aes_crypt_ecb( aes_ctx, MBEDTLS_AES_ENCRYPT,
+                            input + i * MBEDTLS_CTR_DRBG_BLOCKSIZE,
+                            output + i * MBEDTLS_CTR_DRBG_BLOCKSIZE ) ) != 0 )
+            return( ret );
+
+    return( 0 );
+#endif
+}
+
+/*
+ * Block_Cipher_df, fed incrementally so the seed material is never copied
+ * into one buffer. The CBC-MAC chains only differ in their IV block, so they
+ * run side by side and each input block costs one multi-block job.
+ */
+#define CTR_DRBG_DF_CHAINS  ( MBEDTLS_CTR_DRBG_SEEDLEN / MBEDTLS_CTR_DRBG_BLOCKSIZE )
+
+typedef struct
+{
+    mbedtls_aes_context aes_ctx;    /* fixed key 0, 1, 2, ... */
+    mbedtls_aes_context out_ctx;    /* key derived from the chains */
+    unsigned char chain[MBEDTLS_CTR_DRBG_SEEDLEN];
+    unsigned char block[MBEDTLS_CTR_DRBG_BLOCKSIZE];
+    size_t fill;
+}
+ctr_drbg_df_context;
 
+static int df_process_block( ctr_drbg_df_context *df )
+{
     int i, j;
-    size_t buf_len, use_len;
+
+    for( j = 0; j < CTR_DRBG_DF_CHAINS; j++ )
+        for( i = 0; i < MBEDTLS_CTR_DRBG_BLOCKSIZE; i++ )
+            df->chain[j * MBEDTLS_CTR_DRBG_BLOCKSIZE + i] ^= df->block[i];
+
+    df->fill = 0;
+
+    return( ctr_drbg_crypt_blocks( &df->aes_ctx, CTR_DRBG_DF_CHAINS,
+                                   df->chain, df->chain ) );
+}
+
+static int df_update( ctr_drbg_df_context *df,
+                      const unsigned char *data, size_t data_len )
+{
+    int ret;
+    size_t use_len;
+
+    while( data_len > 0 )
+    {
+        use_len = MBEDTLS_CTR_DRBG_BLOCKSIZE - df->fill;
+        if( use_len > data_len )
+            use_len = data_len;
+
+        memcpy( df->block + df->fill, data, use_len );
+        df->fill += use_len;
+        data += use_len;
+        data_len -= use_len;
+
+        if( df->fill == MBEDTLS_CTR_DRBG_BLOCKSIZE &&
+            ( ret = df_process_block( df ) ) != 0 )
+            return( ret );
+    }
+
+    return( 0 );
+}
+
+/*
+ * data_len is the total length of the data passed to df_update()
+ */
+static int df_start( ctr_drbg_df_context *df, size_t data_len )
+{
+    int ret, i;
+    unsigned char key[MBEDTLS_CTR_DRBG_KEYSIZE];
+    unsigned char header[8];
+
+    memset( df, 0, sizeof( ctr_drbg_df_context ) );
+    mbedtls_aes_init( &df->aes_ctx );
+    mbedtls_aes_init( &df->out_ctx );
 
     if( data_len > MBEDTLS_CTR_DRBG_MAX_SEED_INPUT )
         return( MBEDTLS_ERR_CTR_DRBG_INPUT_TOO_BIG );
 
-    memset( buf, 0, MBEDTLS_CTR_DRBG_MAX_SEED_INPUT + MBEDTLS_CTR_DRBG_BLOCKSIZE + 16 );
-    mbedtls_aes_init( &aes_ctx );
+    for( i = 0; i < MBEDTLS_CTR_DRBG_KEYSIZE; i++ )
+        key[i] = i;
+
+    if( ( ret = mbedtls_aes_setkey_enc( &df->aes_ctx, key,
+                                        MBEDTLS_CTR_DRBG_KEYBITS ) ) != 0 )
+        return( ret );
 
     /*
-     * Construct IV (16 bytes) and S in buffer
      * IV = Counter (in 32-bits) padded to 16 with zeroes
-     * S = Length input string (in 32-bits) || Length of output (in 32-bits) ||
-     *     data || 0x80
-     *     (Total is padded to a multiple of 16-bytes with zeroes)
+     * Each chain starts with the encryption of its own IV
      */
-    p = buf + MBEDTLS_CTR_DRBG_BLOCKSIZE;
-    *p++ = ( data_len >> 24 ) & 0xff;
-    *p++ = ( data_len >> 16 ) & 0xff;
-    *p++ = ( data_len >> 8  ) & 0xff;
-    *p++ = ( data_len       ) & 0xff;
-    p += 3;
-    *p++ = MBEDTLS_CTR_DRBG_SEEDLEN;
-    memcpy( p, data, data_len );
-    p[data_len] = 0x80;
-
-    buf_len = MBEDTLS_CTR_DRBG_BLOCKSIZE + 8 + data_len + 1;
-
-    for( i = 0; i < MBEDTLS_CTR_DRBG_KEYSIZE; i++ )
-        key[i] = i;
+    for( i = 0; i < CTR_DRBG_DF_CHAINS; i++ )
+        df->chain[i * MBEDTLS_CTR_DRBG_BLOCKSIZE + 3] = i;
 
-    mbedtls_aes_setkey_enc( &aes_ctx, key, MBEDTLS_CTR_DRBG_KEYBITS );
+    if( ( ret = ctr_drbg_crypt_blocks( &df->aes_ctx, CTR_DRBG_DF_CHAINS,
+                                       df->chain, df->chain ) ) != 0 )
+        return( ret );
 
     /*
-     * Reduce data to MBEDTLS_CTR_DRBG_SEEDLEN bytes of data
+     * S = Length input string (in 32-bits) || Length of output (in 32-bits) ||
+     *     data || 0x80
+     *     (Total is padded to a multiple of 16-bytes with zeroes)
      */
-    for( j = 0; j < MBEDTLS_CTR_DRBG_SEEDLEN; j += MBEDTLS_CTR_DRBG_BLOCKSIZE )
-    {
-        p = buf;
-        memset( chain, 0, MBEDTLS_CTR_DRBG_BLOCKSIZE );
-        use_len = buf_len;
-
-        while( use_len > 0 )
-        {
-            for( i = 0; i < MBEDTLS_CTR_DRBG_BLOCKSIZE; i++ )
-                chain[i] ^= p[i];
-            p += MBEDTLS_CTR_DRBG_BLOCKSIZE;
-            use_len -= ( use_len >= MBEDTLS_CTR_DRBG_BLOCKSIZE ) ?
-                       MBEDTLS_CTR_DRBG_BLOCKSIZE : use_len;
+    header[0] = ( data_len >> 24 ) & 0xff;
+    header[1] = ( data_len >> 16 ) & 0xff;
+    header[2] = ( data_len >> 8  ) & 0xff;
+    header[3] = ( data_len       ) & 0xff;
+    header[4] = 0;
+    header[5] = 0;
+    header[6] = 0;
+    header[7] = MBEDTLS_CTR_DRBG_SEEDLEN;
+
+    return( df_update( df, header, sizeof( header ) ) );
+}
 
-            mbedtls_aes_crypt_ecb( &aes_ctx, MBEDTLS_AES_ENCRYPT, chain, chain );
-        }
+static int df_finish( ctr_drbg_df_context *df, unsigned char *output )
+{
+    int ret, j;
+    const unsigned char pad = 0x80;
+    unsigned char *iv;
 
-        memcpy( tmp + j, chain, MBEDTLS_CTR_DRBG_BLOCKSIZE );
+    if( ( ret = df_update( df, &pad, 1 ) ) != 0 )
+        return( ret );
 
-        /*
-         * Update IV
-         */
-        buf[3]++;
+    if( df->fill > 0 )
+    {
+        memset( df->block + df->fill, 0, MBEDTLS_CTR_DRBG_BLOCKSIZE - df->fill );
+        if( ( ret = df_process_block( df ) ) != 0 )
+            return( ret );
     }
 
     /*
      * Do final encryption with reduced data
      */
-    mbedtls_aes_setkey_enc( &aes_ctx, tmp, MBEDTLS_CTR_DRBG_KEYBITS );
-    iv = tmp + MBEDTLS_CTR_DRBG_KEYSIZE;
-    p = output;
+    if( ( ret = mbedtls_aes_setkey_enc( &df->out_ctx, df->chain,
+                                        MBEDTLS_CTR_DRBG_KEYBITS ) ) != 0 )
+        return( ret );
+
+    iv = df->chain + MBEDTLS_CTR_DRBG_KEYSIZE;
 
     for( j = 0; j < MBEDTLS_CTR_DRBG_SEEDLEN; j += MBEDTLS_CTR_DRBG_BLOCKSIZE )
     {
-        mbedtls_aes_crypt_ecb( &aes_ctx, MBEDTLS_AES_ENCRYPT, iv, iv );
-        memcpy( p, iv, MBEDTLS_CTR_DRBG_BLOCKSIZE );
-        p += MBEDTLS_CTR_DRBG_BLOCKSIZE;
+        if( ( ret = mbedtls_aes_crypt_ecb( &df->out_ctx, MBEDTLS_AES_ENCRYPT,
+                                           iv, iv ) ) != 0 )
+            return( ret );
+        memcpy( output + j, iv, MBEDTLS_CTR_DRBG_BLOCKSIZE );
     }
 
-    mbedtls_aes_free( &aes_ctx );
-
     return( 0 );
 }
 
+static void df_free( ctr_drbg_df_context *df )
+{
+    mbedtls_aes_free( &df->aes_ctx );
+    mbedtls_aes_free( &df->out_ctx );
+    mbedtls_zeroize( df, sizeof( ctr_drbg_df_context ) );
+}
+
+static int block_cipher_df( unsigned char *output,
+                            const unsigned char *data, size_t data_len )
+{
+    int ret;
+    ctr_drbg_df_context df;
+
+    if( ( ret = df_start( &df, data_len ) ) == 0 &&
+        ( ret = df_update( &df, data, data_len ) ) == 0 )
+        ret = df_finish( &df, output );
+
+    df_free( &df );
+
+    return( ret );
+}
+
 static int ctr_drbg_update_internal( mbedtls_ctr_drbg_context *ctx,
                               const unsigned char data[MBEDTLS_CTR_DRBG_SEEDLEN] )
 {
     unsigned char tmp[MBEDTLS_CTR_DRBG_SEEDLEN];
-    unsigned char *p = tmp;
-    int i, j;
-
-    memset( tmp, 0, MBEDTLS_CTR_DRBG_SEEDLEN );
+    int ret, i, j;
 
     for( j = 0; j < MBEDTLS_CTR_DRBG_SEEDLEN; j += MBEDTLS_CTR_DRBG_BLOCKSIZE )
     {
@@ -248,24 +346,30 @@ static int ctr_drbg_update_internal( mbedtls_ctr_drbg_context *ctx,
             if( ++ctx->counter[i - 1] != 0 )
                 break;
 
-        /*
-         * Crypt counter block
-         */
-        mbedtls_aes_crypt_ecb( &ctx->aes_ctx, MBEDTLS_AES_ENCRYPT, ctx->counter, p );
-
-        p += MBEDTLS_CTR_DRBG_BLOCKSIZE;
+        memcpy( tmp + j, ctx->counter, MBEDTLS_CTR_DRBG_BLOCKSIZE );
     }
 
+    /*
+     * Crypt counter blocks
+     */
+    if( ( ret = ctr_drbg_crypt_blocks( &ctx->aes_ctx,
+                                       CTR_DRBG_DF_CHAINS, tmp, tmp ) ) != 0 )
+        goto exit;
+
     for( i = 0; i < MBEDTLS_CTR_DRBG_SEEDLEN; i++ )
         tmp[i] ^= data[i];
 
     /*
      * Update key and counter
      */
-    mbedtls_aes_setkey_enc( &ctx->aes_ctx, tmp, MBEDTLS_CTR_DRBG_KEYBITS );
+    if( ( ret = mbedtls_aes_setkey_enc( &ctx->aes_ctx, tmp,
+                                        MBEDTLS_CTR_DRBG_KEYBITS ) ) != 0 )
+        goto exit;
     memcpy( ctx->counter, tmp + MBEDTLS_CTR_DRBG_KEYSIZE, MBEDTLS_CTR_DRBG_BLOCKSIZE );
 
-    return( 0 );
+exit:
+    mbedtls_zeroize( tmp, sizeof( tmp ) );
+    return( ret );
 }
 
 void mbedtls_ctr_drbg_update( mbedtls_ctr_drbg_context *ctx,
@@ -280,61 +384,74 @@ void mbedtls_ctr_drbg_update( mbedtls_ctr_drbg_context *ctx,
         if( add_len > MBEDTLS_CTR_DRBG_MAX_SEED_INPUT )
             add_len = MBEDTLS_CTR_DRBG_MAX_SEED_INPUT;
 
-        block_cipher_df( add_input, additional, add_len );
-        ctr_drbg_update_internal( ctx, add_input );
+        if( block_cipher_df( add_input, additional, add_len ) == 0 )
+            ctr_drbg_update_internal( ctx, add_input );
+
+        mbedtls_zeroize( add_input, sizeof( add_input ) );
     }
 }
 
 int mbedtls_ctr_drbg_reseed( mbedtls_ctr_drbg_context *ctx,
                      const unsigned char *additional, size_t len )
 {
-    unsigned char *seed = NULL;
-    size_t seedlen = 0;
+    int ret;
+    unsigned char entropy[MBEDTLS_CTR_DRBG_ENTROPY_LEN];
+    unsigned char seed[MBEDTLS_CTR_DRBG_SEEDLEN];
+    ctr_drbg_df_context df;
+    size_t left, use_len;
 
     if( ctx->entropy_len > MBEDTLS_CTR_DRBG_MAX_SEED_INPUT ||
         len > MBEDTLS_CTR_DRBG_MAX_SEED_INPUT - ctx->entropy_len )
         return( MBEDTLS_ERR_CTR_DRBG_INPUT_TOO_BIG );
 
-    seed = calloc(1, MBEDTLS_CTR_DRBG_MAX_SEED_INPUT);
-    if (seed == NULL) {
-        return ( MBEDTLS_ERR_CTR_DRBG_REQUEST_TOO_BIG );
-    }
-    memset( seed, 0, MBEDTLS_CTR_DRBG_MAX_SEED_INPUT );
+    if( additional == NULL )
+        len = 0;
+
+    if( ( ret = df_start( &df, ctx->entropy_len + len ) ) != 0 )
+        goto exit;
 
     /*
-     * Gather entropy_len bytes of entropy to seed state
+     * Gather entropy_len bytes of entropy to seed state, a chunk at a time
      */
-    if( 0 != ctx->f_entropy( ctx->p_entropy, seed,
-                             ctx->entropy_len ) )
+    for( left = ctx->entropy_len; left > 0; left -= use_len )
     {
-        free(seed);
-        return( MBEDTLS_ERR_CTR_DRBG_ENTROPY_SOURCE_FAILED );
-    }
+        use_len = ( left > sizeof( entropy ) ) ? sizeof( entropy ) : left;
+
+        if( 0 != ctx->f_entropy( ctx->p_entropy, entropy, use_len ) )
+        {
+            ret = MBEDTLS_ERR_CTR_DRBG_ENTROPY_SOURCE_FAILED;
+            goto exit;
+        }
 
-    seedlen += ctx->entropy_len;
+        if( ( ret = df_update( &df, entropy, use_len ) ) != 0 )
+            goto exit;
+    }
 
     /*
      * Add additional data
      */
-    if( additional && len )
-    {
-        memcpy( seed + seedlen, additional, len );
-        seedlen += len;
-    }
+    if( ( ret = df_update( &df, additional, len ) ) != 0 )
+        goto exit;
 
     /*
      * Reduce to 384 bits
      */
-    block_cipher_df( seed, seed, seedlen );
+    if( ( ret = df_finish( &df, seed ) ) != 0 )
+        goto exit;
 
     /*
      * Update state
      */
-    ctr_drbg_update_internal( ctx, seed );
+    if( ( ret = ctr_drbg_update_internal( ctx, seed ) ) != 0 )
+        goto exit;
     ctx->reseed_counter = 1;
+    ctr_drbg_stats.reseeds++;
 
-    free(seed);
-    return( 0 );
+exit:
+    df_free( &df );
+    mbedtls_zeroize( entropy, sizeof( entropy ) );
+    mbedtls_zeroize( seed, sizeof( seed ) );
+    return( ret );
 }
 
 int mbedtls_ctr_drbg_random_with_add( void *p_rng,
@@ -343,48 +460,45 @@ int mbedtls_ctr_drbg_random_with_add( void *p_rng,
 {
     int ret = 0;
     mbedtls_ctr_drbg_context *ctx = (mbedtls_ctr_drbg_context *) p_rng;
-    unsigned char *add_input = NULL;
-    unsigned char *p = output;
-    unsigned char *tmp = NULL;
+    unsigned char add_input[MBEDTLS_CTR_DRBG_SEEDLEN];
+    unsigned char tmp[MBEDTLS_CTR_DRBG_BLOCKSIZE];
+    unsigned char *p;
+    size_t blocks, use_len;
+    UInt32 start = Clock_getTicks();
+    UInt taskKey;
     int i;
-    size_t use_len;
 
-    add_input = calloc(1, MBEDTLS_CTR_DRBG_SEEDLEN);
-    tmp = calloc(1, MBEDTLS_CTR_DRBG_BLOCKSIZE);
-    if ( (!add_input) || (!tmp) ) {
-        ret = MBEDTLS_ERR_CTR_DRBG_REQUEST_TOO_BIG;
-        goto random_with_add_cleanup;
-    }
+    if( output_len > MBEDTLS_CTR_DRBG_MAX_REQUEST )
+        return( MBEDTLS_ERR_CTR_DRBG_REQUEST_TOO_BIG );
 
-    if( output_len > MBEDTLS_CTR_DRBG_MAX_REQUEST ) {
-        ret = MBEDTLS_ERR_CTR_DRBG_REQUEST_TOO_BIG;
-        goto random_with_add_cleanup;
-    }
-
-    if( add_len > MBEDTLS_CTR_DRBG_MAX_INPUT ) {
-        ret = MBEDTLS_ERR_CTR_DRBG_INPUT_TOO_BIG;
-        goto random_with_add_cleanup;
-    }
+    if( add_len > MBEDTLS_CTR_DRBG_MAX_INPUT )
+        return( MBEDTLS_ERR_CTR_DRBG_INPUT_TOO_BIG );
 
     memset( add_input, 0, MBEDTLS_CTR_DRBG_SEEDLEN );
 
     if( ctx->reseed_counter > ctx->reseed_interval ||
         ctx->prediction_resistance )
     {
-        if( ( ret = mbedtls_ctr_drbg_reseed( ctx, additional, add_len ) ) != 0 ) {
-            goto random_with_add_cleanup;
-        }
+        if( ( ret = mbedtls_ctr_drbg_reseed( ctx, additional, add_len ) ) != 0 )
+            goto exit;
 
         add_len = 0;
     }
 
     if( add_len > 0 )
     {
-        block_cipher_df( add_input, additional, add_len );
-        ctr_drbg_update_internal( ctx, add_input );
+        if( ( ret = block_cipher_df( add_input, additional, add_len ) ) != 0 ||
+            ( ret = ctr_drbg_update_internal( ctx, add_input ) ) != 0 )
+            goto exit;
     }
 
-    while( output_len > 0 )
+    /*
+     * Lay the counter blocks out in the output and encrypt them in place
+     */
+    blocks = output_len / MBEDTLS_CTR_DRBG_BLOCKSIZE;
+
+    for( p = output; p < output + blocks * MBEDTLS_CTR_DRBG_BLOCKSIZE;
+         p += MBEDTLS_CTR_DRBG_BLOCKSIZE )
     {
         /*
          * Increase counter
@@ -393,34 +507,71 @@ int mbedtls_ctr_drbg_random_with_add( void *p_rng,
             if( ++ctx->counter[i - 1] != 0 )
                 break;
 
-        /*
-         * Crypt counter block
-         */
-        mbedtls_aes_crypt_ecb( &ctx->aes_ctx, MBEDTLS_AES_ENCRYPT, ctx->counter, tmp );
+        memcpy( p, ctx->counter, MBEDTLS_CTR_DRBG_BLOCKSIZE );
+    }
+
+    if( blocks > 0 &&
+        ( ret = ctr_drbg_crypt_blocks( &ctx->aes_ctx, blocks, output, output ) ) != 0 )
+        goto exit;
+
+    use_len = output_len - blocks * MBEDTLS_CTR_DRBG_BLOCKSIZE;
+    if( use_len > 0 )
+    {
+        for( i = MBEDTLS_CTR_DRBG_BLOCKSIZE; i > 0; i-- )
+            if( ++ctx->counter[i - 1] != 0 )
+                break;
+
+        if( ( ret = mbedtls_aes_crypt_ecb( &ctx->aes_ctx, MBEDTLS_AES_ENCRYPT,
+                                           ctx->counter, tmp ) ) != 0 )
+            goto exit;
 
-        use_len = ( output_len > MBEDTLS_CTR_DRBG_BLOCKSIZE ) ? MBEDTLS_CTR_DRBG_BLOCKSIZE :
-                                                       output_len;
-        /*
-         * Copy random block to destination
-         */
         memcpy( p, tmp, use_len );
-        p += use_len;
-        output_len -= use_len;
     }
 
-    ctr_drbg_update_internal( ctx, add_input );
+    if( ( ret = ctr_drbg_update_internal( ctx, add_input ) ) != 0 )
+        goto exit;
 
     ctx->reseed_counter++;
-    ret = 0;
 
-random_with_add_cleanup:
-    if (tmp)
-        free(tmp);
-    if(add_input)
-        free(add_input);
+    taskKey = Task_disable();
+    ctr_drbg_stats.requests++;
+    ctr_drbg_stats.bytes += output_len;
+    ctr_drbg_stats.ticks += Clock_getTicks() - start;
+    Task_restore( taskKey );
+
+exit:
+    if( ret != 0 )
+    {
+        /* Never hand out the plain counter blocks */
+        mbedtls_zeroize( output, output_len );
+        taskKey = Task_disable();
+        ctr_drbg_stats.failures++;
+        Task_restore( taskKey );
+    }
+    mbedtls_zeroize( add_input, sizeof( add_input ) );
+    mbedtls_zeroize( tmp, sizeof( tmp ) );
     return( ret );
 }
 
+void mbedtls_ctr_drbg_get_stats( mbedtls_ctr_drbg_stats *stats )
+{
+    UInt taskKey = Task_disable();
+    memcpy( stats, &ctr_drbg_stats, sizeof( mbedtls_ctr_drbg_stats ) );
+    Task_restore( taskKey );
+
+    stats->bytes_per_sec = 0;
+    if( stats->ticks > 0 )
+        stats->bytes_per_sec = (uint32_t)( (uint64_t) stats->bytes * 1000000 /
+                                           ( (uint64_t) stats->ticks * Clock_tickPeriod ) );
+}
+
+void mbedtls_ctr_drbg_reset_stats( void )
+{
+    UInt taskKey = Task_disable();
+    memset( &ctr_drbg_stats, 0, sizeof( mbedtls_ctr_drbg_stats ) );
+    Task_restore( taskKey );
+}
+
 int mbedtls_ctr_drbg_random( void *p_rng, unsigned char *output, size_t output_len )
 {
     int ret;
@@ -534,6 +685,19 @@ static const unsigned char nonce_pers_nopr[16] =
     { 0x1b, 0x54, 0xb8, 0xff, 0x06, 0x42, 0xbf, 0xf5,
       0x21, 0xf1, 0x5c, 0x1c, 0x0b, 0x66, 0x5f, 0x3f };
 
+#if MBEDTLS_CTR_DRBG_KEYSIZE == 16
+/*
+ * The same inputs through AES-128, the key size this build uses. Worked out with
+ * an implementation of SP 800-90A that gives the AES-256 results below.
+ */
+static const unsigned char result_pr[16] =
+    { 0x95, 0x3c, 0xa5, 0xbd, 0x44, 0x01, 0x34, 0xb7,
+      0x13, 0x58, 0x3e, 0x6a, 0x6c, 0x7e, 0x88, 0x8a };
+
+static const unsigned char result_nopr[16] =
+    { 0x6c, 0x25, 0x27, 0x95, 0xa3, 0x62, 0xd6, 0xdb,
+      0x90, 0xfd, 0x69, 0xb5, 0x42, 0x09, 0x4b, 0x84 };
+#else
 static const unsigned char result_pr[16] =
     { 0x34, 0x01, 0x16, 0x56, 0xb4, 0x29, 0x00, 0x8f,
       0x35, 0x63, 0xec, 0xb5, 0xf2, 0x59, 0x07, 0x23 };
@@ -541,6 +705,7 @@ static const unsigned char result_pr[16] =
 static const unsigned char result_nopr[16] =
     { 0xa0, 0x54, 0x30, 0x3d, 0x8a, 0x7e, 0xa9, 0x88,
       0x9d, 0x90, 0x3e, 0x07, 0x7c, 0x6f, 0x21, 0x8f };
+#endif /* MBEDTLS_CTR_DRBG_KEYSIZE == 16 */
 
 static size_t test_offset;
 static int ctr_drbg_self_test_entropy( void *data, unsigned char *buf,
@@ -552,8 +717,10 @@ static int ctr_drbg_self_test_entropy( void *data, unsigned char *buf,
     return( 0 );
 }
 
+/* Frees the context on failure, it holds one of the crypto module's key slots */
 #define CHK( c )    if( (c) != 0 )                          \
                     {                                       \
+                        mbedtls_ctr_drbg_free( &ctx );      \
                         if( verbose != 0 )                  \
                             mbedtls_printf( "failed\n" );  \
                         return( 1 );                        \
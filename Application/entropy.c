@@ -44,6 +44,7 @@
 
 #if defined(MBEDTLS_ENTROPY_NV_SEED)
 #include "mbedtls/platform.h"
+#include "nv_seed.h"
 #endif
 
 #if defined(MBEDTLS_SELF_TEST)
@@ -68,6 +69,11 @@ static void mbedtls_zeroize( void *v, size_t n ) {
 
 void mbedtls_entropy_init( mbedtls_entropy_context *ctx )
 {
+#if defined(MBEDTLS_ENTROPY_NV_SEED)
+    /* A stored seed stands in for part of the TRNG output, see nv_seed.h */
+    int seed_stored = nv_seed_stored();
+#endif
+
     memset( ctx, 0, sizeof(mbedtls_entropy_context) );
 
 #if defined(MBEDTLS_THREADING_C)
@@ -105,13 +111,21 @@ void mbedtls_entropy_init( mbedtls_entropy_context *ctx )
                                 MBEDTLS_ENTROPY_SOURCE_STRONG );
 #endif
 #if defined(MBEDTLS_ENTROPY_HARDWARE_ALT)
+#if defined(MBEDTLS_ENTROPY_NV_SEED)
+    mbedtls_entropy_add_source( ctx, mbedtls_hardware_poll, NULL,
+                                seed_stored ? NV_SEED_MIN_HARDWARE :
+                                              MBEDTLS_ENTROPY_MIN_HARDWARE,
+                                MBEDTLS_ENTROPY_SOURCE_STRONG );
+#else
     mbedtls_entropy_add_source( ctx, mbedtls_hardware_poll, NULL,
                                 MBEDTLS_ENTROPY_MIN_HARDWARE,
                                 MBEDTLS_ENTROPY_SOURCE_STRONG );
 #endif
+#endif
 #if defined(MBEDTLS_ENTROPY_NV_SEED)
+    /* Without a stored seed (first boot) the source gives nothing to wait for */
     mbedtls_entropy_add_source( ctx, mbedtls_nv_seed_poll, NULL,
-                                MBEDTLS_ENTROPY_BLOCK_SIZE,
+                                seed_stored ? MBEDTLS_ENTROPY_BLOCK_SIZE : 0,
                                 MBEDTLS_ENTROPY_SOURCE_STRONG );
 #endif
 #endif /* MBEDTLS_NO_DEFAULT_ENTROPY_SOURCES */
@@ -591,6 +605,11 @@ int mbedtls_entropy_self_test( int verbose )
 #if !defined(MBEDTLS_TEST_NULL_ENTROPY)
     mbedtls_entropy_init( &ctx );
 
+#if defined(MBEDTLS_ENTROPY_NV_SEED)
+    /* A pool with the dummy source in it does not get to replace the seed */
+    ctx.initial_entropy_run = 1;
+#endif
+
     /* First do a gather to make sure we have default sources */
     if( ( ret = mbedtls_entropy_gather( &ctx ) ) != 0 )
         goto cleanup;
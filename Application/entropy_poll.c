@@ -19,11 +19,10 @@
  *  This file is part of mbed TLS (https://tls.mbed.org)
  */
 
-#include <driverlib/trng.h>
-#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Clock.h>
 #include <string.h>
-#include <ti/drivers/Power.h>
-#include <ti/drivers/power/PowerCC26XX.h>
+
+#include "trng_pool.h"
 
 #if !defined(MBEDTLS_CONFIG_FILE)
 #include "mbedtls/config.h"
@@ -45,6 +44,7 @@
 #endif
 #if defined(MBEDTLS_ENTROPY_NV_SEED)
 #include "mbedtls/platform.h"
+#include "nv_seed.h"
 #endif
 
 #if !defined(MBEDTLS_NO_PLATFORM_ENTROPY)
@@ -252,24 +252,13 @@ int mbedtls_havege_poll( void *data,
 
 int mbedtls_hardware_poll( void *data,
                            unsigned char *output, size_t len, size_t *olen ) {
+    ((void) data);
 
-    uint32_t r = 1;
-
-    Power_setDependency(PowerCC26XX_PERIPH_TRNG);
-    TRNGEnable();
-    uint32_t trng_status;
-    do {
-        // Wait until a new number is ready...
-        trng_status = TRNGStatusGet();
-        Task_sleep(2);
-    } while ( !(trng_status & TRNG_NUMBER_READY) );
-
-    r = TRNGNumberGet(TRNG_LOW_WORD);
-    TRNGDisable();
-    Power_releaseDependency(PowerCC26XX_PERIPH_TRNG);
-
-    memcpy( output, &r, sizeof(uint32_t));
-    *olen = sizeof(uint32_t);
+    // The TRNG interrupt fills the pool in the background, only an empty pool makes us wait
+    *olen = trng_pool_read(output, len, (TRNG_POOL_READ_TIMEOUT_MS * 1000) / Clock_tickPeriod);
+    if (*olen == 0) {
+        return MBEDTLS_ERR_ENTROPY_SOURCE_FAILED;
+    }
     return 0;
 }
 
@@ -280,14 +269,17 @@ int mbedtls_nv_seed_poll( void *data,
                           unsigned char *output, size_t len, size_t *olen )
 {
     unsigned char buf[MBEDTLS_ENTROPY_BLOCK_SIZE];
-    size_t use_len = MBEDTLS_ENTROPY_BLOCK_SIZE;
+    int read_len;
+    size_t use_len;
     ((void) data);
 
     memset( buf, 0, MBEDTLS_ENTROPY_BLOCK_SIZE );
 
-    if( mbedtls_nv_seed_read( buf, MBEDTLS_ENTROPY_BLOCK_SIZE ) < 0 )
+    if( ( read_len = mbedtls_nv_seed_read( buf, MBEDTLS_ENTROPY_BLOCK_SIZE ) ) < 0 )
       return( MBEDTLS_ERR_ENTROPY_SOURCE_FAILED );
 
+    /* Nothing stored yet counts for nothing, not for a block of zeros */
+    use_len = (size_t) read_len;
     if( len < use_len )
       use_len = len;
 
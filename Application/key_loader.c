@@ -0,0 +1,106 @@
+#include "key_loader.h"
+
+#include <string.h>
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Clock.h>
+
+#include "trace.h"
+
+/*
+ * Key loading front end.
+ *
+ * mbedtls_pk_parse_key() used to try every PEM header and then every DER parser until
+ * one accepted the input. Each miss set up and tore down a PEM context or rescanned the
+ * buffer, and the encrypted PKCS#8 attempt alone put a 2 KB buffer on the stack.
+ * The key is now classified once and handed to the matching parser. The format and the
+ * time it took are kept so boot and key rotation can be compared.
+ */
+
+static key_loader_stats_t loaderStats;
+
+static int key_loader_run(mbedtls_pk_context *pk, const unsigned char *key, size_t keylen,
+                          const unsigned char *pwd, size_t pwdlen,
+                          unsigned char *buf, size_t size) {
+    mbedtls_pk_format_t format;
+    UInt32 start = Clock_getTicks();
+    UInt32 ticks;
+    UInt taskKey;
+    int ret;
+
+    format = mbedtls_pk_key_format(key, keylen);
+    ret = mbedtls_pk_parse_key_as(pk, format, key, keylen, pwd, pwdlen, buf, size);
+    ticks = Clock_getTicks() - start;
+
+    taskKey = Task_disable();
+    loaderStats.loads++;
+    if (ret != 0) {
+        loaderStats.failures++;
+    }
+    if (format == MBEDTLS_PK_FORMAT_UNKNOWN) {
+        loaderStats.unknown++;
+    }
+    loaderStats.last_result = ret;
+    loaderStats.last_format = format;
+    loaderStats.last_ticks = ticks;
+    if (ticks > loaderStats.max_ticks) {
+        loaderStats.max_ticks = ticks;
+    }
+    Task_restore(taskKey);
+
+    TRACE(TRACE_KEY_LOAD, format, ret);
+    TRACE(TRACE_KEY_LOAD_TIME, ticks * Clock_tickPeriod);
+    return ret;
+}
+
+int key_loader_load(mbedtls_pk_context *pk, const unsigned char *key, size_t keylen,
+                    const unsigned char *pwd, size_t pwdlen) {
+    return key_loader_run(pk, key, keylen, pwd, pwdlen, NULL, 0);
+}
+
+int key_loader_load_inplace(mbedtls_pk_context *pk, unsigned char *key, size_t keylen,
+                            const unsigned char *pwd, size_t pwdlen) {
+    return key_loader_run(pk, key, keylen, pwd, pwdlen, key, keylen);
+}
+
+const char *key_loader_format_name(mbedtls_pk_format_t format) {
+    switch (format) {
+        case MBEDTLS_PK_FORMAT_PEM_PKCS1:
+            return "PEM PKCS#1";
+        case MBEDTLS_PK_FORMAT_PEM_SEC1:
+            return "PEM SEC1";
+        case MBEDTLS_PK_FORMAT_PEM_PKCS8:
+            return "PEM PKCS#8";
+        case MBEDTLS_PK_FORMAT_PEM_PKCS8_ENC:
+            return "PEM encrypted PKCS#8";
+        case MBEDTLS_PK_FORMAT_DER_PKCS1:
+            return "DER PKCS#1";
+        case MBEDTLS_PK_FORMAT_DER_SEC1:
+            return "DER SEC1";
+        case MBEDTLS_PK_FORMAT_DER_PKCS8:
+            return "DER PKCS#8";
+        case MBEDTLS_PK_FORMAT_DER_PKCS8_ENC:
+            return "DER encrypted PKCS#8";
+        default:
+            return "unknown";
+    }
+}
+
+void key_loader_get_stats(key_loader_stats_t *stats) {
+    UInt taskKey;
+
+    if (!stats) {
+        return;
+    }
+
+    taskKey = Task_disable();
+    memcpy(stats, &loaderStats, sizeof(key_loader_stats_t));
+    stats->tick_period_us = Clock_tickPeriod;
+    Task_restore(taskKey);
+}
+
+void key_loader_reset_stats() {
+    UInt taskKey = Task_disable();
+    memset(&loaderStats, 0, sizeof(key_loader_stats_t));
+    Task_restore(taskKey);
+}
@@ -0,0 +1,44 @@
+#ifndef APPLICATION_KEY_LOADER_H_
+#define APPLICATION_KEY_LOADER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "mbedtls/pk.h"
+
+typedef struct key_loader_stats {
+    uint32_t loads;           // key_loader_load*() calls
+    uint32_t failures;        // Loads that did not give a key
+    uint32_t unknown;         // Inputs that matched no key format
+    int32_t  last_result;     // mbedtls error code of the last load, 0 on success
+    uint8_t  last_format;     // mbedtls_pk_format_t the last input was classified as
+    uint32_t last_ticks;      // Clock ticks the last load took, reads 0 before BIOS_start()
+    uint32_t max_ticks;
+    uint32_t tick_period_us;  // Length of one Clock tick
+} key_loader_stats_t;
+
+/*
+ * Classifies the key once by its PEM armour or DER structure and parses it with the
+ * parser for that format only. pk must be freshly initialized.
+ * Returns 0 or the mbedtls error code.
+ */
+int key_loader_load(mbedtls_pk_context *pk, const unsigned char *key, size_t keylen,
+                    const unsigned char *pwd, size_t pwdlen);
+
+/*
+ * Same as key_loader_load() for a key in RAM, e.g. one received for a key rotation.
+ * PEM data is decoded over the buffer, so nothing is allocated for it, and the buffer
+ * does not hold the key anymore afterwards.
+ */
+int key_loader_load_inplace(mbedtls_pk_context *pk, unsigned char *key, size_t keylen,
+                            const unsigned char *pwd, size_t pwdlen);
+
+/*
+ * Short name of a format for logging, like "PEM PKCS#1"
+ */
+const char *key_loader_format_name(mbedtls_pk_format_t format);
+
+void key_loader_get_stats(key_loader_stats_t *stats);
+void key_loader_reset_stats();
+
+#endif /* APPLICATION_KEY_LOADER_H_ */
@@ -0,0 +1,175 @@
+#include "latency.h"
+
+#include <string.h>
+#include <stdbool.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Task.h>
+#include <inc/hw_types.h>
+#include <inc/hw_memmap.h>
+#include <inc/hw_cpu_dwt.h>
+#include <inc/hw_cpu_scs.h>
+
+/*
+ * Where the time of a challenge goes.
+ *
+ * Every stage of the sign pipeline is timed and kept as a histogram with power of two
+ * buckets next to its count, sum, minimum and maximum, so min, average, max and the
+ * 99th percentile can be read from the Diagnostics characteristic without a debugger.
+ * Stages that only compute are timed with the DWT cycle counter. The counter stops
+ * while the core sleeps, so stages that wait for the user or for the app task use the
+ * Clock instead.
+ */
+
+typedef struct latency_hist {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint16_t buckets[LATENCY_BUCKETS];
+} latency_hist_t;
+
+// Stages timed with the Clock
+static const bool stageBlocks[LATENCY_STAGE_COUNT] = {
+    true,   // LATENCY_DISPATCH
+    true,   // LATENCY_CONFIRM
+    true,   // LATENCY_SEED, waits on the TRNG pool
+    false,  // LATENCY_SHA256
+    false,  // LATENCY_RSA_PRIVATE
+    false,  // LATENCY_VERIFY
+    false,  // LATENCY_NOTIFY
+    true    // LATENCY_JOB
+};
+
+static latency_hist_t hists[LATENCY_STAGE_COUNT];
+
+static uint8_t bucket_of(uint32_t us) {
+    uint8_t bucket = 0;
+
+    while ((us > 0) && (bucket < LATENCY_BUCKETS - 1)) {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+static void put_u32(uint8_t *buf, uint32_t value) {
+    buf[0] = value & 0xFF;
+    buf[1] = (value >> 8) & 0xFF;
+    buf[2] = (value >> 16) & 0xFF;
+    buf[3] = (value >> 24) & 0xFF;
+}
+
+void latency_init() {
+    latency_enable_counter();
+    latency_reset();
+}
+
+void latency_enable_counter() {
+    HWREG(CPU_SCS_BASE + CPU_SCS_O_DEMCR) |= CPU_SCS_DEMCR_TRCENA;
+    HWREG(CPU_DWT_BASE + CPU_DWT_O_CTRL) |= CPU_DWT_CTRL_CYCCNTENA;
+}
+
+uint32_t latency_start(latency_stage_t stage) {
+    if (stageBlocks[stage]) {
+        return Clock_getTicks();
+    }
+    latency_enable_counter();
+    return HWREG(CPU_DWT_BASE + CPU_DWT_O_CYCCNT);
+}
+
+void latency_stop(latency_stage_t stage, uint32_t start) {
+    latency_hist_t *hist = &hists[stage];
+    uint32_t us;
+    uint8_t bucket;
+    uint8_t i;
+    UInt taskKey;
+
+    // Unsigned differences stay right across one wrap of either counter
+    if (stageBlocks[stage]) {
+        us = (Clock_getTicks() - start) * Clock_tickPeriod;
+    }
+    else {
+        us = (HWREG(CPU_DWT_BASE + CPU_DWT_O_CYCCNT) - start) / LATENCY_CPU_MHZ;
+    }
+    bucket = bucket_of(us);
+
+    taskKey = Task_disable();
+    if ((hist->count == 0) || (us < hist->min_us)) {
+        hist->min_us = us;
+    }
+    if (us > hist->max_us) {
+        hist->max_us = us;
+    }
+    hist->count++;
+    hist->sum_us += us;
+    if (hist->buckets[bucket] == UINT16_MAX) {
+        // Keep the shape, the percentiles only need the proportions
+        for (i = 0; i < LATENCY_BUCKETS; i++) {
+            hist->buckets[i] >>= 1;
+        }
+    }
+    hist->buckets[bucket]++;
+    Task_restore(taskKey);
+}
+
+void latency_get_summary(latency_stage_t stage, latency_summary_t *summary) {
+    latency_hist_t hist;
+    uint32_t total = 0;
+    uint32_t seen = 0;
+    uint8_t i;
+    UInt taskKey;
+
+    if ((!summary) || (stage >= LATENCY_STAGE_COUNT)) {
+        return;
+    }
+
+    taskKey = Task_disable();
+    memcpy(&hist, &hists[stage], sizeof(latency_hist_t));
+    Task_restore(taskKey);
+
+    memset(summary, 0, sizeof(latency_summary_t));
+    if (hist.count == 0) {
+        return;
+    }
+    summary->count = hist.count;
+    summary->min_us = hist.min_us;
+    summary->max_us = hist.max_us;
+    summary->avg_us = (uint32_t) (hist.sum_us / hist.count);
+
+    for (i = 0; i < LATENCY_BUCKETS; i++) {
+        total += hist.buckets[i];
+    }
+    for (i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += hist.buckets[i];
+        if (seen * 100 >= total * 99) {
+            break;
+        }
+    }
+    // Bucket i ends at 2^i us, the last one and a sparse histogram end at the maximum
+    summary->p99_us = ((i < LATENCY_BUCKETS - 1) && ((1UL << i) < hist.max_us)) ? (1UL << i) : hist.max_us;
+}
+
+uint16_t latency_serialize(uint8_t *buf) {
+    latency_summary_t summary;
+    uint8_t *p = buf;
+    uint8_t stage;
+
+    *p++ = LATENCY_DIAG_VERSION;
+    *p++ = LATENCY_STAGE_COUNT;
+    for (stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+        latency_get_summary((latency_stage_t) stage, &summary);
+        put_u32(p, summary.count);
+        put_u32(p + 4, summary.min_us);
+        put_u32(p + 8, summary.avg_us);
+        put_u32(p + 12, summary.max_us);
+        put_u32(p + 16, summary.p99_us);
+        p += sizeof(latency_summary_t);
+    }
+    return p - buf;
+}
+
+void latency_reset() {
+    UInt taskKey = Task_disable();
+    memset(hists, 0, sizeof(hists));
+    Task_restore(taskKey);
+}
@@ -0,0 +1,72 @@
+#ifndef APPLICATION_LATENCY_H_
+#define APPLICATION_LATENCY_H_
+
+#include <stdint.h>
+
+// Core clock the cycle counter runs at
+#ifndef LATENCY_CPU_MHZ
+#define LATENCY_CPU_MHZ 48
+#endif
+
+// Histogram buckets, bucket i counts times below 2^i us and the last one all longer ones
+#define LATENCY_BUCKETS 24
+
+// Layout of latency_serialize(), bumped when it changes
+#define LATENCY_DIAG_VERSION 1
+
+typedef enum latency_stage {
+    LATENCY_DISPATCH = 0,   // GATT write until the app task takes the message
+    LATENCY_CONFIRM,        // Waiting for the button
+    LATENCY_SEED,           // Seeding the DRBG, can wait for TRNG output
+    LATENCY_SHA256,         // Hash of the challenge
+    LATENCY_RSA_PRIVATE,    // mbedtls_rsa_private()
+    LATENCY_VERIFY,         // Checking the signature before it is handed out
+    LATENCY_NOTIFY,         // Response into the profile and notification of the status
+    LATENCY_JOB,            // Whole sign job, from its turn to the notification
+    LATENCY_STAGE_COUNT
+} latency_stage_t;
+
+typedef struct latency_summary {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t avg_us;
+    uint32_t max_us;
+    uint32_t p99_us;        // Upper end of the bucket the 99th percentile is in
+} latency_summary_t;
+
+// Bytes latency_serialize() writes: version, stage count and a summary per stage
+#define LATENCY_DIAG_LEN (2 + LATENCY_STAGE_COUNT * sizeof(latency_summary_t))
+
+/*
+ * Starts the cycle counter, it is not cleared, boot_time_init() counts on it
+ */
+void latency_init();
+
+/*
+ * Enables the cycle counter again. A debugger that detaches clears TRCENA and the
+ * counter stops, so whatever times with it calls this first.
+ */
+void latency_enable_counter();
+
+/*
+ * Start of a stage. Stages that can block are timed with the Clock, the cycle counter
+ * stops while the device sleeps.
+ */
+uint32_t latency_start(latency_stage_t stage);
+
+/*
+ * End of a stage that began with latency_start() at start
+ */
+void latency_stop(latency_stage_t stage, uint32_t start);
+
+void latency_get_summary(latency_stage_t stage, latency_summary_t *summary);
+
+/*
+ * Every summary, little endian, for the Diagnostics characteristic.
+ * buf has to hold LATENCY_DIAG_LEN bytes.
+ */
+uint16_t latency_serialize(uint8_t *buf);
+
+void latency_reset();
+
+#endif /* APPLICATION_LATENCY_H_ */
@@ -2,27 +2,45 @@
 
 #include <ti/drivers/PIN.h>
 #include <ti/drivers/pin/PINCC26XX.h>
-#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Swi.h>
 #include <time.h>
-#include <stdlib.h>
 #include <xdc/runtime/system.h>
 
 static PIN_Handle ledPinHandle;
 static PIN_State ledPinState;
 
-static PIN_Handle buttonPinHandle;
-static PIN_State buttonPinState;
+/*
+ * All LEDs run on one Clock instead of a task per blinking LED. The clock only runs
+ * while a pattern does, and a pattern is nothing more than its slot below, so setting
+ * an LED neither allocates nor creates anything.
+ */
+
+typedef struct led_slot {
+    led_pattern_t pattern;  // on_ticks is 0 while the LED is steady
+    bool isLit;
+    uint16_t left;          // Ticks until the LED toggles
+    uint8_t pulsesLeft;
+} led_slot_t;
+
+// Patterns of the LED_state_t values, in engine ticks
+#define LED_BLINK_TICKS (LED_BLINK_MS / LED_ENGINE_TICK_MS)
+
+static const led_pattern_t ledPatterns[] = {
+    { 0, 0, 0 },                                // off
+    { 0, 0, 0 },                                // on
+    { LED_BLINK_TICKS, LED_BLINK_TICKS, 0 }     // blinking
+};
+
+static const PIN_Id ledPins[LED_COUNT] = { Board_PIN_LED0, Board_PIN_LED1 };
 
-// The semaphore used to interract with the button
-Semaphore_Params sem_params;
-Semaphore_Handle button_sem;
+// Set while an LED runs a pattern that is none of the LED_state_t ones
+#define LED_STATE_PATTERN 0xFF
 
-#define LED_BLINK_TASK_PRIOTITY 1
-#define LED_BLINK_TASK_STACK_SIZE 200
-Char *ledBlinkTaskStack = NULL;
+static led_slot_t ledSlots[LED_COUNT];
+static Clock_Struct ledClock;
+static uint8_t current_LED_state[LED_COUNT] = { off, off };
 
-static Task_Handle ledBlinkTask[2] = { NULL, NULL };
-static LED_state_t current_LED_state[2] = { off, off };
 /*
  * Initial LED pin configuration table
  *   - LEDs Board_PIN_LED0 is on.
@@ -34,138 +52,122 @@ PIN_Config ledPinTable[] = {
     PIN_TERMINATE
 };
 
-/*
- * Application button pin configuration table:
- *   - Buttons interrupts are configured to trigger on falling edge.
- */
-PIN_Config buttonPinTable[] = {
-    Board_PIN_BUTTON0  | PIN_INPUT_EN | PIN_PULLUP | PIN_IRQ_NEGEDGE,
-    Board_PIN_BUTTON1  | PIN_INPUT_EN | PIN_PULLUP | PIN_IRQ_NEGEDGE,
-    PIN_TERMINATE
-};
-
-
-#define LED_BLINK_INTERVAL 50000
-
-void buttonCallbackFxn(PIN_Handle handle, PIN_Id pinId) {
-    CPUdelay(8000*50);
-    if (!PIN_getInputValue(pinId)) {
-        switch (pinId) {
-            case Board_PIN_BUTTON0:
-                Semaphore_post(button_sem);
-                break;
-
-            case Board_PIN_BUTTON1:
-                Semaphore_post(button_sem);
-                break;
-
-            default:
-                /* Do nothing */
-                break;
-        }
-    }
-}
+static void led_clock_fxn(UArg arg);
 
 void init_LED_pins(){
+    Clock_Params clockParams;
+
     ledPinHandle = PIN_open(&ledPinState, ledPinTable);
     if(!ledPinHandle) {
         /* Error initializing board LED pins */
         System_abort("LED failure");
     }
 
-    buttonPinHandle = PIN_open(&buttonPinState, buttonPinTable);
-    if(!buttonPinHandle) {
-        /* Error initializing button pins */
-        System_abort("Button Failure");
-    }
+    Clock_Params_init(&clockParams);
+    clockParams.period = (LED_ENGINE_TICK_MS * 1000) / Clock_tickPeriod;
+    clockParams.startFlag = FALSE;
+    Clock_construct(&ledClock, led_clock_fxn, clockParams.period, &clockParams);
+}
+
+/*
+ * The engine advances every LED once per tick, so on and off times are multiples of it
+ */
+static void led_clock_fxn(UArg arg) {
+    bool isActive = false;
+    uint8_t i;
+
+    for (i = 0; i < LED_COUNT; i++) {
+        led_slot_t *slot = &ledSlots[i];
 
-    Semaphore_Params_init(&sem_params);
-    button_sem = Semaphore_create(0, &sem_params, NULL);
-    if (!button_sem) {
-        System_abort("Semaphore failure");
+        if (slot->pattern.on_ticks == 0) {
+            continue;
+        }
+        if (--slot->left == 0) {
+            if (slot->isLit) {
+                slot->isLit = false;
+                slot->left = slot->pattern.off_ticks;
+                if ((slot->pattern.pulses != 0) && (--slot->pulsesLeft == 0)) {
+                    // Done, the LED stays off
+                    slot->pattern.on_ticks = 0;
+                }
+            }
+            else {
+                slot->isLit = true;
+                slot->left = slot->pattern.on_ticks;
+            }
+            PIN_setOutputValue(ledPinHandle, ledPins[i], slot->isLit);
+        }
+        if (slot->pattern.on_ticks != 0) {
+            isActive = true;
+        }
     }
-    /* Setup callback for button pins */
-    if (PIN_registerIntCb(buttonPinHandle, &buttonCallbackFxn) != 0) {
-        /* Error registering button callback function */
-        System_abort("Button callback failure");
+
+    if (!isActive) {
+        Clock_stop(Clock_handle(&ledClock));
     }
 }
 
-static void led_blink_task_fxn(UArg a0, UArg a1) {
-    uint32_t currVal = 0;
-    while(1) {
-        currVal =  PIN_getOutputValue(a0);
-        PIN_setOutputValue(ledPinHandle, a0, !currVal);
-        Task_sleep(LED_BLINK_INTERVAL);
-    }
+static uint16_t ms_to_led_ticks(uint16_t ms) {
+    uint16_t ticks = (ms + LED_ENGINE_TICK_MS - 1) / LED_ENGINE_TICK_MS;
+
+    return (ticks == 0) ? 1 : ticks;
 }
 
-void set_led(LED_state_t state, PIN_Id pin) {
+// A pattern with on_ticks 0 leaves the LED steady on or off
+static void start_pattern(led_id_t led, const led_pattern_t *pattern, bool isLit) {
+    led_slot_t *slot = &ledSlots[led];
+    UInt swiKey = Swi_disable();
+
+    slot->pattern = *pattern;
+    slot->pulsesLeft = pattern->pulses;
+    // Every pattern starts with the LED lit
+    slot->isLit = (pattern->on_ticks != 0) ? true : isLit;
+    slot->left = pattern->on_ticks;
+    PIN_setOutputValue(ledPinHandle, ledPins[led], slot->isLit);
+    // A steady LED leaves the clock alone, it stops on its next tick if nothing runs
+    if ((pattern->on_ticks != 0) && (!Clock_isActive(Clock_handle(&ledClock)))) {
+        Clock_start(Clock_handle(&ledClock));
+    }
+    Swi_restore(swiKey);
+}
 
-    uint8_t led_index;
-    switch(pin){
-        case Board_PIN_LED0:
-            led_index = 0;
-            break;
-        case Board_PIN_LED1:
-            led_index = 1;
-            break;
+static void set_led(LED_state_t state, led_id_t led) {
+    if ((led >= LED_COUNT) || (state > blinking)) {
+        return;
     }
-    if(current_LED_state[led_index] == state) {
+    if (current_LED_state[led] == state) {
         // This means the state doesn't change. do nothing
         return;
     }
+    current_LED_state[led] = state;
+    start_pattern(led, &ledPatterns[state], state == on);
+}
 
-    if (current_LED_state[led_index] == blinking) {
-        // Terminate the blinking LED task
-        if (ledBlinkTask[led_index]) {
-            Task_delete( &ledBlinkTask[led_index] );
-            ledBlinkTask[led_index] = NULL;
+void set_red_led(LED_state_t state) {
+    set_led(state, LED_RED);
+}
 
-        }
-        if (ledBlinkTaskStack) {
-            free(ledBlinkTaskStack);
-            ledBlinkTaskStack = NULL;
-        }
-    }
+void set_green_led(LED_state_t state) {
+    set_led(state, LED_GREEN);
+}
 
-    Task_Params ledBlinkParams;
-    uint32_t setVal = 0;
-    // Change to the new requested state
-    switch(state){
-        case on:
-            setVal = 1;
-        case off:
-            PIN_setOutputValue(ledPinHandle, pin, setVal);
-            break;
-        case blinking:
-            // Configure task
-            Task_Params_init(&ledBlinkParams);
-            ledBlinkTaskStack = (Char*)calloc(1, LED_BLINK_TASK_STACK_SIZE);
-            if (!ledBlinkTaskStack) {
-                // Failed to allocate the stack for the Blink task...
-                set_red_led(on);
-                return;
-            }
-            ledBlinkParams.stack = ledBlinkTaskStack;
-            ledBlinkParams.stackSize = LED_BLINK_TASK_STACK_SIZE;
-            ledBlinkParams.priority = LED_BLINK_TASK_PRIOTITY;
-            ledBlinkParams.arg0 = pin;
+void set_led_blink(led_id_t led, uint16_t on_ms, uint16_t off_ms, uint8_t pulses) {
+    led_pattern_t pattern;
 
-            ledBlinkTask[led_index] = Task_create((Task_FuncPtr)led_blink_task_fxn, &ledBlinkParams, NULL);
-            break;
+    if (led >= LED_COUNT) {
+        return;
     }
-
-    // Set the new state
-    current_LED_state[led_index] = state;
+    pattern.on_ticks = ms_to_led_ticks(on_ms);
+    pattern.off_ticks = ms_to_led_ticks(off_ms);
+    pattern.pulses = pulses;
+    current_LED_state[led] = LED_STATE_PATTERN;
+    start_pattern(led, &pattern, true);
 }
 
-void set_red_led(LED_state_t state) {
-    set_led(state, Board_PIN_LED0);
+void pulse_red_led(uint8_t pulses) {
+    set_led_blink(LED_RED, LED_PULSE_MS, LED_PULSE_MS, pulses);
 }
 
-void set_green_led(LED_state_t state) {
-    set_led(state, Board_PIN_LED1);
+void pulse_green_led(uint8_t pulses) {
+    set_led_blink(LED_GREEN, LED_PULSE_MS, LED_PULSE_MS, pulses);
 }
-
-
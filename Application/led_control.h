@@ -1,15 +1,19 @@
 #ifndef APPLICATION_LED_CONTROL_H_
 #define APPLICATION_LED_CONTROL_H_
 
-#include <ti/sysbios/knl/Semaphore.h>
+#include <stdint.h>
+#include <stdbool.h>
 
 #include "board.h"
 
-// How long we wait for the user to press the button before we indicate too long has passed
-#define SIGN_BUTTON_TIMEOUT 5000000
+// Resolution of all LED patterns
+#define LED_ENGINE_TICK_MS 50
 
-// Expose the semaphore used to wait for the button to be clicked
-extern Semaphore_Handle button_sem;
+// Half period of the blinking state
+#define LED_BLINK_MS 500
+
+// Half period of a pulse of pulse_*_led()
+#define LED_PULSE_MS 150
 
 typedef enum LED_state {
     off = 0,
@@ -17,6 +21,18 @@ typedef enum LED_state {
     blinking
 } LED_state_t;
 
+typedef enum led_id {
+    LED_RED = 0,
+    LED_GREEN,
+    LED_COUNT
+} led_id_t;
+
+typedef struct led_pattern {
+    uint16_t on_ticks;   // Engine ticks lit, 0 for a steady LED
+    uint16_t off_ticks;  // Engine ticks dark
+    uint8_t pulses;      // Times it lights up before it stays off, 0 to repeat forever
+} led_pattern_t;
+
 /*
  * Initializes the state of the boards LEDs
  */
@@ -25,4 +41,13 @@ void init_LED_pins();
 void set_red_led(LED_state_t state);
 void set_green_led(LED_state_t state);
 
+/*
+ * Blinks an LED at the given rate, rounded to LED_ENGINE_TICK_MS. With pulses set it
+ * lights up that many times and then stays off.
+ */
+void set_led_blink(led_id_t led, uint16_t on_ms, uint16_t off_ms, uint8_t pulses);
+
+void pulse_red_led(uint8_t pulses);
+void pulse_green_led(uint8_t pulses);
+
 #endif /* APPLICATION_LED_CONTROL_H_ */
@@ -0,0 +1,111 @@
+#include "msg_pool.h"
+
+#include <string.h>
+#include <ti/sysbios/hal/Hwi.h>
+
+#include "icall.h"
+
+/*
+ * Fixed size blocks for the messages the application queues to itself.
+ *
+ * Every GATT write, state change and OAD block used to take an ICall_malloc() and an
+ * ICall_free() on the heap the stack allocates from too, in whatever context the
+ * callback ran. A pool hands out blocks from a free list threaded through the unused
+ * blocks themselves, so taking or returning one is a pointer swap with the interrupts
+ * held off for a few instructions. Only when every block is out does it fall back to
+ * the heap, and the block's address tells msg_pool_free() where it has to go back to.
+ */
+
+void msg_pool_init(msg_pool_t *pool, uintptr_t *storage, uint16_t blockSize, uint8_t count) {
+    uint16_t stride = MSG_POOL_BLOCK_WORDS(blockSize) * sizeof(uintptr_t);
+    uint8_t *block;
+    uint8_t i;
+
+    memset(pool, 0, sizeof(msg_pool_t));
+    pool->blockSize = blockSize;
+    pool->count = count;
+    pool->first = (uint8_t *) storage;
+    pool->end = pool->first + (uint32_t) stride * count;
+
+    // Chain the blocks back to front so the first one is handed out first
+    for (i = count; i > 0; i--) {
+        block = pool->first + (uint32_t) stride * (i - 1);
+        *(void **) block = pool->freeList;
+        pool->freeList = block;
+    }
+}
+
+void *msg_pool_alloc(msg_pool_t *pool) {
+    void *block;
+    UInt hwiKey;
+
+    hwiKey = Hwi_disable();
+    block = pool->freeList;
+    if (block) {
+        pool->freeList = *(void **) block;
+        pool->stats.allocs++;
+        pool->stats.in_use++;
+        if (pool->stats.in_use > pool->stats.max_in_use) {
+            pool->stats.max_in_use = pool->stats.in_use;
+        }
+    }
+    Hwi_restore(hwiKey);
+
+    if (block) {
+        return block;
+    }
+
+    block = ICall_malloc(pool->blockSize);
+    hwiKey = Hwi_disable();
+    if (block) {
+        pool->stats.heap_allocs++;
+    }
+    else {
+        pool->stats.failures++;
+    }
+    Hwi_restore(hwiKey);
+    return block;
+}
+
+void msg_pool_free(msg_pool_t *pool, void *block) {
+    UInt hwiKey;
+
+    if (!block) {
+        return;
+    }
+
+    if (((uint8_t *) block < pool->first) || ((uint8_t *) block >= pool->end)) {
+        ICall_free(block);
+        return;
+    }
+
+    hwiKey = Hwi_disable();
+    *(void **) block = pool->freeList;
+    pool->freeList = block;
+    pool->stats.frees++;
+    pool->stats.in_use--;
+    Hwi_restore(hwiKey);
+}
+
+void msg_pool_get_stats(msg_pool_t *pool, msg_pool_stats_t *stats) {
+    UInt hwiKey;
+
+    if (!stats) {
+        return;
+    }
+
+    hwiKey = Hwi_disable();
+    memcpy(stats, &pool->stats, sizeof(msg_pool_stats_t));
+    Hwi_restore(hwiKey);
+}
+
+void msg_pool_reset_stats(msg_pool_t *pool) {
+    UInt hwiKey = Hwi_disable();
+    uint8_t inUse = pool->stats.in_use;
+
+    memset(&pool->stats, 0, sizeof(msg_pool_stats_t));
+    // Blocks still out have to be counted back in
+    pool->stats.in_use = inUse;
+    pool->stats.max_in_use = inUse;
+    Hwi_restore(hwiKey);
+}
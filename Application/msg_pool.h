@@ -0,0 +1,53 @@
+#ifndef APPLICATION_MSG_POOL_H_
+#define APPLICATION_MSG_POOL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Blocks are handed out aligned for the pointer a free block holds, whatever size was
+// asked for, a word on the device
+#define MSG_POOL_BLOCK_WORDS(size) (((size) + sizeof(uintptr_t) - 1) / sizeof(uintptr_t))
+
+// Declares the storage of a pool of count blocks of size bytes
+#define MSG_POOL_STORAGE(name, size, count) \
+    static uintptr_t name[MSG_POOL_BLOCK_WORDS(size) * (count)]
+
+typedef struct msg_pool_stats {
+    uint32_t allocs;        // Blocks handed out from the pool
+    uint32_t heap_allocs;   // Pool was empty, the block came from the ICall heap
+    uint32_t failures;      // Neither the pool nor the heap had a block
+    uint32_t frees;
+    uint8_t in_use;         // Pool blocks handed out right now
+    uint8_t max_in_use;
+} msg_pool_stats_t;
+
+typedef struct msg_pool {
+    uint8_t *first;         // First block of the storage
+    uint8_t *end;           // Just past the last block
+    void *freeList;         // A free block holds the pointer to the next one
+    uint16_t blockSize;
+    uint8_t count;
+    msg_pool_stats_t stats;
+} msg_pool_t;
+
+/*
+ * Carves the storage into count blocks of blockSize bytes. The storage has to come
+ * from MSG_POOL_STORAGE with the same size and count.
+ */
+void msg_pool_init(msg_pool_t *pool, uintptr_t *storage, uint16_t blockSize, uint8_t count);
+
+/*
+ * A block of the pool's size, from the ICall heap once the pool ran dry.
+ * Safe to call from any task or Swi.
+ */
+void *msg_pool_alloc(msg_pool_t *pool);
+
+/*
+ * Returns a block from msg_pool_alloc() to wherever it came from
+ */
+void msg_pool_free(msg_pool_t *pool, void *block);
+
+void msg_pool_get_stats(msg_pool_t *pool, msg_pool_stats_t *stats);
+void msg_pool_reset_stats(msg_pool_t *pool);
+
+#endif /* APPLICATION_MSG_POOL_H_ */
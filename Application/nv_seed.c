@@ -0,0 +1,164 @@
+#include "nv_seed.h"
+
+#include <string.h>
+
+#include "bcomdef.h"
+#include "osal_snv.h"
+#include "trace.h"
+
+/*
+ * Entropy seed kept in the stack's simple NV (MBEDTLS_ENTROPY_NV_SEED).
+ *
+ * The entropy module mixes the stored seed into its first output and writes a new one
+ * before handing anything out, so the DRBG starts from accumulated entropy after a reset.
+ * The seed is one SNV item. SNV appends every write to its page and compacts the page
+ * when it is full, so the writes are spread over the page. SNV also waits for the radio
+ * before it erases or programs flash. Its pages are outside the image, so an OAD or a
+ * reflash of the image keeps the seed, and only a full chip erase loses it. The record
+ * carries a CRC of its own, so a seed that does not read back intact counts for nothing.
+ *
+ * A seed is written once per boot at most. The first write already replaces the seed
+ * this boot started from, every entropy context made after it would only wear the
+ * flash and stall the task for a page compaction now and then.
+ */
+
+#define NV_SEED_MAGIC 0x5EED5EEDu
+
+typedef struct nv_seed_record {
+    uint32_t magic;
+    uint32_t sequence;   // Counts the writes, for the stats
+    uint32_t length;
+    unsigned char seed[NV_SEED_MAX_LEN];
+    uint32_t crc;        // CRC-32 of everything above
+} nv_seed_record_t;
+
+static bool isScanned = false;
+static bool hasLatest = false;
+static uint32_t latestSequence = 0;
+static bool isWrittenThisBoot = false;
+
+static nv_seed_stats_t seedStats;
+
+static uint32_t nv_seed_crc(const nv_seed_record_t *record) {
+    const unsigned char *p = (const unsigned char *) record;
+    size_t len = offsetof(nv_seed_record_t, crc);
+    uint32_t crc = 0xFFFFFFFFu;
+    int bit;
+
+    while (len--) {
+        crc ^= *p++;
+        for (bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+static bool is_valid(const nv_seed_record_t *record) {
+    return (record->magic == NV_SEED_MAGIC) &&
+           (record->length > 0) && (record->length <= NV_SEED_MAX_LEN) &&
+           (record->crc == nv_seed_crc(record));
+}
+
+static bool read_record(nv_seed_record_t *record) {
+    return (osal_snv_read(NV_SEED_SNV_ID, sizeof(nv_seed_record_t), record) == SUCCESS) &&
+           is_valid(record);
+}
+
+// Looks for a stored seed once, SNV keeps the item where osal_snv_read() finds it
+static void nv_seed_scan() {
+    nv_seed_record_t record;
+
+    hasLatest = read_record(&record);
+    if (hasLatest) {
+        latestSequence = record.sequence;
+    }
+    memset(&record, 0, sizeof(record));
+    isScanned = true;
+}
+
+int nv_seed_read(unsigned char *buf, size_t buf_len) {
+    nv_seed_record_t record;
+    size_t len;
+
+    if (!isScanned) {
+        nv_seed_scan();
+    }
+    seedStats.reads++;
+
+    if (!hasLatest) {
+        // Nothing stored yet, the TRNG has to provide all of it this time
+        seedStats.empty_reads++;
+        return 0;
+    }
+
+    if (!read_record(&record)) {
+        // The item changed under us, look again on the next read
+        isScanned = false;
+        seedStats.failures++;
+        memset(&record, 0, sizeof(record));
+        return -1;
+    }
+
+    len = (buf_len < record.length) ? buf_len : record.length;
+    memcpy(buf, record.seed, len);
+    memset(&record, 0, sizeof(record));
+    return (int) len;
+}
+
+int nv_seed_write(unsigned char *buf, size_t buf_len) {
+    nv_seed_record_t record;
+    int ret = -1;
+
+    if ((!buf) || (buf_len == 0) || (buf_len > NV_SEED_MAX_LEN)) {
+        return -1;
+    }
+    if (!isScanned) {
+        nv_seed_scan();
+    }
+    if (isWrittenThisBoot) {
+        // The seed this boot started from is replaced already
+        seedStats.skipped++;
+        return (int) buf_len;
+    }
+
+    memset(&record, 0, sizeof(record));
+    record.magic = NV_SEED_MAGIC;
+    record.sequence = latestSequence + 1;
+    record.length = buf_len;
+    memcpy(record.seed, buf, buf_len);
+    record.crc = nv_seed_crc(&record);
+
+    if (osal_snv_write(NV_SEED_SNV_ID, sizeof(nv_seed_record_t), &record) == SUCCESS) {
+        hasLatest = true;
+        latestSequence = record.sequence;
+        seedStats.writes++;
+        isWrittenThisBoot = true;
+        ret = (int) buf_len;
+    }
+    else {
+        seedStats.failures++;
+    }
+
+    memset(&record, 0, sizeof(record));
+    if (ret < 0) {
+        TRACE(TRACE_SEED_WRITE_FAILED, ret);
+    }
+    return ret;
+}
+
+bool nv_seed_stored() {
+    if (!isScanned) {
+        nv_seed_scan();
+    }
+    return hasLatest;
+}
+
+void nv_seed_get_stats(nv_seed_stats_t *stats) {
+    if (!stats) {
+        return;
+    }
+
+    memcpy(stats, &seedStats, sizeof(nv_seed_stats_t));
+    stats->sequence = latestSequence;
+}
@@ -0,0 +1,52 @@
+#ifndef APPLICATION_NV_SEED_H_
+#define APPLICATION_NV_SEED_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// SNV item of the seed, BLE_NVID_CUST_START is the first ID left to the application
+#ifndef NV_SEED_SNV_ID
+#define NV_SEED_SNV_ID BLE_NVID_CUST_START
+#endif
+
+// Largest seed a record holds, MBEDTLS_ENTROPY_BLOCK_SIZE with the SHA-512 accumulator
+#define NV_SEED_MAX_LEN 64
+
+// TRNG bytes the entropy collector still waits for when a stored seed is mixed in,
+// instead of MBEDTLS_ENTROPY_MIN_HARDWARE without one
+#ifndef NV_SEED_MIN_HARDWARE
+#define NV_SEED_MIN_HARDWARE 16
+#endif
+
+typedef struct nv_seed_stats {
+    uint32_t reads;        // nv_seed_read() calls
+    uint32_t writes;       // Records written to SNV
+    uint32_t empty_reads;  // Reads that found no valid record and returned nothing
+    uint32_t skipped;      // Writes left out, a seed was written this boot already
+    uint32_t failures;     // SNV writes that failed and records that did not read back intact
+    uint32_t sequence;     // Writes of the latest record since the SNV item was made
+} nv_seed_stats_t;
+
+/*
+ * Reads the stored seed into buf.
+ * Until a seed has been written (first boot) it reads nothing and returns 0.
+ * Returns the number of bytes read or -1 on failure, like mbedtls_nv_seed_read().
+ */
+int nv_seed_read(unsigned char *buf, size_t buf_len);
+
+/*
+ * Replaces the stored seed, SNV spreads the writes over its page.
+ * Only the first write of a boot is programmed, later ones succeed without writing.
+ * Returns the number of bytes written or -1 on failure, like mbedtls_nv_seed_write().
+ */
+int nv_seed_write(unsigned char *buf, size_t buf_len);
+
+/*
+ * A valid seed record is stored
+ */
+bool nv_seed_stored();
+
+void nv_seed_get_stats(nv_seed_stats_t *stats);
+
+#endif /* APPLICATION_NV_SEED_H_ */
@@ -53,16 +53,20 @@
 /*
  * Macro to generate an internal function for oid_XXX_from_asn1() (used by
  * the other functions)
+ *
+ * The OIDs of one list share their arcs up to the last one, so entries are
+ * told apart by length and last byte before the full compare.
  */
 #define FN_OID_TYPED_FROM_ASN1( TYPE_T, NAME, LIST )                        \
 static const TYPE_T * oid_ ## NAME ## _from_asn1( const mbedtls_asn1_buf *oid )     \
 {                                                                           \
     const TYPE_T *p = LIST;                                                 \
     const mbedtls_oid_descriptor_t *cur = (const mbedtls_oid_descriptor_t *) p;             \
-    if( p == NULL || oid == NULL ) return( NULL );                          \
+    if( p == NULL || oid == NULL || oid->len == 0 ) return( NULL );         \
     while( cur->asn1 != NULL ) {                                            \
         if( cur->asn1_len == oid->len &&                                    \
-            memcmp( cur->asn1, oid->p, oid->len ) == 0 ) {                  \
+            cur->asn1[oid->len - 1] == (char) oid->p[oid->len - 1] &&       \
+            memcmp( cur->asn1, oid->p, oid->len - 1 ) == 0 ) {              \
             return( p );                                                    \
         }                                                                   \
         p++;                                                                \
@@ -152,6 +156,31 @@ int FN_NAME( ATTR1_TYPE ATTR1, ATTR2_TYPE ATTR2, const char **oid ,         \
     return( MBEDTLS_ERR_OID_NOT_FOUND );                                   \
 }
 
+/*
+ * Reverse index entry, the OID for one value of an attribute enum
+ */
+typedef struct {
+    const char *asn1;
+    size_t      asn1_len;
+} oid_index_t;
+
+#define OID_INDEX_NONE  { NULL, 0 }
+
+/*
+ * Macro to generate a function for retrieving the OID based on an enum
+ * attribute from a reverse index that is in enum order.
+ */
+#define FN_OID_GET_OID_BY_INDEX(FN_NAME, INDEX, ATTR1_TYPE, ATTR1)          \
+int FN_NAME( ATTR1_TYPE ATTR1, const char **oid, size_t *olen )             \
+{                                                                           \
+    if( (size_t) ATTR1 >= sizeof( INDEX ) / sizeof( INDEX[0] ) ||           \
+        INDEX[ATTR1].asn1 == NULL )                                         \
+        return( MBEDTLS_ERR_OID_NOT_FOUND );                               \
+    *oid = INDEX[ATTR1].asn1;                                               \
+    *olen = INDEX[ATTR1].asn1_len;                                          \
+    return( 0 );                                                            \
+}
+
 #if defined(MBEDTLS_X509_USE_C) || defined(MBEDTLS_X509_CREATE_C)
 /*
  * For X520 attribute types
@@ -409,7 +438,111 @@ static const oid_sig_alg_t oid_sig_alg[] =
 FN_OID_TYPED_FROM_ASN1(oid_sig_alg_t, sig_alg, oid_sig_alg)
 FN_OID_GET_DESCRIPTOR_ATTR1(mbedtls_oid_get_sig_alg_desc, oid_sig_alg_t, sig_alg, const char *, description)
 FN_OID_GET_ATTR2(mbedtls_oid_get_sig_alg, oid_sig_alg_t, sig_alg, mbedtls_md_type_t, md_alg, mbedtls_pk_type_t, pk_alg)
-FN_OID_GET_OID_BY_ATTR2(mbedtls_oid_get_oid_by_sig_alg, oid_sig_alg_t, oid_sig_alg, mbedtls_pk_type_t, pk_alg, mbedtls_md_type_t, md_alg)
+
+/*
+ * Reverse index for mbedtls_oid_get_oid_by_sig_alg(), one row per pk_alg in
+ * mbedtls_md_type_t order. Has to agree with oid_sig_alg above, where the
+ * first match wins.
+ */
+#if defined(MBEDTLS_RSA_C)
+static const oid_index_t oid_sig_alg_rsa[] =
+{
+    OID_INDEX_NONE,                                     /* MBEDTLS_MD_NONE */
+#if defined(MBEDTLS_MD2_C)
+    { ADD_LEN( MBEDTLS_OID_PKCS1_MD2 ) },
+#else
+    OID_INDEX_NONE,
+#endif
+#if defined(MBEDTLS_MD4_C)
+    { ADD_LEN( MBEDTLS_OID_PKCS1_MD4 ) },
+#else
+    OID_INDEX_NONE,
+#endif
+#if defined(MBEDTLS_MD5_C)
+    { ADD_LEN( MBEDTLS_OID_PKCS1_MD5 ) },
+#else
+    OID_INDEX_NONE,
+#endif
+#if defined(MBEDTLS_SHA1_C)
+    { ADD_LEN( MBEDTLS_OID_PKCS1_SHA1 ) },
+#else
+    OID_INDEX_NONE,
+#endif
+#if defined(MBEDTLS_SHA256_C)
+    { ADD_LEN( MBEDTLS_OID_PKCS1_SHA224 ) },
+    { ADD_LEN( MBEDTLS_OID_PKCS1_SHA256 ) },
+#else
+    OID_INDEX_NONE,
+    OID_INDEX_NONE,
+#endif
+#if defined(MBEDTLS_SHA512_C)
+    { ADD_LEN( MBEDTLS_OID_PKCS1_SHA384 ) },
+    { ADD_LEN( MBEDTLS_OID_PKCS1_SHA512 ) },
+#else
+    OID_INDEX_NONE,
+    OID_INDEX_NONE,
+#endif
+};
+
+static const oid_index_t oid_sig_alg_rsassa_pss[] =
+{
+    { ADD_LEN( MBEDTLS_OID_RSASSA_PSS ) },              /* MBEDTLS_MD_NONE */
+};
+
+static FN_OID_GET_OID_BY_INDEX(oid_get_oid_by_sig_alg_rsa, oid_sig_alg_rsa, mbedtls_md_type_t, md_alg)
+static FN_OID_GET_OID_BY_INDEX(oid_get_oid_by_sig_alg_rsassa_pss, oid_sig_alg_rsassa_pss, mbedtls_md_type_t, md_alg)
+#endif /* MBEDTLS_RSA_C */
+
+#if defined(MBEDTLS_ECDSA_C)
+static const oid_index_t oid_sig_alg_ecdsa[] =
+{
+    OID_INDEX_NONE,                                     /* MBEDTLS_MD_NONE */
+    OID_INDEX_NONE,                                     /* MBEDTLS_MD_MD2 */
+    OID_INDEX_NONE,                                     /* MBEDTLS_MD_MD4 */
+    OID_INDEX_NONE,                                     /* MBEDTLS_MD_MD5 */
+#if defined(MBEDTLS_SHA1_C)
+    { ADD_LEN( MBEDTLS_OID_ECDSA_SHA1 ) },
+#else
+    OID_INDEX_NONE,
+#endif
+#if defined(MBEDTLS_SHA256_C)
+    { ADD_LEN( MBEDTLS_OID_ECDSA_SHA224 ) },
+    { ADD_LEN( MBEDTLS_OID_ECDSA_SHA256 ) },
+#else
+    OID_INDEX_NONE,
+    OID_INDEX_NONE,
+#endif
+#if defined(MBEDTLS_SHA512_C)
+    { ADD_LEN( MBEDTLS_OID_ECDSA_SHA384 ) },
+    { ADD_LEN( MBEDTLS_OID_ECDSA_SHA512 ) },
+#else
+    OID_INDEX_NONE,
+    OID_INDEX_NONE,
+#endif
+};
+
+static FN_OID_GET_OID_BY_INDEX(oid_get_oid_by_sig_alg_ecdsa, oid_sig_alg_ecdsa, mbedtls_md_type_t, md_alg)
+#endif /* MBEDTLS_ECDSA_C */
+
+int mbedtls_oid_get_oid_by_sig_alg( mbedtls_pk_type_t pk_alg, mbedtls_md_type_t md_alg,
+                                    const char **oid, size_t *olen )
+{
+    switch( pk_alg )
+    {
+#if defined(MBEDTLS_RSA_C)
+        case MBEDTLS_PK_RSA:
+            return( oid_get_oid_by_sig_alg_rsa( md_alg, oid, olen ) );
+        case MBEDTLS_PK_RSASSA_PSS:
+            return( oid_get_oid_by_sig_alg_rsassa_pss( md_alg, oid, olen ) );
+#endif /* MBEDTLS_RSA_C */
+#if defined(MBEDTLS_ECDSA_C)
+        case MBEDTLS_PK_ECDSA:
+            return( oid_get_oid_by_sig_alg_ecdsa( md_alg, oid, olen ) );
+#endif /* MBEDTLS_ECDSA_C */
+        default:
+            return( MBEDTLS_ERR_OID_NOT_FOUND );
+    }
+}
 #endif /* MBEDTLS_MD_C */
 
 /*
@@ -624,7 +757,51 @@ static const oid_md_alg_t oid_md_alg[] =
 
 FN_OID_TYPED_FROM_ASN1(oid_md_alg_t, md_alg, oid_md_alg)
 FN_OID_GET_ATTR1(mbedtls_oid_get_md_alg, oid_md_alg_t, md_alg, mbedtls_md_type_t, md_alg)
-FN_OID_GET_OID_BY_ATTR1(mbedtls_oid_get_oid_by_md, oid_md_alg_t, oid_md_alg, mbedtls_md_type_t, md_alg)
+
+/*
+ * Reverse index for mbedtls_oid_get_oid_by_md(), in mbedtls_md_type_t order.
+ * Every PKCS#1 v1.5 signature looks its DigestInfo OID up here.
+ */
+static const oid_index_t oid_md_alg_index[] =
+{
+    OID_INDEX_NONE,                                     /* MBEDTLS_MD_NONE */
+#if defined(MBEDTLS_MD2_C)
+    { ADD_LEN( MBEDTLS_OID_DIGEST_ALG_MD2 ) },
+#else
+    OID_INDEX_NONE,
+#endif
+#if defined(MBEDTLS_MD4_C)
+    { ADD_LEN( MBEDTLS_OID_DIGEST_ALG_MD4 ) },
+#else
+    OID_INDEX_NONE,
+#endif
+#if defined(MBEDTLS_MD5_C)
+    { ADD_LEN( MBEDTLS_OID_DIGEST_ALG_MD5 ) },
+#else
+    OID_INDEX_NONE,
+#endif
+#if defined(MBEDTLS_SHA1_C)
+    { ADD_LEN( MBEDTLS_OID_DIGEST_ALG_SHA1 ) },
+#else
+    OID_INDEX_NONE,
+#endif
+#if defined(MBEDTLS_SHA256_C)
+    { ADD_LEN( MBEDTLS_OID_DIGEST_ALG_SHA224 ) },
+    { ADD_LEN( MBEDTLS_OID_DIGEST_ALG_SHA256 ) },
+#else
+    OID_INDEX_NONE,
+    OID_INDEX_NONE,
+#endif
+#if defined(MBEDTLS_SHA512_C)
+    { ADD_LEN( MBEDTLS_OID_DIGEST_ALG_SHA384 ) },
+    { ADD_LEN( MBEDTLS_OID_DIGEST_ALG_SHA512 ) },
+#else
+    OID_INDEX_NONE,
+    OID_INDEX_NONE,
+#endif
+};
+
+FN_OID_GET_OID_BY_INDEX(mbedtls_oid_get_oid_by_md, oid_md_alg_index, mbedtls_md_type_t, md_alg)
 #endif /* MBEDTLS_MD_C */
 
 #if defined(MBEDTLS_PKCS12_C)
@@ -55,6 +55,13 @@ void mbedtls_pem_init( mbedtls_pem_context *ctx )
     memset( ctx, 0, sizeof( mbedtls_pem_context ) );
 }
 
+void mbedtls_pem_set_buffer( mbedtls_pem_context *ctx,
+                             unsigned char *buf, size_t size )
+{
+    ctx->dst = buf;
+    ctx->dstlen = size;
+}
+
 #if defined(MBEDTLS_MD5_C) && defined(MBEDTLS_CIPHER_MODE_CBC) &&         \
     ( defined(MBEDTLS_DES_C) || defined(MBEDTLS_AES_C) )
 /*
@@ -203,12 +210,24 @@ static void pem_aes_decrypt( unsigned char aes_iv[16], unsigned int keylen,
 #endif /* MBEDTLS_MD5_C && MBEDTLS_CIPHER_MODE_CBC &&
           ( MBEDTLS_AES_C || MBEDTLS_DES_C ) */
 
+/*
+ * Wipe decoded data and free it unless it is in the caller's buffer
+ */
+static void pem_release( mbedtls_pem_context *ctx, unsigned char *buf,
+                         size_t len )
+{
+    mbedtls_zeroize( buf, len );
+
+    if( buf != ctx->dst )
+        mbedtls_free( buf );
+}
+
 int mbedtls_pem_read_buffer( mbedtls_pem_context *ctx, const char *header, const char *footer,
                      const unsigned char *data, const unsigned char *pwd,
                      size_t pwdlen, size_t *use_len )
 {
     int ret, enc;
-    size_t len;
+    size_t len, size;
     unsigned char *buf;
     const unsigned char *s1, *s2, *end;
 #if defined(MBEDTLS_MD5_C) && defined(MBEDTLS_CIPHER_MODE_CBC) &&         \
@@ -321,17 +340,25 @@ int mbedtls_pem_read_buffer( mbedtls_pem_context *ctx, const char *header, const
     if( s1 >= s2 )
         return( MBEDTLS_ERR_PEM_INVALID_DATA );
 
-    ret = mbedtls_base64_decode( NULL, 0, &len, s1, s2 - s1 );
-
-    if( ret == MBEDTLS_ERR_BASE64_INVALID_CHARACTER )
-        return( MBEDTLS_ERR_PEM_INVALID_DATA + ret );
+    /*
+     * Decode in a single pass. Four characters never give more than three
+     * bytes, so the output is bounded by the base64 text and there is no
+     * need for a sizing pass.
+     */
+    size = ( ( s2 - s1 ) / 4 ) * 3 + 3;
 
-    if( ( buf = mbedtls_calloc( 1, len ) ) == NULL )
+    if( ctx->dst != NULL )
+    {
+        buf = ctx->dst;
+        if( ctx->dstlen < size )
+            size = ctx->dstlen;
+    }
+    else if( ( buf = mbedtls_calloc( 1, size ) ) == NULL )
         return( MBEDTLS_ERR_PEM_ALLOC_FAILED );
 
-    if( ( ret = mbedtls_base64_decode( buf, len, &len, s1, s2 - s1 ) ) != 0 )
+    if( ( ret = mbedtls_base64_decode( buf, size, &len, s1, s2 - s1 ) ) != 0 )
     {
-        mbedtls_free( buf );
+        pem_release( ctx, buf, size );
         return( MBEDTLS_ERR_PEM_INVALID_DATA + ret );
     }
 
@@ -341,7 +368,7 @@ int mbedtls_pem_read_buffer( mbedtls_pem_context *ctx, const char *header, const
     ( defined(MBEDTLS_DES_C) || defined(MBEDTLS_AES_C) )
         if( pwd == NULL )
         {
-            mbedtls_free( buf );
+            pem_release( ctx, buf, len );
             return( MBEDTLS_ERR_PEM_PASSWORD_REQUIRED );
         }
 
@@ -369,11 +396,11 @@ int mbedtls_pem_read_buffer( mbedtls_pem_context *ctx, const char *header, const
          */
         if( len <= 2 || buf[0] != 0x30 || buf[1] > 0x83 )
         {
-            mbedtls_free( buf );
+            pem_release( ctx, buf, len );
             return( MBEDTLS_ERR_PEM_PASSWORD_MISMATCH );
         }
 #else
-        mbedtls_free( buf );
+        pem_release( ctx, buf, len );
         return( MBEDTLS_ERR_PEM_FEATURE_UNAVAILABLE );
 #endif /* MBEDTLS_MD5_C && MBEDTLS_CIPHER_MODE_CBC &&
           ( MBEDTLS_AES_C || MBEDTLS_DES_C ) */
@@ -387,7 +414,8 @@ int mbedtls_pem_read_buffer( mbedtls_pem_context *ctx, const char *header, const
 
 void mbedtls_pem_free( mbedtls_pem_context *ctx )
 {
-    mbedtls_free( ctx->buf );
+    if( ctx->buf != NULL )
+        pem_release( ctx, ctx->buf, ctx->buflen );
     mbedtls_free( ctx->info );
 
     mbedtls_zeroize( ctx, sizeof( mbedtls_pem_context ) );
@@ -46,6 +46,7 @@
 
 #include "mbedtls/rsa.h"
 #include "mbedtls/oid.h"
+#include "latency.h"
 
 #include <string.h>
 
@@ -417,7 +418,7 @@ int mbedtls_rsa_private( mbedtls_rsa_context *ctx,
         return( MBEDTLS_ERR_RSA_BAD_INPUT_DATA );
 
     // Allocate room for number operations. (Use heap to save stack space)
-    T = calloc(3, sizeof(mbedtls_mpi));
+    T = mbedtls_calloc(3, sizeof(mbedtls_mpi));
     if (!T) {
         return MBEDTLS_ERR_RSA_OUTPUT_TOO_LARGE;
     }
@@ -438,7 +439,7 @@ int mbedtls_rsa_private( mbedtls_rsa_context *ctx,
 
 #if defined(MBEDTLS_THREADING_C)
     if( ( ret = mbedtls_mutex_lock( &ctx->mutex ) ) != 0 ) {
-        free(T);
+        mbedtls_free(T);
         return( ret );
     }
 #endif
@@ -551,7 +552,7 @@ cleanup:
     mbedtls_mpi_free( &P1 ); mbedtls_mpi_free( &Q1 ); mbedtls_mpi_free( &R );
 
     if (T)
-        free(T);
+        mbedtls_free(T);
 
     if( f_rng != NULL )
     {
@@ -1179,6 +1180,7 @@ int mbedtls_rsa_rsassa_pkcs1_v15_sign( mbedtls_rsa_context *ctx,
     unsigned char diff;
     volatile unsigned char diff_no_optimize;
     int ret;
+    uint32_t start;
 
     if( mode == MBEDTLS_RSA_PRIVATE && ctx->padding != MBEDTLS_RSA_PKCS_V15 )
         return( MBEDTLS_ERR_RSA_BAD_INPUT_DATA );
@@ -1259,13 +1261,18 @@ int mbedtls_rsa_rsassa_pkcs1_v15_sign( mbedtls_rsa_context *ctx,
         return( MBEDTLS_ERR_MPI_ALLOC_FAILED );
     }
 
+    start = latency_start( LATENCY_RSA_PRIVATE );
     MBEDTLS_MPI_CHK( mbedtls_rsa_private( ctx, f_rng, p_rng, sig, sig_try ) );
+    latency_stop( LATENCY_RSA_PRIVATE, start );
+
+    start = latency_start( LATENCY_VERIFY );
     MBEDTLS_MPI_CHK( mbedtls_rsa_public( ctx, sig_try, verif ) );
 
     /* Compare in constant time just in case */
     for( diff = 0, i = 0; i < ctx->len; i++ )
         diff |= verif[i] ^ sig[i];
     diff_no_optimize = diff;
+    latency_stop( LATENCY_VERIFY, start );
 
     if( diff_no_optimize != 0 )
     {
@@ -0,0 +1,427 @@
+#include "self_test.h"
+
+#ifdef SIGNER_SELF_TEST
+#include <string.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <inc/hw_types.h>
+#include <inc/hw_memmap.h>
+#include <inc/hw_cpu_dwt.h>
+
+#include "mbedtls/aes.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/md.h"
+#include "mbedtls/ccm.h"
+#include "mbedtls/base64.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/bignum.h"
+#include "mbedtls/rsa.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/platform.h"
+
+#include "signer.h"
+#include "sign_power.h"
+#include "latency.h"
+#endif // SIGNER_SELF_TEST
+
+/*
+ * Self test and benchmark of the mbedTLS this firmware is built with.
+ *
+ * The configuration is trimmed and partly replaced, AES runs on the crypto module
+ * through aes_alt.c, RSA goes without the CRT and SHA-256 is the small variant, so
+ * numbers from a stock mbedTLS say little about it. A build with SIGNER_SELF_TEST
+ * turns MBEDTLS_SELF_TEST on, and writing DIAGNOSTICS_RUN_SELF_TEST to the
+ * Diagnostics characteristic runs the self tests of the modules and then times every
+ * primitive the signer uses with the real key. The results are read back from the
+ * same characteristic, one fixed size record per case, and
+ * TOOLS/self_test_report.py turns them into CSV lines to compare builds with. Every
+ * case counts the CPU cycles, which stop while the core sleeps, and the Clock time.
+ */
+
+#ifdef SIGNER_SELF_TEST
+
+// Largest signature the benchmark makes, a 2048 bit key
+#define SELF_TEST_SIG_LEN   256
+
+typedef struct self_test_result {
+    int32_t status;
+    uint16_t iterations;
+    uint32_t cycles;
+    uint32_t us;
+} self_test_result_t;
+
+typedef int (*self_test_fn_t)(void);
+
+static self_test_result_t results[SELF_TEST_CASE_COUNT];
+static bool hasResults = false;
+
+// What the benchmarks work on, set up as they go
+static struct {
+    mbedtls_aes_context aes;
+    mbedtls_ccm_context ccm;
+    unsigned char iv[16];
+    unsigned char stream[16];
+    size_t off;
+    mbedtls_entropy_context *entropy;
+    mbedtls_ctr_drbg_context *drbg;
+    mbedtls_rsa_context *rsa;
+    mbedtls_mpi A;
+    mbedtls_mpi X;
+    mbedtls_mpi RR;
+    unsigned char hash[32];
+    unsigned char tag[8];
+    unsigned char sig[SELF_TEST_SIG_LEN];
+} bench;
+
+static unsigned char input[256];
+static unsigned char output[256];
+
+static void put_u16(uint8_t *buf, uint16_t value) {
+    buf[0] = value & 0xFF;
+    buf[1] = (value >> 8) & 0xFF;
+}
+
+static void put_u32(uint8_t *buf, uint32_t value) {
+    put_u16(buf, value & 0xFFFF);
+    put_u16(buf + 2, value >> 16);
+}
+
+static uint32_t cycles_now() {
+    return HWREG(CPU_DWT_BASE + CPU_DWT_O_CYCCNT);
+}
+
+// Runs fn up to iterations times, stops at the first failure
+static void run_case(self_test_id_t id, self_test_fn_t fn, uint16_t iterations) {
+    self_test_result_t *result = &results[id];
+    uint32_t ticks;
+    uint32_t cycles;
+    int status = 0;
+    uint16_t i;
+
+    latency_enable_counter();
+    ticks = Clock_getTicks();
+    cycles = cycles_now();
+
+    for (i = 0; (i < iterations) && (status == 0); i++) {
+        status = fn();
+    }
+
+    result->cycles = cycles_now() - cycles;
+    result->us = (Clock_getTicks() - ticks) * Clock_tickPeriod;
+    result->iterations = i;
+    result->status = status;
+}
+
+static int test_aes()       { return mbedtls_aes_self_test(0); }
+static int test_sha256()    { return mbedtls_sha256_self_test(0); }
+static int test_ccm()       { return mbedtls_ccm_self_test(0); }
+static int test_base64()    { return mbedtls_base64_self_test(0); }
+static int test_ctr_drbg()  { return mbedtls_ctr_drbg_self_test(0); }
+static int test_entropy()   { return mbedtls_entropy_self_test(0); }
+static int test_mpi()       { return mbedtls_mpi_self_test(0); }
+static int test_rsa()       { return mbedtls_rsa_self_test(0); }
+
+static int aes_ecb_16() {
+    return mbedtls_aes_crypt_ecb(&bench.aes, MBEDTLS_AES_ENCRYPT, input, output);
+}
+
+static int aes_cbc(size_t len) {
+    return mbedtls_aes_crypt_cbc(&bench.aes, MBEDTLS_AES_ENCRYPT, len, bench.iv, input, output);
+}
+static int aes_cbc_16()     { return aes_cbc(16); }
+static int aes_cbc_256()    { return aes_cbc(256); }
+
+static int aes_cfb(size_t len) {
+    return mbedtls_aes_crypt_cfb128(&bench.aes, MBEDTLS_AES_ENCRYPT, len, &bench.off, bench.iv,
+                                    input, output);
+}
+static int aes_cfb_16()     { return aes_cfb(16); }
+static int aes_cfb_256()    { return aes_cfb(256); }
+
+static int aes_ctr(size_t len) {
+    return mbedtls_aes_crypt_ctr(&bench.aes, len, &bench.off, bench.iv, bench.stream,
+                                 input, output);
+}
+static int aes_ctr_16()     { return aes_ctr(16); }
+static int aes_ctr_256()    { return aes_ctr(256); }
+
+// In place with a 13 byte nonce and an 8 byte tag, like the sealed challenge channel
+static int ccm_encrypt(size_t len) {
+    return mbedtls_ccm_encrypt_and_tag(&bench.ccm, len, bench.iv, 13, NULL, 0, output, output,
+                                       bench.tag, sizeof(bench.tag));
+}
+static int ccm_encrypt_16()     { return ccm_encrypt(16); }
+static int ccm_encrypt_128()    { return ccm_encrypt(128); }
+
+// Opens what the setup sealed into the first half of output
+static int ccm_decrypt_128() {
+    return mbedtls_ccm_auth_decrypt(&bench.ccm, 128, bench.iv, 13, NULL, 0, output, output + 128,
+                                    bench.tag, sizeof(bench.tag));
+}
+
+static int sha256_64() {
+    mbedtls_sha256(input, 64, bench.hash, 0);
+    return 0;
+}
+
+static int sha256_1024() {
+    mbedtls_sha256_context ctx;
+    uint8_t i;
+
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_starts(&ctx, 0);
+    for (i = 0; i < 1024 / sizeof(input); i++) {
+        mbedtls_sha256_update(&ctx, input, sizeof(input));
+    }
+    mbedtls_sha256_finish(&ctx, bench.hash);
+    mbedtls_sha256_free(&ctx);
+    return 0;
+}
+
+static int hmac_sha256_64() {
+    return mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), bench.iv,
+                           sizeof(bench.iv), input, 64, bench.hash);
+}
+
+static int ctr_drbg_seed() {
+    return mbedtls_ctr_drbg_seed(bench.drbg, mbedtls_entropy_func, bench.entropy, NULL, 0);
+}
+
+static int ctr_drbg_32() {
+    return mbedtls_ctr_drbg_random(bench.drbg, output, 32);
+}
+
+static int mpi_mul() {
+    return mbedtls_mpi_mul_mpi(&bench.X, &bench.A, &bench.A);
+}
+
+// A full size private exponent, what a signature without the CRT costs
+static int mpi_exp_mod() {
+    return mbedtls_mpi_exp_mod(&bench.X, &bench.A, &bench.rsa->D, &bench.rsa->N, &bench.RR);
+}
+
+static int rsa_sign() {
+    return mbedtls_rsa_pkcs1_sign(bench.rsa, mbedtls_ctr_drbg_random, bench.drbg,
+                                  MBEDTLS_RSA_PRIVATE, MBEDTLS_MD_SHA256, 0, bench.hash,
+                                  bench.sig);
+}
+
+static int rsa_verify() {
+    return mbedtls_rsa_pkcs1_verify(bench.rsa, NULL, NULL, MBEDTLS_RSA_PUBLIC,
+                                    MBEDTLS_MD_SHA256, 0, bench.hash, bench.sig);
+}
+
+static int pem_parse() {
+    mbedtls_pk_context pk;
+    int ret;
+
+    mbedtls_pk_init(&pk);
+    ret = RSA_load_key(&pk);
+    mbedtls_pk_free(&pk);
+    return ret;
+}
+
+static void run_aes() {
+    mbedtls_aes_init(&bench.aes);
+    if (mbedtls_aes_setkey_enc(&bench.aes, input, 128) == 0) {
+        run_case(BENCH_AES_ECB_16, aes_ecb_16, 16);
+        run_case(BENCH_AES_CBC_16, aes_cbc_16, 16);
+        run_case(BENCH_AES_CBC_256, aes_cbc_256, 16);
+        run_case(BENCH_AES_CFB_16, aes_cfb_16, 16);
+        run_case(BENCH_AES_CFB_256, aes_cfb_256, 16);
+        bench.off = 0;
+        run_case(BENCH_AES_CTR_16, aes_ctr_16, 16);
+        run_case(BENCH_AES_CTR_256, aes_ctr_256, 16);
+    }
+    mbedtls_aes_free(&bench.aes);
+}
+
+static void run_ccm_cases(self_test_id_t encrypt16, self_test_id_t encrypt128,
+                          self_test_id_t decrypt128) {
+    mbedtls_ccm_stats before;
+    mbedtls_ccm_stats after;
+
+    mbedtls_ccm_get_stats(&before);
+    memcpy(output, input, sizeof(output));
+    run_case(encrypt16, ccm_encrypt_16, 16);
+    run_case(encrypt128, ccm_encrypt_128, 16);
+    if (ccm_encrypt(128) == 0) {
+        run_case(decrypt128, ccm_decrypt_128, 16);
+    }
+    mbedtls_ccm_get_stats(&after);
+
+    // A hardware case that fell back to software timed the wrong path
+    if (after.fallbacks != before.fallbacks) {
+        results[encrypt16].status = MBEDTLS_ERR_CCM_BAD_INPUT;
+        results[encrypt128].status = MBEDTLS_ERR_CCM_BAD_INPUT;
+        results[decrypt128].status = MBEDTLS_ERR_CCM_BAD_INPUT;
+    }
+}
+
+// The crypto engine against the construction over single AES blocks
+static void run_ccm() {
+    mbedtls_ccm_init(&bench.ccm);
+    if (mbedtls_ccm_setkey(&bench.ccm, MBEDTLS_CIPHER_ID_AES, input, 128) == 0) {
+        run_ccm_cases(BENCH_CCM_HW_16, BENCH_CCM_HW_128, BENCH_CCM_HW_DECRYPT_128);
+        mbedtls_ccm_set_hardware(&bench.ccm, 0);
+        run_ccm_cases(BENCH_CCM_SW_16, BENCH_CCM_SW_128, BENCH_CCM_SW_DECRYPT_128);
+    }
+    mbedtls_ccm_free(&bench.ccm);
+}
+
+static void run_rsa() {
+    bench.rsa = mbedtls_pk_rsa(*RSA_key());
+    if (bench.rsa->len > SELF_TEST_SIG_LEN) {
+        return;
+    }
+
+    mbedtls_mpi_init(&bench.A);
+    mbedtls_mpi_init(&bench.X);
+    mbedtls_mpi_init(&bench.RR);
+    if (mbedtls_mpi_sub_int(&bench.A, &bench.rsa->N, 1) == 0) {
+        run_case(BENCH_MPI_MUL, mpi_mul, 8);
+        run_case(BENCH_MPI_EXP_MOD, mpi_exp_mod, 1);
+    }
+    mbedtls_mpi_free(&bench.A);
+    mbedtls_mpi_free(&bench.X);
+    mbedtls_mpi_free(&bench.RR);
+
+    // Signs the hash left by the SHA-256 benchmark
+    run_case(BENCH_RSA_SIGN, rsa_sign, 1);
+    if (results[BENCH_RSA_SIGN].status == 0) {
+        run_case(BENCH_RSA_VERIFY, rsa_verify, 4);
+    }
+}
+
+bool self_test_run() {
+    uint16_t i;
+
+    memset(results, 0, sizeof(results));
+    for (i = 0; i < SELF_TEST_CASE_COUNT; i++) {
+        // Cases that could not run
+        results[i].status = MBEDTLS_ERR_MPI_BAD_INPUT_DATA;
+    }
+    for (i = 0; i < sizeof(input); i++) {
+        input[i] = i;
+    }
+    memset(bench.iv, 0, sizeof(bench.iv));
+
+    sign_power_begin();
+
+    run_case(SELF_TEST_AES, test_aes, 1);
+    run_case(SELF_TEST_SHA256, test_sha256, 1);
+    run_case(SELF_TEST_CCM, test_ccm, 1);
+    run_case(SELF_TEST_BASE64, test_base64, 1);
+    run_case(SELF_TEST_CTR_DRBG, test_ctr_drbg, 1);
+    run_case(SELF_TEST_ENTROPY, test_entropy, 1);
+    run_case(SELF_TEST_MPI, test_mpi, 1);
+    run_case(SELF_TEST_RSA, test_rsa, 1);
+
+    run_aes();
+    run_ccm();
+    run_case(BENCH_SHA256_64, sha256_64, 16);
+    run_case(BENCH_SHA256_1024, sha256_1024, 4);
+    run_case(BENCH_HMAC_SHA256_64, hmac_sha256_64, 16);
+
+    bench.entropy = mbedtls_calloc(1, sizeof(mbedtls_entropy_context));
+    bench.drbg = mbedtls_calloc(1, sizeof(mbedtls_ctr_drbg_context));
+    if ((bench.entropy) && (bench.drbg)) {
+        mbedtls_entropy_init(bench.entropy);
+#if defined(MBEDTLS_ENTROPY_NV_SEED)
+        // The NV seed is the signer's, the benchmark does not write it
+        bench.entropy->initial_entropy_run = 1;
+#endif
+        mbedtls_ctr_drbg_init(bench.drbg);
+        run_case(BENCH_CTR_DRBG_SEED, ctr_drbg_seed, 1);
+        if (results[BENCH_CTR_DRBG_SEED].status == 0) {
+            run_case(BENCH_CTR_DRBG_32, ctr_drbg_32, 16);
+            if (RSA_key()) {
+                run_rsa();
+            }
+        }
+        mbedtls_ctr_drbg_free(bench.drbg);
+        mbedtls_entropy_free(bench.entropy);
+    }
+    mbedtls_free(bench.drbg);
+    mbedtls_free(bench.entropy);
+
+    // Last, a second copy of the key is only room for once the contexts are gone
+    run_case(BENCH_PEM_PARSE, pem_parse, 1);
+
+    sign_power_end();
+    hasResults = true;
+    return true;
+}
+
+uint16_t self_test_len() {
+    return hasResults ? (SELF_TEST_HEADER_LEN + SELF_TEST_CASE_COUNT * SELF_TEST_RECORD_LEN) : 0;
+}
+
+uint16_t self_test_read(uint16_t offset, uint8_t *buf, uint16_t len) {
+    uint8_t record[SELF_TEST_RECORD_LEN];
+    const self_test_result_t *result;
+    uint16_t total = self_test_len();
+    uint16_t copied = 0;
+    uint16_t pos;
+    uint16_t index;
+    uint16_t count;
+
+    if (!hasResults) {
+        return 0;
+    }
+
+    while ((copied < len) && (offset < total)) {
+        if (offset < SELF_TEST_HEADER_LEN) {
+            record[0] = SELF_TEST_VERSION;
+            record[1] = SELF_TEST_CASE_COUNT;
+            record[2] = 0;
+#if defined(MBEDTLS_AES_ALT)
+            record[2] |= SELF_TEST_CONFIG_AES_ALT;
+#endif
+#if defined(MBEDTLS_RSA_NO_CRT)
+            record[2] |= SELF_TEST_CONFIG_RSA_NO_CRT;
+#endif
+#if defined(MBEDTLS_SHA256_SMALLER)
+            record[2] |= SELF_TEST_CONFIG_SHA256_SMALLER;
+#endif
+            record[3] = LATENCY_CPU_MHZ;
+            pos = offset;
+            count = SELF_TEST_HEADER_LEN - pos;
+        }
+        else {
+            index = (offset - SELF_TEST_HEADER_LEN) / SELF_TEST_RECORD_LEN;
+            result = &results[index];
+            record[0] = index;
+            put_u32(&record[1], result->status);
+            put_u16(&record[5], result->iterations);
+            put_u32(&record[7], result->cycles);
+            put_u32(&record[11], result->us);
+            pos = (offset - SELF_TEST_HEADER_LEN) % SELF_TEST_RECORD_LEN;
+            count = SELF_TEST_RECORD_LEN - pos;
+        }
+
+        if (count > len - copied) {
+            count = len - copied;
+        }
+        memcpy(&buf[copied], &record[pos], count);
+        copied += count;
+        offset += count;
+    }
+    return copied;
+}
+
+#else
+
+bool self_test_run() {
+    return false;
+}
+
+uint16_t self_test_read(uint16_t offset, uint8_t *buf, uint16_t len) {
+    return 0;
+}
+
+uint16_t self_test_len() {
+    return 0;
+}
+
+#endif // SIGNER_SELF_TEST
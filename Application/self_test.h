@@ -0,0 +1,84 @@
+#ifndef APPLICATION_SELF_TEST_H_
+#define APPLICATION_SELF_TEST_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Every self test and benchmark: its id, the name TOOLS/self_test_report.py prints
+ * and the bytes one iteration works on. TOOLS/self_test_report.py reads this list,
+ * keep one case per line and only add at the end, the ids are the positions in it.
+ */
+#define SELF_TEST_CASES(X) \
+    X(SELF_TEST_AES,            "test_aes",             0) \
+    X(SELF_TEST_SHA256,         "test_sha256",          0) \
+    X(SELF_TEST_CCM,            "test_ccm",             0) \
+    X(SELF_TEST_BASE64,         "test_base64",          0) \
+    X(SELF_TEST_CTR_DRBG,       "test_ctr_drbg",        0) \
+    X(SELF_TEST_ENTROPY,        "test_entropy",         0) \
+    X(SELF_TEST_MPI,            "test_mpi",             0) \
+    X(SELF_TEST_RSA,            "test_rsa",             0) \
+    X(BENCH_AES_ECB_16,         "aes_ecb",              16) \
+    X(BENCH_AES_CBC_16,         "aes_cbc",              16) \
+    X(BENCH_AES_CBC_256,        "aes_cbc",              256) \
+    X(BENCH_AES_CFB_16,         "aes_cfb128",           16) \
+    X(BENCH_AES_CFB_256,        "aes_cfb128",           256) \
+    X(BENCH_AES_CTR_16,         "aes_ctr",              16) \
+    X(BENCH_AES_CTR_256,        "aes_ctr",              256) \
+    X(BENCH_SHA256_64,          "sha256",               64) \
+    X(BENCH_SHA256_1024,        "sha256",               1024) \
+    X(BENCH_HMAC_SHA256_64,     "hmac_sha256",          64) \
+    X(BENCH_CTR_DRBG_SEED,      "ctr_drbg_seed",        0) \
+    X(BENCH_CTR_DRBG_32,        "ctr_drbg_random",      32) \
+    X(BENCH_MPI_MUL,            "mpi_mul_1024",         128) \
+    X(BENCH_MPI_EXP_MOD,        "mpi_exp_mod_1024",     128) \
+    X(BENCH_RSA_SIGN,           "rsa_sign_1024",        32) \
+    X(BENCH_RSA_VERIFY,         "rsa_verify_1024",      32) \
+    X(BENCH_PEM_PARSE,          "pem_parse_key",        0) \
+    X(BENCH_CCM_HW_16,          "ccm_hw_encrypt",       16) \
+    X(BENCH_CCM_HW_128,         "ccm_hw_encrypt",       128) \
+    X(BENCH_CCM_HW_DECRYPT_128, "ccm_hw_decrypt",       128) \
+    X(BENCH_CCM_SW_16,          "ccm_sw_encrypt",       16) \
+    X(BENCH_CCM_SW_128,         "ccm_sw_encrypt",       128) \
+    X(BENCH_CCM_SW_DECRYPT_128, "ccm_sw_decrypt",       128)
+
+#define SELF_TEST_CASE_ID(name, label, bytes) name,
+typedef enum self_test_id {
+    SELF_TEST_CASES(SELF_TEST_CASE_ID)
+    SELF_TEST_CASE_COUNT
+} self_test_id_t;
+#undef SELF_TEST_CASE_ID
+
+// Layout of self_test_read(), bumped when it changes
+#define SELF_TEST_VERSION 1
+
+// Configuration bits in the header, builds with different ones do not compare
+#define SELF_TEST_CONFIG_AES_ALT        0x01
+#define SELF_TEST_CONFIG_RSA_NO_CRT     0x02
+#define SELF_TEST_CONFIG_SHA256_SMALLER 0x04
+
+/*
+ * Header: version, case count, configuration bits, CPU MHz.
+ * Case: id, status (int32, 0 passed), iterations (uint16), CPU cycles (uint32) and
+ * microseconds (uint32) all iterations took together. Little endian.
+ */
+#define SELF_TEST_HEADER_LEN 4
+#define SELF_TEST_RECORD_LEN 15
+
+/*
+ * Runs the mbedTLS self tests and the benchmarks, several seconds with the key loaded.
+ * Only built with SIGNER_SELF_TEST, otherwise it returns false right away.
+ */
+bool self_test_run();
+
+/*
+ * Results of the last run from offset on, returns the bytes copied
+ */
+uint16_t self_test_read(uint16_t offset, uint8_t *buf, uint16_t len);
+
+/*
+ * Bytes self_test_read() has in all, 0 before the first run
+ */
+uint16_t self_test_len();
+
+#endif /* APPLICATION_SELF_TEST_H_ */
@@ -0,0 +1,99 @@
+#include "sign_power.h"
+
+#include <string.h>
+#include <ti/drivers/Power.h>
+#include <ti/drivers/power/PowerCC26XX.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Task.h>
+#include <inc/hw_types.h>
+#include <inc/hw_memmap.h>
+#include <inc/hw_cpu_dwt.h>
+#include "trng_pool.h"
+#include "latency.h"
+#include "trace.h"
+
+/*
+ * Power for signatures.
+ *
+ * A signature is mostly CPU work with short waits in between, for an AES block or for
+ * entropy. Nothing kept the device from going to standby in such a wait, and every
+ * standby costs the wakeup and settle time and the crypto module has to be set up
+ * again. A burst now disallows standby and holds the crypto module once, from the
+ * start of a signature or a batch of them to its end, and releases both right after.
+ * The waits for the user are outside the bursts, standby is only given up while
+ * computing. Each burst counts the CPU time it used and how long it held standby off.
+ */
+
+static uint8_t depth = 0;
+static uint32_t startCycles;
+static uint32_t startTicks;
+
+static sign_power_stats_t powerStats;
+
+void sign_power_begin() {
+    UInt taskKey = Task_disable();
+
+    if (depth++ > 0) {
+        Task_restore(taskKey);
+        return;
+    }
+    Task_restore(taskKey);
+
+    Power_setConstraint(PowerCC26XX_SB_DISALLOW);
+    Power_setDependency(PowerCC26XX_PERIPH_CRYPTO);
+    startTicks = Clock_getTicks();
+    latency_enable_counter();
+    startCycles = HWREG(CPU_DWT_BASE + CPU_DWT_O_CYCCNT);
+
+    // Seeding reads entropy first thing, have it ready
+    trng_pool_start();
+}
+
+void sign_power_end() {
+    uint32_t activeUs;
+    uint32_t heldUs;
+    UInt taskKey = Task_disable();
+
+    if ((depth == 0) || (--depth > 0)) {
+        Task_restore(taskKey);
+        return;
+    }
+    Task_restore(taskKey);
+
+    activeUs = (HWREG(CPU_DWT_BASE + CPU_DWT_O_CYCCNT) - startCycles) / LATENCY_CPU_MHZ;
+    heldUs = (Clock_getTicks() - startTicks) * Clock_tickPeriod;
+    Power_releaseDependency(PowerCC26XX_PERIPH_CRYPTO);
+    Power_releaseConstraint(PowerCC26XX_SB_DISALLOW);
+
+    taskKey = Task_disable();
+    powerStats.bursts++;
+    powerStats.active_us_total += activeUs;
+    if (activeUs > powerStats.active_us_max) {
+        powerStats.active_us_max = activeUs;
+    }
+    powerStats.held_us_total += heldUs;
+    if (heldUs > powerStats.held_us_max) {
+        powerStats.held_us_max = heldUs;
+    }
+    Task_restore(taskKey);
+
+    TRACE(TRACE_SIGN_POWER, activeUs, heldUs);
+}
+
+void sign_power_get_stats(sign_power_stats_t *stats) {
+    UInt taskKey;
+
+    if (!stats) {
+        return;
+    }
+
+    taskKey = Task_disable();
+    memcpy(stats, &powerStats, sizeof(sign_power_stats_t));
+    Task_restore(taskKey);
+}
+
+void sign_power_reset_stats() {
+    UInt taskKey = Task_disable();
+    memset(&powerStats, 0, sizeof(sign_power_stats_t));
+    Task_restore(taskKey);
+}
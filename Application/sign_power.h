@@ -0,0 +1,26 @@
+#ifndef APPLICATION_SIGN_POWER_H_
+#define APPLICATION_SIGN_POWER_H_
+
+#include <stdint.h>
+
+typedef struct sign_power_stats {
+    uint32_t bursts;            // Outermost sign_power_begin() calls
+    uint32_t active_us_total;   // CPU time while a burst ran, the cycle counter stops in sleep
+    uint32_t active_us_max;
+    uint32_t held_us_total;     // Time standby was disallowed
+    uint32_t held_us_max;
+} sign_power_stats_t;
+
+/*
+ * Start of a compute burst: keeps the device out of standby and the crypto module
+ * powered until sign_power_end(), and tops the entropy pool up. Bursts nest, only
+ * the outermost one takes and gives back the constraints. Never hold one across a
+ * wait for the user.
+ */
+void sign_power_begin();
+void sign_power_end();
+
+void sign_power_get_stats(sign_power_stats_t *stats);
+void sign_power_reset_stats();
+
+#endif /* APPLICATION_SIGN_POWER_H_ */
@@ -0,0 +1,278 @@
+#include "sign_session.h"
+
+#include <string.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Clock.h>
+
+/*
+ * Per connection sign sessions.
+ *
+ * With several gateways connected, each client gets a session that holds the challenge
+ * it wrote, so the challenge is copied out of the profile the moment it arrives and the
+ * next write of another client can not change what gets signed. Jobs are served round
+ * robin, one per client per turn, and only one runs at a time since every signature
+ * needs the button.
+ */
+
+typedef struct sign_session {
+    uint16_t connHandle;
+    bool isQueued;
+    bool isRunning;
+    uint8_t kind;
+    UInt32 queuedAt;
+    uint8_t challenge[USER_CHALLANGE_CHAR_LENGTH];
+    uint8_t nonce[SEALED_NONCE_LENGTH];
+    uint8_t runningNonce[SEALED_NONCE_LENGTH];  // A newer challenge may queue while the job runs
+} sign_session_t;
+
+static sign_session_t sessions[SIGN_SESSION_MAX];
+static bool isInitialized = false;
+static uint8_t lastServed = SIGN_SESSION_MAX - 1;
+
+static sign_session_stats_t sessionStats;
+
+static void sign_session_init() {
+    uint8_t i;
+
+    for (i = 0; i < SIGN_SESSION_MAX; i++) {
+        sessions[i].connHandle = INVALID_CONNHANDLE;
+    }
+    isInitialized = true;
+}
+
+static sign_session_t *find_session(uint16_t connHandle) {
+    uint8_t i;
+
+    if (!isInitialized) {
+        sign_session_init();
+    }
+    for (i = 0; i < SIGN_SESSION_MAX; i++) {
+        if (sessions[i].connHandle == connHandle) {
+            return &sessions[i];
+        }
+    }
+    return NULL;
+}
+
+static uint8_t count_queued() {
+    uint8_t count = 0;
+    uint8_t i;
+
+    for (i = 0; i < SIGN_SESSION_MAX; i++) {
+        if ((sessions[i].connHandle != INVALID_CONNHANDLE) && sessions[i].isQueued) {
+            count++;
+        }
+    }
+    return count;
+}
+
+static bool submit(uint16_t connHandle, uint8_t kind, const uint8_t *challenge,
+                   const uint8_t *nonce) {
+    sign_session_t *session;
+    UInt taskKey;
+    uint8_t queued;
+
+    if (connHandle == INVALID_CONNHANDLE) {
+        return false;
+    }
+
+    session = find_session(connHandle);
+    if (!session) {
+        session = find_session(INVALID_CONNHANDLE);
+        if (!session) {
+            taskKey = Task_disable();
+            sessionStats.rejected++;
+            Task_restore(taskKey);
+            return false;
+        }
+        memset(session, 0, sizeof(sign_session_t));
+        session->connHandle = connHandle;
+    }
+
+    taskKey = Task_disable();
+    if (session->isQueued && (session->kind != kind)) {
+        // Only one job waits per client, and neither kind may push the other out
+        sessionStats.rejected++;
+        Task_restore(taskKey);
+        return false;
+    }
+    if (session->isQueued) {
+        sessionStats.replaced++;
+    }
+    else {
+        // The wait is counted from the first challenge that is still waiting
+        session->queuedAt = Clock_getTicks();
+        session->isQueued = true;
+        session->kind = kind;
+    }
+    if (challenge) {
+        memcpy(session->challenge, challenge, USER_CHALLANGE_CHAR_LENGTH);
+    }
+    if (nonce) {
+        memcpy(session->nonce, nonce, SEALED_NONCE_LENGTH);
+    }
+    sessionStats.submitted++;
+    queued = count_queued();
+    if (queued > sessionStats.max_queued) {
+        sessionStats.max_queued = queued;
+    }
+    Task_restore(taskKey);
+    return true;
+}
+
+bool sign_session_submit(uint16_t connHandle, const uint8_t *challenge) {
+    if (!challenge) {
+        return false;
+    }
+    return submit(connHandle, SIGN_JOB_CHALLENGE, challenge, NULL);
+}
+
+bool sign_session_submit_bulk(uint16_t connHandle) {
+    return submit(connHandle, SIGN_JOB_BULK, NULL, NULL);
+}
+
+bool sign_session_submit_sealed(uint16_t connHandle, const uint8_t *challenge,
+                                const uint8_t *nonce) {
+    if ((!challenge) || (!nonce)) {
+        return false;
+    }
+    return submit(connHandle, SIGN_JOB_SEALED, challenge, nonce);
+}
+
+bool sign_session_next(uint16_t *connHandle, uint8_t *kind, uint8_t *challenge) {
+    sign_session_t *session;
+    UInt32 wait;
+    UInt taskKey;
+    uint8_t i;
+    uint8_t index;
+
+    if ((!connHandle) || (!kind) || (!challenge)) {
+        return false;
+    }
+    if (!isInitialized) {
+        sign_session_init();
+    }
+
+    for (i = 1; i <= SIGN_SESSION_MAX; i++) {
+        index = (lastServed + i) % SIGN_SESSION_MAX;
+        session = &sessions[index];
+        if ((session->connHandle == INVALID_CONNHANDLE) || (!session->isQueued) || session->isRunning) {
+            continue;
+        }
+
+        taskKey = Task_disable();
+        session->isQueued = false;
+        session->isRunning = true;
+        wait = Clock_getTicks() - session->queuedAt;
+        sessionStats.started++;
+        sessionStats.last_wait_ticks = wait;
+        if (wait > sessionStats.max_wait_ticks) {
+            sessionStats.max_wait_ticks = wait;
+        }
+        Task_restore(taskKey);
+
+        lastServed = index;
+        *connHandle = session->connHandle;
+        *kind = session->kind;
+        if (session->kind != SIGN_JOB_BULK) {
+            memcpy(challenge, session->challenge, USER_CHALLANGE_CHAR_LENGTH);
+        }
+        if (session->kind == SIGN_JOB_SEALED) {
+            memcpy(session->runningNonce, session->nonce, SEALED_NONCE_LENGTH);
+        }
+        return true;
+    }
+    return false;
+}
+
+bool sign_session_nonce(uint16_t connHandle, uint8_t *nonce) {
+    sign_session_t *session = find_session(connHandle);
+
+    if ((connHandle == INVALID_CONNHANDLE) || (!session) || (!nonce) || (!session->isRunning)) {
+        return false;
+    }
+    memcpy(nonce, session->runningNonce, SEALED_NONCE_LENGTH);
+    return true;
+}
+
+void sign_session_finish(uint16_t connHandle, bool success) {
+    sign_session_t *session = find_session(connHandle);
+    UInt taskKey;
+
+    // A closed session already counted its job as abandoned
+    if ((connHandle == INVALID_CONNHANDLE) || (!session) || (!session->isRunning)) {
+        return;
+    }
+
+    taskKey = Task_disable();
+    session->isRunning = false;
+    if (success) {
+        sessionStats.completed++;
+    }
+    else {
+        sessionStats.failed++;
+    }
+    Task_restore(taskKey);
+}
+
+void sign_session_close(uint16_t connHandle) {
+    sign_session_t *session = find_session(connHandle);
+    UInt taskKey;
+
+    if ((connHandle == INVALID_CONNHANDLE) || (!session)) {
+        return;
+    }
+
+    taskKey = Task_disable();
+    if (session->isQueued) {
+        sessionStats.abandoned++;
+    }
+    if (session->isRunning) {
+        sessionStats.abandoned++;
+    }
+    memset(session, 0, sizeof(sign_session_t));
+    session->connHandle = INVALID_CONNHANDLE;
+    Task_restore(taskKey);
+}
+
+bool sign_session_pending() {
+    uint8_t i;
+
+    for (i = 0; i < SIGN_SESSION_MAX; i++) {
+        if ((sessions[i].connHandle != INVALID_CONNHANDLE) && sessions[i].isQueued &&
+            (!sessions[i].isRunning)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void sign_session_get_stats(sign_session_stats_t *stats) {
+    UInt taskKey;
+    uint8_t i;
+
+    if (!stats) {
+        return;
+    }
+    if (!isInitialized) {
+        sign_session_init();
+    }
+
+    taskKey = Task_disable();
+    memcpy(stats, &sessionStats, sizeof(sign_session_stats_t));
+    stats->queued = count_queued();
+    stats->sessions = 0;
+    for (i = 0; i < SIGN_SESSION_MAX; i++) {
+        if (sessions[i].connHandle != INVALID_CONNHANDLE) {
+            stats->sessions++;
+        }
+    }
+    stats->tick_period_us = Clock_tickPeriod;
+    Task_restore(taskKey);
+}
+
+void sign_session_reset_stats() {
+    UInt taskKey = Task_disable();
+    memset(&sessionStats, 0, sizeof(sign_session_stats_t));
+    Task_restore(taskKey);
+}
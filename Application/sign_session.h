@@ -0,0 +1,86 @@
+#ifndef APPLICATION_SIGN_SESSION_H_
+#define APPLICATION_SIGN_SESSION_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bcomdef.h"
+#include "simple_gatt_profile.h"
+
+// One session per client the profile keeps values for
+#define SIGN_SESSION_MAX SIMPLEPROFILE_MAX_CONNS
+
+typedef enum sign_job_kind {
+    SIGN_JOB_CHALLENGE = 0,  // A challenge written to the simple profile
+    SIGN_JOB_BULK,           // A request held by the bulk channel
+    SIGN_JOB_SEALED          // A challenge that came over the sealed channel, its response is sealed too
+} sign_job_kind_t;
+
+typedef struct sign_session_stats {
+    uint32_t submitted;        // Challenges queued
+    uint32_t replaced;         // Queued challenges overwritten by a newer one of the same client
+    uint32_t rejected;         // Jobs dropped because every session was taken or a job of the
+                               // other kind waits for the client
+    uint32_t started;          // Jobs handed to the signer
+    uint32_t completed;        // Jobs that gave a signature
+    uint32_t failed;           // Jobs that did not, e.g. the user did not confirm
+    uint32_t abandoned;        // Jobs dropped because their client disconnected
+    uint32_t last_wait_ticks;  // Time the last job waited for its turn
+    uint32_t max_wait_ticks;
+    uint8_t  queued;           // Jobs waiting now
+    uint8_t  max_queued;
+    uint8_t  sessions;         // Clients with an open session
+    uint32_t tick_period_us;   // Length of one Clock tick
+} sign_session_stats_t;
+
+/*
+ * Queues a signing job for the client on connHandle, opening its session if needed.
+ * A client has at most one job waiting: a newer challenge replaces the waiting one,
+ * so a busy client can not push the others back.
+ * Returns false if every session is taken.
+ */
+bool sign_session_submit(uint16_t connHandle, const uint8_t *challenge);
+
+/*
+ * Queues the request the bulk channel of connHandle holds. It replaces a waiting bulk
+ * job the same way, the bulk channel keeps the data.
+ */
+bool sign_session_submit_bulk(uint16_t connHandle);
+
+/*
+ * Queues a challenge the client sealed, with the nonce it came with. It replaces a
+ * waiting sealed challenge the same way.
+ */
+bool sign_session_submit_sealed(uint16_t connHandle, const uint8_t *challenge,
+                                const uint8_t *nonce);
+
+/*
+ * Picks the next job round robin, starting after the client served last.
+ * Copies its kind and, for a plain or sealed challenge, the challenge out and marks
+ * it running.
+ * Returns false if no job is waiting.
+ */
+bool sign_session_next(uint16_t *connHandle, uint8_t *kind, uint8_t *challenge);
+
+/*
+ * Copies the SEALED_NONCE_LENGTH byte nonce of the sealed job running for connHandle,
+ * the one it was started with. Returns false if no job of the client runs.
+ */
+bool sign_session_nonce(uint16_t connHandle, uint8_t *nonce);
+
+/*
+ * Ends the running job of connHandle.
+ */
+void sign_session_finish(uint16_t connHandle, bool success);
+
+/*
+ * Closes the session of a client whose link went down, dropping its jobs.
+ */
+void sign_session_close(uint16_t connHandle);
+
+bool sign_session_pending();
+
+void sign_session_get_stats(sign_session_stats_t *stats);
+void sign_session_reset_stats();
+
+#endif /* APPLICATION_SIGN_SESSION_H_ */
@@ -1,4 +1,3 @@
-#include <xdc/runtime/system.h>
 #include <time.h>
 #include <stdlib.h>
 #include <driverlib/trng.h>
@@ -7,18 +6,34 @@
 #include <ti/drivers/power/PowerCC26XX.h>
 
 #include "signer.h"
+#include "trng_pool.h"
+#include "key_loader.h"
+#include "trace.h"
+#include "latency.h"
+#include "telemetry.h"
+#include "sign_power.h"
 #include "Board.h"
 
 #include "mbedtls/pk.h"
+#include "mbedtls/rsa.h"
 #include "mbedtls/md.h"
 #include "mbedtls/entropy.h"
 #include "mbedtls/ctr_drbg.h"
 #include "mbedtls/aes.h"
+#include "mbedtls/ccm.h"
+#include "mbedtls/platform.h"
 
 // The private key context that will be used for the entire encryption
 mbedtls_pk_context privateKey;
 
-int rsa_state = -1;
+int rsa_state = RSA_STATE_PENDING;
+
+static uint16_t keyId = 0;
+
+// Seeded once and kept for every signature, a new entropy context each time would
+// write a fresh NV seed to flash for each of them. From the crypto arena.
+static mbedtls_entropy_context *entropy = NULL;
+static mbedtls_ctr_drbg_context *ctrDrbg = NULL;
 
 #define PRIVATE_KEY_BUFFER_LEN 888
 const unsigned char keyBuffer[PRIVATE_KEY_BUFFER_LEN] = {
@@ -40,10 +55,83 @@ const unsigned char keyBuffer[PRIVATE_KEY_BUFFER_LEN] = {
 };
 
 int initialize_TRNG() {
-    // No need to do anything actually...
+    // Start filling the entropy pool so it is ready by the first signature
+    trng_pool_init();
     return 0;
 }
 
+// Hashes the public modulus, it identifies the key without revealing anything about it
+static uint16_t compute_key_id() {
+    mbedtls_rsa_context *rsa = mbedtls_pk_rsa(privateKey);
+    unsigned char hash[32];
+    unsigned char *modulus;
+    size_t len = mbedtls_mpi_size(&rsa->N);
+    uint16_t id = 0;
+
+    modulus = mbedtls_calloc(1, len);
+    if (!modulus) {
+        return 0;
+    }
+    if ((mbedtls_mpi_write_binary(&rsa->N, modulus, len) == 0) &&
+        (mbedtls_md(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), modulus, len, hash) == 0)) {
+        id = ((uint16_t) hash[0] << 8) | hash[1];
+    }
+    mbedtls_free(modulus);
+    return id;
+}
+
+uint16_t RSA_key_id() {
+    return keyId;
+}
+
+int RSA_load_key(mbedtls_pk_context *pk) {
+    return key_loader_load(pk, keyBuffer, PRIVATE_KEY_BUFFER_LEN, NULL, 0);
+}
+
+// Seeds the DRBG on first use, a failed seed is tried again by the next signature
+static int seed_drbg() {
+    uint32_t start;
+    int ret;
+
+    if (ctrDrbg) {
+        return 0;
+    }
+
+    entropy = mbedtls_calloc(1, sizeof(mbedtls_entropy_context));
+    ctrDrbg = mbedtls_calloc(1, sizeof(mbedtls_ctr_drbg_context));
+    if ((!entropy) || (!ctrDrbg)) {
+        ret = MBEDTLS_ERR_CTR_DRBG_REQUEST_TOO_BIG;
+        goto error;
+    }
+    mbedtls_entropy_init(entropy);
+    mbedtls_ctr_drbg_init(ctrDrbg);
+
+    // The counter works with AES module
+    start = latency_start(LATENCY_SEED);
+    ret = mbedtls_ctr_drbg_seed(ctrDrbg, mbedtls_entropy_func, entropy, NULL, 0);
+    latency_stop(LATENCY_SEED, start);
+    if (ret == 0) {
+        return 0;
+    }
+
+error:
+    if (entropy) {
+        mbedtls_entropy_free(entropy);
+        mbedtls_free(entropy);
+        entropy = NULL;
+    }
+    if (ctrDrbg) {
+        mbedtls_ctr_drbg_free(ctrDrbg);
+        mbedtls_free(ctrDrbg);
+        ctrDrbg = NULL;
+    }
+    return ret;
+}
+
+mbedtls_pk_context *RSA_key() {
+    return (rsa_state == RSA_STATE_READY) ? &privateKey : NULL;
+}
+
 int is_RSA_read() {
 
     // If it was not initialized we return -1.
@@ -57,22 +145,25 @@ void RSA_init() {
     // Initialize the private key state
     mbedtls_pk_init(&privateKey);
 
-    pk_error = mbedtls_pk_parse_key(&privateKey, keyBuffer, PRIVATE_KEY_BUFFER_LEN, NULL, 0);
+    pk_error = RSA_load_key(&privateKey);
     if (pk_error != 0) {
         // Well this means loading the key failed. this sucks
         // TODO: figure out what to do from here, maybe we can notify the failure via BLE
-        rsa_state = -2;
+        rsa_state = RSA_STATE_FAILED;
     }
     else {
         // Key loading worked!
-        rsa_state = 0;
-
+        keyId = compute_key_id();
+        rsa_state = RSA_STATE_READY;
+
+        // Seeded now rather than by the first signature, with the standby held off
+        // for the TRNG
+        sign_power_begin();
+        seed_drbg();
+        sign_power_end();
     }
 
-    // Initialize the random number generator
-    initialize_TRNG();
-
-    System_printf("RSA init ok: %d\n", rsa_state);
+    TRACE(TRACE_RSA_INIT, rsa_state);
 
     return;
 }
@@ -85,49 +176,82 @@ int AES_encrypt(const unsigned char *input, size_t input_len, unsigned char *out
         return -1;
     }
 
+    int ret;
     mbedtls_aes_context ctx;
     mbedtls_aes_init(&ctx);
-    mbedtls_aes_setkey_enc(&ctx, key, 128);
+    ret = mbedtls_aes_setkey_enc(&ctx, key, 128);
+    if (ret == 0) {
+        ret = mbedtls_aes_crypt_ecb( &ctx, MBEDTLS_AES_ENCRYPT, input, output_buffer);
+    }
+
+    // Release the key RAM entry and the crypto handle
+    mbedtls_aes_free(&ctx);
+    return ret;
+}
+
+// Built in like the private key, the gateways hold the same one
+static const unsigned char channelKey[16] = {
+    0x4b, 0x1e, 0x93, 0x0c, 0x7a, 0xd2, 0x65, 0xf8, 0x31, 0xae, 0x0f, 0x5c, 0xc4, 0x27, 0x88, 0xe9
+};
+
+static int channel_crypt(int seal, const unsigned char *nonce, size_t nonce_len,
+                         unsigned char *data, size_t len, unsigned char *tag, size_t tag_len) {
+    mbedtls_ccm_context ctx;
+    int ret;
+
+    mbedtls_ccm_init(&ctx);
+    ret = mbedtls_ccm_setkey(&ctx, MBEDTLS_CIPHER_ID_AES, channelKey, 128);
+    if (ret == 0) {
+        if (seal) {
+            ret = mbedtls_ccm_encrypt_and_tag(&ctx, len, nonce, nonce_len, NULL, 0,
+                                              data, data, tag, tag_len);
+        }
+        else {
+            ret = mbedtls_ccm_auth_decrypt(&ctx, len, nonce, nonce_len, NULL, 0,
+                                           data, data, tag, tag_len);
+        }
+    }
+
+    // Release the key RAM entry and the crypto handle
+    mbedtls_ccm_free(&ctx);
+    return ret;
+}
 
-    return mbedtls_aes_crypt_ecb( &ctx, MBEDTLS_AES_ENCRYPT, input, output_buffer);
+int CCM_seal(const unsigned char *nonce, size_t nonce_len, unsigned char *data, size_t len,
+             unsigned char *tag, size_t tag_len) {
+    return channel_crypt(1, nonce, nonce_len, data, len, tag, tag_len);
+}
+
+int CCM_open(const unsigned char *nonce, size_t nonce_len, unsigned char *data, size_t len,
+             const unsigned char *tag, size_t tag_len) {
+    return channel_crypt(0, nonce, nonce_len, data, len, (unsigned char *)tag, tag_len);
 }
 
 int RSA_sign(const unsigned char *input, size_t input_len, unsigned char *output_buf, size_t *output_len) {
     // Will be used to check all sort of return values
     int ret = 0;
 
-    // We use a random counter mode to sign the message
-    // Allocate on the heap to save stack memory
-    mbedtls_entropy_context *entropy = NULL;
-    mbedtls_ctr_drbg_context *ctr_drbg = NULL;
-
     // Buffers for the Hash
     unsigned char *input_hash;
     input_hash = NULL;
 
-    entropy = calloc(1, sizeof(mbedtls_entropy_context));
-    ctr_drbg = calloc(1, sizeof(mbedtls_ctr_drbg_context));
-    if ( (!entropy) || (!ctr_drbg) ) {
-        //Failed to allocate heap memory for Entropy
-        ret = MBEDTLS_ERR_CTR_DRBG_REQUEST_TOO_BIG;
-        goto error_cleanup;
-    }
-    mbedtls_entropy_init( entropy );
-    mbedtls_ctr_drbg_init( ctr_drbg );
+    uint32_t start;
 
+    // The arena's peak then tells what this signature needed
+    crypto_arena_reset_peak();
 
-    // The counter works with AES module
-    ret = mbedtls_ctr_drbg_seed( ctr_drbg,
-                                 mbedtls_entropy_func,
-                                 entropy,
-                                 NULL, 0);
+    // No standby from here to the end of the signature
+    sign_power_begin();
+
+    // We use a random counter mode to sign the message, seeded when the key loaded
+    ret = seed_drbg();
     if (ret != 0) {
            //Failed to seed the entropy source
             goto error_cleanup;
        }
 
     // SHA256 requires 32 bytes on the stack!
-    input_hash = calloc(32, sizeof(unsigned char));
+    input_hash = mbedtls_calloc(32, sizeof(unsigned char));
     if ( input_hash == NULL ){
         //Failed to allocate buffer for HASH from heap
         ret = MBEDTLS_ERR_MD_ALLOC_FAILED;
@@ -142,7 +266,9 @@ int RSA_sign(const unsigned char *input, size_t input_len, unsigned char *output
     }
 
     // Perform SHA256 to the input data
+    start = latency_start(LATENCY_SHA256);
     ret = mbedtls_md( mbedtls_md_info_from_type( MBEDTLS_MD_SHA256 ), input, input_len, input_hash);
+    latency_stop(LATENCY_SHA256, start);
     if ( ret != 0) {
         //SHA256 failed on input
         goto error_cleanup;
@@ -162,24 +288,19 @@ int RSA_sign(const unsigned char *input, size_t input_len, unsigned char *output
                            output_buf,
                            output_len,
                            mbedtls_ctr_drbg_random,
-                           ctr_drbg);
+                           ctrDrbg);
+
+    // Every buffer of the signature is still held here
+    telemetry_sample(true);
 
     goto cleanup;
 
 error_cleanup:
 cleanup:
     if (input_hash)
-        free(input_hash);
-
-    if (entropy) {
-        mbedtls_entropy_free( entropy );
-        free( entropy );
-    }
-    if (ctr_drbg) {
-        mbedtls_ctr_drbg_free( ctr_drbg );
-        free(ctr_drbg);
-    }
+        mbedtls_free(input_hash);
 
+    sign_power_end();
     return ret;
 }
 
@@ -2,9 +2,16 @@
 #define SIGNER_H__
 
 #include "mbedtls/bignum.h"
+#include "mbedtls/pk.h"
+
+// is_RSA_read() values
+#define RSA_STATE_READY     0   // The key is loaded
+#define RSA_STATE_PENDING   -1  // RSA_init() did not run yet
+#define RSA_STATE_FAILED    -2  // The key did not load
 
 /*
- * Initializes the RSA private key state for the entire program
+ * Initializes the RSA private key state for the entire program.
+ * It takes a while, the application runs it once advertising started.
  */
 void RSA_init();
 
@@ -13,6 +20,22 @@ void RSA_init();
  */
 int is_RSA_read();
 
+/*
+ * Parses the built in private key into pk, RSA_init() loads the signing key with it
+ */
+int RSA_load_key(mbedtls_pk_context *pk);
+
+/*
+ * The signing key, NULL while it is not loaded
+ */
+mbedtls_pk_context *RSA_key();
+
+/*
+ * Short id of the loaded key, the first two bytes of the SHA256 of its public modulus.
+ * It changes with the key, 0 while no key is loaded.
+ */
+uint16_t RSA_key_id();
+
 /*
  * Perform a SHA256 signature for the input buffer
  */
@@ -25,6 +48,20 @@ int RSA_sign(const unsigned char *input, size_t input_len, unsigned char *output
  */
 int AES_encrypt(const unsigned char *input, size_t input_len, unsigned char *output_buffer, size_t output_len);
 
+/*
+ * Encrypts data in place with AES-CCM under the built in channel key and writes the tag.
+ * The nonce must never repeat for the key. Returns 0 or the mbedtls error code.
+ */
+int CCM_seal(const unsigned char *nonce, size_t nonce_len, unsigned char *data, size_t len,
+             unsigned char *tag, size_t tag_len);
+
+/*
+ * Checks the tag and decrypts data in place, data is cleared if the tag does not match.
+ * Returns 0 or MBEDTLS_ERR_CCM_AUTH_FAILED.
+ */
+int CCM_open(const unsigned char *nonce, size_t nonce_len, unsigned char *data, size_t len,
+             const unsigned char *tag, size_t tag_len);
+
 /*
  * Initializes the True Random Generator hardware the board has
  */
@@ -50,6 +50,7 @@
  */
 #include <string.h>
 #include <xdc/runtime/system.h>
+#include <xdc/runtime/Memory.h>
 
 #include <ti/sysbios/knl/Task.h>
 #include <ti/sysbios/knl/Clock.h>
@@ -65,6 +66,7 @@
 #include "devinfoservice.h"
 #include "simple_gatt_profile.h"
 #include "led_control.h"
+#include "button.h"
 
 #if defined(FEATURE_OAD) || defined(IMAGE_INVALIDATE)
 #include "oad_target.h"
@@ -101,8 +103,24 @@
 // The encryption library we added for performing the RSA encryption
 #ifdef USE_MBEDTLS
 #include "signer.h"
+#include "crypto_arena.h"
+#include "mbedtls/ccm.h"
 #endif
 
+#include "conn_policy.h"
+#include "sign_session.h"
+#include "att_queue.h"
+#include "conn_notice.h"
+#include "bulk_channel.h"
+#include "adv_status.h"
+#include "msg_pool.h"
+#include "trace.h"
+#include "latency.h"
+#include "telemetry.h"
+#include "boot_time.h"
+#include "sign_power.h"
+#include "self_test.h"
+
 
 
 /*********************************************************************
@@ -116,30 +134,24 @@
 // General discoverable mode advertises indefinitely
 #define DEFAULT_DISCOVERABLE_MODE             GAP_ADTYPE_FLAGS_GENERAL
 
-#ifndef FEATURE_OAD
-// Minimum connection interval (units of 1.25ms, 80=100ms) if automatic
-// parameter update request is enabled
-#define DEFAULT_DESIRED_MIN_CONN_INTERVAL     80
+// The automatic parameter update request asks for the idle parameters of the
+// connection policy. Challenges and OAD switch the link to the fast ones
+// while they run (see conn_policy.h).
 
-// Maximum connection interval (units of 1.25ms, 800=1000ms) if automatic
-// parameter update request is enabled
-#define DEFAULT_DESIRED_MAX_CONN_INTERVAL     800
-#else //!FEATURE_OAD
-// Minimum connection interval (units of 1.25ms, 8=10ms) if automatic
+// Minimum connection interval (units of 1.25ms, 80=100ms) if automatic
 // parameter update request is enabled
-#define DEFAULT_DESIRED_MIN_CONN_INTERVAL     8
+#define DEFAULT_DESIRED_MIN_CONN_INTERVAL     CONN_POLICY_IDLE_MIN_INTERVAL
 
-// Maximum connection interval (units of 1.25ms, 8=10ms) if automatic
+// Maximum connection interval (units of 1.25ms, 160=200ms) if automatic
 // parameter update request is enabled
-#define DEFAULT_DESIRED_MAX_CONN_INTERVAL     8
-#endif // FEATURE_OAD
+#define DEFAULT_DESIRED_MAX_CONN_INTERVAL     CONN_POLICY_IDLE_MAX_INTERVAL
 
 // Slave latency to use if automatic parameter update request is enabled
-#define DEFAULT_DESIRED_SLAVE_LATENCY         0
+#define DEFAULT_DESIRED_SLAVE_LATENCY         CONN_POLICY_IDLE_SLAVE_LATENCY
 
 // Supervision timeout value (units of 10ms, 1000=10s) if automatic parameter
 // update request is enabled
-#define DEFAULT_DESIRED_CONN_TIMEOUT          1000
+#define DEFAULT_DESIRED_CONN_TIMEOUT          CONN_POLICY_CONN_TIMEOUT
 
 // Whether to enable automatic parameter update request when a connection is
 // formed
@@ -192,6 +204,28 @@
 #define SBP_CHAR_CHANGE_EVT                   0x0002
 #define SBP_PERIODIC_EVT                      0x0004
 #define SBP_CONN_EVT_END_EVT                  0x0008
+#define SBP_CONN_POLICY_EVT                   0x0010
+#define SBP_PARAM_UPDATE_EVT                  0x0020
+#define SBP_PARAM_UPDATE_FAIL_EVT             0x0040
+#define SBP_LINK_EVT                          0x0080
+#define SBP_SIGN_JOB_EVT                      0x0100
+#define SBP_KEY_INIT_EVT                      0x0200
+#define SBP_CONFIRM_EVT                       0x0400
+
+// Blocks of the app event pool, events beyond it come from the heap
+#ifndef SBP_EVT_POOL_SIZE
+#define SBP_EVT_POOL_SIZE                     8
+#endif
+
+// Blocks of the OAD write event pool
+#ifndef SBP_OAD_POOL_SIZE
+#define SBP_OAD_POOL_SIZE                     4
+#endif
+
+// Snapshot a long read of the Diagnostics or Telemetry value is served from, one per link
+#define SBP_DIAG_LINKS                        MAX_NUM_BLE_CONNS
+#define SBP_DIAG_LEN                          ((LATENCY_DIAG_LEN > TELEMETRY_DIAG_LEN) ? \
+                                               LATENCY_DIAG_LEN : TELEMETRY_DIAG_LEN)
 
 /*********************************************************************
  * TYPEDEFS
@@ -200,9 +234,22 @@
 // App event passed from profiles.
 typedef struct
 {
-  appEvtHdr_t hdr;  // event header.
+  Queue_Elem _elem;     // queued as is, without a record around it.
+  appEvtHdr_t hdr;      // event header.
+  uint16_t connHandle;  // connection the event is about, if any.
+  uint32_t queued;      // latency_start() of LATENCY_DISPATCH.
 } sbpEvt_t;
 
+// The value a client's long read is served from.
+typedef struct
+{
+  bool isUsed;
+  uint16_t connHandle;  // client reading it.
+  uint8_t paramID;      // DIAGNOSTICS_CHAR_VALUE or TELEMETRY_CHAR_VALUE.
+  uint16_t len;
+  uint8_t value[SBP_DIAG_LEN];
+} sbpDiagSnapshot_t;
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -227,10 +274,19 @@ static Clock_Struct periodicClock;
 static Queue_Struct appMsg;
 static Queue_Handle appMsgQueue;
 
+// Blocks the app messages are allocated from
+MSG_POOL_STORAGE(appEvtStorage, sizeof(sbpEvt_t), SBP_EVT_POOL_SIZE);
+static msg_pool_t appEvtPool;
+
 #if defined(FEATURE_OAD)
 // Event data from OAD profile.
 static Queue_Struct oadQ;
 static Queue_Handle hOadQ;
+
+// Blocks the OAD write events and their packet are allocated from
+MSG_POOL_STORAGE(oadEvtStorage, sizeof(oadTargetWrite_t) + OAD_PACKET_SIZE,
+                 SBP_OAD_POOL_SIZE);
+static msg_pool_t oadEvtPool;
 #endif //FEATURE_OAD
 
 // events flag for internal application events.
@@ -275,7 +331,7 @@ static uint8_t scanRspData[] =
   GAP_ADTYPE_SLAVE_CONN_INTERVAL_RANGE,
   LO_UINT16(DEFAULT_DESIRED_MIN_CONN_INTERVAL),   // 100ms
   HI_UINT16(DEFAULT_DESIRED_MIN_CONN_INTERVAL),
-  LO_UINT16(DEFAULT_DESIRED_MAX_CONN_INTERVAL),   // 1s
+  LO_UINT16(DEFAULT_DESIRED_MAX_CONN_INTERVAL),   // 200ms
   HI_UINT16(DEFAULT_DESIRED_MAX_CONN_INTERVAL),
 
   // Tx power level
@@ -313,13 +369,40 @@ static uint8_t advertData[] =
 #endif //FEATURE_OAD_ONCHIP
 };
 
+// A sign job is waiting for the user or being signed
+static bool isSigning = false;
+
+#ifndef FEATURE_OAD_ONCHIP
+// Gives up on the user's confirmation of the running job
+static Clock_Struct confirmClock;
+
+// The job waiting for the user, SimpleBLEPeripheral_processConfirm() resumes
+// it once the button answered or the confirmation timed out
+static struct
+{
+  bool isWaiting;
+  uint16_t connHandle;
+  uint8_t kind;
+  uint8 challenge[USER_CHALLANGE_CHAR_LENGTH];
+  uint32_t jobStart;      // latency_start() of LATENCY_JOB
+  uint32_t confirmStart;  // latency_start() of LATENCY_CONFIRM
+} signJob;
+
+// Button event that answered the running job, BUTTON_NONE until one did
+static volatile uint8_t confirmAnswer = BUTTON_NONE;
+#endif //!FEATURE_OAD_ONCHIP
+
+#ifndef FEATURE_OAD_ONCHIP
+// What reads of the Diagnostics value return, the last command written to it
+static uint8_t diagView = DIAGNOSTICS_SHOW_LATENCY;
+
+// Taken when a client starts a read, so another client's read does not change it
+static sbpDiagSnapshot_t diagSnapshots[SBP_DIAG_LINKS];
+#endif //!FEATURE_OAD_ONCHIP
+
 // GAP GATT Attributes
 static uint8_t attDeviceName[GAP_DEVICE_NAME_LEN] = "MySigner";
 
-// Globals used for ATT Response retransmission
-static gattMsgEvent_t *pAttRsp = NULL;
-static uint8_t rspTxRetry = 0;
-
 /*********************************************************************
  * LOCAL FUNCTIONS
  */
@@ -331,18 +414,60 @@ static uint8_t SimpleBLEPeripheral_processStackMsg(ICall_Hdr *pMsg);
 static uint8_t SimpleBLEPeripheral_processGATTMsg(gattMsgEvent_t *pMsg);
 static void SimpleBLEPeripheral_processAppMsg(sbpEvt_t *pMsg);
 static void SimpleBLEPeripheral_processStateChangeEvt(gaprole_States_t newState);
-static void SimpleBLEPeripheral_processCharValueChangeEvt(uint8_t paramID);
+static void SimpleBLEPeripheral_processCharValueChangeEvt(uint16_t connHandle,
+                                                         uint8_t paramID);
+static void SimpleBLEPeripheral_processKeyInit(void);
+static void SimpleBLEPeripheral_processSignJob(void);
+#ifndef FEATURE_OAD_ONCHIP
+static void SimpleBLEPeripheral_askConfirm(void);
+static void SimpleBLEPeripheral_processConfirm(void);
+static void SimpleBLEPeripheral_endSignJob(bool success);
+static void SimpleBLEPeripheral_buttonCB(PIN_Id pin, button_event_t event);
+static bool SimpleBLEPeripheral_signChallenge(uint16_t connHandle,
+                                              uint8 *challenge, bool sealed,
+                                              bool confirmed);
+static void SimpleBLEPeripheral_openSealedChallenge(uint16_t connHandle);
+static bool SimpleBLEPeripheral_sealResponse(uint16_t connHandle,
+                                             uint8 *signature);
+#ifdef BULK_CHANNEL_ENABLED
+static uint8_t SimpleBLEPeripheral_checkBulk(uint16_t connHandle);
+static bool SimpleBLEPeripheral_signBulk(uint16_t connHandle, bool confirmed);
+#endif //BULK_CHANNEL_ENABLED
+#endif //!FEATURE_OAD_ONCHIP
+#ifdef BULK_CHANNEL_ENABLED
+static void SimpleBLEPeripheral_bulkRequestCB(uint16_t connHandle, uint8_t op,
+                                              uint8_t id, const uint8_t *pData,
+                                              uint16_t len);
+#endif //BULK_CHANNEL_ENABLED
+static void SimpleBLEPeripheral_processLinkEvt(uint16_t connHandle, uint8_t up);
+static void SimpleBLEPeripheral_getAdvertStatus(adv_status_t *status);
+static void SimpleBLEPeripheral_updateAdvertStatus(void);
 static void SimpleBLEPeripheral_performPeriodicTask(void);
 static void SimpleBLEPeripheral_clockHandler(UArg arg);
 
-static void SimpleBLEPeripheral_sendAttRsp(void);
-static void SimpleBLEPeripheral_freeAttRsp(uint8_t status);
-
 static void SimpleBLEPeripheral_stateChangeCB(gaprole_States_t newState);
+static void SimpleBLEPeripheral_paramUpdateCB(uint16_t connInterval,
+                                              uint16_t connSlaveLatency,
+                                              uint16_t connTimeout);
+static void SimpleBLEPeripheral_paramUpdateFailCB(uint8_t rejected);
+static void SimpleBLEPeripheral_linkCB(uint16_t connHandle, uint8_t up);
 #ifndef FEATURE_OAD_ONCHIP
-static void SimpleBLEPeripheral_charValueChangeCB(uint8_t paramID);
+static void SimpleBLEPeripheral_charValueChangeCB(uint16_t connHandle,
+                                                  uint8_t paramID);
+static void SimpleBLEPeripheral_notiPendingCB(uint16_t connHandle,
+                                              uint16_t handle,
+                                              uint8_t *pValue, uint16_t len);
+static void SimpleBLEPeripheral_notiSentCB(uint16_t connHandle, uint16_t handle);
+static uint16_t SimpleBLEPeripheral_diagReadCB(uint16_t connHandle,
+                                               uint8_t paramID,
+                                               uint16_t offset,
+                                               uint8_t *pValue,
+                                               uint16_t maxLen);
+static void SimpleBLEPeripheral_releaseDiagSnapshot(uint16_t connHandle);
 #endif //!FEATURE_OAD_ONCHIP
 static void SimpleBLEPeripheral_enqueueMsg(uint8_t event, uint8_t state);
+static void SimpleBLEPeripheral_enqueueConnMsg(uint8_t event, uint8_t state,
+                                               uint16_t connHandle);
 
 #ifdef FEATURE_OAD
 void SimpleBLEPeripheral_processOadWriteCB(uint8_t event, uint16_t connHandle,
@@ -360,6 +485,16 @@ static gapRolesCBs_t SimpleBLEPeripheral_gapRoleCBs =
   SimpleBLEPeripheral_stateChangeCB     // Profile State Change Callbacks
 };
 
+// GAP Role Connection Parameter Callbacks
+static gapRolesParamUpdateCB_t SimpleBLEPeripheral_paramUpdateCBs =
+  SimpleBLEPeripheral_paramUpdateCB;
+static gapRolesParamUpdateFailCB_t SimpleBLEPeripheral_paramUpdateFailCBs =
+  SimpleBLEPeripheral_paramUpdateFailCB;
+
+// GAP Role Link Callback, every central gets its own sign session
+static gapRolesLinkCB_t SimpleBLEPeripheral_linkCBs =
+  SimpleBLEPeripheral_linkCB;
+
 // GAP Bond Manager Callbacks
 static gapBondCBs_t simpleBLEPeripheral_BondMgrCBs =
 {
@@ -371,7 +506,10 @@ static gapBondCBs_t simpleBLEPeripheral_BondMgrCBs =
 #ifndef FEATURE_OAD_ONCHIP
 static simpleProfileCBs_t SimpleBLEPeripheral_simpleProfileCBs =
 {
-  SimpleBLEPeripheral_charValueChangeCB // Characteristic value change callback
+  SimpleBLEPeripheral_charValueChangeCB, // Characteristic value change callback
+  SimpleBLEPeripheral_notiPendingCB,     // Notification out of buffers callback
+  SimpleBLEPeripheral_notiSentCB,        // Notification sent callback
+  SimpleBLEPeripheral_diagReadCB         // Diagnostics read callback
 };
 #endif //!FEATURE_OAD_ONCHIP
 
@@ -406,6 +544,7 @@ void SimpleBLEPeripheral_createTask(void)
   taskParams.priority = SBP_TASK_PRIORITY;
 
   Task_construct(&sbpTask, SimpleBLEPeripheral_taskFxn, &taskParams, NULL);
+  telemetry_add_task(Task_handle(&sbpTask));
 }
 
 /*********************************************************************
@@ -427,9 +566,9 @@ static void SimpleBLEPeripheral_init(void)
   // ******************************************************************
   // Register the current thread as an ICall dispatcher application
   // so that the application can send and receive messages.
-  System_printf("About to register\n");
+  TRACE(TRACE_APP_REGISTER);
   ICall_registerApp(&selfEntity, &sem);
-  System_printf("ICALL register done\n");
+  TRACE(TRACE_APP_REGISTERED);
 
 #ifdef USE_RCOSC
   RCOSC_enableCalibration();
@@ -455,17 +594,32 @@ static void SimpleBLEPeripheral_init(void)
 
   // Create an RTOS queue for message from profile to be sent to app.
   appMsgQueue = Util_constructQueue(&appMsg);
+  msg_pool_init(&appEvtPool, appEvtStorage, sizeof(sbpEvt_t), SBP_EVT_POOL_SIZE);
 
   // Create one-shot clocks for internal periodic events.
   Util_constructClock(&periodicClock, SimpleBLEPeripheral_clockHandler,
                       SBP_PERIODIC_EVT_PERIOD, 0, false, SBP_PERIODIC_EVT);
 
+  // Idle timer of the connection parameter policy
+  conn_policy_init(SimpleBLEPeripheral_clockHandler, SBP_CONN_POLICY_EVT);
+
+#ifndef FEATURE_OAD_ONCHIP
+  // The user answers a sign job with the button, or lets it time out
+  Util_constructClock(&confirmClock, SimpleBLEPeripheral_clockHandler,
+                      SIGN_BUTTON_TIMEOUT_MS, 0, false, SBP_CONFIRM_EVT);
+  button_register_cb(SimpleBLEPeripheral_buttonCB);
+#endif //!FEATURE_OAD_ONCHIP
+
+  // Responses, notifications and bulk replies that found no buffer are retried
+  // at the end of the connection events
+  conn_notice_init(selfEntity, SBP_CONN_EVT_END_EVT);
+
   dispHandle = Display_open(SBP_DISPLAY_TYPE, NULL);
 
-  System_printf("About to set GAP\n");
+  TRACE(TRACE_APP_GAP);
   // Setup the GAP
   GAP_SetParamValue(TGAP_CONN_PAUSE_PERIPHERAL, DEFAULT_CONN_PAUSE_PERIPHERAL);
-  System_printf("GAP set\n");
+  TRACE(TRACE_APP_GAP_SET);
 
   // Setup the GAP Peripheral Role Profile
   {
@@ -491,7 +645,13 @@ static void SimpleBLEPeripheral_init(void)
 
     GAPRole_SetParameter(GAPROLE_SCAN_RSP_DATA, sizeof(scanRspData),
                          scanRspData);
-    GAPRole_SetParameter(GAPROLE_ADVERT_DATA, sizeof(advertData), advertData);
+    {
+      adv_status_t status;
+
+      // The signer status follows the fixed advertising data
+      SimpleBLEPeripheral_getAdvertStatus(&status);
+      adv_status_init(advertData, sizeof(advertData), &status);
+    }
 
     GAPRole_SetParameter(GAPROLE_PARAM_UPDATE_ENABLE, sizeof(uint8_t),
                          &enableUpdateRequest);
@@ -534,12 +694,12 @@ static void SimpleBLEPeripheral_init(void)
     GAPBondMgr_SetParameter(GAPBOND_BONDING_ENABLED, sizeof(uint8_t), &bonding);
   }
 
-  System_printf("About to set GATT services\n");
+  TRACE(TRACE_APP_GATT);
    // Initialize GATT attributes
   GGS_AddService(GATT_ALL_SERVICES);           // GAP
   GATTServApp_AddService(GATT_ALL_SERVICES);   // GATT attributes
   //DevInfo_AddService();                        // Device Information Service
-  System_printf("GATT services set\n");
+  TRACE(TRACE_APP_GATT_SET);
 
 #ifndef FEATURE_OAD_ONCHIP
   SimpleProfile_AddService(GATT_ALL_SERVICES); // Simple GATT Profile
@@ -549,6 +709,8 @@ static void SimpleBLEPeripheral_init(void)
   VOID OAD_addService();                 // OAD Profile
   OAD_register((oadTargetCBs_t *)&simpleBLEPeripheral_oadCBs);
   hOadQ = Util_constructQueue(&oadQ);
+  msg_pool_init(&oadEvtPool, oadEvtStorage,
+                sizeof(oadTargetWrite_t) + OAD_PACKET_SIZE, SBP_OAD_POOL_SIZE);
 #endif //FEATURE_OAD
 
 #ifdef IMAGE_INVALIDATE
@@ -575,12 +737,17 @@ static void SimpleBLEPeripheral_init(void)
 
   // Register callback with SimpleGATTprofile
   SimpleProfile_RegisterAppCBs(&SimpleBLEPeripheral_simpleProfileCBs);
-  System_printf("Registered the callbacks\n");
+  TRACE(TRACE_APP_CALLBACKS);
 #endif //!FEATURE_OAD_ONCHIP
 
   // Start the Device
   VOID GAPRole_StartDevice(&SimpleBLEPeripheral_gapRoleCBs);
 
+  // Let the connection policy follow the connection parameters
+  GAPRole_RegisterAppCBs(&SimpleBLEPeripheral_paramUpdateCBs);
+  GAPRole_RegisterParamUpdateFailCB(&SimpleBLEPeripheral_paramUpdateFailCBs);
+  GAPRole_RegisterLinkCB(&SimpleBLEPeripheral_linkCBs);
+
   // Start Bond Manager
   VOID GAPBondMgr_Register(&simpleBLEPeripheral_BondMgrCBs);
 
@@ -590,6 +757,13 @@ static void SimpleBLEPeripheral_init(void)
   // Register for GATT local events and ATT Responses pending for transmission
   GATT_RegisterForMsgs(selfEntity);
 
+#ifdef BULK_CHANNEL_ENABLED
+  // Accept L2CAP channels for bulk requests next to the GATT service
+  bulk_channel_init(ICall_getLocalMsgEntityId(ICALL_SERVICE_CLASS_BLE_MSG,
+                                              selfEntity),
+                    SimpleBLEPeripheral_bulkRequestCB);
+#endif //BULK_CHANNEL_ENABLED
+
   HCI_LE_ReadMaxDataLenCmd();
 
 #if defined FEATURE_OAD
@@ -614,12 +788,17 @@ static void SimpleBLEPeripheral_init(void)
  */
 static void SimpleBLEPeripheral_taskFxn(UArg a0, UArg a1)
 {
+  Memory_Stats biosHeap;
 
-  System_printf("SimplePeripheral_init waiting\n");
+  TRACE(TRACE_APP_INIT_WAIT);
   // Initialize application
   SimpleBLEPeripheral_init();
 
-  System_printf("SimplePeripheral_init done\n");
+  TRACE(TRACE_APP_INIT_DONE);
+
+  // Everything that goes on the BIOS heap is there by now, see BIOS.heapSize
+  Memory_getStats(NULL, &biosHeap);
+  TRACE(TRACE_BIOS_HEAP, biosHeap.totalSize - biosHeap.totalFreeSize, biosHeap.totalSize);
 
   // Application main loop
   for (;;)
@@ -650,8 +829,11 @@ static void SimpleBLEPeripheral_taskFxn(UArg a0, UArg a1)
           {
             if (pEvt->event_flag & SBP_CONN_EVT_END_EVT)
             {
-              // Try to retransmit pending ATT Response (if any)
-              SimpleBLEPeripheral_sendAttRsp();
+              // Try to retransmit pending ATT Responses and notifications
+              att_queue_send();
+#ifdef BULK_CHANNEL_ENABLED
+              bulk_channel_send();
+#endif //BULK_CHANNEL_ENABLED
             }
           }
           else
@@ -670,15 +852,13 @@ static void SimpleBLEPeripheral_taskFxn(UArg a0, UArg a1)
       // If RTOS queue is not empty, process app message.
       while (!Queue_empty(appMsgQueue))
       {
-        sbpEvt_t *pMsg = (sbpEvt_t *)Util_dequeueMsg(appMsgQueue);
-        if (pMsg)
-        {
-          // Process message.
-          SimpleBLEPeripheral_processAppMsg(pMsg);
+        sbpEvt_t *pMsg = (sbpEvt_t *)Queue_get(appMsgQueue);
 
-          // Free the space from the message.
-          ICall_free(pMsg);
-        }
+        // Process message.
+        SimpleBLEPeripheral_processAppMsg(pMsg);
+
+        // Return the message to the pool.
+        msg_pool_free(&appEvtPool, pMsg);
       }
     }
 
@@ -692,11 +872,48 @@ static void SimpleBLEPeripheral_taskFxn(UArg a0, UArg a1)
       SimpleBLEPeripheral_performPeriodicTask();
     }
 
+    if (events & SBP_CONN_POLICY_EVT)
+    {
+      events &= ~SBP_CONN_POLICY_EVT;
+
+      // Link idle for long enough or a parameter request to retry
+      conn_policy_process();
+    }
+
+    if (events & SBP_KEY_INIT_EVT)
+    {
+      events &= ~SBP_KEY_INIT_EVT;
+
+      // Advertising runs, now there is time to load the key
+      SimpleBLEPeripheral_processKeyInit();
+    }
+
+    if (events & SBP_SIGN_JOB_EVT)
+    {
+      events &= ~SBP_SIGN_JOB_EVT;
+
+      // Ask the user about the challenge of the next client in turn
+      SimpleBLEPeripheral_processSignJob();
+    }
+
+#ifndef FEATURE_OAD_ONCHIP
+    if (events & SBP_CONFIRM_EVT)
+    {
+      events &= ~SBP_CONFIRM_EVT;
+
+      // The user answered or the time is up, sign or decline
+      SimpleBLEPeripheral_processConfirm();
+    }
+#endif //!FEATURE_OAD_ONCHIP
+
 #ifdef FEATURE_OAD
     while (!Queue_empty(hOadQ))
     {
       oadTargetWrite_t *oadWriteEvt = Queue_get(hOadQ);
 
+      // Keep the link fast while image blocks come in
+      conn_policy_activity(CONN_POLICY_OAD);
+
       // Identify new image.
       if (oadWriteEvt->event == OAD_WRITE_IDENTIFY_REQ)
       {
@@ -709,7 +926,7 @@ static void SimpleBLEPeripheral_taskFxn(UArg a0, UArg a1)
       }
 
       // Free buffer.
-      ICall_free(oadWriteEvt);
+      msg_pool_free(&oadEvtPool, oadWriteEvt);
     }
 #endif //FEATURE_OAD
   }
@@ -735,6 +952,18 @@ static uint8_t SimpleBLEPeripheral_processStackMsg(ICall_Hdr *pMsg)
       safeToDealloc = SimpleBLEPeripheral_processGATTMsg((gattMsgEvent_t *)pMsg);
       break;
 
+#ifdef BULK_CHANNEL_ENABLED
+    case L2CAP_SIGNAL_EVENT:
+      // Bulk channel opened or closed, credits or a reply sent
+      bulk_channel_process_signal((l2capSignalEvent_t *)pMsg);
+      break;
+
+    case L2CAP_DATA_EVENT:
+      // Bulk request, frees the payload
+      bulk_channel_process_data((l2capDataEvent_t *)pMsg);
+      break;
+#endif //BULK_CHANNEL_ENABLED
+
     case HCI_GAP_EVENT_EVENT:
       {
         // Process HCI message
@@ -772,15 +1001,8 @@ static uint8_t SimpleBLEPeripheral_processGATTMsg(gattMsgEvent_t *pMsg)
   {
     // No HCI buffer was available. Let's try to retransmit the response
     // on the next connection event.
-    if (HCI_EXT_ConnEventNoticeCmd(pMsg->connHandle, selfEntity,
-                                   SBP_CONN_EVT_END_EVT) == SUCCESS)
+    if (att_queue_response(pMsg))
     {
-      // First free any pending response
-      SimpleBLEPeripheral_freeAttRsp(FAILURE);
-
-      // Hold on to the response message for retransmission
-      pAttRsp = pMsg;
-
       // Don't free the response message yet
       return (FALSE);
     }
@@ -808,119 +1030,213 @@ static uint8_t SimpleBLEPeripheral_processGATTMsg(gattMsgEvent_t *pMsg)
 }
 
 /*********************************************************************
- * @fn      SimpleBLEPeripheral_sendAttRsp
+ * @fn      SimpleBLEPeripheral_processAppMsg
  *
- * @brief   Send a pending ATT response message.
+ * @brief   Process an incoming callback from a profile.
  *
- * @param   none
+ * @param   pMsg - message to process
  *
- * @return  none
+ * @return  None.
  */
-static void SimpleBLEPeripheral_sendAttRsp(void)
+static void SimpleBLEPeripheral_processAppMsg(sbpEvt_t *pMsg)
 {
-  // See if there's a pending ATT Response to be transmitted
-  if (pAttRsp != NULL)
+  switch (pMsg->hdr.event)
   {
-    uint8_t status;
+    case SBP_STATE_CHANGE_EVT:
+      SimpleBLEPeripheral_processStateChangeEvt((gaprole_States_t)pMsg->
+                                                hdr.state);
+      break;
 
-    // Increment retransmission count
-    rspTxRetry++;
+    case SBP_CHAR_CHANGE_EVT:
+      latency_stop(LATENCY_DISPATCH, pMsg->queued);
+      SimpleBLEPeripheral_processCharValueChangeEvt(pMsg->connHandle,
+                                                    pMsg->hdr.state);
+      break;
 
-    // Try to retransmit ATT response till either we're successful or
-    // the ATT Client times out (after 30s) and drops the connection.
-    status = GATT_SendRsp(pAttRsp->connHandle, pAttRsp->method, &(pAttRsp->msg));
-    if ((status != blePending) && (status != MSG_BUFFER_NOT_AVAIL))
-    {
-      // Disable connection event end notice
-      HCI_EXT_ConnEventNoticeCmd(pAttRsp->connHandle, selfEntity, 0);
+    case SBP_LINK_EVT:
+      SimpleBLEPeripheral_processLinkEvt(pMsg->connHandle, pMsg->hdr.state);
+      break;
 
-      // We're done with the response message
-      SimpleBLEPeripheral_freeAttRsp(status);
-    }
-    else
-    {
-      // Continue retrying
-      Display_print1(dispHandle, 5, 0, "Rsp send retry: %d", rspTxRetry);
-    }
+    case SBP_PARAM_UPDATE_EVT:
+      {
+        uint16_t connInterval = 0;
+        uint16_t connLatency = 0;
+
+        GAPRole_GetParameter(GAPROLE_CONN_INTERVAL, &connInterval);
+        GAPRole_GetParameter(GAPROLE_CONN_LATENCY, &connLatency);
+        conn_policy_param_updated(connInterval, connLatency);
+      }
+      break;
+
+    case SBP_PARAM_UPDATE_FAIL_EVT:
+      conn_policy_param_update_failed(pMsg->hdr.state);
+      break;
+
+    default:
+      // Do nothing.
+      break;
   }
 }
 
 /*********************************************************************
- * @fn      SimpleBLEPeripheral_freeAttRsp
+ * @fn      SimpleBLEPeripheral_stateChangeCB
+ *
+ * @brief   Callback from GAP Role indicating a role state change.
+ *
+ * @param   newState - new state
+ *
+ * @return  None.
+ */
+static void SimpleBLEPeripheral_stateChangeCB(gaprole_States_t newState)
+{
+  SimpleBLEPeripheral_enqueueMsg(SBP_STATE_CHANGE_EVT, newState);
+}
+
+/*********************************************************************
+ * @fn      SimpleBLEPeripheral_paramUpdateCB
+ *
+ * @brief   Callback from GAP Role indicating new connection parameters.
+ *          The connection policy reads them back in the application task.
+ *
+ * @param   connInterval     - new connection interval
+ * @param   connSlaveLatency - new slave latency
+ * @param   connTimeout      - new supervision timeout
+ *
+ * @return  None.
+ */
+static void SimpleBLEPeripheral_paramUpdateCB(uint16_t connInterval,
+                                              uint16_t connSlaveLatency,
+                                              uint16_t connTimeout)
+{
+  SimpleBLEPeripheral_enqueueMsg(SBP_PARAM_UPDATE_EVT, 0);
+}
+
+/*********************************************************************
+ * @fn      SimpleBLEPeripheral_paramUpdateFailCB
+ *
+ * @brief   Callback from GAP Role indicating that a connection parameter
+ *          update request did not take effect.
+ *
+ * @param   rejected - TRUE if the central rejected the request
+ *
+ * @return  None.
+ */
+static void SimpleBLEPeripheral_paramUpdateFailCB(uint8_t rejected)
+{
+  SimpleBLEPeripheral_enqueueMsg(SBP_PARAM_UPDATE_FAIL_EVT, rejected);
+}
+
+/*********************************************************************
+ * @fn      SimpleBLEPeripheral_linkCB
+ *
+ * @brief   Callback from GAP Role indicating a link came up or went down.
+ *
+ * @param   connHandle - connection handle
+ * @param   up         - TRUE if the link came up
+ *
+ * @return  None.
+ */
+static void SimpleBLEPeripheral_linkCB(uint16_t connHandle, uint8_t up)
+{
+  SimpleBLEPeripheral_enqueueConnMsg(SBP_LINK_EVT, up, connHandle);
+}
+
+/*********************************************************************
+ * @fn      SimpleBLEPeripheral_processLinkEvt
  *
- * @brief   Free ATT response message.
+ * @brief   Process a link coming up or going down.
  *
- * @param   status - response transmit status
+ * @param   connHandle - connection handle
+ * @param   up         - TRUE if the link came up
  *
- * @return  none
+ * @return  None.
  */
-static void SimpleBLEPeripheral_freeAttRsp(uint8_t status)
+static void SimpleBLEPeripheral_processLinkEvt(uint16_t connHandle, uint8_t up)
 {
-  // See if there's a pending ATT response message
-  if (pAttRsp != NULL)
+  if (up)
   {
-    // See if the response was sent out successfully
-    if (status == SUCCESS)
-    {
-      Display_print1(dispHandle, 5, 0, "Rsp sent retry: %d", rspTxRetry);
-    }
-    else
-    {
-      // Free response payload
-      GATT_bm_free(&pAttRsp->msg, pAttRsp->method);
+    TRACE(TRACE_LINK_UP, connHandle);
+  }
+  else
+  {
+    att_queue_flush(connHandle);
+#ifdef BULK_CHANNEL_ENABLED
+    bulk_channel_close(connHandle);
+#endif //BULK_CHANNEL_ENABLED
+#ifndef FEATURE_OAD_ONCHIP
+    // Drop the client's jobs and clear its challenge and response
+    sign_session_close(connHandle);
+    SimpleProfile_CloseConn(connHandle);
+    SimpleBLEPeripheral_releaseDiagSnapshot(connHandle);
 
-      Display_print1(dispHandle, 5, 0, "Rsp retry failed: %d", rspTxRetry);
+    // Stop asking the user about a job nobody waits for any more
+    if (signJob.isWaiting && (signJob.connHandle == connHandle))
+    {
+      Util_stopClock(&confirmClock);
+      signJob.isWaiting = false;
+      set_green_led(off);
+      SimpleBLEPeripheral_endSignJob(false);
     }
+#endif //!FEATURE_OAD_ONCHIP
+    TRACE(TRACE_LINK_DOWN, connHandle);
 
-    // Free response message
-    ICall_freeMsg(pAttRsp);
-
-    // Reset our globals
-    pAttRsp = NULL;
-    rspTxRetry = 0;
+    // Its session is free again
+    SimpleBLEPeripheral_updateAdvertStatus();
   }
 }
 
 /*********************************************************************
- * @fn      SimpleBLEPeripheral_processAppMsg
+ * @fn      SimpleBLEPeripheral_getAdvertStatus
  *
- * @brief   Process an incoming callback from a profile.
+ * @brief   Collect the signer status gateways see in the advertising data.
  *
- * @param   pMsg - message to process
+ * @param   status - status to fill in.
  *
  * @return  None.
  */
-static void SimpleBLEPeripheral_processAppMsg(sbpEvt_t *pMsg)
+static void SimpleBLEPeripheral_getAdvertStatus(adv_status_t *status)
 {
-  switch (pMsg->hdr.event)
-  {
-    case SBP_STATE_CHANGE_EVT:
-      SimpleBLEPeripheral_processStateChangeEvt((gaprole_States_t)pMsg->
-                                                hdr.state);
-      break;
+  sign_session_stats_t stats;
 
-    case SBP_CHAR_CHANGE_EVT:
-      SimpleBLEPeripheral_processCharValueChangeEvt(pMsg->hdr.state);
-      break;
+  sign_session_get_stats(&stats);
 
-    default:
-      // Do nothing.
-      break;
+  if (is_RSA_read() == RSA_STATE_PENDING)
+  {
+    status->state = ADV_SIGNER_LOADING;
+  }
+  else if (is_RSA_read() != RSA_STATE_READY)
+  {
+    status->state = ADV_SIGNER_NO_KEY;
+  }
+  else if (isSigning)
+  {
+    status->state = ADV_SIGNER_BUSY;
+  }
+  else
+  {
+    status->state = ADV_SIGNER_IDLE;
   }
+  status->queued = stats.queued;
+  status->free_sessions = SIGN_SESSION_MAX - stats.sessions;
+  status->key_id = RSA_key_id();
 }
 
 /*********************************************************************
- * @fn      SimpleBLEPeripheral_stateChangeCB
+ * @fn      SimpleBLEPeripheral_updateAdvertStatus
  *
- * @brief   Callback from GAP Role indicating a role state change.
+ * @brief   Advertise the current signer status, called whenever a job
+ *          is queued, starts or ends and when a session closes.
  *
- * @param   newState - new state
+ * @param   None.
  *
  * @return  None.
  */
-static void SimpleBLEPeripheral_stateChangeCB(gaprole_States_t newState)
+static void SimpleBLEPeripheral_updateAdvertStatus(void)
 {
-  SimpleBLEPeripheral_enqueueMsg(SBP_STATE_CHANGE_EVT, newState);
+  adv_status_t status;
+
+  SimpleBLEPeripheral_getAdvertStatus(&status);
+  adv_status_update(&status);
 }
 
 /*********************************************************************
@@ -966,11 +1282,24 @@ static void SimpleBLEPeripheral_processStateChangeEvt(gaprole_States_t newState)
         // Display device address
         Display_print0(dispHandle, 1, 0, Util_convertBdAddr2Str(ownAddress));
         Display_print0(dispHandle, 2, 0, "Initialized");
+        boot_time_mark(BOOT_STACK_READY);
       }
       break;
 
     case GAPROLE_ADVERTISING:
+      // The last link can go down while advertising is already back on for
+      // a free link, then this comes instead of GAPROLE_WAITING
+      Util_stopClock(&periodicClock);
+      att_queue_flush(INVALID_CONNHANDLE);
+      conn_policy_disconnected();
+
       Display_print0(dispHandle, 2, 0, "Advertising");
+      boot_time_mark(BOOT_FIRST_ADVERT);
+      if (is_RSA_read() == RSA_STATE_PENDING)
+      {
+        events |= SBP_KEY_INIT_EVT;
+        Semaphore_post(sem);
+      }
       break;
 
 #ifdef PLUS_BROADCASTER
@@ -996,7 +1325,8 @@ static void SimpleBLEPeripheral_processStateChangeEvt(gaprole_States_t newState)
         // Reset flag for next connection.
         firstConnFlag = false;
 
-        SimpleBLEPeripheral_freeAttRsp(bleNotConnected);
+        att_queue_flush(INVALID_CONNHANDLE);
+        conn_policy_disconnected();
       }
       break;
 #endif //PLUS_BROADCASTER
@@ -1008,6 +1338,15 @@ static void SimpleBLEPeripheral_processStateChangeEvt(gaprole_States_t newState)
 
         Util_startClock(&periodicClock);
 
+        {
+          uint16_t connInterval = 0;
+          uint16_t connLatency = 0;
+
+          GAPRole_GetParameter(GAPROLE_CONN_INTERVAL, &connInterval);
+          GAPRole_GetParameter(GAPROLE_CONN_LATENCY, &connLatency);
+          conn_policy_connected(connInterval, connLatency);
+        }
+
         numActive = linkDB_NumActive();
 
         // Use numActive to determine the connection handle of the last
@@ -1057,7 +1396,8 @@ static void SimpleBLEPeripheral_processStateChangeEvt(gaprole_States_t newState)
 
     case GAPROLE_WAITING:
       Util_stopClock(&periodicClock);
-      SimpleBLEPeripheral_freeAttRsp(bleNotConnected);
+      att_queue_flush(INVALID_CONNHANDLE);
+      conn_policy_disconnected();
 
       Display_print0(dispHandle, 2, 0, "Disconnected");
 
@@ -1066,7 +1406,8 @@ static void SimpleBLEPeripheral_processStateChangeEvt(gaprole_States_t newState)
       break;
 
     case GAPROLE_WAITING_AFTER_TIMEOUT:
-      SimpleBLEPeripheral_freeAttRsp(bleNotConnected);
+      att_queue_flush(INVALID_CONNHANDLE);
+      conn_policy_disconnected();
 
       Display_print0(dispHandle, 2, 0, "Timed Out");
 
@@ -1099,187 +1440,883 @@ static void SimpleBLEPeripheral_processStateChangeEvt(gaprole_States_t newState)
  * @brief   Callback from Simple Profile indicating a characteristic
  *          value change.
  *
+ * @param   connHandle - connection of the client that changed the value.
  * @param   paramID - parameter ID of the value that was changed.
  *
  * @return  None.
  */
-static void SimpleBLEPeripheral_charValueChangeCB(uint8_t paramID)
+static void SimpleBLEPeripheral_charValueChangeCB(uint16_t connHandle,
+                                                  uint8_t paramID)
 {
-  System_printf("SimplePeripheral char value has changed. Enqueueing msg: %d\n", paramID);
-  SimpleBLEPeripheral_enqueueMsg(SBP_CHAR_CHANGE_EVT, paramID);
+  TRACE(TRACE_CHAR_CHANGE, connHandle, paramID);
+  SimpleBLEPeripheral_enqueueConnMsg(SBP_CHAR_CHANGE_EVT, paramID, connHandle);
 }
-#endif //!FEATURE_OAD_ONCHIP
 
 /*********************************************************************
- * @fn      SimpleBLEPeripheral_processCharValueChangeEvt
+ * @fn      SimpleBLEPeripheral_notiPendingCB
  *
- * @brief   Process a pending Simple Profile characteristic value change
- *          event.
+ * @brief   Callback from Simple Profile indicating a notification found
+ *          no buffer. The Response Status tells the client its signature
+ *          is ready, so it is queued ahead of other messages.
  *
- * @param   paramID - parameter ID of the value that was changed.
+ * @param   connHandle - connection to notify.
+ * @param   handle - attribute handle of the value.
+ * @param   pValue - value to notify.
+ * @param   len - length of the value.
  *
  * @return  None.
  */
-static void SimpleBLEPeripheral_processCharValueChangeEvt(uint8_t paramID)
+static void SimpleBLEPeripheral_notiPendingCB(uint16_t connHandle,
+                                              uint16_t handle,
+                                              uint8_t *pValue, uint16_t len)
 {
-#ifndef FEATURE_OAD_ONCHIP
-
-  uint8 *new_value = NULL;
-  size_t output_len = 0;
-  uint8 response_ready_state[1] = "";
-
-  int return_value = 0;
-
-  unsigned char *signed_result = NULL;
-  switch(paramID)
+  if (!att_queue_notification(connHandle, handle, pValue, len,
+                              ATT_QUEUE_SIGNATURE))
   {
-    case USER_CHALLANGE_CHAR_VALUE:
-        new_value = calloc(1, USER_CHALLANGE_CHAR_LENGTH);
-        if (!new_value) {
-            System_printf("Failed to alloacte memory for the new user challange\n");
-            goto challange_cleanup;
-        }
-        SimpleProfile_GetParameter(USER_CHALLANGE_CHAR_VALUE, new_value);
-
-        // Sign the challange we got from the server
-        output_len = MBEDTLS_MPI_MAX_SIZE;
-        signed_result = calloc(1, output_len);
-        if (!signed_result) {
-            System_printf("Failled to allocate memory for PKCS output buffer\n");
-        } else {
-            // Set the green led to indicate we have a request to sign
-            set_red_led(off);
-            set_green_led(blinking);
-
-            // Indicate that the state right now is waiting for the user click
-            response_ready_state[0] = PendingUserClick;
-            SimpleProfile_SetParameter(RESPONSE_READY_CHAR_VALUE, RESPONSE_READY_CHAR_LENGTH, response_ready_state);
-
-            while (Semaphore_pend(button_sem, BIOS_NO_WAIT)) {
-                // Free up any previously clicked buttons
-                continue;
-            }
-            if (Semaphore_pend(button_sem, SIGN_BUTTON_TIMEOUT)) {
-                // Turn off the blinking to free up the space used by the blinking task
-                set_green_led(off);
-
-                return_value = RSA_sign(new_value, USER_CHALLANGE_CHAR_LENGTH, signed_result, &output_len);
-                if (return_value != 0) {
-                    //Signing failed!
-                    set_green_led(off);
-                    set_red_led(blinking);
-                    response_ready_state[0] = ResponseNotReady;
-
-                    // Notify the error code...
-                    memset(signed_result, 0x0, output_len);
-                    memcpy(signed_result, &return_value, sizeof(return_value));
-                    SimpleProfile_SetParameter(SERVER_RESPONSE_CHAR_VALUE, SERVER_RESPONSE_CHAR_LENGTH, signed_result);
-                }
-                else if (output_len > SERVER_RESPONSE_CHAR_LENGTH) {
-                    //Signature is too long
-                    set_red_led(on);
-                    set_green_led(off);
-                    response_ready_state[0] = ResponseNotReady;
-                } else{
-                    // Success!
-                    SimpleProfile_SetParameter(SERVER_RESPONSE_CHAR_VALUE, SERVER_RESPONSE_CHAR_LENGTH, signed_result);
-                    set_green_led(on);
-                    set_red_led(off);
-                    response_ready_state[0] = ResponseReady;
-                }
-            } else {
-                // This means the user failed to click the sign button
-                response_ready_state[0] = ResponseNotReady;
-                set_green_led(off);
-                set_red_led(blinking);
-            }
-            // Update the current state
-            SimpleProfile_SetParameter(RESPONSE_READY_CHAR_VALUE, RESPONSE_READY_CHAR_LENGTH, response_ready_state);
-        }
-challange_cleanup:
-        if (new_value)
-            free(new_value);
-        if (signed_result)
-            free(signed_result);
-
-        break;
-
-    case RESPONSE_READY_CHAR_VALUE:
-        // This means the user has written a value into the response ready state
-        new_value = calloc(1, RESPONSE_READY_CHAR_LENGTH);
-        if (!new_value) {
-            System_printf("Failed to alloacte memory for the new user challange\n");
-            goto challange_cleanup;
-        }
-        SimpleProfile_GetParameter(RESPONSE_READY_CHAR_VALUE, new_value);
-        // This means the user has read the previous result
-        set_green_led(off);
-        set_red_led(off);
-
-    case SERVER_RESPONSE_CHAR_VALUE:
-        //TODO:
-        //SimpleProfile_GetParameter(SERVER_RESPONSE_CHAR_VALUE, new_value);
-        break;
-
-    default:
-      // should not reach here!
-      break;
+    TRACE(TRACE_NOTI_DROPPED, connHandle);
   }
-#endif //!FEATURE_OAD_ONCHIP
 }
 
 /*********************************************************************
- * @fn      SimpleBLEPeripheral_performPeriodicTask
+ * @fn      SimpleBLEPeripheral_notiSentCB
  *
- * @brief   Perform a periodic application task. This function gets called
- *          every five seconds (SBP_PERIODIC_EVT_PERIOD). In this example,
- *          the value of the third characteristic in the SimpleGATTProfile
- *          service is retrieved from the profile, and then copied into the
- *          value of the the fourth characteristic.
+ * @brief   Callback from Simple Profile indicating a notification was
+ *          sent. A queued one of the same value is older and dropped.
  *
- * @param   None.
+ * @param   connHandle - connection notified.
+ * @param   handle - attribute handle of the value.
  *
  * @return  None.
  */
-static void SimpleBLEPeripheral_performPeriodicTask(void)
+static void SimpleBLEPeripheral_notiSentCB(uint16_t connHandle, uint16_t handle)
 {
-#ifndef FEATURE_OAD_ONCHIP
-  //uint8_t valueToCopy;
-
-
-  //TODO: Perform some sort of periodic task?
-
-#endif //!FEATURE_OAD_ONCHIP
+  att_queue_sent(connHandle, handle);
 }
 
-
-#ifdef FEATURE_OAD
 /*********************************************************************
- * @fn      SimpleBLEPeripheral_processOadWriteCB
+ * @fn      SimpleBLEPeripheral_findDiagSnapshot
  *
- * @brief   Process a write request to the OAD profile.
+ * @brief   Find the snapshot of a client's reads, or take a free one.
+ *          Links give theirs back when they go down, so there is always
+ *          one free. Should one not be, the client shares the one of the
+ *          same slot number, which at worst cuts its long read short.
  *
- * @param   event      - event type:
- *                       OAD_WRITE_IDENTIFY_REQ
- *                       OAD_WRITE_BLOCK_REQ
- * @param   connHandle - the connection Handle this request is from.
- * @param   pData      - pointer to data for processing and/or storing.
+ * @param   connHandle - connection of the client.
  *
- * @return  None.
+ * @return  The client's snapshot.
  */
-void SimpleBLEPeripheral_processOadWriteCB(uint8_t event, uint16_t connHandle,
-                                           uint8_t *pData)
+static sbpDiagSnapshot_t *SimpleBLEPeripheral_findDiagSnapshot(uint16_t connHandle)
 {
-  oadTargetWrite_t *oadWriteEvt = ICall_malloc( sizeof(oadTargetWrite_t) + \
-                                             sizeof(uint8_t) * OAD_PACKET_SIZE);
+  sbpDiagSnapshot_t *freeSnapshot = NULL;
+  uint8_t i;
 
-  if ( oadWriteEvt != NULL )
+  for (i = 0; i < SBP_DIAG_LINKS; i++)
   {
-    oadWriteEvt->event = event;
-    oadWriteEvt->connHandle = connHandle;
-
-    oadWriteEvt->pData = (uint8_t *)(&oadWriteEvt->pData + 1);
-    memcpy(oadWriteEvt->pData, pData, OAD_PACKET_SIZE);
+    if (diagSnapshots[i].isUsed && (diagSnapshots[i].connHandle == connHandle))
+    {
+      return &diagSnapshots[i];
+    }
+    if ((!diagSnapshots[i].isUsed) && (!freeSnapshot))
+    {
+      freeSnapshot = &diagSnapshots[i];
+    }
+  }
+
+  if (!freeSnapshot)
+  {
+    freeSnapshot = &diagSnapshots[connHandle % SBP_DIAG_LINKS];
+  }
+  freeSnapshot->isUsed = true;
+  freeSnapshot->connHandle = connHandle;
+  freeSnapshot->len = 0;
+  freeSnapshot->paramID = DIAGNOSTICS_CHAR_VALUE;
+  return freeSnapshot;
+}
+
+/*********************************************************************
+ * @fn      SimpleBLEPeripheral_releaseDiagSnapshot
+ *
+ * @brief   Give back the snapshot of a client whose link went down.
+ *
+ * @param   connHandle - connection of the client.
+ *
+ * @return  None.
+ */
+static void SimpleBLEPeripheral_releaseDiagSnapshot(uint16_t connHandle)
+{
+  uint8_t i;
+
+  for (i = 0; i < SBP_DIAG_LINKS; i++)
+  {
+    if (diagSnapshots[i].isUsed && (diagSnapshots[i].connHandle == connHandle))
+    {
+      diagSnapshots[i].isUsed = false;
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      SimpleBLEPeripheral_diagReadCB
+ *
+ * @brief   Callback from Simple Profile reading the Diagnostics value,
+ *          the latency summary of every stage of the sign pipeline or
+ *          the results of the last self test, or the Telemetry value,
+ *          the stack and heap marks. The value is taken when a read
+ *          starts at offset 0, so the parts of a long read fit together.
+ *          Every client has its own, a read starting on another link
+ *          does not change the one a long read is served from.
+ *
+ * @param   connHandle - connection of the client.
+ * @param   paramID - DIAGNOSTICS_CHAR_VALUE or TELEMETRY_CHAR_VALUE.
+ * @param   offset - offset of the first byte read.
+ * @param   pValue - buffer to fill.
+ * @param   maxLen - space in the buffer.
+ *
+ * @return  Bytes written into pValue, SIMPLEPROFILE_DIAG_INVALID_OFFSET
+ *          if offset is past the end of the value.
+ */
+static uint16_t SimpleBLEPeripheral_diagReadCB(uint16_t connHandle,
+                                               uint8_t paramID,
+                                               uint16_t offset,
+                                               uint8_t *pValue,
+                                               uint16_t maxLen)
+{
+  sbpDiagSnapshot_t *snapshot;
+  uint16_t len;
+
+  // The results stay as they are until the next run, nothing to take
+  if ((paramID == DIAGNOSTICS_CHAR_VALUE) && (diagView == DIAGNOSTICS_RUN_SELF_TEST))
+  {
+    if (offset > self_test_len())
+    {
+      return SIMPLEPROFILE_DIAG_INVALID_OFFSET;
+    }
+    return self_test_read(offset, pValue, maxLen);
+  }
+
+  snapshot = SimpleBLEPeripheral_findDiagSnapshot(connHandle);
+
+  // A read of the other value in between takes its own snapshot
+  if ((offset == 0) || (paramID != snapshot->paramID))
+  {
+    snapshot->paramID = paramID;
+    snapshot->len = (paramID == TELEMETRY_CHAR_VALUE) ? telemetry_serialize(snapshot->value) :
+                                                        latency_serialize(snapshot->value);
+  }
+  // Reading right at the end is allowed and gets nothing
+  if (offset > snapshot->len)
+  {
+    return SIMPLEPROFILE_DIAG_INVALID_OFFSET;
+  }
+  if (offset == snapshot->len)
+  {
+    return 0;
+  }
+
+  len = snapshot->len - offset;
+  if (len > maxLen)
+  {
+    len = maxLen;
+  }
+  memcpy(pValue, &snapshot->value[offset], len);
+  return len;
+}
+#endif //!FEATURE_OAD_ONCHIP
+
+#ifdef BULK_CHANNEL_ENABLED
+/*********************************************************************
+ * @fn      SimpleBLEPeripheral_bulkRequestCB
+ *
+ * @brief   Request that came in over the bulk channel. Sign requests are
+ *          queued like challenges, image blocks are written right away.
+ *
+ * @param   connHandle - connection of the client.
+ * @param   op - bulk_channel_op_t of the request.
+ * @param   id - request id the client picked.
+ * @param   pData - request data after the id.
+ * @param   len - length of the data.
+ *
+ * @return  None.
+ */
+static void SimpleBLEPeripheral_bulkRequestCB(uint16_t connHandle, uint8_t op,
+                                              uint8_t id, const uint8_t *pData,
+                                              uint16_t len)
+{
+  switch (op)
+  {
+#ifndef FEATURE_OAD_ONCHIP
+    case BULK_OP_SIGN:
+    case BULK_OP_SIGN_BATCH:
+      conn_policy_activity((op == BULK_OP_SIGN) ? CONN_POLICY_SIGN : CONN_POLICY_BATCH);
+      if (sign_session_submit_bulk(connHandle))
+      {
+        events |= SBP_SIGN_JOB_EVT;
+        Semaphore_post(sem);
+        SimpleBLEPeripheral_updateAdvertStatus();
+      }
+      else
+      {
+        bulk_channel_reply(connHandle, op, id, 0, BULK_STATUS_REJECTED, NULL, 0);
+        bulk_channel_finish(connHandle);
+      }
+      break;
+#endif //!FEATURE_OAD_ONCHIP
+
+#ifdef FEATURE_OAD
+    case BULK_OP_IMAGE:
+      if ((len == 0) || ((len % OAD_PACKET_SIZE) != 0))
+      {
+        bulk_channel_reply(connHandle, op, id, 0, BULK_STATUS_INVALID, NULL, 0);
+        break;
+      }
+
+      // Keep the link fast while image blocks come in
+      conn_policy_activity(CONN_POLICY_OAD);
+
+      // Same packets as the Image Block characteristic, several per SDU
+      for (; len > 0; len -= OAD_PACKET_SIZE, pData += OAD_PACKET_SIZE)
+      {
+        OAD_imgBlockWrite(connHandle, (uint8_t *)pData);
+      }
+      break;
+#endif //FEATURE_OAD
+
+    default:
+      bulk_channel_reply(connHandle, op, id, 0, BULK_STATUS_INVALID, NULL, 0);
+      bulk_channel_finish(connHandle);
+      break;
+  }
+}
+#endif //BULK_CHANNEL_ENABLED
+
+/*********************************************************************
+ * @fn      SimpleBLEPeripheral_processCharValueChangeEvt
+ *
+ * @brief   Process a pending Simple Profile characteristic value change
+ *          event.
+ *
+ * @param   connHandle - connection of the client that changed the value.
+ * @param   paramID - parameter ID of the value that was changed.
+ *
+ * @return  None.
+ */
+static void SimpleBLEPeripheral_processCharValueChangeEvt(uint16_t connHandle,
+                                                         uint8_t paramID)
+{
+#ifndef FEATURE_OAD_ONCHIP
+
+  uint8 new_value[USER_CHALLANGE_CHAR_LENGTH];
+  uint8 response_ready_state[1] = "";
+
+  switch(paramID)
+  {
+    case USER_CHALLANGE_CHAR_VALUE:
+        // Get the link fast for the response while the user confirms
+        conn_policy_activity(CONN_POLICY_SIGN);
+
+        SimpleProfile_GetConnParameter(connHandle, USER_CHALLANGE_CHAR_VALUE, new_value);
+
+        // Queue the challenge, the clients take turns at the button
+        if (sign_session_submit(connHandle, new_value)) {
+            response_ready_state[0] = ChallangeQueued;
+            events |= SBP_SIGN_JOB_EVT;
+            Semaphore_post(sem);
+            SimpleBLEPeripheral_updateAdvertStatus();
+        } else {
+            TRACE(TRACE_NO_SESSION, connHandle);
+            response_ready_state[0] = ResponseNotReady;
+        }
+        SimpleProfile_SetConnParameter(connHandle, RESPONSE_READY_CHAR_VALUE, RESPONSE_READY_CHAR_LENGTH, response_ready_state);
+
+        // The session has its own copy
+        memset(new_value, 0, USER_CHALLANGE_CHAR_LENGTH);
+        break;
+
+    case SEALED_CHALLENGE_CHAR_VALUE:
+        conn_policy_activity(CONN_POLICY_SIGN);
+        SimpleBLEPeripheral_openSealedChallenge(connHandle);
+        break;
+
+    case RESPONSE_READY_CHAR_VALUE:
+        // This means the user has read the previous result
+        if (!sign_session_pending()) {
+            set_green_led(off);
+            set_red_led(off);
+        }
+        break;
+
+    case DIAGNOSTICS_CHAR_VALUE:
+        SimpleProfile_GetParameter(DIAGNOSTICS_CHAR_VALUE, &diagView);
+        // Blocks the task for seconds, the self test builds are for the bench only
+        if ((diagView == DIAGNOSTICS_RUN_SELF_TEST) && (!self_test_run())) {
+            diagView = DIAGNOSTICS_SHOW_LATENCY;
+        }
+        break;
+
+    case SERVER_RESPONSE_CHAR_VALUE:
+        //TODO:
+        //SimpleProfile_GetParameter(SERVER_RESPONSE_CHAR_VALUE, new_value);
+        break;
+
+    default:
+      // should not reach here!
+      break;
+  }
+#endif //!FEATURE_OAD_ONCHIP
+}
+
+#ifndef FEATURE_OAD_ONCHIP
+/*********************************************************************
+ * @fn      SimpleBLEPeripheral_buttonCB
+ *
+ * @brief   Called from the Clock Swi with every button event. The first
+ *          one while a job waits for the user answers it.
+ *
+ * @param   pin - button that was used.
+ * @param   event - what the user did.
+ *
+ * @return  None.
+ */
+static void SimpleBLEPeripheral_buttonCB(PIN_Id pin, button_event_t event)
+{
+  if (signJob.isWaiting && (confirmAnswer == BUTTON_NONE))
+  {
+    confirmAnswer = event;
+    events |= SBP_CONFIRM_EVT;
+    Semaphore_post(sem);
+  }
+}
+
+/*********************************************************************
+ * @fn      SimpleBLEPeripheral_askConfirm
+ *
+ * @brief   Blink the green led until the user presses the sign button or
+ *          the time is up, SimpleBLEPeripheral_processConfirm() goes on
+ *          from there. The application task keeps running meanwhile.
+ *
+ * @param   None.
+ *
+ * @return  None.
+ */
+static void SimpleBLEPeripheral_askConfirm(void)
+{
+  // Set the green led to indicate we have a request to sign
+  set_red_led(off);
+  set_green_led(blinking);
+
+  // Presses from before the request do not answer it
+  confirmAnswer = BUTTON_NONE;
+  signJob.isWaiting = true;
+  signJob.confirmStart = latency_start(LATENCY_CONFIRM);
+  Util_startClock(&confirmClock);
+}
+
+/*********************************************************************
+ * @fn      SimpleBLEPeripheral_processConfirm
+ *
+ * @brief   Sign the waiting job if the user confirmed it, decline it if
+ *          the button was held down or nobody pressed it in time.
+ *
+ * @param   None.
+ *
+ * @return  None.
+ */
+static void SimpleBLEPeripheral_processConfirm(void)
+{
+  uint8_t answer = confirmAnswer;
+  bool confirmed = false;
+  bool success;
+
+  // Neither answered nor timed out, or the job is gone
+  if ((!signJob.isWaiting) ||
+      ((answer == BUTTON_NONE) && Util_isActive(&confirmClock)))
+  {
+    return;
+  }
+  Util_stopClock(&confirmClock);
+  signJob.isWaiting = false;
+  latency_stop(LATENCY_CONFIRM, signJob.confirmStart);
+
+  // The user answered or failed to, stop asking
+  set_green_led(off);
+  if ((answer == BUTTON_NONE) || (answer == BUTTON_LONG_PRESS))
+  {
+    // Holding the button down declines the request
+    set_red_led(blinking);
+  }
+  else
+  {
+    confirmed = true;
+  }
+
+#ifdef BULK_CHANNEL_ENABLED
+  if (signJob.kind == SIGN_JOB_BULK) {
+      success = SimpleBLEPeripheral_signBulk(signJob.connHandle, confirmed);
+  } else
+#endif //BULK_CHANNEL_ENABLED
+  {
+      success = SimpleBLEPeripheral_signChallenge(signJob.connHandle, signJob.challenge,
+                                                  signJob.kind == SIGN_JOB_SEALED,
+                                                  confirmed);
+  }
+  SimpleBLEPeripheral_endSignJob(success);
+}
+
+/*********************************************************************
+ * @fn      SimpleBLEPeripheral_signChallenge
+ *
+ * @brief   Sign a challenge written to the Simple Profile and leave the
+ *          result in the client's response characteristic.
+ *
+ * @param   connHandle - connection of the client.
+ * @param   challenge - challenge to sign.
+ * @param   sealed - the challenge came over the sealed channel, seal the
+ *                   signature for the Sealed Response value.
+ * @param   confirmed - the user confirmed the challenge.
+ *
+ * @return  TRUE if the challenge was signed, FALSE otherwise.
+ */
+static bool SimpleBLEPeripheral_signChallenge(uint16_t connHandle,
+                                              uint8 *challenge, bool sealed,
+                                              bool confirmed)
+{
+  size_t output_len = 0;
+  uint8 response_ready_state[1] = "";
+  bool success = false;
+  uint32_t notifyStart = 0;
+
+  int return_value = 0;
+
+  unsigned char *signed_result = NULL;
+
+  // Sign the challange we got from the server, the result comes from the
+  // crypto arena like the rest of the signature
+  output_len = MBEDTLS_MPI_MAX_SIZE;
+  signed_result = confirmed ? crypto_arena_calloc(1, output_len) : NULL;
+  if (!confirmed) {
+      response_ready_state[0] = ResponseNotReady;
+  } else if (!signed_result) {
+      TRACE(TRACE_SIGN_NO_MEM, connHandle);
+      response_ready_state[0] = ResponseNotReady;
+  } else {
+      return_value = RSA_sign(challenge, USER_CHALLANGE_CHAR_LENGTH, signed_result, &output_len);
+      if (return_value != 0) {
+          //Signing failed!
+          set_green_led(off);
+          set_red_led(blinking);
+          response_ready_state[0] = ResponseNotReady;
+
+          // Notify the error code...
+          memset(signed_result, 0x0, output_len);
+          memcpy(signed_result, &return_value, sizeof(return_value));
+          SimpleProfile_SetConnParameter(connHandle, SERVER_RESPONSE_CHAR_VALUE, SERVER_RESPONSE_CHAR_LENGTH, signed_result);
+      }
+      else if (output_len > SERVER_RESPONSE_CHAR_LENGTH) {
+          //Signature is too long
+          set_red_led(on);
+          set_green_led(off);
+          response_ready_state[0] = ResponseNotReady;
+      } else if (sealed && !SimpleBLEPeripheral_sealResponse(connHandle, signed_result)) {
+          set_green_led(off);
+          set_red_led(blinking);
+          response_ready_state[0] = ResponseNotReady;
+      } else{
+          // Success! A sealed signature is in the Sealed Response value already
+          notifyStart = latency_start(LATENCY_NOTIFY);
+          if (!sealed) {
+              SimpleProfile_SetConnParameter(connHandle, SERVER_RESPONSE_CHAR_VALUE, SERVER_RESPONSE_CHAR_LENGTH, signed_result);
+          }
+          set_green_led(on);
+          set_red_led(off);
+          response_ready_state[0] = ResponseReady;
+          success = true;
+      }
+      crypto_arena_free(signed_result);
+  }
+
+  // Update the current state
+  SimpleProfile_SetConnParameter(connHandle, RESPONSE_READY_CHAR_VALUE, RESPONSE_READY_CHAR_LENGTH, response_ready_state);
+  if (success) {
+      latency_stop(LATENCY_NOTIFY, notifyStart);
+  }
+  return success;
+}
+
+/*********************************************************************
+ * @fn      SimpleBLEPeripheral_openSealedChallenge
+ *
+ * @brief   Open the challenge a client wrote to the Sealed Challange
+ *          value and queue it. One that does not open is dropped, the
+ *          client sees ResponseNotReady.
+ *
+ * @param   connHandle - connection of the client.
+ *
+ * @return  None.
+ */
+static void SimpleBLEPeripheral_openSealedChallenge(uint16_t connHandle)
+{
+  uint8 sealedValue[SEALED_CHALLENGE_CHAR_LENGTH];
+  uint8 *nonce = sealedValue;
+  uint8 *challenge = sealedValue + SEALED_NONCE_LENGTH;
+  uint8 *tag = challenge + USER_CHALLANGE_CHAR_LENGTH;
+  uint8 response_ready_state[1] = "";
+  int ret = MBEDTLS_ERR_CCM_BAD_INPUT;
+
+  if (SimpleProfile_GetConnParameter(connHandle, SEALED_CHALLENGE_CHAR_VALUE, sealedValue) == SUCCESS) {
+      ret = CCM_open(nonce, SEALED_NONCE_LENGTH, challenge, USER_CHALLANGE_CHAR_LENGTH,
+                     tag, SEALED_TAG_LENGTH);
+  }
+
+  if (ret != 0) {
+      TRACE(TRACE_SEALED_REJECTED, connHandle, ret);
+      response_ready_state[0] = ResponseNotReady;
+  } else if (sign_session_submit_sealed(connHandle, challenge, nonce)) {
+      response_ready_state[0] = ChallangeQueued;
+      events |= SBP_SIGN_JOB_EVT;
+      Semaphore_post(sem);
+      SimpleBLEPeripheral_updateAdvertStatus();
+  } else {
+      TRACE(TRACE_NO_SESSION, connHandle);
+      response_ready_state[0] = ResponseNotReady;
+  }
+  SimpleProfile_SetConnParameter(connHandle, RESPONSE_READY_CHAR_VALUE, RESPONSE_READY_CHAR_LENGTH, response_ready_state);
+
+  memset(sealedValue, 0, sizeof(sealedValue));
+}
+
+/*********************************************************************
+ * @fn      SimpleBLEPeripheral_sealResponse
+ *
+ * @brief   Seal a signature into the Sealed Response value of a client,
+ *          under the nonce of its challenge with the top bit flipped so
+ *          the two directions never share a nonce.
+ *
+ * @param   connHandle - connection of the client.
+ * @param   signature - SERVER_RESPONSE_CHAR_LENGTH bytes followed by room
+ *                      for the tag, sealed in place.
+ *
+ * @return  TRUE if the Sealed Response value holds it, FALSE otherwise.
+ */
+static bool SimpleBLEPeripheral_sealResponse(uint16_t connHandle,
+                                             uint8 *signature)
+{
+  uint8 nonce[SEALED_NONCE_LENGTH];
+
+  if (!sign_session_nonce(connHandle, nonce)) {
+      return false;
+  }
+  nonce[0] ^= 0x80;
+
+  if (CCM_seal(nonce, SEALED_NONCE_LENGTH, signature, SERVER_RESPONSE_CHAR_LENGTH,
+               signature + SERVER_RESPONSE_CHAR_LENGTH, SEALED_TAG_LENGTH) != 0) {
+      return false;
+  }
+  return (SimpleProfile_SetConnParameter(connHandle, SEALED_RESPONSE_CHAR_VALUE,
+                                         SEALED_RESPONSE_CHAR_LENGTH, signature) == SUCCESS);
+}
+
+#ifdef BULK_CHANNEL_ENABLED
+/*********************************************************************
+ * @fn      SimpleBLEPeripheral_checkBulk
+ *
+ * @brief   Count the messages of the client's bulk request before the user
+ *          is asked to confirm them. An invalid request is answered and
+ *          dropped right away.
+ *
+ * @param   connHandle - connection of the client.
+ *
+ * @return  Number of messages to sign, 0 if there is nothing to sign.
+ */
+static uint8_t SimpleBLEPeripheral_checkBulk(uint16_t connHandle)
+{
+  const uint8_t *pData;
+  const uint8_t *pMsg;
+  uint16_t len;
+  uint16_t msgLen;
+  uint8_t op;
+  uint8_t id;
+  uint8_t count = 0;
+
+  // The channel may have closed while the job waited
+  if (!bulk_channel_request(connHandle, &op, &id, &pData, &len)) {
+      return 0;
+  }
+
+  if (op == BULK_OP_SIGN) {
+      count = (len > 0) ? 1 : 0;
+  } else {
+      while (bulk_channel_batch_next(&pData, &len, &pMsg, &msgLen)) {
+          count++;
+      }
+      if ((len != 0) || (count > BULK_CHANNEL_MAX_BATCH)) {
+          count = 0;
+      }
+  }
+  if (count == 0) {
+      bulk_channel_reply(connHandle, op, id, 0, BULK_STATUS_INVALID, NULL, 0);
+      bulk_channel_finish(connHandle);
+  }
+  return count;
+}
+
+/*********************************************************************
+ * @fn      SimpleBLEPeripheral_signBulk
+ *
+ * @brief   Sign the message or batch of messages the client's bulk
+ *          channel holds and send every signature back over it. A batch
+ *          takes a single confirmation.
+ *
+ * @param   connHandle - connection of the client.
+ * @param   confirmed - the user confirmed the request.
+ *
+ * @return  TRUE if every message was signed, FALSE otherwise.
+ */
+static bool SimpleBLEPeripheral_signBulk(uint16_t connHandle, bool confirmed)
+{
+  const uint8_t *pData;
+  const uint8_t *pMsg;
+  uint16_t len;
+  uint16_t msgLen;
+  uint8_t op;
+  uint8_t id;
+  uint8_t index;
+  size_t output_len = 0;
+  bool success = false;
+
+  int return_value = 0;
+
+  unsigned char *signed_result = NULL;
+
+  // The channel may have closed while the user was asked
+  if (!bulk_channel_request(connHandle, &op, &id, &pData, &len)) {
+      return false;
+  }
+
+  if (!confirmed) {
+      bulk_channel_reply(connHandle, op, id, 0, BULK_STATUS_REJECTED, NULL, 0);
+      bulk_channel_finish(connHandle);
+      return false;
+  }
+
+  signed_result = crypto_arena_calloc(1, MBEDTLS_MPI_MAX_SIZE);
+  if (!signed_result) {
+      TRACE(TRACE_SIGN_NO_MEM, connHandle);
+      bulk_channel_reply(connHandle, op, id, 0, BULK_STATUS_BUSY, NULL, 0);
+  } else {
+      // One burst for the whole batch, standby is not given up between messages
+      sign_power_begin();
+      success = true;
+      for (index = 0; index < BULK_CHANNEL_MAX_BATCH; index++) {
+          if (op == BULK_OP_SIGN) {
+              pMsg = pData;
+              msgLen = len;
+          } else if (!bulk_channel_batch_next(&pData, &len, &pMsg, &msgLen)) {
+              break;
+          }
+
+          output_len = MBEDTLS_MPI_MAX_SIZE;
+          return_value = RSA_sign(pMsg, msgLen, signed_result, &output_len);
+          if (return_value != 0) {
+              // Notify the error code...
+              success = false;
+              bulk_channel_reply(connHandle, op, id, index, BULK_STATUS_FAILED,
+                                 (uint8_t *)&return_value, sizeof(return_value));
+          } else {
+              bulk_channel_reply(connHandle, op, id, index, BULK_STATUS_OK,
+                                 signed_result, output_len);
+          }
+          if (op == BULK_OP_SIGN) {
+              break;
+          }
+      }
+      sign_power_end();
+
+      if (success) {
+          set_green_led(on);
+          set_red_led(off);
+      } else {
+          set_green_led(off);
+          set_red_led(blinking);
+      }
+
+      memset(signed_result, 0, MBEDTLS_MPI_MAX_SIZE);
+      crypto_arena_free(signed_result);
+  }
+
+  bulk_channel_finish(connHandle);
+  return success;
+}
+#endif //BULK_CHANNEL_ENABLED
+#endif //!FEATURE_OAD_ONCHIP
+
+/*********************************************************************
+ * @fn      SimpleBLEPeripheral_processKeyInit
+ *
+ * @brief   Load the private key. It used to be loaded in main() before the
+ *          BLE stack came up and held back the first advertisement, now
+ *          it is loaded once advertising runs. Jobs that came in meanwhile
+ *          are started when it is done.
+ *
+ * @param   None.
+ *
+ * @return  None.
+ */
+static void SimpleBLEPeripheral_processKeyInit(void)
+{
+  if (is_RSA_read() != RSA_STATE_PENDING)
+  {
+    return;
+  }
+
+  RSA_init();
+  boot_time_mark(BOOT_KEY_READY);
+
+  if (sign_session_pending())
+  {
+    events |= SBP_SIGN_JOB_EVT;
+    Semaphore_post(sem);
+  }
+  SimpleBLEPeripheral_updateAdvertStatus();
+}
+
+/*********************************************************************
+ * @fn      SimpleBLEPeripheral_processSignJob
+ *
+ * @brief   Sign the next queued challenge or bulk request once the user
+ *          confirmed it. One job runs per call so stack messages are
+ *          handled in between, the next one is scheduled if more are
+ *          waiting.
+ *
+ * @param   None.
+ *
+ * @return  None.
+ */
+static void SimpleBLEPeripheral_processSignJob(void)
+{
+#ifndef FEATURE_OAD_ONCHIP
+  uint8 response_ready_state[1] = { PendingUserClick };
+
+  // One job at a time, SimpleBLEPeripheral_endSignJob() schedules the next
+  if (signJob.isWaiting) {
+      return;
+  }
+
+  // Jobs wait for the key, SimpleBLEPeripheral_processKeyInit() calls again
+  if (is_RSA_read() == RSA_STATE_PENDING) {
+      events |= SBP_KEY_INIT_EVT;
+      Semaphore_post(sem);
+      return;
+  }
+
+  if (!sign_session_next(&signJob.connHandle, &signJob.kind, signJob.challenge)) {
+      return;
+  }
+  signJob.jobStart = latency_start(LATENCY_JOB);
+
+  // Tell gateways scanning for an idle signer to look elsewhere
+  isSigning = true;
+  SimpleBLEPeripheral_updateAdvertStatus();
+
+#ifdef BULK_CHANNEL_ENABLED
+  if (signJob.kind == SIGN_JOB_BULK) {
+      if (SimpleBLEPeripheral_checkBulk(signJob.connHandle) == 0) {
+          SimpleBLEPeripheral_endSignJob(false);
+          return;
+      }
+  } else
+#endif //BULK_CHANNEL_ENABLED
+  {
+      // Indicate that the state right now is waiting for the user click
+      SimpleProfile_SetConnParameter(signJob.connHandle, RESPONSE_READY_CHAR_VALUE,
+                                     RESPONSE_READY_CHAR_LENGTH, response_ready_state);
+  }
+
+  SimpleBLEPeripheral_askConfirm();
+#endif //!FEATURE_OAD_ONCHIP
+}
+
+#ifndef FEATURE_OAD_ONCHIP
+/*********************************************************************
+ * @fn      SimpleBLEPeripheral_endSignJob
+ *
+ * @brief   Close the running job, whether it was signed, declined or its
+ *          link went down, and give the next client its turn.
+ *
+ * @param   success - the job was signed.
+ *
+ * @return  None.
+ */
+static void SimpleBLEPeripheral_endSignJob(bool success)
+{
+  latency_stop(LATENCY_JOB, signJob.jobStart);
+  sign_session_finish(signJob.connHandle, success);
+  memset(signJob.challenge, 0, sizeof(signJob.challenge));
+  isSigning = false;
+
+  // The idle timeout starts over now that the response can be read
+  conn_policy_activity(CONN_POLICY_SIGN);
+
+  // Give the next client its turn after the stack messages that came in
+  if (sign_session_pending()) {
+      events |= SBP_SIGN_JOB_EVT;
+      Semaphore_post(sem);
+  }
+  SimpleBLEPeripheral_updateAdvertStatus();
+}
+#endif //!FEATURE_OAD_ONCHIP
+
+/*********************************************************************
+ * @fn      SimpleBLEPeripheral_performPeriodicTask
+ *
+ * @brief   Perform a periodic application task. This function gets called
+ *          every five seconds (SBP_PERIODIC_EVT_PERIOD) while connected,
+ *          it samples the stack and heap marks.
+ *
+ * @param   None.
+ *
+ * @return  None.
+ */
+static void SimpleBLEPeripheral_performPeriodicTask(void)
+{
+  // Stack and heap marks for the Telemetry characteristic
+  telemetry_sample(false);
+
+#ifndef FEATURE_OAD_ONCHIP
+  //uint8_t valueToCopy;
+
+
+  //TODO: Perform some sort of periodic task?
+
+#endif //!FEATURE_OAD_ONCHIP
+}
+
+
+#ifdef FEATURE_OAD
+/*********************************************************************
+ * @fn      SimpleBLEPeripheral_processOadWriteCB
+ *
+ * @brief   Process a write request to the OAD profile.
+ *
+ * @param   event      - event type:
+ *                       OAD_WRITE_IDENTIFY_REQ
+ *                       OAD_WRITE_BLOCK_REQ
+ * @param   connHandle - the connection Handle this request is from.
+ * @param   pData      - pointer to data for processing and/or storing.
+ *
+ * @return  None.
+ */
+void SimpleBLEPeripheral_processOadWriteCB(uint8_t event, uint16_t connHandle,
+                                           uint8_t *pData)
+{
+  oadTargetWrite_t *oadWriteEvt = msg_pool_alloc(&oadEvtPool);
+
+  if ( oadWriteEvt != NULL )
+  {
+    oadWriteEvt->event = event;
+    oadWriteEvt->connHandle = connHandle;
+
+    oadWriteEvt->pData = (uint8_t *)(&oadWriteEvt->pData + 1);
+    memcpy(oadWriteEvt->pData, pData, OAD_PACKET_SIZE);
 
     Queue_put(hOadQ, (Queue_Elem *)oadWriteEvt);
 
@@ -1322,17 +2359,38 @@ static void SimpleBLEPeripheral_clockHandler(UArg arg)
  * @return  None.
  */
 static void SimpleBLEPeripheral_enqueueMsg(uint8_t event, uint8_t state)
+{
+  SimpleBLEPeripheral_enqueueConnMsg(event, state, INVALID_CONNHANDLE);
+}
+
+/*********************************************************************
+ * @fn      SimpleBLEPeripheral_enqueueConnMsg
+ *
+ * @brief   Creates a message about a connection and puts the message in
+ *          RTOS queue.
+ *
+ * @param   event      - message event.
+ * @param   state      - message state.
+ * @param   connHandle - connection the message is about.
+ *
+ * @return  None.
+ */
+static void SimpleBLEPeripheral_enqueueConnMsg(uint8_t event, uint8_t state,
+                                               uint16_t connHandle)
 {
   sbpEvt_t *pMsg;
 
-  // Create dynamic pointer to message.
-  if ((pMsg = ICall_malloc(sizeof(sbpEvt_t))))
+  // Take a message from the pool.
+  if ((pMsg = msg_pool_alloc(&appEvtPool)))
   {
     pMsg->hdr.event = event;
     pMsg->hdr.state = state;
+    pMsg->connHandle = connHandle;
+    pMsg->queued = latency_start(LATENCY_DISPATCH);
 
     // Enqueue the message.
-    Util_enqueueMsg(appMsgQueue, sem, (uint8*)pMsg);
+    Queue_put(appMsgQueue, &pMsg->_elem);
+    Semaphore_post(sem);
   }
 }
 
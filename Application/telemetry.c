@@ -0,0 +1,225 @@
+#include "telemetry.h"
+
+#include <stddef.h>
+#include <string.h>
+#include <xdc/std.h>
+#include <xdc/runtime/Memory.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include "icall.h"
+#include "crypto_arena.h"
+
+/*
+ * How close the stacks and heaps come to running out.
+ *
+ * The stack sizes and the crypto temporaries that went to the heap to fit them were
+ * picked by guesswork. BIOS fills every task stack with a pattern, Task_stat() finds
+ * how deep it was ever overwritten, and the heaps tell how much is free and how big
+ * the largest hole is. Each sample keeps the least free memory seen, and the samples
+ * taken while signing are kept apart, that is when memory is short. The marks live
+ * in RAM the startup code leaves alone and carry a check word, so after a reset they
+ * are still there to read if the reset was one of running out.
+ */
+
+#define TELEMETRY_MAGIC     0x544C4D31  // "TLM1"
+#define TELEMETRY_NONE      UINT32_MAX  // min_free before the first sample
+#define SYSTEM_PRIORITY     0xFF
+
+#pragma NOINIT(retained)
+static telemetry_t retained;
+
+static Task_Handle tasks[TELEMETRY_MAX_TASKS];
+static uint8_t taskCount = 0;
+
+static uint32_t checksum(const telemetry_t *telemetry) {
+    const uint32_t *word = (const uint32_t *) telemetry;
+    uint32_t sum = TELEMETRY_MAGIC;
+    uint16_t i;
+
+    for (i = 0; i < offsetof(telemetry_t, check) / sizeof(uint32_t); i++) {
+        sum = ((sum << 5) | (sum >> 27)) ^ word[i];
+    }
+    return sum;
+}
+
+static void clear_marks(telemetry_t *telemetry) {
+    uint8_t i;
+
+    memset(telemetry, 0, sizeof(telemetry_t));
+    telemetry->magic = TELEMETRY_MAGIC;
+    for (i = 0; i < TELEMETRY_HEAP_COUNT; i++) {
+        telemetry->heaps[i].min_free = TELEMETRY_NONE;
+        telemetry->heaps[i].sign_min_free = TELEMETRY_NONE;
+    }
+}
+
+static void put_u16(uint8_t *buf, uint16_t value) {
+    buf[0] = value & 0xFF;
+    buf[1] = (value >> 8) & 0xFF;
+}
+
+static void put_u32(uint8_t *buf, uint32_t value) {
+    put_u16(buf, value & 0xFFFF);
+    put_u16(buf + 2, value >> 16);
+}
+
+static void sample_heap(telemetry_heap_t *heap, uint32_t size, uint32_t free,
+                        uint32_t largestFree, uint32_t signFree, bool signing) {
+    heap->size = size;
+    heap->free = free;
+    heap->largest_free = largestFree;
+    if (free < heap->min_free) {
+        heap->min_free = free;
+    }
+    if (signing && (signFree < heap->sign_min_free)) {
+        heap->sign_min_free = signFree;
+    }
+}
+
+void telemetry_add_task(Task_Handle task) {
+    if ((task) && (taskCount < TELEMETRY_MAX_TASKS)) {
+        tasks[taskCount++] = task;
+    }
+}
+
+void telemetry_init() {
+    Task_Handle task;
+    Int i;
+
+    // The idle task, then what ICall made
+    for (i = 0; i < Task_Object_count(); i++) {
+        telemetry_add_task(Task_Object_get(NULL, i));
+    }
+    for (task = Task_Object_first(); task; task = Task_Object_next(task)) {
+        telemetry_add_task(task);
+    }
+
+    // The marks of the boot before only mean something for the same tasks
+    if ((retained.magic == TELEMETRY_MAGIC) && (retained.check == checksum(&retained)) &&
+        (retained.task_count == taskCount)) {
+        retained.boots++;
+    }
+    else {
+        clear_marks(&retained);
+        retained.task_count = taskCount;
+    }
+    retained.check = checksum(&retained);
+}
+
+void telemetry_sample(bool signing) {
+    telemetry_stack_t stacks[TELEMETRY_MAX_TASKS];
+    telemetry_stack_t system;
+    Task_Stat stat;
+    Hwi_StackInfo hwiInfo;
+    Memory_Stats biosHeap;
+#ifdef HEAPMGR_METRICS
+    ICall_heapStats_t icallHeap;
+#endif
+    crypto_arena_stats_t arena;
+    UInt taskKey;
+    uint8_t i;
+
+    // Stack scans and heap walks first, the marks are only locked to be updated
+    for (i = 0; i < taskCount; i++) {
+        Task_stat(tasks[i], &stat);
+        stacks[i].size = stat.stackSize;
+        stacks[i].peak = stat.used;
+        stacks[i].priority = stat.priority;
+    }
+    Hwi_getStackInfo(&hwiInfo, TRUE);
+    system.size = hwiInfo.hwiStackSize;
+    system.peak = hwiInfo.hwiStackPeak;
+    system.priority = SYSTEM_PRIORITY;
+
+    Memory_getStats(NULL, &biosHeap);
+#ifdef HEAPMGR_METRICS
+    ICall_getHeapStats(&icallHeap);
+#endif
+    crypto_arena_get_stats(&arena);
+
+    taskKey = Task_disable();
+    // A peak from before the reset stays until the stack goes deeper this boot
+    for (i = 0; i < taskCount; i++) {
+        if (stacks[i].peak < retained.tasks[i].peak) {
+            stacks[i].peak = retained.tasks[i].peak;
+        }
+        retained.tasks[i] = stacks[i];
+    }
+    if (system.peak < retained.system.peak) {
+        system.peak = retained.system.peak;
+    }
+    retained.system = system;
+
+    sample_heap(&retained.heaps[TELEMETRY_HEAP_BIOS], biosHeap.totalSize,
+                biosHeap.totalFreeSize, biosHeap.largestFreeSize,
+                biosHeap.totalFreeSize, signing);
+#ifdef HEAPMGR_METRICS
+    sample_heap(&retained.heaps[TELEMETRY_HEAP_ICALL], icallHeap.totalSize,
+                icallHeap.totalFreeSize, icallHeap.largestFreeSize,
+                icallHeap.totalFreeSize, signing);
+#endif
+    // The arena's peak covers the whole signature, not only this moment
+    sample_heap(&retained.heaps[TELEMETRY_HEAP_CRYPTO], arena.size,
+                arena.size - arena.used, arena.largest_free,
+                arena.size - arena.peak, signing);
+    retained.check = checksum(&retained);
+    Task_restore(taskKey);
+}
+
+void telemetry_get(telemetry_t *telemetry) {
+    UInt taskKey;
+
+    if (!telemetry) {
+        return;
+    }
+
+    taskKey = Task_disable();
+    memcpy(telemetry, &retained, sizeof(telemetry_t));
+    Task_restore(taskKey);
+}
+
+uint16_t telemetry_serialize(uint8_t *buf) {
+    telemetry_t telemetry;
+    const telemetry_stack_t *stack;
+    const telemetry_heap_t *heap;
+    uint8_t *p = buf;
+    uint8_t i;
+
+    telemetry_get(&telemetry);
+
+    *p++ = TELEMETRY_DIAG_VERSION;
+    put_u16(p, telemetry.boots);
+    p += 2;
+    *p++ = 1 + TELEMETRY_MAX_TASKS;
+    *p++ = TELEMETRY_HEAP_COUNT;
+    for (i = 0; i <= TELEMETRY_MAX_TASKS; i++) {
+        stack = (i == 0) ? &telemetry.system : &telemetry.tasks[i - 1];
+        put_u16(p, stack->size);
+        put_u16(p + 2, stack->peak);
+        p[4] = stack->priority;
+        p += TELEMETRY_STACK_LEN;
+    }
+    for (i = 0; i < TELEMETRY_HEAP_COUNT; i++) {
+        heap = &telemetry.heaps[i];
+        put_u32(p, heap->size);
+        put_u32(p + 4, heap->free);
+        put_u32(p + 8, heap->largest_free);
+        put_u32(p + 12, heap->min_free);
+        put_u32(p + 16, heap->sign_min_free);
+        // Fragmentation in percent, the part of the free memory outside the largest hole
+        p[20] = (heap->free > 0) ? 100 - (uint8_t) (heap->largest_free * 100 / heap->free) : 0;
+        p += TELEMETRY_HEAP_LEN;
+    }
+    return p - buf;
+}
+
+void telemetry_reset() {
+    UInt taskKey = Task_disable();
+    uint8_t count = retained.task_count;
+    uint16_t boots = retained.boots;
+
+    clear_marks(&retained);
+    retained.task_count = count;
+    retained.boots = boots;
+    retained.check = checksum(&retained);
+    Task_restore(taskKey);
+}
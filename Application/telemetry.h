@@ -0,0 +1,86 @@
+#ifndef APPLICATION_TELEMETRY_H_
+#define APPLICATION_TELEMETRY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <ti/sysbios/knl/Task.h>
+
+// Tasks whose stacks are watched, the constructed ones and those BIOS or ICall made
+#define TELEMETRY_MAX_TASKS 6
+
+// Layout of telemetry_serialize(), bumped when it changes
+#define TELEMETRY_DIAG_VERSION 1
+
+typedef enum telemetry_heap_id {
+    TELEMETRY_HEAP_BIOS = 0,    // malloc() and the BIOS objects, BIOS.heapSize
+    TELEMETRY_HEAP_ICALL,       // ICall_malloc() and the BLE stack, with HEAPMGR_METRICS only
+    TELEMETRY_HEAP_CRYPTO,      // mbedTLS, see crypto_arena.h
+    TELEMETRY_HEAP_COUNT
+} telemetry_heap_id_t;
+
+typedef struct telemetry_stack {
+    uint16_t size;
+    uint16_t peak;              // Deepest the stack was ever used, from its fill pattern
+    uint8_t priority;           // 0xFF for the system stack
+} telemetry_stack_t;
+
+typedef struct telemetry_heap {
+    uint32_t size;
+    uint32_t free;
+    uint32_t largest_free;      // Biggest block a request could still get
+    uint32_t min_free;          // Least free seen
+    uint32_t sign_min_free;     // Least free seen while a signature was made
+} telemetry_heap_t;
+
+/*
+ * Kept in RAM the startup code does not clear, so the marks of the boot before a
+ * reset can still be read after it.
+ */
+typedef struct telemetry {
+    uint32_t magic;
+    uint16_t boots;             // Resets the marks lived through
+    uint8_t task_count;
+    telemetry_stack_t system;   // Hwis and Swis run on it
+    telemetry_stack_t tasks[TELEMETRY_MAX_TASKS];
+    telemetry_heap_t heaps[TELEMETRY_HEAP_COUNT];
+    uint32_t check;
+} telemetry_t;
+
+// Bytes telemetry_serialize() writes
+#define TELEMETRY_STACK_LEN 5
+#define TELEMETRY_HEAP_LEN  21
+#define TELEMETRY_DIAG_LEN  (5 + (1 + TELEMETRY_MAX_TASKS) * TELEMETRY_STACK_LEN + \
+                             TELEMETRY_HEAP_COUNT * TELEMETRY_HEAP_LEN)
+
+/*
+ * Watch the stack of a task made with Task_construct(), those are not in the lists
+ * of BIOS. Call it before telemetry_init().
+ */
+void telemetry_add_task(Task_Handle task);
+
+/*
+ * Adds the tasks BIOS and ICall made and takes over the marks of the boot before when
+ * they survived it. Call it right before BIOS_start().
+ */
+void telemetry_init();
+
+/*
+ * Takes the stack and heap marks, signing says a signature is in progress.
+ * Task context only, the BIOS heap is guarded by a mutex.
+ */
+void telemetry_sample(bool signing);
+
+void telemetry_get(telemetry_t *telemetry);
+
+/*
+ * Everything, little endian, for the Telemetry characteristic.
+ * buf has to hold TELEMETRY_DIAG_LEN bytes.
+ */
+uint16_t telemetry_serialize(uint8_t *buf);
+
+/*
+ * Starts the marks over, the stack peaks stay what the fill patterns say
+ */
+void telemetry_reset();
+
+#endif /* APPLICATION_TELEMETRY_H_ */
@@ -0,0 +1,156 @@
+#include "trace.h"
+
+#include <string.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/hal/Hwi.h>
+
+#ifdef TRACE_UART
+#include <ti/drivers/UART.h>
+#include "board.h"
+
+#if defined(BOARD_DISPLAY_USE_UART) && (BOARD_DISPLAY_USE_UART != 0)
+#error "TRACE_UART needs the UART the display uses"
+#endif
+#endif // TRACE_UART
+
+/*
+ * Binary trace records instead of System_printf().
+ *
+ * Every System_printf() formatted its string right where it was called, a few times
+ * for every AES block. A trace point now stores its event id, the time and two
+ * arguments in a ring and returns, the strings stay in trace_events.h and
+ * TOOLS/trace_decode.py puts them back together on the host. The ring is drained from
+ * the idle task, so the records leave the device only when there is nothing else to
+ * do. When the ring is full the oldest record makes room, the gap shows in the
+ * sequence numbers.
+ */
+
+#define TRACE_RING_MASK (TRACE_RING_SIZE - 1)
+
+static trace_record_t ring[TRACE_RING_SIZE];
+static uint16_t head = 0;   // Next record written
+static uint16_t tail = 0;   // Next record drained
+static uint16_t seq = 0;
+static trace_sink_t pfnSink = NULL;
+
+static trace_stats_t traceStats;
+
+#ifdef TRACE_UART
+static UART_Handle uartHandle = NULL;
+static uint8_t uartBuf[1 + sizeof(trace_record_t) + 1];
+static volatile bool isUartBusy = false;
+
+static void uart_write_done(UART_Handle handle, void *buf, size_t count) {
+    isUartBusy = false;
+}
+
+static bool uart_sink(const trace_record_t *record) {
+    uint8_t sum = 0;
+    uint8_t i;
+
+    if (isUartBusy) {
+        return false;
+    }
+
+    uartBuf[0] = TRACE_SYNC_BYTE;
+    memcpy(&uartBuf[1], record, sizeof(trace_record_t));
+    for (i = 1; i <= sizeof(trace_record_t); i++) {
+        sum += uartBuf[i];
+    }
+    uartBuf[1 + sizeof(trace_record_t)] = (uint8_t) -sum;
+    isUartBusy = true;
+    if (UART_write(uartHandle, uartBuf, sizeof(uartBuf)) == UART_ERROR) {
+        isUartBusy = false;
+        return false;
+    }
+    return true;
+}
+#endif // TRACE_UART
+
+void trace_init() {
+#ifdef TRACE_UART
+    UART_Params params;
+
+    UART_init();
+    UART_Params_init(&params);
+    params.baudRate = 115200;
+    params.writeDataMode = UART_DATA_BINARY;
+    params.writeMode = UART_MODE_CALLBACK;
+    params.writeCallback = uart_write_done;
+    uartHandle = UART_open(Board_UART0, &params);
+    if (uartHandle) {
+        pfnSink = uart_sink;
+    }
+#endif // TRACE_UART
+}
+
+void trace_record(trace_id_t id, uint32_t arg0, uint32_t arg1) {
+    trace_record_t *record;
+    UInt hwiKey;
+
+    hwiKey = Hwi_disable();
+    if ((uint16_t) (head - tail) == TRACE_RING_SIZE) {
+        tail++;
+        traceStats.overwritten++;
+    }
+    record = &ring[head & TRACE_RING_MASK];
+    record->timestamp = Clock_getTicks();
+    record->id = id;
+    record->seq = seq++;
+    record->args[0] = arg0;
+    record->args[1] = arg1;
+    head++;
+    traceStats.recorded++;
+    Hwi_restore(hwiKey);
+}
+
+void trace_set_sink(trace_sink_t sink) {
+    pfnSink = sink;
+}
+
+void trace_idle() {
+    trace_record_t record;
+    uint16_t taken;
+    UInt hwiKey;
+
+    while (pfnSink) {
+        hwiKey = Hwi_disable();
+        if (head == tail) {
+            Hwi_restore(hwiKey);
+            return;
+        }
+        taken = tail;
+        memcpy(&record, &ring[taken & TRACE_RING_MASK], sizeof(trace_record_t));
+        Hwi_restore(hwiKey);
+
+        if (!pfnSink(&record)) {
+            return;
+        }
+
+        hwiKey = Hwi_disable();
+        // Unless it was overwritten meanwhile and the tail moved on already
+        if (tail == taken) {
+            tail++;
+        }
+        traceStats.drained++;
+        Hwi_restore(hwiKey);
+    }
+}
+
+void trace_get_stats(trace_stats_t *stats) {
+    UInt hwiKey;
+
+    if (!stats) {
+        return;
+    }
+
+    hwiKey = Hwi_disable();
+    memcpy(stats, &traceStats, sizeof(trace_stats_t));
+    Hwi_restore(hwiKey);
+}
+
+void trace_reset_stats() {
+    UInt hwiKey = Hwi_disable();
+    memset(&traceStats, 0, sizeof(trace_stats_t));
+    Hwi_restore(hwiKey);
+}
@@ -0,0 +1,95 @@
+#ifndef APPLICATION_TRACE_H_
+#define APPLICATION_TRACE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TRACE_LEVEL_NONE  0
+#define TRACE_LEVEL_ERROR 1
+#define TRACE_LEVEL_WARN  2
+#define TRACE_LEVEL_INFO  3
+#define TRACE_LEVEL_DEBUG 4
+
+// Events above this level are compiled out together with their arguments
+#ifndef TRACE_LEVEL
+#define TRACE_LEVEL TRACE_LEVEL_INFO
+#endif
+
+// Records kept until the idle hook drains them, a power of two
+#ifndef TRACE_RING_SIZE
+#define TRACE_RING_SIZE 16
+#endif
+
+// Leads every record on the UART so the decoder can find the record boundaries.
+// The record bytes can hold it as well, a checksum byte after the record, the
+// bytes of the record and it add up to zero, tells a real one from those.
+#define TRACE_SYNC_BYTE 0xA5
+
+#include "trace_events.h"
+
+#define TRACE_EVENT_ID(name, level, format) name,
+typedef enum trace_id {
+    TRACE_EVENTS(TRACE_EVENT_ID)
+    TRACE_EVENT_COUNT
+} trace_id_t;
+#undef TRACE_EVENT_ID
+
+#define TRACE_EVENT_LEVEL(name, level, format) name##_LEVEL = level,
+enum trace_levels {
+    TRACE_EVENTS(TRACE_EVENT_LEVEL)
+};
+#undef TRACE_EVENT_LEVEL
+
+typedef struct trace_record {
+    uint32_t timestamp;   // Clock ticks
+    uint16_t id;          // trace_id_t
+    uint16_t seq;         // Counts every record, gaps are records that were overwritten
+    uint32_t args[2];
+} trace_record_t;
+
+typedef struct trace_stats {
+    uint32_t recorded;
+    uint32_t drained;
+    uint32_t overwritten;   // Ring was full, the oldest record made room
+} trace_stats_t;
+
+/*
+ * Takes one record, returns false to be offered it again on the next idle pass.
+ * Called from the idle task.
+ */
+typedef bool (*trace_sink_t)(const trace_record_t *record);
+
+/*
+ * Trace an event with up to two integer arguments, TRACE(TRACE_LINK_UP, connHandle).
+ * The level test is constant, a disabled event leaves no code behind.
+ */
+#define TRACE(...) TRACE_ARGS(__VA_ARGS__, 0, 0, 0)
+#define TRACE_ARGS(id, a0, a1, ...) \
+    do { \
+        if (id##_LEVEL <= TRACE_LEVEL) { \
+            trace_record((id), (uint32_t) (a0), (uint32_t) (a1)); \
+        } \
+    } while (0)
+
+/*
+ * Opens the UART sink when built with TRACE_UART. Records can be taken before it.
+ */
+void trace_init();
+
+void trace_record(trace_id_t id, uint32_t arg0, uint32_t arg1);
+
+/*
+ * Records are handed to the sink from the idle task, without one they stay in the
+ * ring for the debugger.
+ */
+void trace_set_sink(trace_sink_t sink);
+
+/*
+ * Idle function, see release.cfg
+ */
+void trace_idle();
+
+void trace_get_stats(trace_stats_t *stats);
+void trace_reset_stats();
+
+#endif /* APPLICATION_TRACE_H_ */
@@ -0,0 +1,46 @@
+#ifndef APPLICATION_TRACE_EVENTS_H_
+#define APPLICATION_TRACE_EVENTS_H_
+
+/*
+ * Every trace event: its id, level and the format its two arguments are printed with.
+ * TOOLS/trace_decode.py reads this list, so keep one event per line and only add at the
+ * end, the ids are the positions in it.
+ */
+#define TRACE_EVENTS(X) \
+    X(TRACE_MAIN_STARTED,       TRACE_LEVEL_INFO,   "Main started") \
+    X(TRACE_BIOS_START,         TRACE_LEVEL_INFO,   "BIOS_start will be called") \
+    X(TRACE_RSA_INIT,           TRACE_LEVEL_INFO,   "RSA init: %d") \
+    X(TRACE_KEY_LOAD,           TRACE_LEVEL_INFO,   "Key load: format %u, result %d") \
+    X(TRACE_KEY_LOAD_TIME,      TRACE_LEVEL_INFO,   "Key load took %u us") \
+    X(TRACE_APP_REGISTER,       TRACE_LEVEL_DEBUG,  "About to register") \
+    X(TRACE_APP_REGISTERED,     TRACE_LEVEL_DEBUG,  "ICALL register done") \
+    X(TRACE_APP_GAP,            TRACE_LEVEL_DEBUG,  "About to set GAP") \
+    X(TRACE_APP_GAP_SET,        TRACE_LEVEL_DEBUG,  "GAP set") \
+    X(TRACE_APP_GATT,           TRACE_LEVEL_DEBUG,  "About to set GATT services") \
+    X(TRACE_APP_GATT_SET,       TRACE_LEVEL_DEBUG,  "GATT services set") \
+    X(TRACE_APP_CALLBACKS,      TRACE_LEVEL_DEBUG,  "Registered the callbacks") \
+    X(TRACE_APP_INIT_WAIT,      TRACE_LEVEL_DEBUG,  "SimplePeripheral_init waiting") \
+    X(TRACE_APP_INIT_DONE,      TRACE_LEVEL_INFO,   "SimplePeripheral_init done") \
+    X(TRACE_LINK_UP,            TRACE_LEVEL_INFO,   "Link %u up") \
+    X(TRACE_LINK_DOWN,          TRACE_LEVEL_INFO,   "Link %u down") \
+    X(TRACE_CHAR_CHANGE,        TRACE_LEVEL_DEBUG,  "Link %u wrote characteristic %u") \
+    X(TRACE_NOTI_DROPPED,       TRACE_LEVEL_WARN,   "Dropped notification for link %u") \
+    X(TRACE_CHALLENGE_NO_MEM,   TRACE_LEVEL_ERROR,  "No memory for the challenge of link %u") \
+    X(TRACE_NO_SESSION,         TRACE_LEVEL_WARN,   "No sign session left for link %u") \
+    X(TRACE_SIGN_NO_MEM,        TRACE_LEVEL_ERROR,  "No memory for the signature of link %u") \
+    X(TRACE_AES_INIT,           TRACE_LEVEL_DEBUG,  "AES init") \
+    X(TRACE_AES_FREE,           TRACE_LEVEL_DEBUG,  "AES free") \
+    X(TRACE_AES_SETKEY,         TRACE_LEVEL_DEBUG,  "AES set key: %d") \
+    X(TRACE_AES_SETKEY_FAILED,  TRACE_LEVEL_ERROR,  "AES key has no key RAM entry") \
+    X(TRACE_AES_BLOCK,          TRACE_LEVEL_DEBUG,  "AES block, decrypt %u") \
+    X(TRACE_AES_FAILED,         TRACE_LEVEL_ERROR,  "AES transaction failed: %d") \
+    X(TRACE_KEY_CACHE_FULL,     TRACE_LEVEL_ERROR,  "Key cache has no free key RAM entry") \
+    X(TRACE_CRYPTO_OPEN_FAILED, TRACE_LEVEL_ERROR,  "Failed to open the Crypto Module") \
+    X(TRACE_SEED_WRITE_FAILED,  TRACE_LEVEL_ERROR,  "Failed to store the entropy seed: %d") \
+    X(TRACE_MPI_RANDOM_NO_MEM,  TRACE_LEVEL_ERROR,  "No memory for a random fill") \
+    X(TRACE_BOOT_MARK,          TRACE_LEVEL_INFO,   "Boot step %u reached after %u us") \
+    X(TRACE_SIGN_POWER,         TRACE_LEVEL_DEBUG,  "Sign burst: %u us CPU, standby held off %u us") \
+    X(TRACE_SEALED_REJECTED,    TRACE_LEVEL_WARN,   "Sealed challenge of link %u did not open: %d") \
+    X(TRACE_BIOS_HEAP,          TRACE_LEVEL_INFO,   "BIOS heap: %u of %u bytes taken at start up")
+
+#endif /* APPLICATION_TRACE_EVENTS_H_ */
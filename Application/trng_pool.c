@@ -0,0 +1,248 @@
+#include "trng_pool.h"
+
+#include <string.h>
+#include <stdbool.h>
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include <ti/sysbios/knl/Semaphore.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/drivers/Power.h>
+#include <ti/drivers/power/PowerCC26XX.h>
+#include <driverlib/trng.h>
+#include <inc/hw_types.h>
+#include <inc/hw_memmap.h>
+#include <inc/hw_ints.h>
+#include <inc/hw_trng.h>
+
+/*
+ * Background TRNG harvester.
+ *
+ * mbedtls_hardware_poll() used to power the TRNG up, sleep until one number was ready,
+ * keep its low word and power the TRNG down again, so seeding the DRBG took dozens of
+ * power cycles. The TRNG interrupt now pushes both words of every number into a ring
+ * buffer and the poll only copies out what is there. The TRNG stays powered, and
+ * standby stays blocked, only until the pool is full again.
+ *
+ * The TRNGCC26XX driver of the BLE stack owns the same TRNG. When it reconfigures or
+ * disables it in the middle of a harvest, no number arrives anymore, so a harvest
+ * that made no progress for TRNG_POOL_STALL_MS is torn down and armed again.
+ */
+
+#if (TRNG_POOL_SIZE & (TRNG_POOL_SIZE - 1)) != 0
+#error TRNG_POOL_SIZE must be a power of two
+#endif
+
+// Free running indexes, their difference is the fill level
+static unsigned char poolBuffer[TRNG_POOL_SIZE];
+static volatile uint16_t poolHead = 0;
+static volatile uint16_t poolTail = 0;
+
+static volatile bool isHarvesting = false;
+static volatile uint32_t progressTicks;     // Start of the harvest or its last number
+static bool isPoolInitialized = false;
+static uint32_t lastNumber[2];
+static bool hasLastNumber = false;
+
+static Hwi_Struct trngHwiStruct;
+static Semaphore_Struct dataSemStruct;
+static Semaphore_Handle dataSem;
+
+static trng_pool_stats_t poolStats;
+
+// Called with interrupts disabled
+static void trng_pool_stop() {
+    TRNGIntDisable(TRNG_NUMBER_READY | TRNG_FRO_SHUTDOWN);
+    TRNGDisable();
+    Power_releaseConstraint(PowerCC26XX_SB_DISALLOW);
+    Power_releaseDependency(PowerCC26XX_PERIPH_TRNG);
+    isHarvesting = false;
+}
+
+static void trng_pool_isr(UArg arg) {
+    uint32_t status = TRNGStatusGet();
+    uint32_t number[2];
+    uint32_t alarms;
+
+    if (status & TRNG_FRO_SHUTDOWN) {
+        // Detune the FROs that locked up and turn them back on
+        alarms = HWREG(TRNG_BASE + TRNG_O_ALARMSTOP);
+        HWREG(TRNG_BASE + TRNG_O_FRODETUNE) ^= alarms;
+        HWREG(TRNG_BASE + TRNG_O_ALARMMASK) = 0;
+        HWREG(TRNG_BASE + TRNG_O_ALARMSTOP) = 0;
+        HWREG(TRNG_BASE + TRNG_O_FROEN) |= alarms;
+        TRNGIntClear(TRNG_FRO_SHUTDOWN);
+        poolStats.fro_alarms++;
+    }
+
+    if (!(status & TRNG_NUMBER_READY)) {
+        return;
+    }
+
+    // Read both words before the acknowledge starts the next number
+    number[0] = HWREG(TRNG_BASE + TRNG_O_OUT0);
+    number[1] = HWREG(TRNG_BASE + TRNG_O_OUT1);
+    TRNGIntClear(TRNG_NUMBER_READY);
+    poolStats.numbers++;
+    progressTicks = Clock_getTicks();
+
+    // Repetition count test, a stuck source gives the same number again
+    if (hasLastNumber && (number[0] == lastNumber[0]) && (number[1] == lastNumber[1])) {
+        poolStats.repeats++;
+        return;
+    }
+    lastNumber[0] = number[0];
+    lastNumber[1] = number[1];
+    hasLastNumber = true;
+
+    if ((uint16_t)(poolHead - poolTail) <= (TRNG_POOL_SIZE - sizeof(number))) {
+        uint16_t i;
+        const unsigned char *src = (const unsigned char *) number;
+        for (i = 0; i < sizeof(number); i++) {
+            poolBuffer[(poolHead + i) & (TRNG_POOL_SIZE - 1)] = src[i];
+        }
+        poolHead += sizeof(number);
+        Semaphore_post(dataSem);
+    }
+
+    if ((uint16_t)(poolHead - poolTail) > (TRNG_POOL_SIZE - sizeof(number))) {
+        trng_pool_stop();
+    }
+}
+
+void trng_pool_init() {
+    Hwi_Params hwiParams;
+    Semaphore_Params semParams;
+    UInt hwiKey = Hwi_disable();
+
+    if (isPoolInitialized) {
+        Hwi_restore(hwiKey);
+        return;
+    }
+
+    Semaphore_Params_init(&semParams);
+    semParams.mode = Semaphore_Mode_BINARY;
+    Semaphore_construct(&dataSemStruct, 0, &semParams);
+    dataSem = Semaphore_handle(&dataSemStruct);
+
+    Hwi_Params_init(&hwiParams);
+    Hwi_construct(&trngHwiStruct, INT_TRNG_IRQ, trng_pool_isr, &hwiParams, NULL);
+
+    poolStats.fill_min = TRNG_POOL_SIZE;
+    isPoolInitialized = true;
+    Hwi_restore(hwiKey);
+
+    trng_pool_start();
+}
+
+void trng_pool_start() {
+    uint32_t stallTicks = (TRNG_POOL_STALL_MS * 1000) / Clock_tickPeriod;
+    UInt hwiKey = Hwi_disable();
+
+    if (isHarvesting) {
+        if ((Clock_getTicks() - progressTicks) < stallTicks) {
+            Hwi_restore(hwiKey);
+            return;
+        }
+        // Someone else turned the TRNG or its interrupt off, start over
+        trng_pool_stop();
+        poolStats.stalls++;
+    }
+    if ((uint16_t)(poolHead - poolTail) > (TRNG_POOL_SIZE - 8)) {
+        Hwi_restore(hwiKey);
+        return;
+    }
+
+    // The TRNG does not run in standby, keep the device out of it while harvesting
+    Power_setDependency(PowerCC26XX_PERIPH_TRNG);
+    Power_setConstraint(PowerCC26XX_SB_DISALLOW);
+    TRNGIntClear(TRNG_NUMBER_READY | TRNG_FRO_SHUTDOWN);
+    TRNGIntEnable(TRNG_NUMBER_READY | TRNG_FRO_SHUTDOWN);
+    TRNGEnable();
+    Hwi_enableInterrupt(INT_TRNG_IRQ);
+    progressTicks = Clock_getTicks();
+    isHarvesting = true;
+    poolStats.harvests++;
+    Hwi_restore(hwiKey);
+}
+
+static size_t trng_pool_copy(unsigned char *output, size_t len) {
+    size_t count = 0;
+    uint16_t fill;
+    UInt hwiKey = Hwi_disable();
+
+    fill = poolHead - poolTail;
+    while ((count < len) && (count < fill)) {
+        output[count] = poolBuffer[(poolTail + count) & (TRNG_POOL_SIZE - 1)];
+        // Entropy is handed out once
+        poolBuffer[(poolTail + count) & (TRNG_POOL_SIZE - 1)] = 0;
+        count++;
+    }
+    poolTail += count;
+    Hwi_restore(hwiKey);
+
+    return count;
+}
+
+size_t trng_pool_read(unsigned char *output, size_t len, uint32_t timeout) {
+    size_t count;
+    uint16_t fill;
+    uint8_t attempt;
+    UInt hwiKey;
+
+    if ((!output) || (len == 0)) {
+        return 0;
+    }
+    if (!isPoolInitialized) {
+        trng_pool_init();
+    }
+
+    count = trng_pool_copy(output, len);
+    // The second attempt comes after a stalled harvest was armed again
+    for (attempt = 0; (count == 0) && (attempt < 2); attempt++) {
+        trng_pool_start();
+        while ((count == 0) && Semaphore_pend(dataSem, timeout)) {
+            count = trng_pool_copy(output, len);
+        }
+    }
+
+    hwiKey = Hwi_disable();
+    fill = poolHead - poolTail;
+    if (attempt > 0) {
+        poolStats.underruns++;
+    }
+    if (count == 0) {
+        poolStats.timeouts++;
+    }
+    poolStats.reads++;
+    poolStats.bytes_out += count;
+    if (fill < poolStats.fill_min) {
+        poolStats.fill_min = fill;
+    }
+    Hwi_restore(hwiKey);
+
+    if (fill < TRNG_POOL_LOW_WATER) {
+        trng_pool_start();
+    }
+    return count;
+}
+
+void trng_pool_get_stats(trng_pool_stats_t *stats) {
+    UInt hwiKey;
+
+    if (!stats) {
+        return;
+    }
+
+    hwiKey = Hwi_disable();
+    memcpy(stats, &poolStats, sizeof(trng_pool_stats_t));
+    stats->fill = poolHead - poolTail;
+    stats->running = isHarvesting;
+    Hwi_restore(hwiKey);
+}
+
+void trng_pool_reset_stats() {
+    UInt hwiKey = Hwi_disable();
+    memset(&poolStats, 0, sizeof(trng_pool_stats_t));
+    poolStats.fill_min = TRNG_POOL_SIZE;
+    Hwi_restore(hwiKey);
+}
@@ -0,0 +1,64 @@
+#ifndef APPLICATION_TRNG_POOL_H_
+#define APPLICATION_TRNG_POOL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Size of the entropy ring buffer in bytes, must be a power of two
+#ifndef TRNG_POOL_SIZE
+#define TRNG_POOL_SIZE 128
+#endif
+
+// The harvester is restarted when a read leaves fewer bytes than this in the pool
+#ifndef TRNG_POOL_LOW_WATER
+#define TRNG_POOL_LOW_WATER 64
+#endif
+
+// How long mbedtls_hardware_poll() waits when the pool is completely empty
+#ifndef TRNG_POOL_READ_TIMEOUT_MS
+#define TRNG_POOL_READ_TIMEOUT_MS 100
+#endif
+
+// A harvest that got no number for this long is armed again, see trng_pool_start()
+#ifndef TRNG_POOL_STALL_MS
+#define TRNG_POOL_STALL_MS 20
+#endif
+
+typedef struct trng_pool_stats {
+    uint32_t numbers;     // 64 bit numbers read from the TRNG
+    uint32_t bytes_out;   // Bytes handed out by trng_pool_read()
+    uint32_t reads;       // trng_pool_read() calls
+    uint32_t underruns;   // Reads that found the pool empty and had to wait
+    uint32_t timeouts;    // Reads that gave up waiting
+    uint32_t repeats;     // Numbers dropped for repeating the previous one
+    uint32_t fro_alarms;  // FRO shutdown events, the FROs were detuned and restarted
+    uint32_t harvests;    // Times the TRNG was powered up to refill the pool
+    uint32_t stalls;      // Harvests that stopped getting numbers and were armed again
+    uint16_t fill;        // Bytes currently in the pool
+    uint16_t fill_min;    // Lowest fill level left behind by a read
+    uint8_t  running;     // The TRNG is powered and filling the pool
+} trng_pool_stats_t;
+
+/*
+ * Sets up the TRNG interrupt and starts filling the pool.
+ * Can be called before BIOS_start(), the pool fills once interrupts are enabled.
+ */
+void trng_pool_init();
+
+/*
+ * Powers the TRNG up if the pool is not full. It powers down again once the pool is full.
+ * A harvest that has stalled for TRNG_POOL_STALL_MS is armed again.
+ */
+void trng_pool_start();
+
+/*
+ * Copies up to len bytes of entropy out of the pool without waiting for the TRNG.
+ * Only pends, up to timeout Clock ticks, if the pool is empty.
+ * Returns the number of bytes copied.
+ */
+size_t trng_pool_read(unsigned char *output, size_t len, uint32_t timeout);
+
+void trng_pool_get_stats(trng_pool_stats_t *stats);
+void trng_pool_reset_stats();
+
+#endif /* APPLICATION_TRNG_POOL_H_ */
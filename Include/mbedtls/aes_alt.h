@@ -68,6 +68,26 @@ int mbedtls_aes_crypt_ecb( mbedtls_aes_context *ctx,
                     const unsigned char input[16],
                     unsigned char output[16] );
 
+/**
+ * \brief          AES-ECB encryption/decryption of several blocks
+ *
+ *                 All blocks run as one crypto engine job, which saves the
+ *                 per-call locking of mbedtls_aes_crypt_ecb().
+ *
+ * \param ctx      AES context
+ * \param mode     MBEDTLS_AES_ENCRYPT or MBEDTLS_AES_DECRYPT
+ * \param blocks   number of 16-byte blocks
+ * \param input    buffer holding the input blocks
+ * \param output   buffer holding the output blocks, may be equal to input
+ *
+ * \return         0 if successful
+ */
+int mbedtls_aes_crypt_ecb_blocks( mbedtls_aes_context *ctx,
+                    int mode,
+                    size_t blocks,
+                    const unsigned char *input,
+                    unsigned char *output );
+
 #if defined(MBEDTLS_CIPHER_MODE_CBC)
 /**
  * \brief          AES-CBC buffer encryption/decryption
@@ -144,6 +144,16 @@ typedef struct mbedtls_asn1_sequence
 }
 mbedtls_asn1_sequence;
 
+/**
+ * Cursor over the elements of a constructed ASN.1 value
+ */
+typedef struct mbedtls_asn1_cursor
+{
+    unsigned char *p;           /**< Start of the next element. */
+    const unsigned char *end;   /**< End of the constructed value. */
+}
+mbedtls_asn1_cursor;
+
 /**
  * Container for a sequence or list of 'named' ASN.1 data items
  */
@@ -243,6 +253,56 @@ int mbedtls_asn1_get_bitstring( unsigned char **p, const unsigned char *end,
 int mbedtls_asn1_get_bitstring_null( unsigned char **p, const unsigned char *end,
                              size_t *len );
 
+/**
+ * \brief       Start walking the elements of a constructed value, like a
+ *              SEQUENCE, without copying or allocating anything.
+ *              Updates the pointer to immediately behind the full value.
+ *
+ * \param cur   The cursor to set up
+ * \param p     The position in the ASN.1 data
+ * \param end   End of data
+ * \param tag   The expected tag of the constructed value
+ *
+ * \return      0 if successful or a specific ASN.1 error code.
+ */
+int mbedtls_asn1_cursor_init( mbedtls_asn1_cursor *cur,
+                              unsigned char **p,
+                              const unsigned char *end,
+                              int tag );
+
+/**
+ * \brief       Start walking the content of an element returned by
+ *              mbedtls_asn1_cursor_next(), for nested values.
+ *
+ * \param cur   The cursor to set up
+ * \param elem  The constructed element to walk
+ */
+void mbedtls_asn1_cursor_enter( mbedtls_asn1_cursor *cur,
+                                const mbedtls_asn1_buf *elem );
+
+/**
+ * \brief       Check whether all elements have been read
+ *
+ * \param cur   The cursor
+ *
+ * \return      1 at the end of the constructed value, 0 otherwise.
+ */
+int mbedtls_asn1_cursor_done( const mbedtls_asn1_cursor *cur );
+
+/**
+ * \brief       Read the next element. elem points into the input data and
+ *              stays valid as long as it does.
+ *
+ * \param cur   The cursor
+ * \param elem  The variable that will receive the tag, length and content
+ *              of the element
+ *
+ * \return      0 if successful or a specific ASN.1 error code. The cursor
+ *              does not move on error.
+ */
+int mbedtls_asn1_cursor_next( mbedtls_asn1_cursor *cur,
+                              mbedtls_asn1_buf *elem );
+
 /**
  * \brief       Parses and splits an ASN.1 "SEQUENCE OF <tag>"
  *              Updated the pointer to immediately behind the full sequence tag.
@@ -252,6 +312,10 @@ int mbedtls_asn1_get_bitstring_null( unsigned char **p, const unsigned char *end
  * \param cur   First variable in the chain to fill
  * \param tag   Type of sequence
  *
+ * \note        Allocates one entry per element after the first. Use
+ *              mbedtls_asn1_cursor_init() and mbedtls_asn1_cursor_next() to
+ *              walk the elements without allocating.
+ *
  * \return      0 if successful or a specific ASN.1 error code.
  */
 int mbedtls_asn1_get_sequence_of( unsigned char **p,
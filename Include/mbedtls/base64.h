@@ -24,6 +24,7 @@
 #define MBEDTLS_BASE64_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 #define MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL               -0x002A  /**< Output buffer too small. */
 #define MBEDTLS_ERR_BASE64_INVALID_CHARACTER              -0x002C  /**< Invalid character in input. */
@@ -32,6 +33,21 @@
 extern "C" {
 #endif
 
+/**
+ * \brief          Streaming base64 decoder context
+ *
+ *                 Carries the sextets of an incomplete quantum and the
+ *                 line state from one chunk of input to the next.
+ */
+typedef struct
+{
+    uint32_t carry;         /*!< sextets of the incomplete quantum      */
+    unsigned char count;    /*!< number of sextets in carry             */
+    unsigned char pad;      /*!< number of '=' seen                     */
+    unsigned char state;    /*!< pending space or CR of the line        */
+}
+mbedtls_base64_dec_context;
+
 /**
  * \brief          Encode a buffer into base64 format
  *
@@ -70,10 +86,59 @@ int mbedtls_base64_encode( unsigned char *dst, size_t dlen, size_t *olen,
  *
  * \note           Call this function with *dst = NULL or dlen = 0 to obtain
  *                 the required buffer size in *olen
+ *
+ * \note           The input is read once. dst can be the same as src to
+ *                 decode in place. When dst is too small it holds the part
+ *                 of the output that did fit.
  */
 int mbedtls_base64_decode( unsigned char *dst, size_t dlen, size_t *olen,
                    const unsigned char *src, size_t slen );
 
+/**
+ * \brief          Initialize a streaming base64 decoder
+ *
+ * \param ctx      context to be initialized
+ */
+void mbedtls_base64_dec_init( mbedtls_base64_dec_context *ctx );
+
+/**
+ * \brief          Decode the next chunk of a base64-formatted buffer
+ *
+ *                 Chunks can be split anywhere, including inside a
+ *                 quantum or a CRLF. Only complete quanta are written, the
+ *                 rest is carried in ctx until the next call.
+ *
+ * \param ctx      decoder context
+ * \param dst      destination buffer (can be NULL for checking size)
+ * \param dlen     size of the destination buffer
+ * \param olen     number of bytes written by this call
+ * \param src      next chunk of the source
+ * \param slen     length of the chunk
+ *
+ * \return         0 if successful, MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL, or
+ *                 MBEDTLS_ERR_BASE64_INVALID_CHARACTER if the input data is
+ *                 not correct. On MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL the
+ *                 whole chunk has been checked and *olen is the size this
+ *                 chunk needed, but the output can not be resumed.
+ *
+ * \note           dst can overlap src as long as it does not start after
+ *                 it, so a chunk can be decoded in place.
+ */
+int mbedtls_base64_dec_update( mbedtls_base64_dec_context *ctx,
+                               unsigned char *dst, size_t dlen, size_t *olen,
+                               const unsigned char *src, size_t slen );
+
+/**
+ * \brief          Check that the input ended on a complete quantum and
+ *                 clear the context
+ *
+ * \param ctx      decoder context
+ *
+ * \return         0 if successful, or MBEDTLS_ERR_BASE64_INVALID_CHARACTER
+ *                 if the input was truncated.
+ */
+int mbedtls_base64_dec_finish( mbedtls_base64_dec_context *ctx );
+
 /**
  * \brief          Checkup routine
  *
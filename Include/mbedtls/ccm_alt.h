@@ -0,0 +1,148 @@
+#ifndef MBEDTLS_CCM_ALT_H
+#define MBEDTLS_CCM_ALT_H
+
+#if defined(MBEDTLS_CCM_ALT)
+#include <stdint.h>
+#include "aes.h"
+// Alternate implementation on top of the CC1350 crypto engine
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief          CCM context structure
+ *
+ *                 CCM runs on the AES key loaded in the crypto engine key RAM.
+ *                 Operations the engine can not do in one pass fall back to
+ *                 the software construction over mbedtls_aes_crypt_ecb().
+ */
+typedef struct {
+    mbedtls_aes_context aes_ctx;    /*!< AES context holding the key RAM entry */
+    int use_hardware;               /*!< 0 forces the software construction */
+}
+mbedtls_ccm_context;
+
+/**
+ * \brief          Counters of both CCM paths, used to compare their throughput
+ */
+typedef struct {
+    uint32_t hw_ops;                /*!< Operations done in one engine pass */
+    uint32_t hw_bytes;              /*!< Payload bytes processed by the engine */
+    uint32_t hw_ticks;              /*!< Clock ticks spent in the engine path */
+    uint32_t sw_ops;                /*!< Operations done with the ECB construction */
+    uint32_t sw_bytes;              /*!< Payload bytes processed in software */
+    uint32_t sw_ticks;              /*!< Clock ticks spent in the software path */
+    uint32_t fallbacks;             /*!< Engine operations retried in software */
+}
+mbedtls_ccm_stats;
+
+/**
+ * \brief           Initialize CCM context (just makes references valid)
+ *                  Makes the context ready for mbedtls_ccm_setkey() or
+ *                  mbedtls_ccm_free().
+ *
+ * \param ctx       CCM context to initialize
+ */
+void mbedtls_ccm_init( mbedtls_ccm_context *ctx );
+
+/**
+ * \brief           CCM initialization (encryption and decryption)
+ *
+ * \param ctx       CCM context to be initialized
+ * \param cipher    cipher to use, must be MBEDTLS_CIPHER_ID_AES
+ * \param key       encryption key
+ * \param keybits   key size in bits, must be 128
+ *
+ * \return          0 if successful, MBEDTLS_ERR_CCM_BAD_INPUT or an AES
+ *                  specific error code
+ */
+int mbedtls_ccm_setkey( mbedtls_ccm_context *ctx,
+                        mbedtls_cipher_id_t cipher,
+                        const unsigned char *key,
+                        unsigned int keybits );
+
+/**
+ * \brief           Free a CCM context and underlying AES sub-context
+ *
+ * \param ctx       CCM context to free
+ */
+void mbedtls_ccm_free( mbedtls_ccm_context *ctx );
+
+/**
+ * \brief           CCM buffer encryption
+ *
+ * \param ctx       CCM context
+ * \param length    length of the input data in bytes
+ * \param iv        nonce (initialization vector)
+ * \param iv_len    length of IV in bytes
+ *                  must be 7, 8, 9, 10, 11, 12, or 13
+ * \param add       additional data
+ * \param add_len   length of additional data in bytes
+ *                  must be less than 2^16 - 2^8
+ * \param input     buffer holding the input data
+ * \param output    buffer for holding the output data
+ *                  must be at least 'length' bytes wide
+ * \param tag       buffer for holding the tag
+ * \param tag_len   length of the tag to generate in bytes
+ *                  must be 4, 6, 8, 10, 14 or 16
+ *
+ * \return          0 if successful
+ */
+int mbedtls_ccm_encrypt_and_tag( mbedtls_ccm_context *ctx, size_t length,
+                         const unsigned char *iv, size_t iv_len,
+                         const unsigned char *add, size_t add_len,
+                         const unsigned char *input, unsigned char *output,
+                         unsigned char *tag, size_t tag_len );
+
+/**
+ * \brief           CCM buffer authenticated decryption
+ *
+ * \param ctx       CCM context
+ * \param length    length of the input data
+ * \param iv        initialization vector
+ * \param iv_len    length of IV
+ * \param add       additional data
+ * \param add_len   length of additional data
+ * \param input     buffer holding the input data
+ * \param output    buffer for holding the output data
+ * \param tag       buffer holding the tag
+ * \param tag_len   length of the tag
+ *
+ * \return         0 if successful and authenticated,
+ *                 MBEDTLS_ERR_CCM_AUTH_FAILED if tag does not match
+ */
+int mbedtls_ccm_auth_decrypt( mbedtls_ccm_context *ctx, size_t length,
+                      const unsigned char *iv, size_t iv_len,
+                      const unsigned char *add, size_t add_len,
+                      const unsigned char *input, unsigned char *output,
+                      const unsigned char *tag, size_t tag_len );
+
+/**
+ * \brief           Select the CCM path of a context
+ *
+ * \param ctx       CCM context
+ * \param enable    0 to always use the software construction,
+ *                  1 to use the crypto engine when it supports the request
+ */
+void mbedtls_ccm_set_hardware( mbedtls_ccm_context *ctx, int enable );
+
+/**
+ * \brief           Read the counters of the hardware and software paths
+ *
+ * \param stats     Destination of the counters
+ */
+void mbedtls_ccm_get_stats( mbedtls_ccm_stats *stats );
+
+/**
+ * \brief           Clear the counters of the hardware and software paths
+ */
+void mbedtls_ccm_reset_stats( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MBEDTLS_CCM_ALT */
+
+#endif /* ccm_alt.h */
@@ -144,7 +144,7 @@
  *
  * Enable this layer to allow use of alternative memory allocators.
  */
-//#define MBEDTLS_PLATFORM_MEMORY
+#define MBEDTLS_PLATFORM_MEMORY
 
 /**
  * \def MBEDTLS_PLATFORM_NO_STD_FUNCTIONS
@@ -266,6 +266,7 @@
  * module.
  */
 #define MBEDTLS_AES_ALT
+#define MBEDTLS_CCM_ALT
 //#define MBEDTLS_ARC4_ALT
 //#define MBEDTLS_BLOWFISH_ALT
 //#define MBEDTLS_CAMELLIA_ALT
@@ -954,7 +955,7 @@
  * \note The entropy collector will write to the seed file before entropy is
  *       given to an external source, to update it.
  */
-//#define MBEDTLS_ENTROPY_NV_SEED
+#define MBEDTLS_ENTROPY_NV_SEED
 
 /**
  * \def MBEDTLS_MEMORY_DEBUG
@@ -1029,6 +1030,11 @@
  */
 //#define MBEDTLS_SELF_TEST
 
+/* The self test build runs them, see Application/self_test.h */
+#if defined(SIGNER_SELF_TEST)
+#define MBEDTLS_SELF_TEST
+#endif
+
 /**
  * \def MBEDTLS_SHA256_SMALLER
  *
@@ -2614,7 +2620,12 @@
 //#define MBEDTLS_ECP_FIXED_POINT_OPTIM      1 /**< Enable fixed-point speed-up */
 
 /* Entropy options */
-#define MBEDTLS_ENTROPY_MAX_SOURCES                1 /**< Maximum number of sources supported */
+#if defined(SIGNER_SELF_TEST)
+/* mbedtls_entropy_self_test() adds a dummy source to the TRNG and the NV seed */
+#define MBEDTLS_ENTROPY_MAX_SOURCES                3 /**< Maximum number of sources supported */
+#else
+#define MBEDTLS_ENTROPY_MAX_SOURCES                2 /**< Maximum number of sources supported */
+#endif
 //#define MBEDTLS_ENTROPY_MAX_GATHER                128 /**< Maximum amount requested from entropy sources */
 //#define MBEDTLS_ENTROPY_MIN_HARDWARE               32 /**< Default minimum number of bytes required for the hardware entropy source mbedtls_hardware_poll() before entropy is released */
 
@@ -2639,8 +2650,8 @@
 
 /* To Use Function Macros MBEDTLS_PLATFORM_C must be enabled */
 /* MBEDTLS_PLATFORM_XXX_MACRO and MBEDTLS_PLATFORM_XXX_ALT cannot both be defined */
-//#define MBEDTLS_PLATFORM_CALLOC_MACRO        calloc /**< Default allocator macro to use, can be undefined */
-//#define MBEDTLS_PLATFORM_FREE_MACRO            free /**< Default free macro to use, can be undefined */
+#define MBEDTLS_PLATFORM_CALLOC_MACRO        crypto_arena_calloc /**< Allocations come from the crypto arena, see crypto_arena.h */
+#define MBEDTLS_PLATFORM_FREE_MACRO            crypto_arena_free /**< Returns them to the crypto arena */
 //#define MBEDTLS_PLATFORM_EXIT_MACRO            exit /**< Default exit macro to use, can be undefined */
 //#define MBEDTLS_PLATFORM_TIME_MACRO            time /**< Default time macro to use, can be undefined. MBEDTLS_HAVE_TIME must be enabled */
 //#define MBEDTLS_PLATFORM_TIME_TYPE_MACRO       time_t /**< Default time macro to use, can be undefined. MBEDTLS_HAVE_TIME must be enabled */
@@ -2648,8 +2659,8 @@
 //#define MBEDTLS_PLATFORM_PRINTF_MACRO        printf /**< Default printf macro to use, can be undefined */
 /* Note: your snprintf must correclty zero-terminate the buffer! */
 //#define MBEDTLS_PLATFORM_SNPRINTF_MACRO    snprintf /**< Default snprintf macro to use, can be undefined */
-//#define MBEDTLS_PLATFORM_NV_SEED_READ_MACRO   mbedtls_platform_std_nv_seed_read /**< Default nv_seed_read function to use, can be undefined */
-//#define MBEDTLS_PLATFORM_NV_SEED_WRITE_MACRO  mbedtls_platform_std_nv_seed_write /**< Default nv_seed_write function to use, can be undefined */
+#define MBEDTLS_PLATFORM_NV_SEED_READ_MACRO   nv_seed_read /**< Seed record in the stack's SNV, see nv_seed.h */
+#define MBEDTLS_PLATFORM_NV_SEED_WRITE_MACRO  nv_seed_write /**< Seed record in the stack's SNV, see nv_seed.h */
 
 /* SSL Cache options */
 //#define MBEDTLS_SSL_CACHE_DEFAULT_TIMEOUT       86400 /**< 1 day  */
@@ -2721,6 +2732,11 @@
 #include MBEDTLS_USER_CONFIG_FILE
 #endif
 
+/* Prototypes of the allocator the platform macros above name */
+#if defined(MBEDTLS_PLATFORM_MEMORY)
+#include "crypto_arena.h"
+#endif
+
 #include "check_config.h"
 
 #endif /* MBEDTLS_CONFIG_H */
@@ -25,6 +25,8 @@
 
 #include "aes.h"
 
+#include <stdint.h>
+
 #if defined(MBEDTLS_THREADING_C)
 #include "mbedtls/threading.h"
 #endif
@@ -109,6 +111,21 @@ typedef struct
 }
 mbedtls_ctr_drbg_context;
 
+/**
+ * \brief          Generation counters shared by all CTR_DRBG contexts
+ */
+typedef struct
+{
+    uint32_t requests;          /*!<  successful random requests        */
+    uint32_t bytes;             /*!<  random bytes returned             */
+    uint32_t ticks;             /*!<  Clock ticks spent in the requests,
+                                      reseeds included                  */
+    uint32_t reseeds;           /*!<  successful (re)seeds              */
+    uint32_t failures;          /*!<  failed random requests            */
+    uint32_t bytes_per_sec;     /*!<  computed by mbedtls_ctr_drbg_get_stats() */
+}
+mbedtls_ctr_drbg_stats;
+
 /**
  * \brief               CTR_DRBG context initialization
  *                      Makes the context ready for mbedtls_ctr_drbg_seed() or
@@ -243,6 +260,19 @@ int mbedtls_ctr_drbg_random_with_add( void *p_rng,
 int mbedtls_ctr_drbg_random( void *p_rng,
                      unsigned char *output, size_t output_len );
 
+/**
+ * \brief               Read the generation counters and the resulting
+ *                      throughput in random bytes per second
+ *
+ * \param stats         Destination of the counters
+ */
+void mbedtls_ctr_drbg_get_stats( mbedtls_ctr_drbg_stats *stats );
+
+/**
+ * \brief               Clear the generation counters
+ */
+void mbedtls_ctr_drbg_reset_stats( void );
+
 #if defined(MBEDTLS_FS_IO)
 /**
  * \brief               Write a seed file
@@ -55,6 +55,8 @@ typedef struct
     unsigned char *buf;     /*!< buffer for decoded data             */
     size_t buflen;          /*!< length of the buffer                */
     unsigned char *info;    /*!< buffer for extra header information */
+    unsigned char *dst;     /*!< caller supplied output buffer       */
+    size_t dstlen;          /*!< size of the output buffer           */
 }
 mbedtls_pem_context;
 
@@ -65,6 +67,19 @@ mbedtls_pem_context;
  */
 void mbedtls_pem_init( mbedtls_pem_context *ctx );
 
+/**
+ * \brief       Decode into a caller supplied buffer instead of allocating
+ *              one. The buffer has to stay valid until mbedtls_pem_free().
+ *
+ * \param ctx   context to use
+ * \param buf   output buffer. It can be the (writable) PEM data itself,
+ *              the decoded data never overtakes the base64 text it is read
+ *              from.
+ * \param size  size of the output buffer, at least 3/4 of the base64 text
+ */
+void mbedtls_pem_set_buffer( mbedtls_pem_context *ctx,
+                             unsigned char *buf, size_t size );
+
 /**
  * \brief       Read a buffer for PEM information and store the resulting
  *              data into the specified context buffers.
@@ -85,6 +100,10 @@ void mbedtls_pem_init( mbedtls_pem_context *ctx );
  *                  the decrypted text starts with an ASN.1 sequence of
  *                  appropriate length
  *
+ * \note            The base64 text is decoded in one pass. Nothing is
+ *                  allocated if a buffer was set with
+ *                  mbedtls_pem_set_buffer()
+ *
  * \return          0 on success, or a specific PEM error code
  */
 int mbedtls_pem_read_buffer( mbedtls_pem_context *ctx, const char *header, const char *footer,
@@ -93,7 +112,8 @@ int mbedtls_pem_read_buffer( mbedtls_pem_context *ctx, const char *header, const
                      size_t pwdlen, size_t *use_len );
 
 /**
- * \brief       PEM context memory freeing
+ * \brief       PEM context memory freeing. Wipes the decoded data,
+ *              also when it is in a caller supplied buffer.
  *
  * \param ctx   context to be freed
  */
@@ -428,6 +428,63 @@ const char * mbedtls_pk_get_name( const mbedtls_pk_context *ctx );
 mbedtls_pk_type_t mbedtls_pk_get_type( const mbedtls_pk_context *ctx );
 
 #if defined(MBEDTLS_PK_PARSE_C)
+/**
+ * \brief           Private key encodings told apart by mbedtls_pk_key_format()
+ */
+typedef enum {
+    MBEDTLS_PK_FORMAT_UNKNOWN=0,
+    MBEDTLS_PK_FORMAT_PEM_PKCS1,        /**< BEGIN RSA PRIVATE KEY */
+    MBEDTLS_PK_FORMAT_PEM_SEC1,         /**< BEGIN EC PRIVATE KEY */
+    MBEDTLS_PK_FORMAT_PEM_PKCS8,        /**< BEGIN PRIVATE KEY */
+    MBEDTLS_PK_FORMAT_PEM_PKCS8_ENC,    /**< BEGIN ENCRYPTED PRIVATE KEY */
+    MBEDTLS_PK_FORMAT_DER_PKCS1,        /**< RSAPrivateKey */
+    MBEDTLS_PK_FORMAT_DER_SEC1,         /**< ECPrivateKey */
+    MBEDTLS_PK_FORMAT_DER_PKCS8,        /**< PrivateKeyInfo */
+    MBEDTLS_PK_FORMAT_DER_PKCS8_ENC,    /**< EncryptedPrivateKeyInfo */
+} mbedtls_pk_format_t;
+
+/** \ingroup pk_module */
+/**
+ * \brief           Classify a private key by its PEM armour or, for DER,
+ *                  by the tags and version of its first elements
+ *
+ * \param key       input buffer
+ * \param keylen    size of the buffer
+ *                  (including the terminating null byte for PEM data)
+ *
+ * \note            Only the structure is looked at, the key can still
+ *                  fail to parse.
+ *
+ * \return          the format, or MBEDTLS_PK_FORMAT_UNKNOWN
+ */
+mbedtls_pk_format_t mbedtls_pk_key_format( const unsigned char *key, size_t keylen );
+
+/** \ingroup pk_module */
+/**
+ * \brief           Parse a private key of a known format with the one
+ *                  parser for that format
+ *
+ * \param ctx       key to be initialized
+ * \param format    format from mbedtls_pk_key_format()
+ * \param key       input buffer
+ * \param keylen    size of the buffer
+ *                  (including the terminating null byte for PEM data)
+ * \param pwd       password for decryption (optional)
+ * \param pwdlen    size of the password
+ * \param buf       buffer for the decoded PEM data, NULL to allocate one.
+ *                  It can be key itself, see mbedtls_pem_set_buffer()
+ * \param size      size of buf
+ *
+ * \note            On entry, ctx must be empty, like for
+ *                  mbedtls_pk_parse_key().
+ *
+ * \return          0 if successful, or a specific PK or PEM error code
+ */
+int mbedtls_pk_parse_key_as( mbedtls_pk_context *ctx, mbedtls_pk_format_t format,
+                  const unsigned char *key, size_t keylen,
+                  const unsigned char *pwd, size_t pwdlen,
+                  unsigned char *buf, size_t size );
+
 /** \ingroup pk_module */
 /**
  * \brief           Parse a private key in PEM or DER format
@@ -451,6 +508,29 @@ int mbedtls_pk_parse_key( mbedtls_pk_context *ctx,
                   const unsigned char *key, size_t keylen,
                   const unsigned char *pwd, size_t pwdlen );
 
+/** \ingroup pk_module */
+/**
+ * \brief           Parse a private key in PEM or DER format without
+ *                  allocating a buffer for the decoded PEM data
+ *
+ * \param ctx       key to be initialized
+ * \param key       input buffer, PEM data is decoded over it
+ * \param keylen    size of the buffer
+ *                  (including the terminating null byte for PEM data)
+ * \param pwd       password for decryption (optional)
+ * \param pwdlen    size of the password
+ *
+ * \note            Same as mbedtls_pk_parse_key(), but for keys that are
+ *                  received into RAM, like keys provisioned over BLE. The
+ *                  content of PEM data is destroyed, the decoded key is
+ *                  wiped from the buffer before returning.
+ *
+ * \return          0 if successful, or a specific PK or PEM error code
+ */
+int mbedtls_pk_parse_key_inplace( mbedtls_pk_context *ctx,
+                  unsigned char *key, size_t keylen,
+                  const unsigned char *pwd, size_t pwdlen );
+
 /** \ingroup pk_module */
 /**
  * \brief           Parse a public key in PEM or DER format
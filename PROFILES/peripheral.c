@@ -77,6 +77,7 @@
 
 #include "osal_snv.h"
 #include "icall_apimsg.h"
+#include "telemetry.h"
 
 /*********************************************************************
  * MACROS
@@ -216,6 +217,21 @@ static uint8_t  gapRole_AdvFilterPolicy;
 
 static uint16_t gapRole_ConnectionHandle = INVALID_CONNHANDLE;
 
+// Links that are up. gapRole_ConnectionHandle and the gapRole_Conn* values
+// below mirror the most recent one.
+typedef struct
+{
+  uint16_t connHandle;
+  uint16_t connInterval;
+  uint16_t connSlaveLatency;
+  uint16_t connTimeout;
+  uint8_t  devAddrType;
+  uint8_t  devAddr[B_ADDR_LEN];
+} gapRole_link_t;
+
+static gapRole_link_t gapRole_links[GAPROLE_MAX_CONNS];
+static uint8_t gapRole_numConns = 0;
+
 static uint8_t  gapRole_ConnectedDevAddr[B_ADDR_LEN] = {0};
 
 // Connection parameter update parameters.
@@ -237,10 +253,13 @@ static uint8_t  gapRole_ConnectedDevAddrType = 0;
 static uint8_t  gapRole_ConnTermReason = 0;
 
 static uint8_t paramUpdateNoSuccessOption = GAPROLE_NO_ACTION;
+static uint8_t paramUpdateRejected = FALSE;
 
 // Application callbacks
 static gapRolesCBs_t *pGapRoles_AppCGs = NULL;
 static gapRolesParamUpdateCB_t *pGapRoles_ParamUpdateCB = NULL;
+static gapRolesParamUpdateFailCB_t *pGapRoles_ParamUpdateFailCB = NULL;
+static gapRolesLinkCB_t *pGapRoles_LinkCB = NULL;
 
 /*********************************************************************
  * Profile Attributes - variables
@@ -265,6 +284,10 @@ static bStatus_t gapRole_startConnUpdate(uint8_t handleFailure,
 
 static void gapRole_setEvent(uint32_t event);
 
+static gapRole_link_t *gapRole_findLink(uint16_t connHandle);
+static void gapRole_selectLink(gapRole_link_t *pLink);
+static void gapRole_notifyLink(uint16_t connHandle, uint8_t up);
+
 /*********************************************************************
  * CALLBACKS
  */
@@ -739,6 +762,10 @@ bStatus_t GAPRole_GetParameter(uint16_t param, void *pValue)
       *((uint8_t*)pValue) = gapRole_ConnTermReason;
       break;
 
+    case GAPROLE_NUM_CONNS:
+      *((uint8_t*)pValue) = gapRole_numConns;
+      break;
+
     default:
       // The param value isn't part of this profile, try the GAP.
       if (param < TGAP_PARAMID_MAX)
@@ -794,6 +821,32 @@ void GAPRole_RegisterAppCBs(gapRolesParamUpdateCB_t *pParamUpdateCB)
   }
 }
 
+/*********************************************************************
+ * @brief   Register application's failed param update callback.
+ *
+ * Public function defined in peripheral.h.
+ */
+void GAPRole_RegisterParamUpdateFailCB(gapRolesParamUpdateFailCB_t *pParamUpdateFailCB)
+{
+  if (pParamUpdateFailCB != NULL)
+  {
+    pGapRoles_ParamUpdateFailCB = pParamUpdateFailCB;
+  }
+}
+
+/*********************************************************************
+ * @brief   Register application's link callback.
+ *
+ * Public function defined in peripheral.h.
+ */
+void GAPRole_RegisterLinkCB(gapRolesLinkCB_t *pLinkCB)
+{
+  if (pLinkCB != NULL)
+  {
+    pGapRoles_LinkCB = pLinkCB;
+  }
+}
+
 /*********************************************************************
  * @brief   Terminates the existing connection.
  *
@@ -833,6 +886,7 @@ void GAPRole_createTask(void)
   taskParams.priority = GAPROLE_TASK_PRIORITY;
 
   Task_construct(&gapRoleTask, gapRole_taskFxn, &taskParams, NULL);
+  telemetry_add_task(Task_handle(&gapRoleTask));
 }
 
 /*********************************************************************
@@ -860,6 +914,15 @@ static void gapRole_init(void)
 
   gapRole_state = GAPROLE_INIT;
   gapRole_ConnectionHandle = INVALID_CONNHANDLE;
+  gapRole_numConns = 0;
+  {
+    uint8_t i;
+
+    for (i = 0; i < GAPROLE_MAX_CONNS; i++)
+    {
+      gapRole_links[i].connHandle = INVALID_CONNHANDLE;
+    }
+  }
 
   // Get link DB maximum number of connections
   linkDBNumConns = linkDB_NumConns();
@@ -1016,6 +1079,10 @@ static void gapRole_taskFxn(UArg a0, UArg a1)
 #endif //ICALL_EVENTS
 
       // Unsuccessful in updating connection parameters
+      if (pGapRoles_ParamUpdateFailCB != NULL)
+      {
+        (*pGapRoles_ParamUpdateFailCB)(paramUpdateRejected);
+      }
       gapRole_HandleParamUpdateNoSuccess();
     }
   } // for
@@ -1047,6 +1114,8 @@ static void gapRole_processStackMsg(ICall_Hdr *pMsg)
         {
           l2capParamUpdateRsp_t *pRsp = (l2capParamUpdateRsp_t *)&(pPkt->cmd.updateRsp);
 
+          paramUpdateRejected = (pRsp->result == L2CAP_CONN_PARAMS_REJECTED);
+
           if ((pRsp->result == L2CAP_CONN_PARAMS_REJECTED) &&
                (paramUpdateNoSuccessOption == GAPROLE_TERMINATE_LINK))
           {
@@ -1056,6 +1125,15 @@ static void gapRole_processStackMsg(ICall_Hdr *pMsg)
             // Terminate connection immediately
             GAPRole_TerminateConnection();
           }
+          else if ((pRsp->result == L2CAP_CONN_PARAMS_REJECTED) &&
+                   (paramUpdateNoSuccessOption != GAPROLE_RESEND_PARAM_UPDATE))
+          {
+            // A rejection is final, report it now instead of after the timeout.
+            // A resend still waits for it, so a central that keeps rejecting
+            // is not asked again back to back.
+            Util_stopClock(&updateTimeoutClock);
+            gapRole_setEvent(CONN_PARAM_TIMEOUT_EVT);
+          }
           else
           {
             uint16_t timeout = GAP_GetParamValue(TGAP_CONN_PARAM_TIMEOUT);
@@ -1224,18 +1302,27 @@ static void gapRole_processGAPMsg(gapEventHdr_t *pMsg)
     case GAP_LINK_ESTABLISHED_EVENT:
       {
         gapEstLinkReqEvent_t *pPkt = (gapEstLinkReqEvent_t *)pMsg;
+        gapRole_link_t *pLink = gapRole_findLink(INVALID_CONNHANDLE);
 
-        if (pPkt->hdr.status == SUCCESS)
+        if ((pPkt->hdr.status == SUCCESS) && (pLink == NULL))
+        {
+          // More links than configured, the advertising was not stopped in time
+          VOID GAP_TerminateLinkReq(selfEntity, pPkt->connectionHandle,
+                                    HCI_DISCONNECT_REMOTE_USER_TERM);
+        }
+        else if (pPkt->hdr.status == SUCCESS)
         {
-          VOID memcpy(gapRole_ConnectedDevAddr, pPkt->devAddr, B_ADDR_LEN);
-          gapRole_ConnectionHandle = pPkt->connectionHandle;
-          gapRole_state = GAPROLE_CONNECTED;
-
           // Store connection information
-          gapRole_ConnInterval = pPkt->connInterval;
-          gapRole_ConnSlaveLatency = pPkt->connLatency;
-          gapRole_ConnTimeout = pPkt->connTimeout;
-          gapRole_ConnectedDevAddrType = pPkt->devAddrType;
+          pLink->connHandle = pPkt->connectionHandle;
+          pLink->connInterval = pPkt->connInterval;
+          pLink->connSlaveLatency = pPkt->connLatency;
+          pLink->connTimeout = pPkt->connTimeout;
+          pLink->devAddrType = pPkt->devAddrType;
+          VOID memcpy(pLink->devAddr, pPkt->devAddr, B_ADDR_LEN);
+          gapRole_numConns++;
+
+          gapRole_selectLink(pLink);
+          gapRole_state = GAPROLE_CONNECTED;
 
           // Check whether update parameter request is enabled
           if ((gapRole_updateConnParams.paramUpdateEnable == 
@@ -1253,6 +1340,14 @@ static void gapRole_processGAPMsg(gapEventHdr_t *pMsg)
           // Notify the Bond Manager to the connection
           VOID GAPBondMgr_LinkEst(pPkt->devAddrType, pPkt->devAddr,
                                   pPkt->connectionHandle, GAP_PROFILE_PERIPHERAL);
+
+          gapRole_notifyLink(pPkt->connectionHandle, TRUE);
+
+          // Keep accepting centrals until all links are taken
+          if ((gapRole_numConns < GAPROLE_MAX_CONNS) && (gapRole_AdvEnabled))
+          {
+            gapRole_setEvent(START_ADVERTISING_EVT);
+          }
         }
         else if (pPkt->hdr.status == bleGAPConnNotAcceptable)
         {
@@ -1274,16 +1369,61 @@ static void gapRole_processGAPMsg(gapEventHdr_t *pMsg)
     case GAP_LINK_TERMINATED_EVENT:
       {
         gapTerminateLinkEvent_t *pPkt = (gapTerminateLinkEvent_t *)pMsg;
+        gapRole_link_t *pLink = gapRole_findLink(pPkt->connectionHandle);
+        uint8_t i;
 
         GAPBondMgr_LinkTerm(pPkt->connectionHandle);
 
+        gapRole_ConnTermReason = pPkt->reason;
+
+        if (pLink != NULL)
+        {
+          pLink->connHandle = INVALID_CONNHANDLE;
+          gapRole_numConns--;
+          gapRole_notifyLink(pPkt->connectionHandle, FALSE);
+        }
+
+        if (gapRole_numConns > 0)
+        {
+          // Other links are still up
+          if (pPkt->connectionHandle == gapRole_ConnectionHandle)
+          {
+            // A request on the link that went down will not be answered,
+            // let the application send its next one on the remaining link
+            if ((Util_isActive(&updateTimeoutClock)) &&
+                (pGapRoles_ParamUpdateFailCB != NULL))
+            {
+              (*pGapRoles_ParamUpdateFailCB)(FALSE);
+            }
+
+            // Cancel connection parameter update timers of the link that went down
+            Util_stopClock(&startUpdateClock);
+            Util_stopClock(&updateTimeoutClock);
+
+            for (i = 0; i < GAPROLE_MAX_CONNS; i++)
+            {
+              if (gapRole_links[i].connHandle != INVALID_CONNHANDLE)
+              {
+                gapRole_selectLink(&gapRole_links[i]);
+                break;
+              }
+            }
+          }
+
+          // A link is free again, resume connectable advertising
+          if ((gapRole_state == GAPROLE_CONNECTED) && (gapRole_AdvEnabled))
+          {
+            gapRole_setEvent(START_ADVERTISING_EVT);
+          }
+          break;
+        }
+
         memset(gapRole_ConnectedDevAddr, 0, B_ADDR_LEN);
 
         // Erase connection information
         gapRole_ConnInterval = 0;
         gapRole_ConnSlaveLatency = 0;
         gapRole_ConnTimeout = 0;
-        gapRole_ConnTermReason = pPkt->reason;
 
         // Cancel all connection parameter update timers (if any active)
         Util_stopClock(&startUpdateClock);
@@ -1299,6 +1439,12 @@ static void gapRole_processGAPMsg(gapEventHdr_t *pMsg)
           // Continue advertising.
           gapRole_state = GAPROLE_ADVERTISING_NONCONN;
         }
+        // Connectable advertising resumed for a free link and is still on,
+        // starting it again would fail
+        else if (gapRole_state == GAPROLE_CONNECTED_ADV)
+        {
+          gapRole_state = GAPROLE_ADVERTISING;
+        }
         // Else go to WAITING state.
         else
         {
@@ -1320,6 +1466,20 @@ static void gapRole_processGAPMsg(gapEventHdr_t *pMsg)
     case GAP_LINK_PARAM_UPDATE_EVENT:
       {
         gapLinkUpdateEvent_t *pPkt = (gapLinkUpdateEvent_t *)pMsg;
+        gapRole_link_t *pLink = gapRole_findLink(pPkt->connectionHandle);
+
+        if ((pPkt->hdr.status == SUCCESS) && (pLink != NULL))
+        {
+          pLink->connInterval = pPkt->connInterval;
+          pLink->connSlaveLatency = pPkt->connLatency;
+          pLink->connTimeout = pPkt->connTimeout;
+        }
+
+        // Updates of the other links are only stored
+        if (pPkt->connectionHandle != gapRole_ConnectionHandle)
+        {
+          break;
+        }
 
         // Cancel connection param update timeout timer (if active)
         Util_stopClock(&updateTimeoutClock);
@@ -1566,6 +1726,7 @@ static bStatus_t gapRole_startConnUpdate(uint8_t handleFailure,
     if(status == SUCCESS)
     {
       paramUpdateNoSuccessOption = handleFailure;
+      paramUpdateRejected = FALSE;
       // Let's wait either for L2CAP Connection Parameters Update Response or
       // for Controller to update connection parameters
       Util_restartClock(&updateTimeoutClock, timeout);
@@ -1608,7 +1769,8 @@ bStatus_t GAPRole_SendUpdateParam(uint16_t minConnInterval,
                                   uint8_t handleFailure)
 {
   // If there is no existing connection no update need be sent
-  if (gapRole_state != GAPROLE_CONNECTED)
+  if ((gapRole_state != GAPROLE_CONNECTED) &&
+      (gapRole_state != GAPROLE_CONNECTED_ADV))
   {
     return (bleNotConnected);
   }
@@ -1629,6 +1791,69 @@ bStatus_t GAPRole_SendUpdateParam(uint16_t minConnInterval,
   }
 }
 
+/*********************************************************************
+ * @fn      gapRole_findLink
+ *
+ * @brief   Find the link table entry of a connection.
+ *
+ * @param   connHandle - connection handle, INVALID_CONNHANDLE finds a free
+ *                       entry
+ *
+ * @return  pointer to the entry, NULL if there is none
+ */
+static gapRole_link_t *gapRole_findLink(uint16_t connHandle)
+{
+  uint8_t i;
+
+  for (i = 0; i < GAPROLE_MAX_CONNS; i++)
+  {
+    if (gapRole_links[i].connHandle == connHandle)
+    {
+      return (&gapRole_links[i]);
+    }
+  }
+
+  return (NULL);
+}
+
+/*********************************************************************
+ * @fn      gapRole_selectLink
+ *
+ * @brief   Make a link the one the connection parameters, the update
+ *          procedure and GAPRole_TerminateConnection() refer to.
+ *
+ * @param   pLink - link table entry
+ *
+ * @return  none
+ */
+static void gapRole_selectLink(gapRole_link_t *pLink)
+{
+  gapRole_ConnectionHandle = pLink->connHandle;
+  gapRole_ConnInterval = pLink->connInterval;
+  gapRole_ConnSlaveLatency = pLink->connSlaveLatency;
+  gapRole_ConnTimeout = pLink->connTimeout;
+  gapRole_ConnectedDevAddrType = pLink->devAddrType;
+  VOID memcpy(gapRole_ConnectedDevAddr, pLink->devAddr, B_ADDR_LEN);
+}
+
+/*********************************************************************
+ * @fn      gapRole_notifyLink
+ *
+ * @brief   Tell the application a link came up or went down.
+ *
+ * @param   connHandle - connection handle
+ * @param   up - TRUE if the link came up
+ *
+ * @return  none
+ */
+static void gapRole_notifyLink(uint16_t connHandle, uint8_t up)
+{
+  if (pGapRoles_LinkCB != NULL)
+  {
+    (*pGapRoles_LinkCB)(connHandle, up);
+  }
+}
+
 /*********************************************************************
  * @fn      gapRole_setEvent
  *
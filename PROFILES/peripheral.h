@@ -62,6 +62,21 @@ extern "C"
  * CONSTANTS
  */
 
+/**
+ * Most links the peripheral keeps at once. Connectable advertising resumes
+ * after a connection while fewer links than this are up. Must not exceed the
+ * MAX_NUM_BLE_CONNS the stack was built with. That is set in the stack
+ * project's build_config.opt, so the application project has the same
+ * MAX_NUM_BLE_CONNS in its predefined symbols.
+ */
+#ifndef GAPROLE_MAX_CONNS
+#ifdef MAX_NUM_BLE_CONNS
+#define GAPROLE_MAX_CONNS           MAX_NUM_BLE_CONNS
+#else
+#error "Define MAX_NUM_BLE_CONNS as in the stack's build_config.opt (or GAPROLE_MAX_CONNS)"
+#endif
+#endif
+
 /** @defgroup GAPROLE_PROFILE_PARAMETERS GAP Role Parameters
  * @{
  */
@@ -95,6 +110,7 @@ extern "C"
 #define GAPROLE_ADV_NONCONN_ENABLED 0x31B  //!< Enable/Disable Non-Connectable Advertising.  Read/Write.  Size is uint8_t.  Default is FALSE=Disabled.
 #define GAPROLE_BD_ADDR_TYPE        0x31C  //!< Address type of connected device. Read only. Size is uint8_t.
 #define GAPROLE_CONN_TERM_REASON    0x31D  //!< Reason of the last connection terminated event. Size is uint8_t.
+#define GAPROLE_NUM_CONNS           0x31E  //!< Number of links that are up. Read only. Size is uint8_t. The connection parameters and address above belong to the most recent one (GAPROLE_CONNHANDLE).
    
 /** @} End GAPROLE_PROFILE_PARAMETERS */
 
@@ -157,6 +173,20 @@ typedef void (*gapRolesParamUpdateCB_t)(uint16_t connInterval,
                                         uint16_t connSlaveLatency,
                                         uint16_t connTimeout);
 
+/**
+ * Callback when a connection parameter update requested with
+ * GAPRole_SendUpdateParam() did not take effect. rejected is TRUE if the
+ * central rejected the request, FALSE if it timed out.
+ */
+typedef void (*gapRolesParamUpdateFailCB_t)(uint8_t rejected);
+
+/**
+ * Callback when a link comes up (up is TRUE) or goes down. With several
+ * links the state change callback only reports GAPROLE_WAITING once the last
+ * one went down, this one reports every link.
+ */
+typedef void (*gapRolesLinkCB_t)(uint16_t connHandle, uint8_t up);
+
 /**
  * Callback when the device has been started.  Callback event to
  * the Notify of a state change.
@@ -267,6 +297,25 @@ extern bStatus_t GAPRole_SendUpdateParam(uint16_t minConnInterval,
  */
 extern void GAPRole_RegisterAppCBs(gapRolesParamUpdateCB_t *pParamUpdateCB);
 
+/**
+ * @brief       Register application's failed param update callback. It is
+ *              called before the handleFailure action of the request runs.
+ *
+ * @param       pParamUpdateFailCB - pointer to failed param update callback.
+ *
+ * @return      none
+ */
+extern void GAPRole_RegisterParamUpdateFailCB(gapRolesParamUpdateFailCB_t *pParamUpdateFailCB);
+
+/**
+ * @brief       Register application's link callback.
+ *
+ * @param       pLinkCB - pointer to link callback.
+ *
+ * @return      none
+ */
+extern void GAPRole_RegisterLinkCB(gapRolesLinkCB_t *pLinkCB);
+
 /**
  * @} End GAPROLES_PERIPHERAL_API
  */
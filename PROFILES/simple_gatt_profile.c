@@ -74,12 +74,26 @@
  * CONSTANTS
  */
 
-#define SERVAPP_NUM_ATTR_SUPPORTED        12
+#define SERVAPP_NUM_ATTR_SUPPORTED        24
+
+// Position of the Response Status value in the attribute table
+#define RESPONSE_READY_VALUE_IDX          8
 
 /*********************************************************************
  * TYPEDEFS
  */
 
+// Characteristic values of one client
+typedef struct
+{
+  uint16 connHandle;
+  uint8 challange[USER_CHALLANGE_CHAR_LENGTH];
+  uint8 response[SERVER_RESPONSE_CHAR_LENGTH];
+  uint8 ready[RESPONSE_READY_CHAR_LENGTH];
+  uint8 sealedChallange[SEALED_CHALLENGE_CHAR_LENGTH];
+  uint8 sealedResponse[SEALED_RESPONSE_CHAR_LENGTH];
+} simpleProfileConn_t;
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -104,6 +118,26 @@ CONST uint8 ResponseReadyProfileCharUUID[ATT_BT_UUID_SIZE] =
   LO_UINT16(RESPONSE_READY_UUID), HI_UINT16(RESPONSE_READY_UUID)
 };
 
+CONST uint8 DiagnosticsProfileCharUUID[ATT_BT_UUID_SIZE] =
+{
+  LO_UINT16(DIAGNOSTICS_UUID), HI_UINT16(DIAGNOSTICS_UUID)
+};
+
+CONST uint8 TelemetryProfileCharUUID[ATT_BT_UUID_SIZE] =
+{
+  LO_UINT16(TELEMETRY_UUID), HI_UINT16(TELEMETRY_UUID)
+};
+
+CONST uint8 SealedChallangeProfileCharUUID[ATT_BT_UUID_SIZE] =
+{
+  LO_UINT16(SEALED_CHALLENGE_UUID), HI_UINT16(SEALED_CHALLENGE_UUID)
+};
+
+CONST uint8 SealedResponseProfileCharUUID[ATT_BT_UUID_SIZE] =
+{
+  LO_UINT16(SEALED_RESPONSE_UUID), HI_UINT16(SEALED_RESPONSE_UUID)
+};
+
 /*********************************************************************
  * EXTERNAL VARIABLES
  */
@@ -156,6 +190,45 @@ static uint8 ResponseReadyProfileDesp[16] = "Response Status";
 
 static gattCharCfg_t *ResponseReadyCharConfig;
 
+// Simple Profile Characteristic 4 Properties
+static uint8 DiagnosticsProfileCharProps = GATT_PROP_READ | GATT_PROP_WRITE;
+
+// Characteristic 4 Value, the last command written, the application fills every read
+static uint8 DiagnosticsProfileBuffer[DIAGNOSTICS_CHAR_LENGTH] = "";
+
+// Simple Profile Characteristic 4 User Description
+static uint8 DiagnosticsProfileDesp[12] = "Diagnostics";
+
+// Simple Profile Characteristic 5 Properties
+static uint8 TelemetryProfileCharProps = GATT_PROP_READ;
+
+// Characteristic 5 Value, the application fills every read
+static uint8 TelemetryProfileBuffer[1] = "";
+
+// Simple Profile Characteristic 5 User Description
+static uint8 TelemetryProfileDesp[10] = "Telemetry";
+
+// Simple Profile Characteristic 6 Properties
+static uint8 SealedChallangeProfileCharProps = GATT_PROP_WRITE;
+
+// Simple Profile Characteristic 6 User Description
+static uint8 SealedChallangeProfileDesp[17] = "Sealed Challange";
+
+// Simple Profile Characteristic 7 Properties
+static uint8 SealedResponseProfileCharProps = GATT_PROP_READ;
+
+// Simple Profile Characteristic 7 User Description
+static uint8 SealedResponseProfileDesp[16] = "Sealed Response";
+
+// Characteristic 6 and 7 Values only exist in the slot of a client, the
+// channel is not open to clients without one
+static uint8 SealedProfileNoSlot[1] = "";
+
+// Every client writes its challenge into and reads its response from its own
+// slot, so a second client can not overwrite the challenge of the first one.
+// A client without a slot reads the values in the attribute table.
+static simpleProfileConn_t simpleProfileConns[SIMPLEPROFILE_MAX_CONNS];
+
 /*********************************************************************
  * Profile Attributes - Table
  */
@@ -249,6 +322,102 @@ static gattAttribute_t simpleProfileAttrTbl[SERVAPP_NUM_ATTR_SUPPORTED] =
           0,
           ResponseReadyProfileDesp
         },
+
+      // Characteristic 4 Declaration
+      {
+        { ATT_BT_UUID_SIZE, characterUUID },
+        GATT_PERMIT_READ,
+        0,
+        &DiagnosticsProfileCharProps
+      },
+
+        // Characteristic Value 4
+        {
+          { ATT_BT_UUID_SIZE, DiagnosticsProfileCharUUID },
+          GATT_PERMIT_READ | GATT_PERMIT_WRITE,
+          0,
+          DiagnosticsProfileBuffer
+        },
+
+        // Characteristic 4 User Description
+        {
+          { ATT_BT_UUID_SIZE, charUserDescUUID },
+          GATT_PERMIT_READ,
+          0,
+          DiagnosticsProfileDesp
+        },
+
+      // Characteristic 5 Declaration
+      {
+        { ATT_BT_UUID_SIZE, characterUUID },
+        GATT_PERMIT_READ,
+        0,
+        &TelemetryProfileCharProps
+      },
+
+        // Characteristic Value 5
+        {
+          { ATT_BT_UUID_SIZE, TelemetryProfileCharUUID },
+          GATT_PERMIT_READ,
+          0,
+          TelemetryProfileBuffer
+        },
+
+        // Characteristic 5 User Description
+        {
+          { ATT_BT_UUID_SIZE, charUserDescUUID },
+          GATT_PERMIT_READ,
+          0,
+          TelemetryProfileDesp
+        },
+
+      // Characteristic 6 Declaration
+      {
+        { ATT_BT_UUID_SIZE, characterUUID },
+        GATT_PERMIT_READ,
+        0,
+        &SealedChallangeProfileCharProps
+      },
+
+        // Characteristic Value 6
+        {
+          { ATT_BT_UUID_SIZE, SealedChallangeProfileCharUUID },
+          GATT_PERMIT_WRITE,
+          0,
+          SealedProfileNoSlot
+        },
+
+        // Characteristic 6 User Description
+        {
+          { ATT_BT_UUID_SIZE, charUserDescUUID },
+          GATT_PERMIT_READ,
+          0,
+          SealedChallangeProfileDesp
+        },
+
+      // Characteristic 7 Declaration
+      {
+        { ATT_BT_UUID_SIZE, characterUUID },
+        GATT_PERMIT_READ,
+        0,
+        &SealedResponseProfileCharProps
+      },
+
+        // Characteristic Value 7
+        {
+          { ATT_BT_UUID_SIZE, SealedResponseProfileCharUUID },
+          GATT_PERMIT_READ,
+          0,
+          SealedProfileNoSlot
+        },
+
+        // Characteristic 7 User Description
+        {
+          { ATT_BT_UUID_SIZE, charUserDescUUID },
+          GATT_PERMIT_READ,
+          0,
+          SealedResponseProfileDesp
+        },
 };
 
 /*********************************************************************
@@ -263,6 +432,10 @@ static bStatus_t simpleProfile_WriteAttrCB(uint16_t connHandle,
                                            gattAttribute_t *pAttr,
                                            uint8_t *pValue, uint16_t len,
                                            uint16_t offset, uint8_t method);
+static simpleProfileConn_t *simpleProfile_FindConn(uint16 connHandle,
+                                                   uint8 allocate);
+static uint8 *simpleProfile_ConnValue(simpleProfileConn_t *pConn, uint8 param);
+static void simpleProfile_NotifyReady(simpleProfileConn_t *pConn);
 
 /*********************************************************************
  * PROFILE CALLBACKS
@@ -313,6 +486,15 @@ bStatus_t SimpleProfile_AddService( uint32 services )
     // Initialize Client Characteristic Configuration attributes
     GATTServApp_InitCharCfg( INVALID_CONNHANDLE, ResponseReadyCharConfig );
 
+  {
+    uint8 i;
+
+    for ( i = 0; i < SIMPLEPROFILE_MAX_CONNS; i++ )
+    {
+      simpleProfileConns[i].connHandle = INVALID_CONNHANDLE;
+    }
+  }
+
   if ( services & SIMPLEPROFILE_SERVICE )
   {
     // Register GATT attribute list and CBs with GATT Server App
@@ -440,11 +622,288 @@ bStatus_t SimpleProfile_GetParameter( uint8 param, void *value )
     case RESPONSE_READY_CHAR_VALUE:
       VOID memcpy( value, ResponseReadyProfileBuffer , RESPONSE_READY_CHAR_LENGTH );
       break;
+    case DIAGNOSTICS_CHAR_VALUE:
+      VOID memcpy( value, DiagnosticsProfileBuffer, DIAGNOSTICS_CHAR_LENGTH );
+      break;
   }
   
   return ( ret );
 }
 
+/*********************************************************************
+ * @fn      SimpleProfile_SetConnParameter
+ *
+ * @brief   Set a Simple Profile parameter for one client.
+ *
+ * @param   connHandle - connection of the client
+ * @param   param - Profile parameter ID
+ * @param   len - length of data to write
+ * @param   value - pointer to data to write
+ *
+ * @return  bStatus_t
+ */
+bStatus_t SimpleProfile_SetConnParameter( uint16 connHandle, uint8 param,
+                                          uint8 len, void *value )
+{
+  simpleProfileConn_t *pConn = simpleProfile_FindConn( connHandle, TRUE );
+  uint8 *pCurValue;
+  uint8 valueLen;
+
+  switch ( param )
+  {
+    case USER_CHALLANGE_CHAR_VALUE:
+      valueLen = USER_CHALLANGE_CHAR_LENGTH;
+      break;
+
+    case SERVER_RESPONSE_CHAR_VALUE:
+      valueLen = SERVER_RESPONSE_CHAR_LENGTH;
+      break;
+
+    case RESPONSE_READY_CHAR_VALUE:
+      valueLen = RESPONSE_READY_CHAR_LENGTH;
+      break;
+
+    case SEALED_CHALLENGE_CHAR_VALUE:
+      valueLen = SEALED_CHALLENGE_CHAR_LENGTH;
+      break;
+
+    case SEALED_RESPONSE_CHAR_VALUE:
+      valueLen = SEALED_RESPONSE_CHAR_LENGTH;
+      break;
+
+    default:
+      return ( INVALIDPARAMETER );
+  }
+
+  if ( len != valueLen )
+  {
+    return ( bleInvalidRange );
+  }
+  if ( pConn == NULL )
+  {
+    return ( bleNoResources );
+  }
+
+  pCurValue = simpleProfile_ConnValue( pConn, param );
+  VOID memcpy( pCurValue, value, len );
+
+  if ( param == RESPONSE_READY_CHAR_VALUE )
+  {
+    simpleProfile_NotifyReady( pConn );
+  }
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      SimpleProfile_GetConnParameter
+ *
+ * @brief   Get the value of a Simple Profile parameter one client sees.
+ *
+ * @param   connHandle - connection of the client
+ * @param   param - Profile parameter ID
+ * @param   value - pointer to data to put
+ *
+ * @return  bStatus_t
+ */
+bStatus_t SimpleProfile_GetConnParameter( uint16 connHandle, uint8 param,
+                                          void *value )
+{
+  simpleProfileConn_t *pConn = simpleProfile_FindConn( connHandle, FALSE );
+
+  if ( ( pConn == NULL ) && ( ( param == SEALED_CHALLENGE_CHAR_VALUE ) ||
+                              ( param == SEALED_RESPONSE_CHAR_VALUE ) ) )
+  {
+    return ( bleNoResources );
+  }
+  if ( pConn == NULL )
+  {
+    return ( SimpleProfile_GetParameter( param, value ) );
+  }
+
+  switch ( param )
+  {
+    case USER_CHALLANGE_CHAR_VALUE:
+      VOID memcpy( value, pConn->challange, USER_CHALLANGE_CHAR_LENGTH );
+      break;
+
+    case SERVER_RESPONSE_CHAR_VALUE:
+      VOID memcpy( value, pConn->response, SERVER_RESPONSE_CHAR_LENGTH );
+      break;
+
+    case RESPONSE_READY_CHAR_VALUE:
+      VOID memcpy( value, pConn->ready, RESPONSE_READY_CHAR_LENGTH );
+      break;
+
+    case SEALED_CHALLENGE_CHAR_VALUE:
+      VOID memcpy( value, pConn->sealedChallange, SEALED_CHALLENGE_CHAR_LENGTH );
+      break;
+
+    case SEALED_RESPONSE_CHAR_VALUE:
+      VOID memcpy( value, pConn->sealedResponse, SEALED_RESPONSE_CHAR_LENGTH );
+      break;
+
+    default:
+      return ( INVALIDPARAMETER );
+  }
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      SimpleProfile_CloseConn
+ *
+ * @brief   Clear and release the values of a client.
+ *
+ * @param   connHandle - connection of the client
+ *
+ * @return  none
+ */
+void SimpleProfile_CloseConn( uint16 connHandle )
+{
+  simpleProfileConn_t *pConn = simpleProfile_FindConn( connHandle, FALSE );
+
+  if ( pConn != NULL )
+  {
+    VOID memset( pConn, 0, sizeof( simpleProfileConn_t ) );
+    pConn->connHandle = INVALID_CONNHANDLE;
+  }
+}
+
+/*********************************************************************
+ * @fn      simpleProfile_FindConn
+ *
+ * @brief   Find the values of a client.
+ *
+ * @param   connHandle - connection of the client
+ * @param   allocate - take a free slot if the client has none yet. It
+ *                     starts out with the values of the attribute table.
+ *
+ * @return  pointer to the slot, NULL if there is none
+ */
+static simpleProfileConn_t *simpleProfile_FindConn( uint16 connHandle,
+                                                    uint8 allocate )
+{
+  simpleProfileConn_t *pFree = NULL;
+  uint8 i;
+
+  if ( connHandle == INVALID_CONNHANDLE )
+  {
+    return ( NULL );
+  }
+
+  for ( i = 0; i < SIMPLEPROFILE_MAX_CONNS; i++ )
+  {
+    if ( simpleProfileConns[i].connHandle == connHandle )
+    {
+      return ( &simpleProfileConns[i] );
+    }
+    if ( ( pFree == NULL ) &&
+         ( simpleProfileConns[i].connHandle == INVALID_CONNHANDLE ) )
+    {
+      pFree = &simpleProfileConns[i];
+    }
+  }
+
+  if ( allocate && ( pFree != NULL ) )
+  {
+    pFree->connHandle = connHandle;
+    VOID memcpy( pFree->challange, UserChllangeProfileBuffer, USER_CHALLANGE_CHAR_LENGTH );
+    VOID memcpy( pFree->response, ServerResonseProfileBuffer, SERVER_RESPONSE_CHAR_LENGTH );
+    VOID memcpy( pFree->ready, ResponseReadyProfileBuffer, RESPONSE_READY_CHAR_LENGTH );
+    return ( pFree );
+  }
+
+  return ( NULL );
+}
+
+/*********************************************************************
+ * @fn      simpleProfile_ConnValue
+ *
+ * @brief   Get the buffer of a parameter in a client's slot.
+ *
+ * @param   pConn - client slot
+ * @param   param - Profile parameter ID
+ *
+ * @return  pointer to the value
+ */
+static uint8 *simpleProfile_ConnValue( simpleProfileConn_t *pConn, uint8 param )
+{
+  switch ( param )
+  {
+    case USER_CHALLANGE_CHAR_VALUE:
+      return ( pConn->challange );
+
+    case SERVER_RESPONSE_CHAR_VALUE:
+      return ( pConn->response );
+
+    case SEALED_CHALLENGE_CHAR_VALUE:
+      return ( pConn->sealedChallange );
+
+    case SEALED_RESPONSE_CHAR_VALUE:
+      return ( pConn->sealedResponse );
+
+    default:
+      return ( pConn->ready );
+  }
+}
+
+/*********************************************************************
+ * @fn      simpleProfile_NotifyReady
+ *
+ * @brief   Notify a client of its Response Status, if it enabled
+ *          notifications. Without a free buffer the notification is
+ *          handed to the application, once sent the application drops
+ *          the one it may still hold.
+ *
+ * @param   pConn - client slot
+ *
+ * @return  none
+ */
+static void simpleProfile_NotifyReady( simpleProfileConn_t *pConn )
+{
+  attHandleValueNoti_t noti;
+  bStatus_t status = MSG_BUFFER_NOT_AVAIL;
+
+  if ( !( GATTServApp_ReadCharCfg( pConn->connHandle, ResponseReadyCharConfig ) &
+          GATT_CLIENT_CFG_NOTIFY ) )
+  {
+    return;
+  }
+
+  noti.pValue = (uint8 *)GATT_bm_alloc( pConn->connHandle, ATT_HANDLE_VALUE_NOTI,
+                                        RESPONSE_READY_CHAR_LENGTH, NULL );
+  if ( noti.pValue != NULL )
+  {
+    noti.handle = simpleProfileAttrTbl[RESPONSE_READY_VALUE_IDX].handle;
+    noti.len = RESPONSE_READY_CHAR_LENGTH;
+    VOID memcpy( noti.pValue, pConn->ready, RESPONSE_READY_CHAR_LENGTH );
+
+    status = GATT_Notification( pConn->connHandle, &noti, FALSE );
+    if ( status != SUCCESS )
+    {
+      GATT_bm_free( (gattMsg_t *)&noti, ATT_HANDLE_VALUE_NOTI );
+    }
+  }
+
+  // Sent, an older one the application holds must not follow it
+  if ( ( status == SUCCESS ) &&
+       simpleProfile_AppCBs && simpleProfile_AppCBs->pfnSimpleProfileNotiSent )
+  {
+    simpleProfile_AppCBs->pfnSimpleProfileNotiSent( pConn->connHandle,
+                                                    simpleProfileAttrTbl[RESPONSE_READY_VALUE_IDX].handle );
+  }
+
+  // Out of buffers, let the application send it once there are some
+  else if ( ( ( status == MSG_BUFFER_NOT_AVAIL ) || ( status == blePending ) ) &&
+       simpleProfile_AppCBs && simpleProfile_AppCBs->pfnSimpleProfileNotiPending )
+  {
+    simpleProfile_AppCBs->pfnSimpleProfileNotiPending( pConn->connHandle,
+                                                       simpleProfileAttrTbl[RESPONSE_READY_VALUE_IDX].handle,
+                                                       pConn->ready, RESPONSE_READY_CHAR_LENGTH );
+  }
+}
+
 /*********************************************************************
  * @fn          simpleProfile_ReadAttrCB
  *
@@ -468,6 +927,8 @@ static bStatus_t simpleProfile_ReadAttrCB(uint16_t connHandle,
 {
   bStatus_t status = SUCCESS;
   uint16_t bytes_left_to_read;
+  simpleProfileConn_t *pConn = simpleProfile_FindConn( connHandle, FALSE );
+  uint8 *pCurValue = pAttr->pValue;
  
   if ( pAttr->type.len == ATT_BT_UUID_SIZE )
   {
@@ -479,16 +940,60 @@ static bStatus_t simpleProfile_ReadAttrCB(uint16_t connHandle,
       // gattserverapp handles those reads
       case USER_CHALLANGE_UUID:
           bytes_left_to_read = USER_CHALLANGE_CHAR_LENGTH - offset;
+          if ( pConn != NULL )
+          {
+            pCurValue = pConn->challange;
+          }
           break;
 
       case SERVER_RESPONSE_UUID:
           bytes_left_to_read = SERVER_RESPONSE_CHAR_LENGTH - offset;
+          if ( pConn != NULL )
+          {
+            pCurValue = pConn->response;
+          }
           break;
 
       case RESPONSE_READY_UUID:
           bytes_left_to_read = RESPONSE_READY_CHAR_LENGTH - offset;
+          if ( pConn != NULL )
+          {
+            pCurValue = pConn->ready;
+          }
           break;
 
+      case SEALED_RESPONSE_UUID:
+          if ( pConn == NULL )
+          {
+            *pLen = 0;
+            return ( ATT_ERR_INSUFFICIENT_RESOURCES );
+          }
+          if ( offset > SEALED_RESPONSE_CHAR_LENGTH )
+          {
+            *pLen = 0;
+            return ( ATT_ERR_INVALID_OFFSET );
+          }
+          bytes_left_to_read = SEALED_RESPONSE_CHAR_LENGTH - offset;
+          pCurValue = pConn->sealedResponse;
+          break;
+
+      case DIAGNOSTICS_UUID:
+      case TELEMETRY_UUID:
+          // The application builds the value, long reads come back with an offset
+          *pLen = 0;
+          if ( simpleProfile_AppCBs && simpleProfile_AppCBs->pfnSimpleProfileDiagRead )
+          {
+            *pLen = simpleProfile_AppCBs->pfnSimpleProfileDiagRead( connHandle,
+                      ( uuid == DIAGNOSTICS_UUID ) ? DIAGNOSTICS_CHAR_VALUE : TELEMETRY_CHAR_VALUE,
+                      offset, pValue, maxLen );
+          }
+          if ( *pLen == SIMPLEPROFILE_DIAG_INVALID_OFFSET )
+          {
+            *pLen = 0;
+            return ( ATT_ERR_INVALID_OFFSET );
+          }
+          return ( SUCCESS );
+
       default:
         bytes_left_to_read = 0;
         status = ATT_ERR_ATTR_NOT_FOUND;
@@ -498,7 +1003,7 @@ static bStatus_t simpleProfile_ReadAttrCB(uint16_t connHandle,
     // Copy the request value to the correct buffer
     bytes_left_to_read = min(bytes_left_to_read, maxLen);
     *pLen = bytes_left_to_read;
-    VOID memcpy( pValue, &(pAttr->pValue[offset]), bytes_left_to_read );
+    VOID memcpy( pValue, &(pCurValue[offset]), bytes_left_to_read );
   }
   else
   {
@@ -551,25 +1056,78 @@ static bStatus_t simpleProfile_WriteAttrCB(uint16_t connHandle,
           status = ATT_ERR_ATTR_NOT_LONG;
         }
         
-        //Write the value
+        //Write the value into the client's own slot
         if ( status == SUCCESS )
         {
-          uint8 *pCurValue = (uint8 *)pAttr->pValue;        
-          VOID memcpy( pCurValue, pValue, len );
+          simpleProfileConn_t *pConn = simpleProfile_FindConn( connHandle, TRUE );
 
-          notifyApp = USER_CHALLANGE_CHAR_VALUE;
+          if ( pConn == NULL )
+          {
+            status = ATT_ERR_INSUFFICIENT_RESOURCES;
+          }
+          else
+          {
+            VOID memcpy( pConn->challange, pValue, len );
+
+            notifyApp = USER_CHALLANGE_CHAR_VALUE;
+          }
         }
              
         break;
 
+      case SEALED_CHALLENGE_UUID:
+        // Longer than one packet at the default MTU, so it may come as a long
+        // write. The application gets it once the last byte is in.
+        if ( offset > SEALED_CHALLENGE_CHAR_LENGTH )
+        {
+          status = ATT_ERR_INVALID_OFFSET;
+        }
+        else if ( len > SEALED_CHALLENGE_CHAR_LENGTH - offset )
+        {
+          status = ATT_ERR_INVALID_VALUE_SIZE;
+        }
+        else
+        {
+          simpleProfileConn_t *pConn = simpleProfile_FindConn( connHandle, TRUE );
+
+          if ( pConn == NULL )
+          {
+            status = ATT_ERR_INSUFFICIENT_RESOURCES;
+          }
+          else
+          {
+            VOID memcpy( &pConn->sealedChallange[offset], pValue, len );
+            if ( offset + len == SEALED_CHALLENGE_CHAR_LENGTH )
+            {
+              notifyApp = SEALED_CHALLENGE_CHAR_VALUE;
+            }
+          }
+        }
+        break;
+
       case RESPONSE_READY_UUID:
           // The user wants to tell us he has read the response
           if ( (offset != 0) || (len != RESPONSE_READY_CHAR_LENGTH) ) {
               status = ATT_ERR_INVALID_VALUE_SIZE;
           } else {
-              notifyApp = RESPONSE_READY_CHAR_VALUE;
-              uint8 *pCurValue = (uint8 *)pAttr->pValue;
-              VOID memcpy( pCurValue, pValue, len);
+              simpleProfileConn_t *pConn = simpleProfile_FindConn( connHandle, TRUE );
+
+              if ( pConn == NULL ) {
+                  status = ATT_ERR_INSUFFICIENT_RESOURCES;
+              } else {
+                  notifyApp = RESPONSE_READY_CHAR_VALUE;
+                  VOID memcpy( pConn->ready, pValue, len);
+              }
+          }
+          break;
+
+      case DIAGNOSTICS_UUID:
+          // A command for the application, see DIAGNOSTICS_SHOW_LATENCY
+          if ( (offset != 0) || (len != DIAGNOSTICS_CHAR_LENGTH) ) {
+              status = ATT_ERR_INVALID_VALUE_SIZE;
+          } else {
+              DiagnosticsProfileBuffer[0] = pValue[0];
+              notifyApp = DIAGNOSTICS_CHAR_VALUE;
           }
           break;
 
@@ -592,7 +1150,7 @@ static bStatus_t simpleProfile_WriteAttrCB(uint16_t connHandle,
   // If a characteristic value changed then callback function to notify application of change
   if ( (notifyApp != 0xFF ) && simpleProfile_AppCBs && simpleProfile_AppCBs->pfnSimpleProfileChange )
   {
-    simpleProfile_AppCBs->pfnSimpleProfileChange( notifyApp );  
+    simpleProfile_AppCBs->pfnSimpleProfileChange( connHandle, notifyApp );
   }
   
   return ( status );
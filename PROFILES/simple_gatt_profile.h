@@ -65,6 +65,10 @@ extern "C"
 #define USER_CHALLANGE_CHAR_VALUE                   0
 #define SERVER_RESPONSE_CHAR_VALUE                  1
 #define RESPONSE_READY_CHAR_VALUE                   2
+#define DIAGNOSTICS_CHAR_VALUE                      3
+#define TELEMETRY_CHAR_VALUE                        4
+#define SEALED_CHALLENGE_CHAR_VALUE                 5
+#define SEALED_RESPONSE_CHAR_VALUE                  6
   
 // Simple Profile Service UUID
 #define SIMPLEPROFILE_SERV_UUID               0xFFF0
@@ -73,6 +77,10 @@ extern "C"
 #define USER_CHALLANGE_UUID                 0xFFF1
 #define SERVER_RESPONSE_UUID                0xFFF2
 #define RESPONSE_READY_UUID                 0xFFF3
+#define DIAGNOSTICS_UUID                    0xFFF4
+#define TELEMETRY_UUID                      0xFFF5
+#define SEALED_CHALLENGE_UUID               0xFFF6
+#define SEALED_RESPONSE_UUID                0xFFF7
 
 // Simple Keys Profile Services bit fields
 #define SIMPLEPROFILE_SERVICE               0x00000001
@@ -80,6 +88,32 @@ extern "C"
 #define USER_CHALLANGE_CHAR_LENGTH        16
 #define SERVER_RESPONSE_CHAR_LENGTH       128
 #define RESPONSE_READY_CHAR_LENGTH        1
+#define DIAGNOSTICS_CHAR_LENGTH           1
+
+// Sealed challenge channel, AES-CCM under the channel key. The client writes
+// nonce, encrypted challenge and tag, and reads back the encrypted response and
+// its tag. The response nonce is the challenge nonce with the top bit flipped.
+#define SEALED_NONCE_LENGTH               13
+#define SEALED_TAG_LENGTH                 8
+#define SEALED_CHALLENGE_CHAR_LENGTH      (SEALED_NONCE_LENGTH + USER_CHALLANGE_CHAR_LENGTH + SEALED_TAG_LENGTH)
+#define SEALED_RESPONSE_CHAR_LENGTH       (SERVER_RESPONSE_CHAR_LENGTH + SEALED_TAG_LENGTH)
+
+// Returned by the Diagnostics read callback for an offset past the end
+#define SIMPLEPROFILE_DIAG_INVALID_OFFSET 0xFFFF
+
+// Commands written to the Diagnostics value, they pick what its reads return
+#define DIAGNOSTICS_SHOW_LATENCY          0x00
+#define DIAGNOSTICS_RUN_SELF_TEST         0x01  // Builds with SIGNER_SELF_TEST only
+
+// Clients that get their own challenge, response and status values, keep it
+// equal to GAPROLE_MAX_CONNS (see peripheral.h)
+#ifndef SIMPLEPROFILE_MAX_CONNS
+#ifdef MAX_NUM_BLE_CONNS
+#define SIMPLEPROFILE_MAX_CONNS           MAX_NUM_BLE_CONNS
+#else
+#error "Define MAX_NUM_BLE_CONNS as in the stack's build_config.opt (or SIMPLEPROFILE_MAX_CONNS)"
+#endif
+#endif
 
 /*********************************************************************
  * TYPEDEFS
@@ -90,7 +124,8 @@ typedef enum ResponseReadyStatus {
     ResponseRead = 'D',
     ResponseNotReady = 'N',
     PendingUserClick = 'P',
-    WaitingForChallange = 'W'
+    WaitingForChallange = 'W',
+    ChallangeQueued = 'Q'
 } response_ready_status_t;
 
 
@@ -102,12 +137,30 @@ typedef enum ResponseReadyStatus {
  * Profile Callbacks
  */
 
-// Callback when a characteristic value has changed
-typedef void (*simpleProfileChange_t)( uint8 paramID );
+// Callback when a client changed a characteristic value
+typedef void (*simpleProfileChange_t)( uint16 connHandle, uint8 paramID );
+
+// Callback when a notification found no buffer, the application may send it later
+typedef void (*simpleProfileNotiPending_t)( uint16 connHandle, uint16 handle,
+                                            uint8 *pValue, uint16 len );
+
+// Callback when a notification was sent, one the application still holds for
+// the attribute is older
+typedef void (*simpleProfileNotiSent_t)( uint16 connHandle, uint16 handle );
+
+// Callback that fills a read of the Diagnostics or Telemetry value (paramID)
+// from offset on, returns the number of bytes written into pValue or
+// SIMPLEPROFILE_DIAG_INVALID_OFFSET if offset is past the end of the value
+typedef uint16 (*simpleProfileDiagRead_t)( uint16 connHandle, uint8 paramID,
+                                           uint16 offset, uint8 *pValue,
+                                           uint16 maxLen );
 
 typedef struct
 {
   simpleProfileChange_t        pfnSimpleProfileChange;  // Called when characteristic value changes
+  simpleProfileNotiPending_t   pfnSimpleProfileNotiPending;  // Called when a notification could not be sent, may be NULL
+  simpleProfileNotiSent_t      pfnSimpleProfileNotiSent;  // Called when a notification was sent, may be NULL
+  simpleProfileDiagRead_t      pfnSimpleProfileDiagRead;  // Called when the Diagnostics or Telemetry value is read, may be NULL
 } simpleProfileCBs_t;
 
     
@@ -158,6 +211,38 @@ extern bStatus_t SimpleProfile_SetParameter( uint8 param, uint8 len, void *value
  */
 extern bStatus_t SimpleProfile_GetParameter( uint8 param, void *value );
 
+/*
+ * SimpleProfile_SetConnParameter - Set a Simple GATT Profile parameter for one
+ *          client only. Setting RESPONSE_READY_CHAR_VALUE notifies only that
+ *          client.
+ *
+ *    connHandle - connection of the client
+ *    param - Profile parameter ID
+ *    len - length of data to write
+ *    value - pointer to data to write
+ */
+extern bStatus_t SimpleProfile_SetConnParameter( uint16 connHandle, uint8 param,
+                                                 uint8 len, void *value );
+
+/*
+ * SimpleProfile_GetConnParameter - Get the value of a Simple GATT Profile
+ *          parameter one client sees.
+ *
+ *    connHandle - connection of the client
+ *    param - Profile parameter ID
+ *    value - pointer to data to write
+ */
+extern bStatus_t SimpleProfile_GetConnParameter( uint16 connHandle, uint8 param,
+                                                 void *value );
+
+/*
+ * SimpleProfile_CloseConn - Clear and release the values of a client whose
+ *          link went down.
+ *
+ *    connHandle - connection of the client
+ */
+extern void SimpleProfile_CloseConn( uint16 connHandle );
+
 
 /*********************************************************************
 *********************************************************************/
@@ -74,6 +74,11 @@
 
 #include "signer.h"
 #include "led_control.h"
+#include "button.h"
+#include "trace.h"
+#include "latency.h"
+#include "telemetry.h"
+#include "boot_time.h"
 
 // BLE user defined configuration
 bleUserCfg_t user0Cfg = BLE_USER_CFG;
@@ -162,7 +167,8 @@ extern Display_Handle dispHandle;
  */
 int main()
   {
-    System_printf("Main started\n");
+    boot_time_init();
+    TRACE(TRACE_MAIN_STARTED);
 
 #if defined( USE_FPGA )
   HWREG(PRCM_BASE + PRCM_O_PDCTL0) &= ~PRCM_PDCTL0_RFC_ON;
@@ -174,6 +180,10 @@ int main()
 
   PIN_init(BoardGpioInitTable);
 
+  // Trace records taken so far are sent once its sink is open
+  trace_init();
+  latency_init();
+
 #ifdef CC1350_LAUNCHXL
   // Enable 2.4GHz Radio
   radCtrlHandle = PIN_open(&radCtrlState, radCtrlCfg);
@@ -204,10 +214,12 @@ int main()
   Power_setConstraint(PowerCC26XX_IDLE_PD_DISALLOW);
 #endif // POWER_SAVING | USE_FPGA
 
-  //Initialize the RSA part of the application
-  RSA_init();
+  // Start filling the entropy pool, the key itself is loaded once advertising
+  // started (SBP_KEY_INIT_EVT)
+  initialize_TRNG();
 
   init_LED_pins();
+  init_buttons();
 
   /* Initialize ICall module */
   ICall_init();
@@ -221,7 +233,11 @@ int main()
   /* The task for our application with priotiy 1 (Lowest) */
   SimpleBLEPeripheral_createTask();
 
-  System_printf("BIOS_start will be called\n");
+  /* Every task is there now, watch their stacks */
+  telemetry_init();
+
+  TRACE(TRACE_BIOS_START);
+  boot_time_mark(BOOT_BIOS_START);
 
   /* enable interrupts and start SYS/BIOS */
   BIOS_start();
@@ -0,0 +1,11 @@
+#ifndef HOST_BOARD_H_
+#define HOST_BOARD_H_
+
+// The driver instances and pins of the board, indexes the stand-ins ignore
+
+#define Board_CRYPTO0   0
+
+#define Board_PIN_BUTTON0   13
+#define Board_PIN_BUTTON1   14
+
+#endif /* HOST_BOARD_H_ */
@@ -0,0 +1,47 @@
+#ifndef HOST_BCOMDEF_H_
+#define HOST_BCOMDEF_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// What the application takes from the BLE stack's common definitions
+
+typedef uint8_t uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+typedef int8_t int8;
+typedef int16_t int16;
+typedef int32_t int32;
+typedef uint8_t bStatus_t;
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+#define VOID (void)
+
+#define SUCCESS                 0x00
+#define FAILURE                 0x01
+#define INVALIDPARAMETER        0x02
+#define MSG_BUFFER_NOT_AVAIL    0x04
+#define bleNotReady             0x10
+#define bleAlreadyInRequestedMode 0x11
+#define bleIncorrectMode        0x12
+#define bleMemAllocError        0x13
+#define bleNotConnected         0x14
+#define bleNoResources          0x15
+#define blePending              0x16
+#define bleTimeout              0x17
+#define bleInvalidRange         0x18
+
+#define INVALID_CONNHANDLE      0xFFFF
+
+// BLE_V41_FEATURES bits of build_config.opt
+#define L2CAP_COC_CFG           0x80
+
+#define BLE_NVID_CUST_START     0x80
+#define BLE_NVID_CUST_END       0x8F
+
+#endif /* HOST_BCOMDEF_H_ */
@@ -0,0 +1,7 @@
+#ifndef HOST_BOARD_LOWER_H_
+#define HOST_BOARD_LOWER_H_
+
+// The application includes the board file by this name
+#include "Board.h"
+
+#endif /* HOST_BOARD_LOWER_H_ */
@@ -0,0 +1,6 @@
+#ifndef HOST_DRIVERLIB_PRCM_H_
+#define HOST_DRIVERLIB_PRCM_H_
+
+// Nothing of it is used on the host, the Power stand-in has the dependencies
+
+#endif /* HOST_DRIVERLIB_PRCM_H_ */
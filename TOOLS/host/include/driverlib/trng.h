@@ -0,0 +1,18 @@
+#ifndef HOST_DRIVERLIB_TRNG_H_
+#define HOST_DRIVERLIB_TRNG_H_
+
+#include <stdint.h>
+
+// The TRNG, simulated in sim/trng.c
+
+#define TRNG_NUMBER_READY       0x00000001
+#define TRNG_FRO_SHUTDOWN       0x00000002
+
+void TRNGEnable();
+void TRNGDisable();
+uint32_t TRNGStatusGet();
+void TRNGIntEnable(uint32_t intFlags);
+void TRNGIntDisable(uint32_t intFlags);
+void TRNGIntClear(uint32_t intFlags);
+
+#endif /* HOST_DRIVERLIB_TRNG_H_ */
@@ -0,0 +1,44 @@
+#ifndef HOST_GATT_H_
+#define HOST_GATT_H_
+
+#include "bcomdef.h"
+
+// What the application takes from the stack's GATT and ATT interface, see sim/gatt.c
+
+#define ATT_MTU_SIZE            23
+
+#define ATT_READ_RSP            0x0B
+#define ATT_READ_BLOB_RSP       0x0D
+#define ATT_WRITE_RSP           0x13
+#define ATT_HANDLE_VALUE_NOTI   0x1B
+
+typedef struct attReadRsp {
+    uint16 len;
+    uint8 *pValue;
+} attReadRsp_t;
+
+typedef struct attHandleValueNoti {
+    uint16 handle;
+    uint16 len;
+    uint8 *pValue;
+} attHandleValueNoti_t;
+
+typedef union gattMsg {
+    attReadRsp_t readRsp;
+    attHandleValueNoti_t handleValueNoti;
+} gattMsg_t;
+
+typedef struct gattMsgEvent {
+    uint8 event;
+    uint8 status;
+    uint16 connHandle;
+    uint8 method;
+    gattMsg_t msg;
+} gattMsgEvent_t;
+
+void *GATT_bm_alloc(uint16 connHandle, uint8 opcode, uint16 size, uint16 *pSizeAlloc);
+void GATT_bm_free(gattMsg_t *pMsg, uint8 opcode);
+bStatus_t GATT_SendRsp(uint16 connHandle, uint8 method, gattMsg_t *pRsp);
+bStatus_t GATT_Notification(uint16 connHandle, attHandleValueNoti_t *pNoti, uint8 authenticated);
+
+#endif /* HOST_GATT_H_ */
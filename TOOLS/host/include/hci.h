@@ -0,0 +1,10 @@
+#ifndef HOST_HCI_H_
+#define HOST_HCI_H_
+
+#include "bcomdef.h"
+
+// What the application takes from the stack's HCI vendor commands, see sim/gatt.c
+
+bStatus_t HCI_EXT_ConnEventNoticeCmd(uint16 connHandle, uint8 taskID, uint16 taskEvent);
+
+#endif /* HOST_HCI_H_ */
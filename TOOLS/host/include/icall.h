@@ -0,0 +1,20 @@
+#ifndef HOST_ICALL_H_
+#define HOST_ICALL_H_
+
+#include <stdint.h>
+
+// The ICall heap, malloc() with counters and a failure switch, see sim/host.h
+
+void *ICall_malloc(uint_least16_t size);
+void ICall_free(void *msg);
+void ICall_freeMsg(void *msg);
+
+typedef struct ICall_heapStats_t {
+    uint32_t totalSize;
+    uint32_t totalFreeSize;
+    uint32_t largestFreeSize;
+} ICall_heapStats_t;
+
+void ICall_getHeapStats(ICall_heapStats_t *stats);
+
+#endif /* HOST_ICALL_H_ */
@@ -0,0 +1,8 @@
+#ifndef HOST_ICALL_APIMSG_H_
+#define HOST_ICALL_APIMSG_H_
+
+// The stack calls are plain functions on the host, there are no API messages
+
+#include "icall.h"
+
+#endif /* HOST_ICALL_APIMSG_H_ */
@@ -0,0 +1,9 @@
+#ifndef HOST_INC_HW_CPU_DWT_H_
+#define HOST_INC_HW_CPU_DWT_H_
+
+#define CPU_DWT_O_CTRL          0x00000000
+#define CPU_DWT_O_CYCCNT        0x00000004
+
+#define CPU_DWT_CTRL_CYCCNTENA  0x00000001
+
+#endif /* HOST_INC_HW_CPU_DWT_H_ */
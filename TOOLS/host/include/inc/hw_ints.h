@@ -0,0 +1,6 @@
+#ifndef HOST_INC_HW_INTS_H_
+#define HOST_INC_HW_INTS_H_
+
+#define INT_TRNG_IRQ            49
+
+#endif /* HOST_INC_HW_INTS_H_ */
@@ -0,0 +1,8 @@
+#ifndef HOST_INC_HW_MEMMAP_H_
+#define HOST_INC_HW_MEMMAP_H_
+
+#define TRNG_BASE               0x40028000
+#define CPU_DWT_BASE            0xE0001000
+#define CPU_SCS_BASE            0xE000E000
+
+#endif /* HOST_INC_HW_MEMMAP_H_ */
@@ -0,0 +1,15 @@
+#ifndef HOST_INC_HW_TRNG_H_
+#define HOST_INC_HW_TRNG_H_
+
+#define TRNG_O_OUT0             0x00000000
+#define TRNG_O_OUT1             0x00000004
+#define TRNG_O_IRQFLAGSTAT      0x00000008
+#define TRNG_O_IRQFLAGMASK      0x0000000C
+#define TRNG_O_IRQFLAGCLR       0x00000010
+#define TRNG_O_CTL              0x00000014
+#define TRNG_O_FROEN            0x00000020
+#define TRNG_O_FRODETUNE        0x00000024
+#define TRNG_O_ALARMMASK        0x00000028
+#define TRNG_O_ALARMSTOP        0x0000002C
+
+#endif /* HOST_INC_HW_TRNG_H_ */
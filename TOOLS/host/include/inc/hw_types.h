@@ -0,0 +1,14 @@
+#ifndef HOST_INC_HW_TYPES_H_
+#define HOST_INC_HW_TYPES_H_
+
+#include <stdint.h>
+
+/*
+ * Registers are words of a register file in sim/hwreg.c, a stand-in that models a
+ * peripheral (sim/trng.c) reads and writes the same words.
+ */
+volatile uint32_t *host_hwreg(uint32_t address);
+
+#define HWREG(x)        (*host_hwreg((uint32_t) (x)))
+
+#endif /* HOST_INC_HW_TYPES_H_ */
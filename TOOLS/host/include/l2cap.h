@@ -0,0 +1,105 @@
+#ifndef HOST_L2CAP_H_
+#define HOST_L2CAP_H_
+
+#include "bcomdef.h"
+
+// What the application takes from the stack's L2CAP interface, see sim/l2cap.c
+
+#define L2CAP_SIGNAL_EVENT              0xB0
+#define L2CAP_DATA_EVENT                0xB1
+
+#define L2CAP_CHANNEL_ESTABLISHED_EVT   0x60
+#define L2CAP_CHANNEL_TERMINATED_EVT    0x61
+#define L2CAP_OUT_OF_CREDIT_EVT         0x62
+#define L2CAP_PEER_CREDIT_THRESHOLD_EVT 0x63
+#define L2CAP_SEND_SDU_DONE_EVT         0x64
+
+#define L2CAP_CONN_SUCCESS              0x0000
+
+typedef struct l2capPacket {
+    uint16 CID;
+    uint8 *pPayload;
+    uint16 len;
+} l2capPacket_t;
+
+typedef struct l2capDataEvent {
+    uint8 event;
+    uint8 status;
+    uint16 connHandle;
+    l2capPacket_t pkt;
+} l2capDataEvent_t;
+
+typedef struct l2capCoCInfo {
+    uint16 psm;
+    uint16 mtu;
+    uint16 mps;
+    uint16 credits;
+    uint16 peerCID;
+    uint16 peerMtu;
+    uint16 peerMps;
+    uint16 peerCredits;
+    uint16 peerCreditThreshold;
+} l2capCoCInfo_t;
+
+typedef struct l2capChannelEstEvt {
+    uint16 result;
+    uint16 CID;
+    l2capCoCInfo_t info;
+} l2capChannelEstEvt_t;
+
+typedef struct l2capChannelTermEvt {
+    uint16 CID;
+    uint16 peerCID;
+    uint16 reason;
+} l2capChannelTermEvt_t;
+
+typedef struct l2capCreditEvt {
+    uint16 CID;
+    uint16 peerCID;
+    uint16 credits;
+} l2capCreditEvt_t;
+
+typedef struct l2capSendSduDoneEvt {
+    uint16 CID;
+    uint16 credits;
+    uint16 peerCID;
+    uint16 peerCredits;
+    uint16 totalLen;
+    uint16 txLen;
+} l2capSendSduDoneEvt_t;
+
+typedef union l2capSignalCmd {
+    l2capChannelEstEvt_t channelEstEvt;
+    l2capChannelTermEvt_t channelTermEvt;
+    l2capCreditEvt_t creditEvt;
+    l2capSendSduDoneEvt_t sendSduDoneEvt;
+} l2capSignalCmd_t;
+
+typedef struct l2capSignalEvent {
+    uint8 event;
+    uint8 status;
+    uint16 connHandle;
+    uint8 id;
+    uint8 opcode;
+    l2capSignalCmd_t cmd;
+} l2capSignalEvent_t;
+
+typedef uint16 (*pfnVerifySecCB_t)(uint16 connHandle, uint8 id, void *pReq);
+
+typedef struct l2capPsm {
+    uint16 psm;
+    uint16 mtu;
+    uint16 initPeerCredits;
+    uint16 peerCreditThreshold;
+    uint8 maxNumChannels;
+    pfnVerifySecCB_t pfnVerifySecCB;
+    uint8 taskId;
+} l2capPsm_t;
+
+bStatus_t L2CAP_RegisterPsm(l2capPsm_t *pPsm);
+bStatus_t L2CAP_FlowCtrlCredit(uint16 CID, uint16 peerCredits);
+bStatus_t L2CAP_DisconnectReq(uint16 CID);
+bStatus_t L2CAP_SendSDU(l2capPacket_t *pPkt);
+void *L2CAP_bm_alloc(uint16 size);
+
+#endif /* HOST_L2CAP_H_ */
@@ -0,0 +1,8 @@
+#ifndef HOST_OSAL_BUFMGR_H_
+#define HOST_OSAL_BUFMGR_H_
+
+// Stack buffers come from the ICall heap stand-in, see sim/l2cap.c
+
+void osal_bm_free(void *payload_ptr);
+
+#endif /* HOST_OSAL_BUFMGR_H_ */
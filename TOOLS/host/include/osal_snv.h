@@ -0,0 +1,16 @@
+#ifndef HOST_OSAL_SNV_H_
+#define HOST_OSAL_SNV_H_
+
+#include "bcomdef.h"
+
+// The stack's simple NV, items in a simulated flash page, see sim/snv.c
+
+#define NV_OPER_FAILED          0x0A
+
+typedef uint8 osalSnvId_t;
+typedef uint8 osalSnvLen_t;
+
+uint8 osal_snv_read(osalSnvId_t id, osalSnvLen_t len, void *pBuf);
+uint8 osal_snv_write(osalSnvId_t id, osalSnvLen_t len, void *pBuf);
+
+#endif /* HOST_OSAL_SNV_H_ */
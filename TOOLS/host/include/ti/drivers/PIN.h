@@ -0,0 +1,43 @@
+#ifndef HOST_TI_DRIVERS_PIN_H_
+#define HOST_TI_DRIVERS_PIN_H_
+
+#include <stdint.h>
+
+/*
+ * The PIN driver on simulated levels, host_pin_set() in sim/host.h changes one and
+ * runs the interrupt callback like the pin's edge interrupt would.
+ */
+
+typedef uint32_t PIN_Config;
+typedef uint32_t PIN_Id;
+
+#define PIN_ID(config)          ((config) & 0xFF)
+#define PIN_TERMINATE           0xFE
+#define PIN_UNASSIGNED          0xFF
+
+#define PIN_INPUT_EN            (1 << 8)
+#define PIN_PULLUP              (1 << 9)
+#define PIN_IRQ_NEGEDGE         (1 << 10)
+#define PIN_IRQ_POSEDGE         (1 << 11)
+#define PIN_IRQ_BOTHEDGES       (PIN_IRQ_NEGEDGE | PIN_IRQ_POSEDGE)
+#define PIN_GPIO_OUTPUT_EN      (1 << 12)
+#define PIN_GPIO_LOW            0
+#define PIN_GPIO_HIGH           (1 << 13)
+#define PIN_PUSHPULL            0
+#define PIN_DRVSTR_MAX          0
+
+struct PIN_State_s;
+typedef struct PIN_State_s *PIN_Handle;
+typedef void (*PIN_IntCb)(PIN_Handle handle, PIN_Id pinId);
+
+typedef struct PIN_State_s {
+    const PIN_Config *table;
+    PIN_IntCb intCb;
+} PIN_State;
+
+PIN_Handle PIN_open(PIN_State *state, const PIN_Config pinList[]);
+int PIN_registerIntCb(PIN_Handle handle, PIN_IntCb callbackFxn);
+unsigned int PIN_getInputValue(PIN_Id pinId);
+int PIN_setOutputValue(PIN_Handle handle, PIN_Id pinId, unsigned int val);
+
+#endif /* HOST_TI_DRIVERS_PIN_H_ */
@@ -0,0 +1,16 @@
+#ifndef HOST_TI_DRIVERS_POWER_H_
+#define HOST_TI_DRIVERS_POWER_H_
+
+// The power manager, counts what is set and released, see sim/power.c
+
+#define Power_SOK               0
+#define Power_EINVALIDINPUT     (-3)
+
+int Power_setDependency(unsigned int resourceId);
+int Power_releaseDependency(unsigned int resourceId);
+int Power_setConstraint(unsigned int constraintId);
+int Power_releaseConstraint(unsigned int constraintId);
+unsigned int Power_getConstraintMask();
+int Power_getDependencyCount(unsigned int resourceId);
+
+#endif /* HOST_TI_DRIVERS_POWER_H_ */
@@ -0,0 +1,99 @@
+#ifndef HOST_TI_DRIVERS_CRYPTO_CRYPTOCC26XX_H_
+#define HOST_TI_DRIVERS_CRYPTO_CRYPTOCC26XX_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// The crypto module driver, AES in software through OpenSSL, see sim/crypto.c
+
+#define CRYPTOCC26XX_STATUS_SUCCESS     0
+#define CRYPTOCC26XX_STATUS_ERROR       (-1)
+
+// driverlib/crypto.h, which the driver header includes
+#define AES_SUCCESS                     0
+#define AES_KEYSTORE_READ_ERROR         1
+#define AES_KEYSTORE_WRITE_ERROR        2
+#define AES_DMA_BUS_ERROR               3
+#define CCM_AUTHENTICATION_FAILED       4
+#define AES_ECB_TEST_ERROR              8
+#define AES_NULL_ERROR                  9
+#define AES_CCM_TEST_ERROR              10
+#define AES_DMA_BSY                     11
+
+typedef struct CryptoCC26XX_Config *CryptoCC26XX_Handle;
+
+typedef struct CryptoCC26XX_Params {
+    uint32_t timeout;
+} CryptoCC26XX_Params;
+
+typedef enum CryptoCC26XX_Mode {
+    CRYPTOCC26XX_MODE_BLOCKING,
+    CRYPTOCC26XX_MODE_POLLING
+} CryptoCC26XX_Mode;
+
+typedef enum CryptoCC26XX_Operation {
+    CRYPTOCC26XX_OP_AES_CCM_ENCRYPT,
+    CRYPTOCC26XX_OP_AES_CCM_ENCRYPT_AAD_ONLY,
+    CRYPTOCC26XX_OP_AES_CCM_DECRYPT,
+    CRYPTOCC26XX_OP_AES_CCM_DECRYPT_AAD_ONLY,
+    CRYPTOCC26XX_OP_AES_ECB_ENCRYPT,
+    CRYPTOCC26XX_OP_AES_ECB_DECRYPT,
+    CRYPTOCC26XX_OP_AES_CBC_ENCRYPT,
+    CRYPTOCC26XX_OP_AES_CBC_DECRYPT
+} CryptoCC26XX_Operation;
+
+typedef enum CryptoCC26XX_KeyLocation {
+    CRYPTOCC26XX_KEY_0 = 0,
+    CRYPTOCC26XX_KEY_1,
+    CRYPTOCC26XX_KEY_2,
+    CRYPTOCC26XX_KEY_3,
+    CRYPTOCC26XX_KEY_4,
+    CRYPTOCC26XX_KEY_5,
+    CRYPTOCC26XX_KEY_COUNT,
+    CRYPTOCC26XX_KEY_ANY
+} CryptoCC26XX_KeyLocation;
+
+typedef struct CryptoCC26XX_Transaction {
+    CryptoCC26XX_Operation opType;
+    CryptoCC26XX_Mode mode;
+    uint32_t data[8];
+} CryptoCC26XX_Transaction;
+
+typedef struct CryptoCC26XX_AESCCM_Transaction {
+    CryptoCC26XX_Operation opType;
+    CryptoCC26XX_Mode mode;
+    uint8_t keyIndex;
+    uint8_t authLength;
+    char *nonce;
+    char *msgIn;
+    char *header;
+    void *msgOut;
+    uint8_t fieldLength;
+    uint16_t msgInLength;
+    uint16_t headerLength;
+} CryptoCC26XX_AESCCM_Transaction;
+
+typedef struct CryptoCC26XX_AESECB_Transaction {
+    CryptoCC26XX_Operation opType;
+    CryptoCC26XX_Mode mode;
+    uint8_t keyIndex;
+    uint32_t *msgIn;
+    uint32_t *msgOut;
+} CryptoCC26XX_AESECB_Transaction;
+
+void CryptoCC26XX_init(void);
+void CryptoCC26XX_Params_init(CryptoCC26XX_Params *params);
+CryptoCC26XX_Handle CryptoCC26XX_open(unsigned int index, bool exclusiveAccess,
+                                      CryptoCC26XX_Params *params);
+int CryptoCC26XX_close(CryptoCC26XX_Handle handle);
+
+int CryptoCC26XX_allocateKey(CryptoCC26XX_Handle handle, CryptoCC26XX_KeyLocation keyLocation,
+                             const uint32_t *keySrc);
+int CryptoCC26XX_loadKey(CryptoCC26XX_Handle handle, int keyIndex, const uint32_t *keySrc);
+int CryptoCC26XX_releaseKey(CryptoCC26XX_Handle handle, int *keyIndex);
+
+void CryptoCC26XX_Transac_init(CryptoCC26XX_Transaction *trans, CryptoCC26XX_Operation opType);
+int CryptoCC26XX_transact(CryptoCC26XX_Handle handle, CryptoCC26XX_Transaction *trans);
+int CryptoCC26XX_transactPolling(CryptoCC26XX_Handle handle, CryptoCC26XX_Transaction *trans);
+
+#endif /* HOST_TI_DRIVERS_CRYPTO_CRYPTOCC26XX_H_ */
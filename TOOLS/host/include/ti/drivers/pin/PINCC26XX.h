@@ -0,0 +1,7 @@
+#ifndef HOST_TI_DRIVERS_PIN_PINCC26XX_H_
+#define HOST_TI_DRIVERS_PIN_PINCC26XX_H_
+
+// The device specific part of the PIN driver, nothing the stand-in needs
+#include <ti/drivers/PIN.h>
+
+#endif /* HOST_TI_DRIVERS_PIN_PINCC26XX_H_ */
@@ -0,0 +1,15 @@
+#ifndef HOST_TI_DRIVERS_POWER_POWERCC26XX_H_
+#define HOST_TI_DRIVERS_POWER_POWERCC26XX_H_
+
+#include <ti/drivers/Power.h>
+
+#define PowerCC26XX_PERIPH_CRYPTO       5
+#define PowerCC26XX_PERIPH_TRNG         7
+#define PowerCC26XX_NUMRESOURCES        32
+
+#define PowerCC26XX_SB_DISALLOW         1
+#define PowerCC26XX_IDLE_PD_DISALLOW    2
+#define PowerCC26XX_SD_DISALLOW         3
+#define PowerCC26XX_NUMCONSTRAINTS      8
+
+#endif /* HOST_TI_DRIVERS_POWER_POWERCC26XX_H_ */
@@ -0,0 +1,9 @@
+#ifndef HOST_TI_SYSBIOS_BIOS_H_
+#define HOST_TI_SYSBIOS_BIOS_H_
+
+#include <xdc/std.h>
+
+#define BIOS_WAIT_FOREVER (~((UInt32) 0))
+#define BIOS_NO_WAIT      ((UInt32) 0)
+
+#endif /* HOST_TI_SYSBIOS_BIOS_H_ */
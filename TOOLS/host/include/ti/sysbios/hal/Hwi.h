@@ -0,0 +1,40 @@
+#ifndef HOST_TI_SYSBIOS_HAL_HWI_H_
+#define HOST_TI_SYSBIOS_HAL_HWI_H_
+
+#include <xdc/std.h>
+
+/*
+ * Disabling the interrupts takes one lock shared with Task_disable() and
+ * Swi_disable(), so tests can run "interrupts" on threads of their own
+ */
+UInt Hwi_disable();
+void Hwi_restore(UInt key);
+UInt Hwi_enableInterrupt(UInt intNum);
+UInt Hwi_disableInterrupt(UInt intNum);
+
+typedef void (*Hwi_FuncPtr)(UArg arg);
+
+typedef struct Hwi_Params {
+    UArg arg;
+    Int priority;
+} Hwi_Params;
+
+typedef struct Hwi_Struct {
+    Int intNum;
+    Hwi_FuncPtr fxn;
+    UArg arg;
+} Hwi_Struct;
+
+typedef Hwi_Struct *Hwi_Handle;
+
+typedef struct Hwi_StackInfo {
+    SizeT hwiStackPeak;
+    SizeT hwiStackSize;
+    Ptr hwiStackBase;
+} Hwi_StackInfo;
+
+void Hwi_Params_init(Hwi_Params *params);
+void Hwi_construct(Hwi_Struct *hwi, Int intNum, Hwi_FuncPtr fxn, const Hwi_Params *params, void *eb);
+Bool Hwi_getStackInfo(Hwi_StackInfo *info, Bool computeStackDepth);
+
+#endif /* HOST_TI_SYSBIOS_HAL_HWI_H_ */
@@ -0,0 +1,46 @@
+#ifndef HOST_TI_SYSBIOS_KNL_CLOCK_H_
+#define HOST_TI_SYSBIOS_KNL_CLOCK_H_
+
+#include <xdc/std.h>
+
+/*
+ * The Clock runs on host_advance(), see sim/host.h. Clock functions are called
+ * from there, as from the Clock Swi on the device.
+ */
+
+typedef void (*Clock_FuncPtr)(UArg arg);
+
+typedef struct Clock_Params {
+    UInt32 period;
+    Bool startFlag;
+    UArg arg;
+} Clock_Params;
+
+typedef struct Clock_Struct {
+    Clock_FuncPtr fxn;
+    UArg arg;
+    UInt32 timeout;
+    UInt32 period;
+    UInt32 due;
+    bool isActive;
+    struct Clock_Struct *next;
+} Clock_Struct;
+
+typedef Clock_Struct *Clock_Handle;
+
+// Microseconds per tick
+extern UInt32 Clock_tickPeriod;
+
+UInt32 Clock_getTicks();
+void Clock_Params_init(Clock_Params *params);
+void Clock_construct(Clock_Struct *clock, Clock_FuncPtr fxn, UInt32 timeout, const Clock_Params *params);
+void Clock_destruct(Clock_Struct *clock);
+Clock_Handle Clock_handle(Clock_Struct *clock);
+void Clock_start(Clock_Handle clock);
+void Clock_stop(Clock_Handle clock);
+void Clock_setTimeout(Clock_Handle clock, UInt32 timeout);
+void Clock_setPeriod(Clock_Handle clock, UInt32 period);
+UInt32 Clock_getTimeout(Clock_Handle clock);
+Bool Clock_isActive(Clock_Handle clock);
+
+#endif /* HOST_TI_SYSBIOS_KNL_CLOCK_H_ */
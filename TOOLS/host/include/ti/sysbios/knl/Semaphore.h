@@ -0,0 +1,35 @@
+#ifndef HOST_TI_SYSBIOS_KNL_SEMAPHORE_H_
+#define HOST_TI_SYSBIOS_KNL_SEMAPHORE_H_
+
+#include <xdc/std.h>
+
+typedef enum Semaphore_Mode {
+    Semaphore_Mode_COUNTING = 0,
+    Semaphore_Mode_BINARY
+} Semaphore_Mode;
+
+typedef struct Semaphore_Params {
+    Semaphore_Mode mode;
+} Semaphore_Params;
+
+typedef struct Semaphore_Struct {
+    Semaphore_Mode mode;
+    Int count;
+} Semaphore_Struct;
+
+typedef Semaphore_Struct *Semaphore_Handle;
+
+void Semaphore_Params_init(Semaphore_Params *params);
+void Semaphore_construct(Semaphore_Struct *sem, Int count, const Semaphore_Params *params);
+Semaphore_Handle Semaphore_create(Int count, const Semaphore_Params *params, void *eb);
+Semaphore_Handle Semaphore_handle(Semaphore_Struct *sem);
+void Semaphore_post(Semaphore_Handle sem);
+
+/*
+ * Nothing else runs on the host while a task waits, so a pend lets the Clock run
+ * until the semaphore is posted or the timeout passed
+ */
+Bool Semaphore_pend(Semaphore_Handle sem, UInt32 timeout);
+Int Semaphore_getCount(Semaphore_Handle sem);
+
+#endif /* HOST_TI_SYSBIOS_KNL_SEMAPHORE_H_ */
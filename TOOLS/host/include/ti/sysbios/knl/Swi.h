@@ -0,0 +1,9 @@
+#ifndef HOST_TI_SYSBIOS_KNL_SWI_H_
+#define HOST_TI_SYSBIOS_KNL_SWI_H_
+
+#include <xdc/std.h>
+
+UInt Swi_disable();
+void Swi_restore(UInt key);
+
+#endif /* HOST_TI_SYSBIOS_KNL_SWI_H_ */
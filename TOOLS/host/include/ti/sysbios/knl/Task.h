@@ -0,0 +1,50 @@
+#ifndef HOST_TI_SYSBIOS_KNL_TASK_H_
+#define HOST_TI_SYSBIOS_KNL_TASK_H_
+
+#include <xdc/std.h>
+
+typedef void (*Task_FuncPtr)(UArg arg0, UArg arg1);
+
+typedef struct Task_Params {
+    Ptr stack;
+    SizeT stackSize;
+    Int priority;
+    UArg arg0;
+    UArg arg1;
+} Task_Params;
+
+typedef struct Task_Struct {
+    Task_FuncPtr fxn;
+    Task_Params params;
+    struct Task_Struct *next;
+} Task_Struct;
+
+typedef Task_Struct *Task_Handle;
+
+typedef struct Task_Stat {
+    Int priority;
+    Ptr stack;
+    SizeT stackSize;
+    SizeT used;
+    Int mode;
+    Ptr sp;
+} Task_Stat;
+
+UInt Task_disable();
+void Task_restore(UInt key);
+
+// Runs the Clock, a task that sleeps lets the time pass
+void Task_sleep(UInt32 ticks);
+void Task_yield();
+
+void Task_Params_init(Task_Params *params);
+void Task_construct(Task_Struct *task, Task_FuncPtr fxn, const Task_Params *params, void *eb);
+Task_Handle Task_handle(Task_Struct *task);
+Task_Handle Task_self();
+void Task_stat(Task_Handle task, Task_Stat *stat);
+Task_Handle Task_Object_first();
+Task_Handle Task_Object_next(Task_Handle task);
+Int Task_Object_count();
+Task_Handle Task_Object_get(void *objects, Int i);
+
+#endif /* HOST_TI_SYSBIOS_KNL_TASK_H_ */
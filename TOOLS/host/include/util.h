@@ -0,0 +1,17 @@
+#ifndef HOST_UTIL_H_
+#define HOST_UTIL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <ti/sysbios/knl/Clock.h>
+
+// The clock helpers of the BLE SDK's util.c, durations in milliseconds
+
+Clock_Handle Util_constructClock(Clock_Struct *pClock, Clock_FuncPtr clockCB, uint32_t clockDuration,
+                                 uint32_t clockPeriod, uint8_t startFlag, UArg arg);
+void Util_startClock(Clock_Struct *pClock);
+void Util_restartClock(Clock_Struct *pClock, uint32_t clockTimeout);
+bool Util_isActive(Clock_Struct *pClock);
+void Util_stopClock(Clock_Struct *pClock);
+
+#endif /* HOST_UTIL_H_ */
@@ -0,0 +1,8 @@
+#ifndef HOST_XDC_RUNTIME_ERROR_H_
+#define HOST_XDC_RUNTIME_ERROR_H_
+
+typedef struct Error_Block {
+    int id;
+} Error_Block;
+
+#endif /* HOST_XDC_RUNTIME_ERROR_H_ */
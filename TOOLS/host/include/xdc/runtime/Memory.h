@@ -0,0 +1,15 @@
+#ifndef HOST_XDC_RUNTIME_MEMORY_H_
+#define HOST_XDC_RUNTIME_MEMORY_H_
+
+#include <xdc/std.h>
+
+typedef struct Memory_Stats {
+    SizeT totalSize;
+    SizeT totalFreeSize;
+    SizeT largestFreeSize;
+} Memory_Stats;
+
+// There is no BIOS heap here, it reads as empty
+void Memory_getStats(Ptr heap, Memory_Stats *stats);
+
+#endif /* HOST_XDC_RUNTIME_MEMORY_H_ */
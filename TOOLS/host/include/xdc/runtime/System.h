@@ -0,0 +1,11 @@
+#ifndef HOST_XDC_RUNTIME_SYSTEM_H_
+#define HOST_XDC_RUNTIME_SYSTEM_H_
+
+#include <xdc/std.h>
+
+// Prints and exits, the tests see an abort as a failure
+void System_abort(const char *msg);
+Int System_printf(const char *fmt, ...);
+void System_flush();
+
+#endif /* HOST_XDC_RUNTIME_SYSTEM_H_ */
@@ -0,0 +1,36 @@
+#ifndef HOST_XDC_STD_H_
+#define HOST_XDC_STD_H_
+
+// The XDC base types, sized as on the Cortex-M3
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef char            Char;
+typedef unsigned char   UChar;
+typedef short           Short;
+typedef unsigned short  UShort;
+typedef int             Int;
+typedef unsigned int    UInt;
+typedef long            Long;
+typedef unsigned long   ULong;
+typedef int8_t          Int8;
+typedef int16_t         Int16;
+typedef int32_t         Int32;
+typedef uint8_t         UInt8;
+typedef uint16_t        UInt16;
+typedef uint32_t        UInt32;
+typedef uint64_t        UInt64;
+typedef size_t          SizeT;
+typedef uintptr_t       UArg;
+typedef unsigned short  Bool;
+typedef void           *Ptr;
+typedef void          (*Fxn)();
+
+#ifndef TRUE
+#define TRUE  1
+#define FALSE 0
+#endif
+
+#endif /* HOST_XDC_STD_H_ */
@@ -0,0 +1,31 @@
+#ifndef HOST_SIM_CONFIG_OID_FULL_H_
+#define HOST_SIM_CONFIG_OID_FULL_H_
+
+/*
+ * The shipped configuration with everything oid.c has rows for, for test_oid_full.
+ * Only the tables are built from it, none of the code these switch on.
+ */
+#include "mbedtls/config.h"
+
+#define MBEDTLS_MD2_C
+#define MBEDTLS_MD4_C
+#define MBEDTLS_MD5_C
+#define MBEDTLS_SHA1_C
+#define MBEDTLS_SHA512_C
+#define MBEDTLS_ECP_C
+#define MBEDTLS_ECDSA_C
+#define MBEDTLS_ECP_DP_SECP192R1_ENABLED
+#define MBEDTLS_ECP_DP_SECP224R1_ENABLED
+#define MBEDTLS_ECP_DP_SECP256R1_ENABLED
+#define MBEDTLS_ECP_DP_SECP384R1_ENABLED
+#define MBEDTLS_ECP_DP_SECP521R1_ENABLED
+#define MBEDTLS_ECP_DP_SECP192K1_ENABLED
+#define MBEDTLS_ECP_DP_SECP224K1_ENABLED
+#define MBEDTLS_ECP_DP_SECP256K1_ENABLED
+#define MBEDTLS_ECP_DP_BP256R1_ENABLED
+#define MBEDTLS_ECP_DP_BP384R1_ENABLED
+#define MBEDTLS_ECP_DP_BP512R1_ENABLED
+#define MBEDTLS_X509_USE_C
+#define MBEDTLS_X509_CREATE_C
+
+#endif /* HOST_SIM_CONFIG_OID_FULL_H_ */
@@ -0,0 +1,167 @@
+#include "host.h"
+
+#include <string.h>
+#include <openssl/evp.h>
+#include <ti/drivers/crypto/CryptoCC26XX.h>
+
+#include "mbedtls/cipher_internal.h"
+
+/*
+ * Crypto module stand-in. The key RAM entries and the transactions behave like the
+ * driver's, the AES itself is OpenSSL's, so whatever a host test times here is the
+ * cost of the code around the engine, not of the engine.
+ */
+
+struct CryptoCC26XX_Config {
+    int isOpen;
+};
+
+static struct CryptoCC26XX_Config engine;
+
+static struct {
+    bool isUsed;
+    uint8_t key[16];
+} keyRam[CRYPTOCC26XX_KEY_COUNT];
+
+long host_crypto_jobs = 0;
+bool host_ccm_fail = false;
+
+void CryptoCC26XX_init(void) {
+}
+
+void CryptoCC26XX_Params_init(CryptoCC26XX_Params *params) {
+    params->timeout = 0;
+}
+
+CryptoCC26XX_Handle CryptoCC26XX_open(unsigned int index, bool exclusiveAccess,
+                                      CryptoCC26XX_Params *params) {
+    engine.isOpen++;
+    return &engine;
+}
+
+int CryptoCC26XX_close(CryptoCC26XX_Handle handle) {
+    handle->isOpen--;
+    return CRYPTOCC26XX_STATUS_SUCCESS;
+}
+
+int CryptoCC26XX_allocateKey(CryptoCC26XX_Handle handle, CryptoCC26XX_KeyLocation keyLocation,
+                             const uint32_t *keySrc) {
+    int i;
+
+    for (i = 0; i < CRYPTOCC26XX_KEY_COUNT; i++) {
+        if ((!keyRam[i].isUsed) && ((keyLocation == CRYPTOCC26XX_KEY_ANY) || (keyLocation == i))) {
+            keyRam[i].isUsed = true;
+            memcpy(keyRam[i].key, keySrc, 16);
+            return i;
+        }
+    }
+    return CRYPTOCC26XX_STATUS_ERROR;
+}
+
+int CryptoCC26XX_loadKey(CryptoCC26XX_Handle handle, int keyIndex, const uint32_t *keySrc) {
+    if ((keyIndex < 0) || (keyIndex >= CRYPTOCC26XX_KEY_COUNT) || (!keyRam[keyIndex].isUsed)) {
+        return CRYPTOCC26XX_STATUS_ERROR;
+    }
+    memcpy(keyRam[keyIndex].key, keySrc, 16);
+    return CRYPTOCC26XX_STATUS_SUCCESS;
+}
+
+int CryptoCC26XX_releaseKey(CryptoCC26XX_Handle handle, int *keyIndex) {
+    if ((*keyIndex < 0) || (*keyIndex >= CRYPTOCC26XX_KEY_COUNT)) {
+        return CRYPTOCC26XX_STATUS_ERROR;
+    }
+    memset(&keyRam[*keyIndex], 0, sizeof(keyRam[0]));
+    *keyIndex = CRYPTOCC26XX_STATUS_ERROR;
+    return CRYPTOCC26XX_STATUS_SUCCESS;
+}
+
+void CryptoCC26XX_Transac_init(CryptoCC26XX_Transaction *trans, CryptoCC26XX_Operation opType) {
+    // Only the common head, the transactions are shorter than CryptoCC26XX_Transaction
+    trans->opType = opType;
+    trans->mode = CRYPTOCC26XX_MODE_BLOCKING;
+}
+
+static int ecb(CryptoCC26XX_AESECB_Transaction *trans) {
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    int encrypt = (trans->opType == CRYPTOCC26XX_OP_AES_ECB_ENCRYPT);
+    int len;
+    int ok;
+
+    ok = EVP_CipherInit_ex(ctx, EVP_aes_128_ecb(), NULL, keyRam[trans->keyIndex].key, NULL, encrypt) &&
+         EVP_CIPHER_CTX_set_padding(ctx, 0) &&
+         EVP_CipherUpdate(ctx, (uint8_t *) trans->msgOut, &len, (uint8_t *) trans->msgIn, 16);
+    EVP_CIPHER_CTX_free(ctx);
+    return ok ? CRYPTOCC26XX_STATUS_SUCCESS : CRYPTOCC26XX_STATUS_ERROR;
+}
+
+// In place like the engine, the tag follows the ciphertext when decrypting
+static int ccm(CryptoCC26XX_AESCCM_Transaction *trans) {
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    int decrypt = (trans->opType == CRYPTOCC26XX_OP_AES_CCM_DECRYPT);
+    int msgLen = trans->msgInLength - (decrypt ? trans->authLength : 0);
+    uint8_t *msg = (uint8_t *) trans->msgIn;
+    uint8_t none[16];
+    int len;
+    int ok;
+
+    ok = EVP_CipherInit_ex(ctx, EVP_aes_128_ccm(), NULL, NULL, NULL, !decrypt) &&
+         EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_CCM_SET_IVLEN, 15 - trans->fieldLength, NULL) &&
+         EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_CCM_SET_TAG, trans->authLength,
+                             decrypt ? msg + msgLen : NULL) &&
+         EVP_CipherInit_ex(ctx, NULL, NULL, keyRam[trans->keyIndex].key,
+                           (uint8_t *) trans->nonce, !decrypt) &&
+         EVP_CipherUpdate(ctx, NULL, &len, NULL, msgLen);
+    if (ok && (trans->headerLength > 0)) {
+        ok = EVP_CipherUpdate(ctx, NULL, &len, (uint8_t *) trans->header, trans->headerLength);
+    }
+    if (ok) {
+        // Fails on a tag mismatch
+        ok = EVP_CipherUpdate(ctx, msg, &len, msg, msgLen);
+    }
+    if (ok && !decrypt) {
+        ok = EVP_CipherFinal_ex(ctx, none, &len) &&
+             EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_CCM_GET_TAG, trans->authLength, trans->msgOut);
+    }
+    EVP_CIPHER_CTX_free(ctx);
+    return ok ? CRYPTOCC26XX_STATUS_SUCCESS : CRYPTOCC26XX_STATUS_ERROR;
+}
+
+int CryptoCC26XX_transactPolling(CryptoCC26XX_Handle handle, CryptoCC26XX_Transaction *trans) {
+    uint8_t keyIndex = ((CryptoCC26XX_AESECB_Transaction *) trans)->keyIndex;
+
+    __atomic_add_fetch(&host_crypto_jobs, 1, __ATOMIC_RELAXED);
+    if ((!handle->isOpen) || (keyIndex >= CRYPTOCC26XX_KEY_COUNT) ||
+        (!keyRam[keyIndex].isUsed)) {
+        return CRYPTOCC26XX_STATUS_ERROR;
+    }
+
+    switch (trans->opType) {
+    case CRYPTOCC26XX_OP_AES_ECB_ENCRYPT:
+    case CRYPTOCC26XX_OP_AES_ECB_DECRYPT:
+        return ecb((CryptoCC26XX_AESECB_Transaction *) trans);
+
+    case CRYPTOCC26XX_OP_AES_CCM_ENCRYPT:
+    case CRYPTOCC26XX_OP_AES_CCM_DECRYPT:
+        if (host_ccm_fail) {
+            return CRYPTOCC26XX_STATUS_ERROR;
+        }
+        return ccm((CryptoCC26XX_AESCCM_Transaction *) trans);
+
+    default:
+        return CRYPTOCC26XX_STATUS_ERROR;
+    }
+}
+
+int CryptoCC26XX_transact(CryptoCC26XX_Handle handle, CryptoCC26XX_Transaction *trans) {
+    return CryptoCC26XX_transactPolling(handle, trans);
+}
+
+/*
+ * cipher_wrap.c is not part of the application, the device build never reaches the
+ * cipher layer with the unencrypted key. An empty table lets pkcs12.c link.
+ */
+const mbedtls_cipher_definition_t mbedtls_cipher_definitions[] = {
+    { MBEDTLS_CIPHER_NONE, NULL }
+};
+
+int mbedtls_cipher_supported[] = { MBEDTLS_CIPHER_NONE };
@@ -0,0 +1,72 @@
+#include "host.h"
+
+#include <string.h>
+
+#include "gatt.h"
+#include "hci.h"
+#include "icall.h"
+
+/*
+ * GATT and HCI stand-in. Message payloads come from the ICall heap like on the device,
+ * so a test sees one that leaked. A send takes one of host_gatt_buffers, with none left
+ * it fails the way the stack does, blePending for a response and MSG_BUFFER_NOT_AVAIL
+ * for a notification, and the caller keeps the payload. Once sent the payload is freed.
+ */
+
+#define LINKS 16
+
+int host_gatt_buffers = 1000;
+void (*host_gatt_sent)(uint16_t connHandle, uint8_t method, uint16_t handle,
+                       const uint8_t *pValue, uint16_t len) = NULL;
+
+static bool notice[LINKS];
+
+void *GATT_bm_alloc(uint16 connHandle, uint8 opcode, uint16 size, uint16 *pSizeAlloc) {
+    if (pSizeAlloc) {
+        *pSizeAlloc = size;
+    }
+    return ICall_malloc(size ? size : 1);
+}
+
+void GATT_bm_free(gattMsg_t *pMsg, uint8 opcode) {
+    if (opcode == ATT_HANDLE_VALUE_NOTI) {
+        ICall_free(pMsg->handleValueNoti.pValue);
+        pMsg->handleValueNoti.pValue = NULL;
+    }
+    else {
+        ICall_free(pMsg->readRsp.pValue);
+        pMsg->readRsp.pValue = NULL;
+    }
+}
+
+static bStatus_t take(uint16 connHandle, uint8 method, uint16 handle, uint8 *pValue, uint16 len) {
+    if (host_gatt_buffers <= 0) {
+        return (method == ATT_HANDLE_VALUE_NOTI) ? MSG_BUFFER_NOT_AVAIL : blePending;
+    }
+    host_gatt_buffers--;
+    if (host_gatt_sent) {
+        host_gatt_sent(connHandle, method, handle, pValue, len);
+    }
+    ICall_free(pValue);
+    return SUCCESS;
+}
+
+bStatus_t GATT_SendRsp(uint16 connHandle, uint8 method, gattMsg_t *pRsp) {
+    return take(connHandle, method, 0, pRsp->readRsp.pValue, pRsp->readRsp.len);
+}
+
+bStatus_t GATT_Notification(uint16 connHandle, attHandleValueNoti_t *pNoti, uint8 authenticated) {
+    return take(connHandle, ATT_HANDLE_VALUE_NOTI, pNoti->handle, pNoti->pValue, pNoti->len);
+}
+
+bStatus_t HCI_EXT_ConnEventNoticeCmd(uint16 connHandle, uint8 taskID, uint16 taskEvent) {
+    if (connHandle >= LINKS) {
+        return bleNotConnected;
+    }
+    notice[connHandle] = (taskEvent != 0);
+    return SUCCESS;
+}
+
+bool host_conn_event_notice(uint16_t connHandle) {
+    return (connHandle < LINKS) && notice[connHandle];
+}
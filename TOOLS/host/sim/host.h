@@ -0,0 +1,150 @@
+#ifndef HOST_SIM_HOST_H_
+#define HOST_SIM_HOST_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/*
+ * Control of the TI-RTOS and driver stand-ins, and the checks the tests report with.
+ *
+ * Time only passes when a test says so: host_advance() moves the Clock on tick by tick
+ * and calls the Clock functions that come due, Task_sleep() and a Semaphore_pend()
+ * that has to wait do the same. The interrupt, Swi and Task locks are one recursive
+ * mutex, so a test can run callbacks on threads of its own and the locks hold.
+ */
+
+// Ticks since the start
+uint32_t host_ticks();
+
+// Lets ticks pass, the Clock functions due in that time run in order
+void host_advance(uint32_t ticks);
+
+// Nanoseconds of a monotonic clock, what the benchmarks time with
+uint64_t host_ns();
+
+// Bytes ICall_malloc() has out right now, and makes the next calls fail while set
+extern long host_icall_in_use;
+extern bool host_icall_fail;
+
+// Jobs the crypto module ran, and makes the next CCM jobs fail while set
+extern long host_crypto_jobs;
+extern bool host_ccm_fail;
+
+// Runs the Hwi constructed for intNum, if there is one and the interrupt is enabled
+void host_interrupt(int intNum);
+
+// The TRNG stand-in: ticks from an acknowledge to the next number, numbers made so far,
+// and a source that repeats its first number or makes none at all while set
+extern uint32_t host_trng_period;
+extern long host_trng_numbers;
+extern bool host_trng_stuck;
+extern bool host_trng_dead;
+
+// The n-th number the TRNG makes, OUT0 is its low word
+uint64_t host_trng_number(long n);
+
+// True while the TRNG is enabled
+bool host_trng_enabled();
+
+// Shuts the given FROs down and raises the FRO shutdown flag
+void host_trng_fro_alarm(uint32_t fros);
+
+// The simple NV stand-in: item writes, page compactions and bytes programmed so far,
+// counted across the processes a test forks
+typedef struct host_snv_stats {
+    long writes;
+    long erases;
+    long programmed;
+} host_snv_stats_t;
+
+host_snv_stats_t host_snv_stats();
+
+// Makes the next SNV writes fail while set
+extern bool host_snv_fail;
+
+// Forgets every item and the counts, like a full chip erase
+void host_snv_erase();
+
+// Flips a bit of a stored item
+void host_snv_corrupt(uint8_t id, int offset);
+
+// The GATT and HCI stand-ins: HCI buffers left for ATT messages, a send finds none
+// once they are used up, and a function that sees every message the stack took
+extern int host_gatt_buffers;
+extern void (*host_gatt_sent)(uint16_t connHandle, uint8_t method, uint16_t handle,
+                              const uint8_t *pValue, uint16_t len);
+
+// True while the link reports the end of its connection events
+bool host_conn_event_notice(uint16_t connHandle);
+
+// The L2CAP stand-in: SDU buffers left, L2CAP_SendSDU() answers blePending while
+// host_l2cap_pending is set, a function that sees every SDU the stack took, and the
+// credits given to the peers
+extern int host_l2cap_buffers;
+extern bool host_l2cap_pending;
+extern void (*host_l2cap_sent)(uint16_t CID, const uint8_t *pData, uint16_t len);
+extern long host_l2cap_credits;
+
+// The PIN stand-in: sets the level of a pin, a change runs the interrupt callback of
+// the handle that opened it with an edge interrupt. Pins are high until set.
+void host_pin_set(uint32_t pin, bool level);
+
+// Every Power_set*() and Power_release*() in order, with the holders after it
+typedef struct host_power_event {
+    uint32_t tick;
+    bool isConstraint;
+    bool isSet;
+    uint8_t id;
+    int count;
+} host_power_event_t;
+
+// Events kept since host_power_clear(), later ones are only counted
+#define HOST_POWER_EVENTS 512
+
+// The timeline in events, returns how many happened. Printed as it happens while set.
+long host_power_timeline(const host_power_event_t **events);
+void host_power_clear();
+extern FILE *host_power_log;
+
+// The core ran this many cycles, the DWT cycle counter counts them if it is enabled.
+// With host_dwt_realtime set it also counts the host's own time, at the device's clock.
+#define HOST_CPU_MHZ 48
+void host_cpu_cycles(uint32_t cycles);
+extern bool host_dwt_realtime;
+
+// How deep the interrupt lock is held by the calling thread
+int host_lock_depth();
+
+extern int host_failures;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            host_failures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(a, b) \
+    do { \
+        long long _a = (long long) (a); \
+        long long _b = (long long) (b); \
+        if (_a != _b) { \
+            fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed, %lld != %lld\n", \
+                    __FILE__, __LINE__, #a, #b, _a, _b); \
+            host_failures++; \
+        } \
+    } while (0)
+
+/*
+ * Exit code of a test, prints the verdict
+ */
+int host_report(const char *name);
+
+/*
+ * True if the program was started with --bench, the benchmarks only run then
+ */
+bool host_bench(int argc, char **argv);
+
+#endif /* HOST_SIM_HOST_H_ */
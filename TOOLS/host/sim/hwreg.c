@@ -0,0 +1,83 @@
+#include "host.h"
+
+#include <xdc/runtime/System.h>
+#include <inc/hw_types.h>
+#include <inc/hw_memmap.h>
+#include <inc/hw_cpu_dwt.h>
+#include <inc/hw_cpu_scs.h>
+
+/*
+ * Register file behind HWREG(). A register is a plain word that reads back what was
+ * last written, from the test or a peripheral stand-in, and starts out as 0.
+ *
+ * The DWT cycle counter is the one register with a model of its own. It counts the
+ * cycles host_cpu_cycles() says the core ran, and with host_dwt_realtime the host's
+ * own time at HOST_CPU_MHZ, but only while DEMCR.TRCENA and DWT_CTRL.CYCCNTENA are
+ * both set, as on the device, where a debugger that lets go clears TRCENA.
+ */
+
+#define HOST_HWREG_COUNT 64
+
+static struct {
+    uint32_t address;
+    volatile uint32_t value;
+} regs[HOST_HWREG_COUNT];
+static int regCount = 0;
+
+bool host_dwt_realtime = false;
+static uint32_t pendingCycles = 0;
+static uint64_t lastNs = 0;
+static uint64_t countedNs = 0;
+static uint64_t countedCycles = 0;
+
+static volatile uint32_t *find_reg(uint32_t address) {
+    int i;
+
+    for (i = 0; i < regCount; i++) {
+        if (regs[i].address == address) {
+            return &regs[i].value;
+        }
+    }
+    if (regCount == HOST_HWREG_COUNT) {
+        System_abort("host_hwreg() ran out of registers");
+    }
+    regs[regCount].address = address;
+    regs[regCount].value = 0;
+    return &regs[regCount++].value;
+}
+
+static bool is_counting() {
+    return (*find_reg(CPU_SCS_BASE + CPU_SCS_O_DEMCR) & CPU_SCS_DEMCR_TRCENA) &&
+           (*find_reg(CPU_DWT_BASE + CPU_DWT_O_CTRL) & CPU_DWT_CTRL_CYCCNTENA);
+}
+
+// Brings the counter up to date before it is read or written
+static void update_cyccnt(volatile uint32_t *cyccnt) {
+    uint64_t now = host_ns();
+    uint64_t cycles;
+
+    if (is_counting()) {
+        *cyccnt += pendingCycles;
+        if (host_dwt_realtime && lastNs) {
+            countedNs += now - lastNs;
+            cycles = countedNs * HOST_CPU_MHZ / 1000;
+            *cyccnt += (uint32_t) (cycles - countedCycles);
+            countedCycles = cycles;
+        }
+    }
+    pendingCycles = 0;
+    lastNs = now;
+}
+
+void host_cpu_cycles(uint32_t cycles) {
+    pendingCycles += cycles;
+}
+
+volatile uint32_t *host_hwreg(uint32_t address) {
+    volatile uint32_t *reg = find_reg(address);
+
+    if (address == CPU_DWT_BASE + CPU_DWT_O_CYCCNT) {
+        update_cyccnt(reg);
+    }
+    return reg;
+}
@@ -0,0 +1,48 @@
+#include "host.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "icall.h"
+
+/*
+ * ICall heap stand-in. Every block carries its size in front, so the bytes out are
+ * known and a test can check nothing leaked.
+ */
+
+long host_icall_in_use = 0;
+bool host_icall_fail = false;
+
+void *ICall_malloc(uint_least16_t size) {
+    size_t *block;
+
+    if (host_icall_fail) {
+        return NULL;
+    }
+    block = malloc(sizeof(size_t) + size);
+    if (!block) {
+        return NULL;
+    }
+    block[0] = size;
+    __atomic_add_fetch(&host_icall_in_use, (long) size, __ATOMIC_RELAXED);
+    return &block[1];
+}
+
+void ICall_free(void *msg) {
+    size_t *block = msg;
+
+    if (!block) {
+        return;
+    }
+    block--;
+    __atomic_sub_fetch(&host_icall_in_use, (long) block[0], __ATOMIC_RELAXED);
+    free(block);
+}
+
+void ICall_freeMsg(void *msg) {
+    ICall_free(msg);
+}
+
+void ICall_getHeapStats(ICall_heapStats_t *stats) {
+    memset(stats, 0, sizeof(ICall_heapStats_t));
+}
@@ -0,0 +1,58 @@
+#include "host.h"
+
+#include <string.h>
+
+#include "l2cap.h"
+#include "osal_bufmgr.h"
+#include "icall.h"
+
+/*
+ * L2CAP stand-in. SDU buffers come from the ICall heap like on the device, so a test
+ * sees one that leaked. L2CAP_bm_alloc() finds none while host_l2cap_buffers is 0,
+ * L2CAP_SendSDU() answers blePending while host_l2cap_pending is set, and an SDU it
+ * took is handed to host_l2cap_sent and freed. The SDU done event is up to the test.
+ */
+
+int host_l2cap_buffers = 1000;
+bool host_l2cap_pending = false;
+void (*host_l2cap_sent)(uint16_t CID, const uint8_t *pData, uint16_t len) = NULL;
+long host_l2cap_credits = 0;
+
+bStatus_t L2CAP_RegisterPsm(l2capPsm_t *pPsm) {
+    return SUCCESS;
+}
+
+bStatus_t L2CAP_FlowCtrlCredit(uint16 CID, uint16 peerCredits) {
+    host_l2cap_credits += peerCredits;
+    return SUCCESS;
+}
+
+bStatus_t L2CAP_DisconnectReq(uint16 CID) {
+    return SUCCESS;
+}
+
+void *L2CAP_bm_alloc(uint16 size) {
+    if (host_l2cap_buffers <= 0) {
+        return NULL;
+    }
+    host_l2cap_buffers--;
+    return ICall_malloc(size);
+}
+
+void osal_bm_free(void *payload_ptr) {
+    if (payload_ptr) {
+        host_l2cap_buffers++;
+        ICall_free(payload_ptr);
+    }
+}
+
+bStatus_t L2CAP_SendSDU(l2capPacket_t *pPkt) {
+    if (host_l2cap_pending) {
+        return blePending;
+    }
+    if (host_l2cap_sent) {
+        host_l2cap_sent(pPkt->CID, pPkt->pPayload, pPkt->len);
+    }
+    osal_bm_free(pPkt->pPayload);
+    return SUCCESS;
+}
@@ -0,0 +1,80 @@
+#include "host.h"
+
+#include <string.h>
+
+#include <ti/drivers/PIN.h>
+#include <ti/sysbios/hal/Hwi.h>
+
+/*
+ * PIN driver stand-in. Every pin is high until a test sets it, like an input with a
+ * pull-up. A level change on a pin opened with an edge interrupt runs the handle's
+ * callback with the interrupts held off, as the pin Hwi does on the device.
+ */
+
+#define PINS 32
+
+static bool levels[PINS];
+static bool isSet[PINS];
+static PIN_Handle owners[PINS];
+
+PIN_Handle PIN_open(PIN_State *state, const PIN_Config pinList[]) {
+    uint8_t i;
+
+    memset(state, 0, sizeof(PIN_State));
+    state->table = pinList;
+    for (i = 0; PIN_ID(pinList[i]) != PIN_TERMINATE; i++) {
+        if (PIN_ID(pinList[i]) < PINS) {
+            owners[PIN_ID(pinList[i])] = state;
+        }
+    }
+    return state;
+}
+
+int PIN_registerIntCb(PIN_Handle handle, PIN_IntCb callbackFxn) {
+    handle->intCb = callbackFxn;
+    return 0;
+}
+
+unsigned int PIN_getInputValue(PIN_Id pinId) {
+    if (pinId >= PINS) {
+        return 0;
+    }
+    return (!isSet[pinId]) || levels[pinId];
+}
+
+int PIN_setOutputValue(PIN_Handle handle, PIN_Id pinId, unsigned int val) {
+    if (pinId < PINS) {
+        isSet[pinId] = true;
+        levels[pinId] = (val != 0);
+    }
+    return 0;
+}
+
+static bool has_edge_irq(PIN_Handle handle, uint32_t pin, bool level) {
+    uint8_t i;
+
+    for (i = 0; PIN_ID(handle->table[i]) != PIN_TERMINATE; i++) {
+        if (PIN_ID(handle->table[i]) == pin) {
+            return (handle->table[i] & (level ? PIN_IRQ_POSEDGE : PIN_IRQ_NEGEDGE)) != 0;
+        }
+    }
+    return false;
+}
+
+void host_pin_set(uint32_t pin, bool level) {
+    PIN_Handle handle;
+    UInt key;
+
+    if ((pin >= PINS) || (PIN_getInputValue(pin) == level)) {
+        return;
+    }
+    isSet[pin] = true;
+    levels[pin] = level;
+
+    handle = owners[pin];
+    if (handle && handle->intCb && has_edge_irq(handle, pin, level)) {
+        key = Hwi_disable();
+        handle->intCb(handle, pin);
+        Hwi_restore(key);
+    }
+}
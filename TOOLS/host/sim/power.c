@@ -0,0 +1,125 @@
+#include "host.h"
+
+#include <xdc/runtime/System.h>
+#include <ti/drivers/power/PowerCC26XX.h>
+
+/*
+ * Power manager stand-in. Nothing powers down here, it counts the dependencies and
+ * constraints so a test can check every set has its release, and keeps the timeline
+ * of them, printed to host_power_log as they happen while that is set.
+ */
+
+static int dependencies[PowerCC26XX_NUMRESOURCES];
+static int constraints[PowerCC26XX_NUMCONSTRAINTS];
+
+static host_power_event_t timeline[HOST_POWER_EVENTS];
+static long eventCount = 0;
+FILE *host_power_log = NULL;
+
+static const char *name_of(bool isConstraint, unsigned int id) {
+    if (isConstraint) {
+        switch (id) {
+            case PowerCC26XX_SB_DISALLOW:       return "SB_DISALLOW";
+            case PowerCC26XX_IDLE_PD_DISALLOW:  return "IDLE_PD_DISALLOW";
+            case PowerCC26XX_SD_DISALLOW:       return "SD_DISALLOW";
+            default:                            return "constraint";
+        }
+    }
+    switch (id) {
+        case PowerCC26XX_PERIPH_CRYPTO: return "PERIPH_CRYPTO";
+        case PowerCC26XX_PERIPH_TRNG:   return "PERIPH_TRNG";
+        default:                        return "resource";
+    }
+}
+
+static void log_event(bool isConstraint, bool isSet, unsigned int id, int count) {
+    host_power_event_t *event;
+
+    if (eventCount < HOST_POWER_EVENTS) {
+        event = &timeline[eventCount];
+        event->tick = host_ticks();
+        event->isConstraint = isConstraint;
+        event->isSet = isSet;
+        event->id = (uint8_t) id;
+        event->count = count;
+    }
+    eventCount++;
+
+    if (host_power_log) {
+        fprintf(host_power_log, "timeline: tick %u, %s %s, %d held\n", (unsigned int) host_ticks(),
+                isSet ? "set" : "release", name_of(isConstraint, id), count);
+    }
+}
+
+long host_power_timeline(const host_power_event_t **events) {
+    if (events) {
+        *events = timeline;
+    }
+    return eventCount;
+}
+
+void host_power_clear() {
+    eventCount = 0;
+}
+
+int Power_setDependency(unsigned int resourceId) {
+    if (resourceId >= PowerCC26XX_NUMRESOURCES) {
+        return Power_EINVALIDINPUT;
+    }
+    dependencies[resourceId]++;
+    log_event(false, true, resourceId, dependencies[resourceId]);
+    return Power_SOK;
+}
+
+int Power_releaseDependency(unsigned int resourceId) {
+    if (resourceId >= PowerCC26XX_NUMRESOURCES) {
+        return Power_EINVALIDINPUT;
+    }
+    // The driver asserts on this
+    if (dependencies[resourceId] == 0) {
+        System_abort("Power_releaseDependency() without a Power_setDependency()");
+    }
+    dependencies[resourceId]--;
+    log_event(false, false, resourceId, dependencies[resourceId]);
+    return Power_SOK;
+}
+
+int Power_setConstraint(unsigned int constraintId) {
+    if (constraintId >= PowerCC26XX_NUMCONSTRAINTS) {
+        return Power_EINVALIDINPUT;
+    }
+    constraints[constraintId]++;
+    log_event(true, true, constraintId, constraints[constraintId]);
+    return Power_SOK;
+}
+
+int Power_releaseConstraint(unsigned int constraintId) {
+    if (constraintId >= PowerCC26XX_NUMCONSTRAINTS) {
+        return Power_EINVALIDINPUT;
+    }
+    if (constraints[constraintId] == 0) {
+        System_abort("Power_releaseConstraint() without a Power_setConstraint()");
+    }
+    constraints[constraintId]--;
+    log_event(true, false, constraintId, constraints[constraintId]);
+    return Power_SOK;
+}
+
+unsigned int Power_getConstraintMask() {
+    unsigned int mask = 0;
+    unsigned int i;
+
+    for (i = 0; i < PowerCC26XX_NUMCONSTRAINTS; i++) {
+        if (constraints[i]) {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+}
+
+int Power_getDependencyCount(unsigned int resourceId) {
+    if (resourceId >= PowerCC26XX_NUMRESOURCES) {
+        return Power_EINVALIDINPUT;
+    }
+    return dependencies[resourceId];
+}
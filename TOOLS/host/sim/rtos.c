@@ -0,0 +1,384 @@
+#include "host.h"
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include <xdc/runtime/System.h>
+#include <xdc/runtime/Memory.h>
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include <ti/sysbios/knl/Swi.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Semaphore.h>
+
+/*
+ * TI-RTOS kernel stand-in: one lock for Hwi, Swi and Task, a Clock that moves on
+ * host_advance() and semaphores that wait by letting time pass.
+ */
+
+UInt32 Clock_tickPeriod = 10;
+int host_failures = 0;
+
+static pthread_mutex_t kernelLock;
+static pthread_once_t lockOnce = PTHREAD_ONCE_INIT;
+static __thread int lockDepth = 0;
+
+static uint32_t now = 0;
+static Clock_Struct *clocks = NULL;
+static Task_Struct *tasks = NULL;
+
+#define HOST_NUM_INTERRUPTS 64
+
+static Hwi_Struct *hwis[HOST_NUM_INTERRUPTS];
+static bool isIntEnabled[HOST_NUM_INTERRUPTS];
+
+static void lock_init() {
+    pthread_mutexattr_t attr;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&kernelLock, &attr);
+}
+
+static UInt lock() {
+    pthread_once(&lockOnce, lock_init);
+    pthread_mutex_lock(&kernelLock);
+    return (UInt) lockDepth++;
+}
+
+static void unlock(UInt key) {
+    lockDepth = (int) key;
+    pthread_mutex_unlock(&kernelLock);
+}
+
+int host_lock_depth() {
+    return lockDepth;
+}
+
+UInt Hwi_disable()                  { return lock(); }
+void Hwi_restore(UInt key)          { unlock(key); }
+UInt Swi_disable()                  { return lock(); }
+void Swi_restore(UInt key)          { unlock(key); }
+UInt Task_disable()                 { return lock(); }
+void Task_restore(UInt key)         { unlock(key); }
+
+UInt Hwi_enableInterrupt(UInt intNum) {
+    UInt wasEnabled = isIntEnabled[intNum % HOST_NUM_INTERRUPTS];
+
+    isIntEnabled[intNum % HOST_NUM_INTERRUPTS] = true;
+    return wasEnabled;
+}
+
+UInt Hwi_disableInterrupt(UInt intNum) {
+    UInt wasEnabled = isIntEnabled[intNum % HOST_NUM_INTERRUPTS];
+
+    isIntEnabled[intNum % HOST_NUM_INTERRUPTS] = false;
+    return wasEnabled;
+}
+
+void host_interrupt(int intNum) {
+    Hwi_Struct *hwi = hwis[intNum % HOST_NUM_INTERRUPTS];
+    UInt key;
+
+    if (hwi && isIntEnabled[intNum % HOST_NUM_INTERRUPTS]) {
+        key = lock();
+        hwi->fxn(hwi->arg);
+        unlock(key);
+    }
+}
+
+void Hwi_Params_init(Hwi_Params *params) {
+    memset(params, 0, sizeof(Hwi_Params));
+}
+
+void Hwi_construct(Hwi_Struct *hwi, Int intNum, Hwi_FuncPtr fxn, const Hwi_Params *params,
+                   void *eb) {
+    hwi->intNum = intNum;
+    hwi->fxn = fxn;
+    hwi->arg = params ? params->arg : 0;
+    hwis[intNum % HOST_NUM_INTERRUPTS] = hwi;
+}
+
+Bool Hwi_getStackInfo(Hwi_StackInfo *info, Bool computeStackDepth) {
+    memset(info, 0, sizeof(Hwi_StackInfo));
+    return FALSE;
+}
+
+uint32_t host_ticks() {
+    return now;
+}
+
+uint64_t host_ns() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+void host_advance(uint32_t ticks) {
+    Clock_Struct *clock;
+    uint32_t step;
+    bool hasRun;
+
+    while (ticks) {
+        // Nothing happens between one due clock and the next, skip to it
+        step = ticks;
+        for (clock = clocks; clock; clock = clock->next) {
+            if (clock->isActive && ((clock->due - now) != 0) && ((clock->due - now) < step)) {
+                step = clock->due - now;
+            }
+        }
+        now += step;
+        ticks -= step;
+        // A Clock function can start and stop clocks, the walk starts over after one ran
+        do {
+            hasRun = false;
+            for (clock = clocks; clock; clock = clock->next) {
+                if (clock->isActive && (clock->due == now)) {
+                    if (clock->period) {
+                        clock->due = now + clock->period;
+                    }
+                    else {
+                        clock->isActive = false;
+                    }
+                    clock->fxn(clock->arg);
+                    hasRun = true;
+                    break;
+                }
+            }
+        } while (hasRun);
+    }
+}
+
+UInt32 Clock_getTicks() {
+    return now;
+}
+
+void Clock_Params_init(Clock_Params *params) {
+    memset(params, 0, sizeof(Clock_Params));
+}
+
+void Clock_construct(Clock_Struct *clock, Clock_FuncPtr fxn, UInt32 timeout,
+                     const Clock_Params *params) {
+    Clock_Struct *known;
+
+    for (known = clocks; known; known = known->next) {
+        if (known == clock) {
+            break;
+        }
+    }
+    memset(clock, 0, offsetof(Clock_Struct, next));
+    clock->fxn = fxn;
+    clock->timeout = timeout;
+    if (params) {
+        clock->arg = params->arg;
+        clock->period = params->period;
+    }
+    if (!known) {
+        clock->next = clocks;
+        clocks = clock;
+    }
+    if (params && params->startFlag) {
+        Clock_start(clock);
+    }
+}
+
+void Clock_destruct(Clock_Struct *clock) {
+    Clock_Struct **link;
+
+    for (link = &clocks; *link; link = &(*link)->next) {
+        if (*link == clock) {
+            *link = clock->next;
+            break;
+        }
+    }
+}
+
+Clock_Handle Clock_handle(Clock_Struct *clock) {
+    return clock;
+}
+
+void Clock_start(Clock_Handle clock) {
+    // A zero timeout never fires on the device either
+    clock->isActive = (clock->timeout != 0);
+    clock->due = now + clock->timeout;
+}
+
+void Clock_stop(Clock_Handle clock) {
+    clock->isActive = false;
+}
+
+void Clock_setTimeout(Clock_Handle clock, UInt32 timeout) {
+    clock->timeout = timeout;
+}
+
+void Clock_setPeriod(Clock_Handle clock, UInt32 period) {
+    clock->period = period;
+}
+
+UInt32 Clock_getTimeout(Clock_Handle clock) {
+    return clock->isActive ? (clock->due - now) : clock->timeout;
+}
+
+Bool Clock_isActive(Clock_Handle clock) {
+    return clock->isActive;
+}
+
+void Semaphore_Params_init(Semaphore_Params *params) {
+    params->mode = Semaphore_Mode_COUNTING;
+}
+
+void Semaphore_construct(Semaphore_Struct *sem, Int count, const Semaphore_Params *params) {
+    sem->mode = params ? params->mode : Semaphore_Mode_COUNTING;
+    sem->count = count;
+}
+
+Semaphore_Handle Semaphore_create(Int count, const Semaphore_Params *params, void *eb) {
+    Semaphore_Struct *sem = malloc(sizeof(Semaphore_Struct));
+
+    if (sem) {
+        Semaphore_construct(sem, count, params);
+    }
+    return sem;
+}
+
+Semaphore_Handle Semaphore_handle(Semaphore_Struct *sem) {
+    return sem;
+}
+
+void Semaphore_post(Semaphore_Handle sem) {
+    UInt key = lock();
+
+    if ((sem->mode == Semaphore_Mode_BINARY) || (sem->count < 0x7FFF)) {
+        sem->count = (sem->mode == Semaphore_Mode_BINARY) ? 1 : sem->count + 1;
+    }
+    unlock(key);
+}
+
+Bool Semaphore_pend(Semaphore_Handle sem, UInt32 timeout) {
+    UInt32 waited = 0;
+    UInt key;
+
+    for (;;) {
+        key = lock();
+        if (sem->count > 0) {
+            sem->count--;
+            unlock(key);
+            return TRUE;
+        }
+        unlock(key);
+        if (waited == timeout) {
+            return FALSE;
+        }
+        // Nothing could ever post it
+        if ((timeout == BIOS_WAIT_FOREVER) && !clocks) {
+            System_abort("Semaphore_pend() would wait forever");
+        }
+        host_advance(1);
+        waited++;
+    }
+}
+
+Int Semaphore_getCount(Semaphore_Handle sem) {
+    return sem->count;
+}
+
+void Task_sleep(UInt32 ticks) {
+    host_advance(ticks);
+}
+
+void Task_yield() {
+}
+
+void Task_Params_init(Task_Params *params) {
+    memset(params, 0, sizeof(Task_Params));
+    params->priority = 1;
+    params->stackSize = 1024;
+}
+
+void Task_construct(Task_Struct *task, Task_FuncPtr fxn, const Task_Params *params, void *eb) {
+    task->fxn = fxn;
+    task->params = *params;
+    task->next = tasks;
+    tasks = task;
+}
+
+Task_Handle Task_handle(Task_Struct *task) {
+    return task;
+}
+
+Task_Handle Task_self() {
+    return tasks;
+}
+
+void Task_stat(Task_Handle task, Task_Stat *stat) {
+    memset(stat, 0, sizeof(Task_Stat));
+    if (task) {
+        stat->priority = task->params.priority;
+        stat->stack = task->params.stack;
+        stat->stackSize = task->params.stackSize;
+    }
+}
+
+Task_Handle Task_Object_first() {
+    return NULL;
+}
+
+Task_Handle Task_Object_next(Task_Handle task) {
+    return NULL;
+}
+
+Int Task_Object_count() {
+    return 0;
+}
+
+Task_Handle Task_Object_get(void *objects, Int i) {
+    return NULL;
+}
+
+void System_abort(const char *msg) {
+    fprintf(stderr, "System_abort: %s\n", msg);
+    abort();
+}
+
+Int System_printf(const char *fmt, ...) {
+    va_list args;
+    int ret;
+
+    va_start(args, fmt);
+    ret = vprintf(fmt, args);
+    va_end(args);
+    return ret;
+}
+
+void System_flush() {
+    fflush(stdout);
+}
+
+void Memory_getStats(Ptr heap, Memory_Stats *stats) {
+    memset(stats, 0, sizeof(Memory_Stats));
+}
+
+int host_report(const char *name) {
+    if (host_failures) {
+        printf("%s: %d checks failed\n", name, host_failures);
+        return 1;
+    }
+    printf("%s: passed\n", name);
+    return 0;
+}
+
+bool host_bench(int argc, char **argv) {
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bench") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,102 @@
+#include "host.h"
+
+#include <string.h>
+#include <sys/mman.h>
+#include <xdc/runtime/System.h>
+#include <osal_snv.h>
+
+/*
+ * Simple NV stand-in. Like the stack's, a write appends a new copy of the item to the
+ * active page and the page is compacted, erased once, when the copy does not fit
+ * anymore. Items live in RAM, the flash is only counted: bytes programmed and erases.
+ * The RAM is shared with forked processes, so a test can boot the application in a
+ * child process as often as it likes and the items are still there, like flash.
+ */
+
+#define HOST_SNV_PAGE_SIZE  4096
+#define HOST_SNV_HEADER     4
+
+typedef struct host_snv_flash {
+    struct {
+        bool isStored;
+        uint8_t len;
+        uint8_t data[255];
+    } items[256];
+    uint32_t pageUsed;
+    host_snv_stats_t stats;
+} host_snv_flash_t;
+
+static host_snv_flash_t *flash = NULL;
+
+bool host_snv_fail = false;
+
+static host_snv_flash_t *snv() {
+    if (!flash) {
+        flash = mmap(NULL, sizeof(host_snv_flash_t), PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (flash == MAP_FAILED) {
+            System_abort("no memory for the SNV stand-in");
+        }
+    }
+    return flash;
+}
+
+static uint32_t live_bytes(host_snv_flash_t *nv) {
+    uint32_t bytes = 0;
+    int id;
+
+    for (id = 0; id < 256; id++) {
+        if (nv->items[id].isStored) {
+            bytes += HOST_SNV_HEADER + nv->items[id].len;
+        }
+    }
+    return bytes;
+}
+
+uint8 osal_snv_read(osalSnvId_t id, osalSnvLen_t len, void *pBuf) {
+    host_snv_flash_t *nv = snv();
+
+    if (!nv->items[id].isStored) {
+        return NV_OPER_FAILED;
+    }
+    memcpy(pBuf, nv->items[id].data, (len < nv->items[id].len) ? len : nv->items[id].len);
+    return SUCCESS;
+}
+
+uint8 osal_snv_write(osalSnvId_t id, osalSnvLen_t len, void *pBuf) {
+    host_snv_flash_t *nv = snv();
+    uint32_t size = HOST_SNV_HEADER + len;
+
+    if (host_snv_fail) {
+        return NV_OPER_FAILED;
+    }
+    if ((nv->pageUsed + size) > HOST_SNV_PAGE_SIZE) {
+        // Compaction, the live items move to the erased page
+        nv->stats.erases++;
+        nv->pageUsed = live_bytes(nv);
+        nv->stats.programmed += nv->pageUsed;
+        if (nv->items[id].isStored) {
+            nv->pageUsed -= HOST_SNV_HEADER + nv->items[id].len;
+        }
+    }
+    nv->pageUsed += size;
+    nv->stats.programmed += size;
+    nv->stats.writes++;
+
+    nv->items[id].isStored = true;
+    nv->items[id].len = len;
+    memcpy(nv->items[id].data, pBuf, len);
+    return SUCCESS;
+}
+
+host_snv_stats_t host_snv_stats() {
+    return snv()->stats;
+}
+
+void host_snv_erase() {
+    memset(snv(), 0, sizeof(host_snv_flash_t));
+}
+
+void host_snv_corrupt(uint8_t id, int offset) {
+    snv()->items[id].data[offset] ^= 0x01;
+}
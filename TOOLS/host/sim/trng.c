@@ -0,0 +1,102 @@
+#include "host.h"
+
+#include <ti/sysbios/knl/Clock.h>
+#include <driverlib/trng.h>
+#include <inc/hw_types.h>
+#include <inc/hw_memmap.h>
+#include <inc/hw_ints.h>
+#include <inc/hw_trng.h>
+
+/*
+ * TRNG stand-in. While enabled it has a number ready host_trng_period ticks after the
+ * last one was acknowledged and raises INT_TRNG_IRQ for the unmasked flags, like the
+ * module does. The numbers are host_trng_number(0), host_trng_number(1), ... so a test
+ * knows which bytes the pool must hand out.
+ */
+
+uint32_t host_trng_period = 1;
+long host_trng_numbers = 0;
+bool host_trng_stuck = false;
+bool host_trng_dead = false;
+
+static Clock_Struct trngClock;
+static bool isClockConstructed = false;
+
+static void trng_raise() {
+    uint32_t pending = HWREG(TRNG_BASE + TRNG_O_IRQFLAGSTAT) & HWREG(TRNG_BASE + TRNG_O_IRQFLAGMASK);
+
+    if (pending) {
+        host_interrupt(INT_TRNG_IRQ);
+    }
+}
+
+static void trng_tick(UArg arg) {
+    uint64_t number;
+
+    if (host_trng_dead || (HWREG(TRNG_BASE + TRNG_O_IRQFLAGSTAT) & TRNG_NUMBER_READY)) {
+        return;
+    }
+    number = host_trng_number(host_trng_stuck ? 0 : host_trng_numbers);
+    host_trng_numbers++;
+    HWREG(TRNG_BASE + TRNG_O_OUT0) = (uint32_t) number;
+    HWREG(TRNG_BASE + TRNG_O_OUT1) = (uint32_t) (number >> 32);
+    HWREG(TRNG_BASE + TRNG_O_IRQFLAGSTAT) |= TRNG_NUMBER_READY;
+    trng_raise();
+}
+
+uint64_t host_trng_number(long n) {
+    // splitmix64
+    uint64_t z = 0x9E3779B97F4A7C15ull * (uint64_t) (n + 1);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+bool host_trng_enabled() {
+    return isClockConstructed && Clock_isActive(Clock_handle(&trngClock));
+}
+
+void host_trng_fro_alarm(uint32_t fros) {
+    HWREG(TRNG_BASE + TRNG_O_ALARMSTOP) |= fros;
+    HWREG(TRNG_BASE + TRNG_O_FROEN) &= ~fros;
+    HWREG(TRNG_BASE + TRNG_O_IRQFLAGSTAT) |= TRNG_FRO_SHUTDOWN;
+    trng_raise();
+}
+
+void TRNGEnable() {
+    Clock_Params params;
+
+    if (!isClockConstructed) {
+        HWREG(TRNG_BASE + TRNG_O_FROEN) = 0x00FFFFFF;
+        isClockConstructed = true;
+    }
+    Clock_Params_init(&params);
+    params.period = host_trng_period;
+    Clock_construct(&trngClock, trng_tick, host_trng_period, &params);
+    Clock_start(Clock_handle(&trngClock));
+}
+
+void TRNGDisable() {
+    if (isClockConstructed) {
+        Clock_stop(Clock_handle(&trngClock));
+    }
+    // A number that was not read is lost
+    HWREG(TRNG_BASE + TRNG_O_IRQFLAGSTAT) &= ~TRNG_NUMBER_READY;
+}
+
+uint32_t TRNGStatusGet() {
+    return HWREG(TRNG_BASE + TRNG_O_IRQFLAGSTAT);
+}
+
+void TRNGIntEnable(uint32_t intFlags) {
+    HWREG(TRNG_BASE + TRNG_O_IRQFLAGMASK) |= intFlags;
+}
+
+void TRNGIntDisable(uint32_t intFlags) {
+    HWREG(TRNG_BASE + TRNG_O_IRQFLAGMASK) &= ~intFlags;
+}
+
+void TRNGIntClear(uint32_t intFlags) {
+    HWREG(TRNG_BASE + TRNG_O_IRQFLAGSTAT) &= ~intFlags;
+}
@@ -0,0 +1,43 @@
+#include "util.h"
+
+/*
+ * The clock helpers of the BLE SDK's util.c on the Clock stand-in.
+ */
+
+static UInt32 ms_to_ticks(uint32_t ms) {
+    return ms * (1000 / Clock_tickPeriod);
+}
+
+Clock_Handle Util_constructClock(Clock_Struct *pClock, Clock_FuncPtr clockCB, uint32_t clockDuration,
+                                 uint32_t clockPeriod, uint8_t startFlag, UArg arg) {
+    Clock_Params params;
+
+    Clock_Params_init(&params);
+    params.period = ms_to_ticks(clockPeriod);
+    params.startFlag = startFlag;
+    params.arg = arg;
+    Clock_construct(pClock, clockCB, ms_to_ticks(clockDuration), &params);
+    return Clock_handle(pClock);
+}
+
+void Util_startClock(Clock_Struct *pClock) {
+    Clock_start(Clock_handle(pClock));
+}
+
+void Util_restartClock(Clock_Struct *pClock, uint32_t clockTimeout) {
+    Clock_Handle handle = Clock_handle(pClock);
+
+    if (Clock_isActive(handle)) {
+        Clock_stop(handle);
+    }
+    Clock_setTimeout(handle, ms_to_ticks(clockTimeout));
+    Clock_start(handle);
+}
+
+bool Util_isActive(Clock_Struct *pClock) {
+    return Clock_isActive(Clock_handle(pClock));
+}
+
+void Util_stopClock(Clock_Struct *pClock) {
+    Clock_stop(Clock_handle(pClock));
+}
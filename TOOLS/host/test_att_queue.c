@@ -0,0 +1,328 @@
+#include "host.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "att_queue.h"
+#include "conn_notice.h"
+#include "icall.h"
+
+/*
+ * att_queue: signatures go out first and in order, a newer notification of an
+ * attribute takes the place of the queued one, and the end of the connection events
+ * is only asked for while a link has something waiting. A response is never dropped
+ * for another message: with every notification slot taken, each link still queues its
+ * response, a signature notification replaces the oldest normal notification and a
+ * normal one is dropped.
+ *
+ * The load test runs ATT_QUEUE_MAX_CONNS clients that each keep one request
+ * outstanding and get bursts of notifications, against connection events with a few
+ * buffers at most. Every response arrives, each client's in order, a client never gets
+ * an older value of an attribute after a newer one, and the last signature status it
+ * gets is the last one written. With --bench, the cost of queueing a notification and
+ * of a connection event that sends it.
+ */
+
+#define ENTITY      7
+#define NOTICE_EVT  0x0100
+#define ATTRS       4
+
+typedef struct link {
+    uint32_t requested;    // Requests the client sent
+    uint32_t answered;     // Responses it got
+    bool isWaiting;        // A response is on its way, the client sends no request until then
+    uint8_t written[ATTRS];
+    uint8_t got[ATTRS];
+} link_t;
+
+static link_t links[ATT_QUEUE_MAX_CONNS];
+static uint32_t responsesSent = 0;
+static uint32_t notificationsSent = 0;
+static bool isLoad = false;
+static uint8_t lastMethod;
+static uint8_t lastValue;
+
+static void on_sent(uint16_t connHandle, uint8_t method, uint16_t handle,
+                    const uint8_t *pValue, uint16_t len) {
+    lastMethod = method;
+    lastValue = pValue[0];
+    if (method == ATT_HANDLE_VALUE_NOTI) {
+        notificationsSent++;
+        if (isLoad && (connHandle < ATT_QUEUE_MAX_CONNS) && (handle < ATTRS)) {
+            CHECK((int8_t) (pValue[0] - links[connHandle].got[handle]) > 0);
+            links[connHandle].got[handle] = pValue[0];
+        }
+        return;
+    }
+
+    responsesSent++;
+    if (isLoad && (connHandle < ATT_QUEUE_MAX_CONNS)) {
+        // The response carries the number of the request it answers
+        CHECK(links[connHandle].isWaiting);
+        CHECK_EQ(pValue[0], (uint8_t) links[connHandle].requested);
+        links[connHandle].isWaiting = false;
+        links[connHandle].answered++;
+    }
+}
+
+static gattMsgEvent_t *make_response(uint16_t connHandle, uint8_t method, uint8_t value) {
+    gattMsgEvent_t *pMsg = ICall_malloc(sizeof(gattMsgEvent_t));
+
+    memset(pMsg, 0, sizeof(gattMsgEvent_t));
+    pMsg->connHandle = connHandle;
+    pMsg->method = method;
+    pMsg->msg.readRsp.len = 1;
+    pMsg->msg.readRsp.pValue = GATT_bm_alloc(connHandle, method, 1, NULL);
+    pMsg->msg.readRsp.pValue[0] = value;
+    return pMsg;
+}
+
+// Queues a response like the application does, freeing it if the queue refused it
+static bool queue_response(uint16_t connHandle, uint8_t method, uint8_t value) {
+    gattMsgEvent_t *pMsg = make_response(connHandle, method, value);
+
+    if (att_queue_response(pMsg)) {
+        return true;
+    }
+    GATT_bm_free(&pMsg->msg, method);
+    ICall_freeMsg(pMsg);
+    return false;
+}
+
+static bool queue_notification(uint16_t connHandle, uint16_t handle, uint8_t value,
+                               att_queue_priority_t priority) {
+    return att_queue_notification(connHandle, handle, &value, 1, priority);
+}
+
+static att_queue_stats_t stats() {
+    att_queue_stats_t s;
+
+    att_queue_get_stats(&s);
+    return s;
+}
+
+static void test_order_and_merge() {
+    att_queue_reset_stats();
+    host_gatt_buffers = 0;
+    CHECK(queue_notification(0, 1, 10, ATT_QUEUE_NORMAL));
+    CHECK(queue_notification(0, 1, 11, ATT_QUEUE_NORMAL));
+    CHECK_EQ(stats().superseded, 1);
+    CHECK(queue_response(1, ATT_READ_BLOB_RSP, 20));
+    CHECK(host_conn_event_notice(0));
+    CHECK(host_conn_event_notice(1));
+    CHECK(!host_conn_event_notice(2));
+
+    // The signature first, then the newest value of the attribute
+    host_gatt_buffers = 1;
+    att_queue_send();
+    CHECK_EQ(lastMethod, ATT_READ_BLOB_RSP);
+    CHECK(!host_conn_event_notice(1));
+    host_gatt_buffers = 1;
+    att_queue_send();
+    CHECK_EQ(lastMethod, ATT_HANDLE_VALUE_NOTI);
+    CHECK_EQ(lastValue, 11);
+    CHECK(!host_conn_event_notice(0));
+
+    // One sent directly drops the queued one
+    host_gatt_buffers = 0;
+    CHECK(queue_notification(0, 2, 30, ATT_QUEUE_NORMAL));
+    att_queue_sent(0, 2);
+    CHECK_EQ(stats().depth, 0);
+    CHECK(!host_conn_event_notice(0));
+    CHECK_EQ(host_icall_in_use, 0);
+}
+
+static void test_responses_kept() {
+    uint16_t i;
+
+    att_queue_reset_stats();
+    host_gatt_buffers = 0;
+
+    // Normal notifications in every slot they may take
+    for (i = 0; i < ATT_QUEUE_NOTI_SLOTS; i++) {
+        CHECK(queue_notification(i % ATT_QUEUE_MAX_CONNS, 100 + i, (uint8_t) i, ATT_QUEUE_NORMAL));
+    }
+    CHECK(!queue_notification(0, 200, 0, ATT_QUEUE_NORMAL));
+    CHECK_EQ(stats().dropped_full, 1);
+
+    // Every link still gets its response in, a plain write response as well
+    for (i = 0; i < ATT_QUEUE_MAX_CONNS; i++) {
+        CHECK(queue_response(i, (i == 0) ? ATT_WRITE_RSP : ATT_READ_RSP, (uint8_t) i));
+    }
+    CHECK_EQ(stats().depth, ATT_QUEUE_DEPTH);
+
+    // A signature notification replaces the oldest normal notification, not a response
+    CHECK(queue_notification(1, 300, 0xAA, ATT_QUEUE_SIGNATURE));
+    CHECK_EQ(stats().dropped_full, 2);
+    for (i = 1; i < ATT_QUEUE_NOTI_SLOTS; i++) {
+        CHECK(queue_notification(2, 301 + i, 0xBB, ATT_QUEUE_SIGNATURE));
+    }
+    // Signatures in every notification slot, the next one has no normal one to replace
+    CHECK(!queue_notification(2, 400, 0xCC, ATT_QUEUE_SIGNATURE));
+    CHECK_EQ(stats().dropped_full, 2 + ATT_QUEUE_NOTI_SLOTS);
+
+    // The write response was the oldest normal message, it goes out all the same
+    responsesSent = 0;
+    notificationsSent = 0;
+    host_gatt_buffers = 1000;
+    att_queue_send();
+    CHECK_EQ(responsesSent, ATT_QUEUE_MAX_CONNS);
+    CHECK_EQ(notificationsSent, ATT_QUEUE_NOTI_SLOTS);
+    CHECK_EQ(stats().depth, 0);
+    CHECK_EQ(host_icall_in_use, 0);
+}
+
+static void test_flush() {
+    att_queue_reset_stats();
+    host_gatt_buffers = 0;
+    CHECK(queue_response(0, ATT_READ_RSP, 1));
+    CHECK(queue_notification(0, 1, 1, ATT_QUEUE_SIGNATURE));
+    CHECK(queue_notification(1, 1, 1, ATT_QUEUE_NORMAL));
+    att_queue_flush(0);
+    CHECK_EQ(stats().dropped_link, 2);
+    CHECK(!host_conn_event_notice(0));
+    CHECK(host_conn_event_notice(1));
+    att_queue_flush(INVALID_CONNHANDLE);
+    CHECK_EQ(stats().depth, 0);
+    CHECK(!host_conn_event_notice(1));
+    CHECK_EQ(host_icall_in_use, 0);
+    host_gatt_buffers = 1000;
+}
+
+// The server sends the response itself, the queue only gets one that found no buffer
+static bool respond(uint16_t connHandle, uint8_t method, uint8_t value) {
+    gattMsgEvent_t *pMsg = make_response(connHandle, method, value);
+
+    if (GATT_SendRsp(connHandle, method, &pMsg->msg) == SUCCESS) {
+        ICall_freeMsg(pMsg);
+        return true;
+    }
+    if (att_queue_response(pMsg)) {
+        return true;
+    }
+    GATT_bm_free(&pMsg->msg, method);
+    ICall_freeMsg(pMsg);
+    return false;
+}
+
+// Like the profile and the application: sent directly if there is a buffer, else queued
+static bool notify(uint16_t connHandle, uint16_t handle, uint8_t value,
+                   att_queue_priority_t priority) {
+    attHandleValueNoti_t noti;
+
+    noti.handle = handle;
+    noti.len = 1;
+    noti.pValue = GATT_bm_alloc(connHandle, ATT_HANDLE_VALUE_NOTI, 1, NULL);
+    noti.pValue[0] = value;
+    if (GATT_Notification(connHandle, &noti, FALSE) == SUCCESS) {
+        att_queue_sent(connHandle, handle);
+        return true;
+    }
+    GATT_bm_free((gattMsg_t *) &noti, ATT_HANDLE_VALUE_NOTI);
+    return queue_notification(connHandle, handle, value, priority);
+}
+
+static void test_load() {
+    unsigned int seed = 1;
+    const uint32_t events = 200000;
+    uint32_t requested = 0;
+    uint32_t dropped;
+    uint32_t e;
+    uint16_t c;
+    uint8_t a;
+    uint8_t n;
+    uint8_t method;
+    link_t *link;
+
+    memset(links, 0, sizeof(links));
+    att_queue_flush(INVALID_CONNHANDLE);
+    att_queue_reset_stats();
+    notificationsSent = 0;
+    isLoad = true;
+
+    for (e = 0; e < events; e++) {
+        // What happened on the links since the last connection event, mostly without buffers
+        for (c = 0; c < ATT_QUEUE_MAX_CONNS; c++) {
+            link = &links[c];
+            host_gatt_buffers = ((rand_r(&seed) % 4) == 0) ? 1 : 0;
+            if ((!link->isWaiting) && ((rand_r(&seed) % 4) == 0)) {
+                link->requested++;
+                link->isWaiting = true;
+                requested++;
+                method = (rand_r(&seed) % 2) ? ATT_READ_BLOB_RSP : ATT_WRITE_RSP;
+                if (!respond(c, method, (uint8_t) link->requested)) {
+                    CHECK(!"response not queued");
+                    link->isWaiting = false;
+                }
+            }
+            for (n = rand_r(&seed) % 3; n > 0; n--) {
+                a = rand_r(&seed) % ATTRS;
+                link->written[a]++;
+                if (!notify(c, a, link->written[a], (a == 0) ? ATT_QUEUE_SIGNATURE :
+                                                               ATT_QUEUE_NORMAL)) {
+                    // Lost, and no older value of it waits: the client keeps what it has
+                    link->got[a] = link->written[a];
+                }
+            }
+        }
+
+        host_gatt_buffers = rand_r(&seed) % 4;
+        att_queue_send();
+    }
+
+    // Quiet links, everything waiting goes out
+    host_gatt_buffers = 1000;
+    att_queue_send();
+
+    isLoad = false;
+    dropped = stats().dropped_full;
+    CHECK_EQ(stats().depth, 0);
+    for (c = 0; c < ATT_QUEUE_MAX_CONNS; c++) {
+        link = &links[c];
+        CHECK(!link->isWaiting);
+        CHECK_EQ(link->answered, link->requested);
+        // A normal value may have made room for a signature, the signature status is kept
+        CHECK_EQ(link->got[0], link->written[0]);
+    }
+    CHECK_EQ(host_icall_in_use, 0);
+    printf("load: %d links, %u connection events, %u responses all answered in order, "
+           "%u notifications sent, %u dropped, %u superseded, deepest %u of %d\n",
+           ATT_QUEUE_MAX_CONNS, events, requested, notificationsSent, dropped,
+           (unsigned int) stats().superseded, stats().max_depth, ATT_QUEUE_DEPTH);
+}
+
+static void bench() {
+    const long rounds = 1000000;
+    uint64_t start;
+    uint8_t value;
+    long r;
+
+    att_queue_flush(INVALID_CONNHANDLE);
+    host_gatt_sent = NULL;
+    start = host_ns();
+    for (r = 0; r < rounds; r++) {
+        value = (uint8_t) r;
+        host_gatt_buffers = 0;
+        att_queue_notification((uint16_t) (r % ATT_QUEUE_MAX_CONNS), (uint16_t) (r % ATTRS),
+                               &value, 1, ATT_QUEUE_NORMAL);
+        if ((r % 4) == 3) {
+            host_gatt_buffers = 4;
+            att_queue_send();
+        }
+    }
+    printf("bench: queue a notification and send it %.1f ns, %d slots\n",
+           (double) (host_ns() - start) / rounds, ATT_QUEUE_DEPTH);
+}
+
+int main(int argc, char **argv) {
+    conn_notice_init(ENTITY, NOTICE_EVT);
+    host_gatt_sent = on_sent;
+    test_order_and_merge();
+    test_responses_kept();
+    test_flush();
+    test_load();
+    if (host_bench(argc, argv)) {
+        bench();
+    }
+    return host_report("att_queue");
+}
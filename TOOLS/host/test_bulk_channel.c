@@ -0,0 +1,400 @@
+#include "host.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "bulk_channel.h"
+#include "conn_notice.h"
+#include "icall.h"
+#include "sign_session.h"
+
+/*
+ * bulk_channel: echoes come back as they were sent, one SDU at a time, and a reply
+ * that found no L2CAP buffer or was answered blePending waits for the end of a
+ * connection event of its link, with the notice held only while it waits and kept for
+ * the att_queue if that needs it too. A held sign request and the short replies take
+ * no heap, a long echo takes it only until it is sent, and a closed channel frees
+ * everything.
+ *
+ * The load test runs a central per sign session that stream echoes and sign requests
+ * against a stack that mostly has no buffer and takes a few connection events per SDU.
+ * Every reply arrives, a channel's echoes and signatures each in the order they were
+ * asked for. With --bench, the
+ * cost of an echo round trip.
+ */
+
+#define ENTITY      7
+#define NOTICE_EVT  0x0100
+#define CID_BASE    0x40
+#define MAX_SDU     BULK_CHANNEL_MTU
+#define CHANNELS    SIGN_SESSION_MAX    // A channel per session, as many as bulk_channel.c keeps
+
+// Ids of the requests of one kind not answered yet, they come back in order
+typedef struct ids {
+    uint8_t id[8];
+    uint8_t head;
+    uint8_t count;
+} ids_t;
+
+typedef struct central {
+    uint16_t CID;
+    bool isBusy;            // The stack has an SDU of this channel
+    uint32_t sent;          // Requests sent
+    uint32_t replies;       // Replies got
+    uint8_t nextId;         // Id of the next request
+    ids_t echoes;
+    ids_t signs;            // A sign reply comes whenever the request was signed
+    bool isSigning;         // A sign request is held
+    uint8_t signId;
+} central_t;
+
+static void push_id(ids_t *ids, uint8_t id) {
+    CHECK(ids->count < sizeof(ids->id));
+    ids->id[(ids->head + ids->count) % sizeof(ids->id)] = id;
+    ids->count++;
+}
+
+static void pop_id(ids_t *ids, uint8_t id) {
+    CHECK(ids->count > 0);
+    CHECK_EQ(id, ids->id[ids->head]);
+    ids->head = (ids->head + 1) % sizeof(ids->id);
+    ids->count--;
+}
+
+static central_t centrals[CHANNELS];
+static uint8_t lastReply[MAX_SDU + BULK_REPLY_HDR_LEN];
+static uint16_t lastReplyLen;
+static uint32_t replies = 0;
+static int heldOp = 0;
+
+static central_t *find_central(uint16_t CID) {
+    uint8_t i;
+
+    for (i = 0; i < CHANNELS; i++) {
+        if (centrals[i].CID == CID) {
+            return &centrals[i];
+        }
+    }
+    return NULL;
+}
+
+static void on_sent(uint16_t CID, const uint8_t *pData, uint16_t len) {
+    central_t *central = find_central(CID);
+
+    CHECK(len <= sizeof(lastReply));
+    memcpy(lastReply, pData, len);
+    lastReplyLen = len;
+    replies++;
+    if (central) {
+        // One SDU at a time, the next only after the done event
+        CHECK(!central->isBusy);
+        central->isBusy = true;
+        central->replies++;
+        pop_id((pData[0] == (BULK_OP_ECHO | BULK_OP_REPLY)) ? &central->echoes : &central->signs,
+               pData[1]);
+    }
+}
+
+static void on_request(uint16_t connHandle, uint8_t op, uint8_t id, const uint8_t *pData,
+                       uint16_t len) {
+    heldOp = op;
+}
+
+static void signal(uint16_t connHandle, uint8_t opcode, uint16_t CID) {
+    l2capSignalEvent_t evt;
+
+    memset(&evt, 0, sizeof(evt));
+    evt.connHandle = connHandle;
+    evt.opcode = opcode;
+    switch (opcode) {
+        case L2CAP_CHANNEL_ESTABLISHED_EVT:
+            evt.cmd.channelEstEvt.result = L2CAP_CONN_SUCCESS;
+            evt.cmd.channelEstEvt.CID = CID;
+            evt.cmd.channelEstEvt.info.psm = BULK_CHANNEL_PSM;
+            evt.cmd.channelEstEvt.info.peerMtu = MAX_SDU + BULK_REPLY_HDR_LEN;
+            break;
+        case L2CAP_CHANNEL_TERMINATED_EVT:
+            evt.cmd.channelTermEvt.CID = CID;
+            break;
+        case L2CAP_SEND_SDU_DONE_EVT:
+            evt.cmd.sendSduDoneEvt.CID = CID;
+            break;
+        default:
+            evt.cmd.creditEvt.CID = CID;
+            break;
+    }
+    bulk_channel_process_signal(&evt);
+}
+
+static void open_channel(uint16_t connHandle) {
+    central_t *central = &centrals[connHandle];
+
+    memset(central, 0, sizeof(central_t));
+    central->CID = CID_BASE + connHandle;
+    signal(connHandle, L2CAP_CHANNEL_ESTABLISHED_EVT, central->CID);
+}
+
+static void sdu_done(uint16_t connHandle) {
+    centrals[connHandle].isBusy = false;
+    signal(connHandle, L2CAP_SEND_SDU_DONE_EVT, centrals[connHandle].CID);
+}
+
+// An SDU from the central, its payload comes from the stack's heap like on the device
+static void send_sdu(uint16_t connHandle, uint8_t op, uint8_t id, const uint8_t *pData,
+                     uint16_t len) {
+    l2capDataEvent_t evt;
+
+    memset(&evt, 0, sizeof(evt));
+    evt.connHandle = connHandle;
+    evt.pkt.CID = centrals[connHandle].CID;
+    evt.pkt.len = 2 + len;
+    evt.pkt.pPayload = ICall_malloc(evt.pkt.len);
+    evt.pkt.pPayload[0] = op;
+    evt.pkt.pPayload[1] = id;
+    if (len > 0) {
+        memcpy(&evt.pkt.pPayload[2], pData, len);
+    }
+    host_l2cap_buffers--;   // osal_bm_free() gives it back
+    centrals[connHandle].sent++;
+    if (op == BULK_OP_ECHO) {
+        push_id(&centrals[connHandle].echoes, id);
+    }
+    else {
+        push_id(&centrals[connHandle].signs, id);
+        centrals[connHandle].signId = id;
+    }
+    bulk_channel_process_data(&evt);
+}
+
+static bulk_channel_stats_t stats() {
+    bulk_channel_stats_t s;
+
+    bulk_channel_get_stats(&s);
+    return s;
+}
+
+static void test_echo_and_retry() {
+    uint8_t data[MAX_SDU];
+    central_t *central = &centrals[0];
+
+    memset(data, 0x5C, sizeof(data));
+    bulk_channel_reset_stats();
+    open_channel(0);
+
+    send_sdu(0, BULK_OP_ECHO, 0, data, 20);
+    CHECK_EQ(lastReplyLen, BULK_REPLY_HDR_LEN + 20);
+    CHECK_EQ(lastReply[0], BULK_OP_ECHO | BULK_OP_REPLY);
+    CHECK_EQ(lastReply[3], BULK_STATUS_OK);
+    CHECK(memcmp(&lastReply[BULK_REPLY_HDR_LEN], data, 20) == 0);
+
+    // The next waits for the stack to be done with the first
+    send_sdu(0, BULK_OP_ECHO, 1, data, 20);
+    CHECK_EQ(central->replies, 1);
+    sdu_done(0);
+    CHECK_EQ(central->replies, 2);
+    sdu_done(0);
+
+    // No buffer: nothing comes in to carry the reply out, the end of a connection event does
+    host_l2cap_buffers = 0;
+    send_sdu(0, BULK_OP_ECHO, 2, data, 20);
+    CHECK_EQ(central->replies, 2);
+    CHECK(host_conn_event_notice(0));
+    CHECK(conn_notice_held(0, CONN_NOTICE_BULK_CHANNEL));
+    bulk_channel_send();
+    CHECK_EQ(central->replies, 2);
+    host_l2cap_buffers = 1000;
+    bulk_channel_send();
+    CHECK_EQ(central->replies, 3);
+    CHECK(!host_conn_event_notice(0));
+    sdu_done(0);
+
+    // blePending is tried again the same way, the att_queue keeps its notice
+    CHECK(conn_notice_request(0, CONN_NOTICE_ATT_QUEUE));
+    host_l2cap_pending = true;
+    send_sdu(0, BULK_OP_ECHO, 3, data, 20);
+    bulk_channel_send();
+    CHECK_EQ(central->replies, 3);
+    host_l2cap_pending = false;
+    bulk_channel_send();
+    CHECK_EQ(central->replies, 4);
+    CHECK(!conn_notice_held(0, CONN_NOTICE_BULK_CHANNEL));
+    CHECK(host_conn_event_notice(0));
+    conn_notice_release(0, CONN_NOTICE_ATT_QUEUE);
+    CHECK(!host_conn_event_notice(0));
+    sdu_done(0);
+
+    CHECK(stats().tx_retries >= 2);
+    CHECK_EQ(stats().tx_dropped, 0);
+    CHECK_EQ(host_icall_in_use, 0);
+}
+
+static void test_buffers() {
+    uint8_t data[MAX_SDU];
+    central_t *central = &centrals[0];
+    uint8_t op;
+    uint8_t id;
+    const uint8_t *pData;
+    uint16_t len;
+    long before;
+
+    memset(data, 0x3A, sizeof(data));
+
+    // A held sign request and its replies take no heap, the credits wait for it
+    heldOp = 0;
+    host_l2cap_pending = true;
+    send_sdu(0, BULK_OP_SIGN, 4, data, MAX_SDU - 2);
+    CHECK_EQ(heldOp, BULK_OP_SIGN);
+    CHECK_EQ(host_icall_in_use, 0);
+    CHECK(bulk_channel_request(0, &op, &id, &pData, &len));
+    CHECK_EQ(len, MAX_SDU - 2);
+    CHECK(memcmp(pData, data, len) == 0);
+    signal(0, L2CAP_PEER_CREDIT_THRESHOLD_EVT, central->CID);
+    before = host_l2cap_credits;
+    CHECK(bulk_channel_reply(0, op, id, 0, BULK_STATUS_OK, data, BULK_CHANNEL_REPLY_LEN -
+                                                                  BULK_REPLY_HDR_LEN));
+    CHECK_EQ(host_icall_in_use, 0);
+    bulk_channel_finish(0);
+    CHECK_EQ(host_l2cap_credits, before + BULK_CHANNEL_CREDITS);
+
+    // A long echo comes from the heap until it is sent
+    send_sdu(0, BULK_OP_ECHO, 5, data, BULK_CHANNEL_REPLY_LEN);
+    CHECK(host_icall_in_use > 0);
+    host_l2cap_pending = false;
+    bulk_channel_send();
+    CHECK_EQ(central->replies, 5);
+    sdu_done(0);
+    CHECK_EQ(central->replies, 6);
+    sdu_done(0);
+    CHECK_EQ(host_icall_in_use, 0);
+
+    // A closed channel drops what it held and lets go of the notice
+    host_l2cap_pending = true;
+    send_sdu(0, BULK_OP_SIGN, 6, data, 16);
+    send_sdu(0, BULK_OP_ECHO, 7, data, BULK_CHANNEL_REPLY_LEN);
+    CHECK(host_conn_event_notice(0));
+    bulk_channel_close(0);
+    host_l2cap_pending = false;
+    CHECK(!host_conn_event_notice(0));
+    CHECK_EQ(stats().channels, 0);
+    CHECK_EQ(host_icall_in_use, 0);
+}
+
+// The signer's reply to the held request
+static void sign(uint16_t connHandle, const uint8_t *signature) {
+    const uint8_t *pData;
+    uint16_t len;
+    uint8_t op;
+    uint8_t id;
+
+    CHECK(bulk_channel_request(connHandle, &op, &id, &pData, &len));
+    CHECK_EQ(id, centrals[connHandle].signId);
+    CHECK(bulk_channel_reply(connHandle, op, id, 0, BULK_STATUS_OK, signature, 32));
+    bulk_channel_finish(connHandle);
+    centrals[connHandle].isSigning = false;
+}
+
+static void test_load() {
+    unsigned int seed = 1;
+    const uint32_t events = 100000;
+    uint8_t data[64];
+    uint32_t sent = 0;
+    uint32_t e;
+    uint16_t c;
+    central_t *central;
+
+    memset(data, 0x11, sizeof(data));
+    bulk_channel_reset_stats();
+    for (c = 0; c < CHANNELS; c++) {
+        open_channel(c);
+    }
+
+    for (e = 0; e < events; e++) {
+        // Few buffers, the stack often busy
+        host_l2cap_buffers = rand_r(&seed) % 3;
+        host_l2cap_pending = (rand_r(&seed) % 4) == 0;
+
+        for (c = 0; c < CHANNELS; c++) {
+            central = &centrals[c];
+            // A central waits for its replies before it sends more than the queue takes
+            if ((central->sent - central->replies < BULK_CHANNEL_TX_DEPTH - 1) &&
+                ((rand_r(&seed) % 3) == 0)) {
+                if ((!central->isSigning) && ((rand_r(&seed) % 4) == 0)) {
+                    central->isSigning = true;
+                    send_sdu(c, BULK_OP_SIGN, central->nextId++, data, 16);
+                }
+                else {
+                    send_sdu(c, BULK_OP_ECHO, central->nextId++, data, rand_r(&seed) % sizeof(data));
+                }
+            }
+            // The signer answers a held request a while later
+            if (central->isSigning && ((rand_r(&seed) % 8) == 0)) {
+                sign(c, data);
+            }
+            // The stack is done with an SDU after a connection event or two
+            if (central->isBusy && ((rand_r(&seed) % 2) == 0)) {
+                sdu_done(c);
+            }
+        }
+
+        bulk_channel_send();
+    }
+
+    // Quiet links, everything waiting goes out
+    host_l2cap_buffers = 1000;
+    host_l2cap_pending = false;
+    for (e = 0; e < 2 * BULK_CHANNEL_TX_DEPTH; e++) {
+        for (c = 0; c < CHANNELS; c++) {
+            if (centrals[c].isSigning) {
+                sign(c, data);
+            }
+            if (centrals[c].isBusy) {
+                sdu_done(c);
+            }
+        }
+        bulk_channel_send();
+    }
+
+    for (c = 0; c < CHANNELS; c++) {
+        central = &centrals[c];
+        CHECK_EQ(central->replies, central->sent);
+        CHECK(!host_conn_event_notice(c));
+        sent += central->sent;
+        bulk_channel_close(c);
+    }
+    CHECK_EQ(stats().tx_dropped, 0);
+    CHECK_EQ(host_icall_in_use, 0);
+    printf("load: %d channels, %u connection events, %u requests all answered, "
+           "%u sends waited for a connection event\n", CHANNELS, events, sent,
+           (unsigned int) stats().tx_retries);
+}
+
+static void bench() {
+    const long rounds = 1000000;
+    uint8_t data[32];
+    uint64_t start;
+    long r;
+
+    memset(data, 0, sizeof(data));
+    open_channel(0);
+    start = host_ns();
+    for (r = 0; r < rounds; r++) {
+        send_sdu(0, BULK_OP_ECHO, (uint8_t) r, data, sizeof(data));
+        sdu_done(0);
+    }
+    printf("bench: echo of %u bytes in and out %.1f ns\n", (unsigned int) sizeof(data),
+           (double) (host_ns() - start) / rounds);
+    bulk_channel_close(0);
+}
+
+int main(int argc, char **argv) {
+    conn_notice_init(ENTITY, NOTICE_EVT);
+    CHECK_EQ(bulk_channel_init(ENTITY, on_request), SUCCESS);
+    host_l2cap_sent = on_sent;
+    test_echo_and_retry();
+    test_buffers();
+    test_load();
+    if (host_bench(argc, argv)) {
+        bench();
+    }
+    return host_report("bulk_channel");
+}
@@ -0,0 +1,271 @@
+#include "host.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "button.h"
+#include "board.h"
+
+/*
+ * button: edges driven on the simulated pins. A press is reported once the button is
+ * let go and the level held BUTTON_DEBOUNCE_MS, a long press while it is still held,
+ * a second short press right after one as a double press, and a spike shorter than the
+ * debounce time not at all. The two buttons do not disturb each other.
+ *
+ * The load test drives thousands of presses with bounce trains of up to a dozen edges,
+ * random hold times and gaps, away from the long and double press limits, and every
+ * one is reported as what it was at the time it should be. With --bench, the cost of
+ * one edge interrupt.
+ */
+
+#define TICKS_PER_MS    (1000 / 10)
+#define BUTTON          Board_PIN_BUTTON0
+#define OTHER           Board_PIN_BUTTON1
+#define MAX_EVENTS      16
+
+typedef struct event {
+    uint32_t pin;
+    button_event_t event;
+    uint32_t tick;
+} event_t;
+
+static event_t events[MAX_EVENTS];
+static int eventCount = 0;
+static unsigned int seed = 1;
+
+static void on_event(PIN_Id pin, button_event_t event) {
+    if (eventCount < MAX_EVENTS) {
+        events[eventCount].pin = pin;
+        events[eventCount].event = event;
+        events[eventCount].tick = host_ticks();
+    }
+    eventCount++;
+}
+
+static void wait_ms(uint32_t ms) {
+    host_advance(ms * TICKS_PER_MS);
+}
+
+// Bounces over up to 5 ms and settles on the level with the last of `edges | 1` edges,
+// returns the first edge
+static uint32_t bounce(uint32_t pin, bool level, int edges) {
+    uint32_t first = host_ticks();
+    int i;
+
+    edges |= 1;
+    for (i = 0; i < edges; i++) {
+        if (i > 0) {
+            host_advance(1 + rand_r(&seed) % (5 * TICKS_PER_MS / edges));
+        }
+        host_pin_set(pin, (i % 2 == 0) ? level : !level);
+    }
+    return first;
+}
+
+static uint32_t press(uint32_t pin, int edges) {
+    return bounce(pin, false, edges);
+}
+
+static uint32_t release(uint32_t pin, int edges) {
+    return bounce(pin, true, edges);
+}
+
+static void clear_events() {
+    eventCount = 0;
+    memset(events, 0, sizeof(events));
+}
+
+static void test_press() {
+    button_stats_t stats;
+    uint32_t settled;
+
+    clear_events();
+    button_reset_stats();
+    press(BUTTON, 7);
+    wait_ms(100);
+    release(BUTTON, 5);
+    settled = host_ticks();
+    wait_ms(BUTTON_DEBOUNCE_MS - 1);
+    CHECK_EQ(eventCount, 0);
+    wait_ms(2);
+    CHECK_EQ(eventCount, 1);
+    CHECK_EQ(events[0].event, BUTTON_PRESS);
+    CHECK_EQ(events[0].pin, BUTTON);
+    CHECK(events[0].tick >= settled + BUTTON_DEBOUNCE_MS * TICKS_PER_MS);
+    CHECK_EQ(button_last_event(), BUTTON_PRESS);
+
+    button_get_stats(&stats);
+    CHECK_EQ(stats.presses, 1);
+    CHECK_EQ(stats.edges, 7 + 5);
+    wait_ms(BUTTON_DOUBLE_PRESS_MS);
+}
+
+static void test_long_press() {
+    uint32_t start;
+
+    clear_events();
+    start = press(BUTTON, 3);
+    wait_ms(BUTTON_LONG_PRESS_MS - 50);
+    CHECK_EQ(eventCount, 0);
+    wait_ms(100);
+    CHECK_EQ(eventCount, 1);
+    CHECK_EQ(events[0].event, BUTTON_LONG_PRESS);
+    // Held since the first edge, not since it settled
+    CHECK(events[0].tick <= start + (BUTTON_LONG_PRESS_MS + 1) * TICKS_PER_MS);
+
+    // Letting go after a long press is no press
+    wait_ms(2000);
+    release(BUTTON, 3);
+    wait_ms(BUTTON_DOUBLE_PRESS_MS + 100);
+    CHECK_EQ(eventCount, 1);
+}
+
+static void test_double_press() {
+    clear_events();
+    press(BUTTON, 2);
+    wait_ms(80);
+    release(BUTTON, 2);
+    wait_ms(BUTTON_DOUBLE_PRESS_MS / 2);
+    press(BUTTON, 2);
+    wait_ms(80);
+    release(BUTTON, 2);
+    wait_ms(50);
+    CHECK_EQ(eventCount, 2);
+    CHECK_EQ(events[0].event, BUTTON_PRESS);
+    CHECK_EQ(events[1].event, BUTTON_DOUBLE_PRESS);
+
+    // A third one right after is a press again, one that comes too late as well
+    press(BUTTON, 0);
+    wait_ms(80);
+    release(BUTTON, 0);
+    wait_ms(BUTTON_DOUBLE_PRESS_MS + 100);
+    press(BUTTON, 0);
+    wait_ms(80);
+    release(BUTTON, 0);
+    wait_ms(BUTTON_DOUBLE_PRESS_MS + 100);
+    CHECK_EQ(eventCount, 4);
+    CHECK_EQ(events[2].event, BUTTON_PRESS);
+    CHECK_EQ(events[3].event, BUTTON_PRESS);
+}
+
+static void test_spike_and_two_buttons() {
+    button_stats_t stats;
+
+    clear_events();
+    button_reset_stats();
+
+    // Shorter than the debounce time, the level it ends on is the one it started from
+    host_pin_set(BUTTON, false);
+    wait_ms(BUTTON_DEBOUNCE_MS / 4);
+    host_pin_set(BUTTON, true);
+    wait_ms(BUTTON_DEBOUNCE_MS * 3);
+    CHECK_EQ(eventCount, 0);
+    button_get_stats(&stats);
+    CHECK_EQ(stats.bounces, 1);
+
+    // One held down while the other is pressed and let go
+    press(BUTTON, 4);
+    wait_ms(100);
+    press(OTHER, 4);
+    wait_ms(100);
+    release(OTHER, 4);
+    wait_ms(100);
+    release(BUTTON, 4);
+    wait_ms(100);
+    CHECK_EQ(eventCount, 2);
+    CHECK_EQ(events[0].pin, OTHER);
+    CHECK_EQ(events[0].event, BUTTON_PRESS);
+    CHECK_EQ(events[1].pin, BUTTON);
+    CHECK_EQ(events[1].event, BUTTON_PRESS);
+    wait_ms(BUTTON_DOUBLE_PRESS_MS);
+}
+
+static void test_load() {
+    const int presses = 5000;
+    int counts[4] = { 0 };
+    bool hasClick = false;
+    uint32_t lastRelease = 0;
+    uint32_t pressEdge;
+    uint32_t releaseEdge;
+    uint32_t settled;
+    uint32_t holdMs;
+    uint32_t gapMs;
+    button_event_t expected;
+    int n;
+
+    for (n = 0; n < presses; n++) {
+        clear_events();
+
+        // Hold and gap clear of the long and double press limits by the bounces and more
+        holdMs = (rand_r(&seed) % 3 == 0) ? BUTTON_LONG_PRESS_MS + 100 + rand_r(&seed) % 1000 :
+                                            30 + rand_r(&seed) % (BUTTON_LONG_PRESS_MS - 130);
+        gapMs = (rand_r(&seed) % 2 == 0) ? 40 + rand_r(&seed) % (BUTTON_DOUBLE_PRESS_MS - 90) :
+                                           BUTTON_DOUBLE_PRESS_MS + 50 + rand_r(&seed) % 600;
+
+        pressEdge = press(BUTTON, rand_r(&seed) % 12);
+        wait_ms(holdMs);
+        releaseEdge = release(BUTTON, rand_r(&seed) % 12);
+        settled = host_ticks();
+        wait_ms(BUTTON_DEBOUNCE_MS + 1);
+
+        if (holdMs > BUTTON_LONG_PRESS_MS) {
+            expected = BUTTON_LONG_PRESS;
+            hasClick = false;
+        }
+        else if (hasClick && ((pressEdge - lastRelease) <= BUTTON_DOUBLE_PRESS_MS * TICKS_PER_MS)) {
+            expected = BUTTON_DOUBLE_PRESS;
+            hasClick = false;
+        }
+        else {
+            expected = BUTTON_PRESS;
+            hasClick = true;
+            lastRelease = releaseEdge;
+        }
+
+        CHECK_EQ(eventCount, 1);
+        CHECK_EQ(events[0].event, expected);
+        if (expected == BUTTON_LONG_PRESS) {
+            CHECK(events[0].tick >= pressEdge + BUTTON_LONG_PRESS_MS * TICKS_PER_MS);
+            CHECK(events[0].tick <= pressEdge + (BUTTON_LONG_PRESS_MS + 1) * TICKS_PER_MS);
+        }
+        else {
+            CHECK(events[0].tick >= settled + BUTTON_DEBOUNCE_MS * TICKS_PER_MS);
+            CHECK(events[0].tick <= settled + (BUTTON_DEBOUNCE_MS + 1) * TICKS_PER_MS);
+        }
+        counts[expected]++;
+
+        wait_ms(gapMs - BUTTON_DEBOUNCE_MS - 1);
+    }
+
+    printf("load: %d bouncing presses, %d short, %d long, %d double, all reported as such\n",
+           presses, counts[BUTTON_PRESS], counts[BUTTON_LONG_PRESS], counts[BUTTON_DOUBLE_PRESS]);
+}
+
+static void bench() {
+    const long rounds = 1000000;
+    uint64_t start;
+    long r;
+
+    button_register_cb(NULL);
+    start = host_ns();
+    for (r = 0; r < rounds; r++) {
+        host_pin_set(BUTTON, (r % 2) != 0);
+    }
+    printf("bench: edge interrupt %.1f ns\n", (double) (host_ns() - start) / rounds);
+    host_pin_set(BUTTON, true);
+    wait_ms(BUTTON_DEBOUNCE_MS * 2);
+}
+
+int main(int argc, char **argv) {
+    init_buttons();
+    button_register_cb(on_event);
+    test_press();
+    test_long_press();
+    test_double_press();
+    test_spike_and_two_buttons();
+    test_load();
+    if (host_bench(argc, argv)) {
+        bench();
+    }
+    return host_report("button");
+}
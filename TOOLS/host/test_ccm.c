@@ -0,0 +1,234 @@
+#include "host.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mbedtls/ccm.h"
+#include "crypto_arena.h"
+
+/*
+ * ccm: the engine path gives the same ciphertext and tag as the construction over
+ * single AES blocks for every length, nonce and tag size the engine takes, in place
+ * and out of place, and long messages no longer fall back to software. A forged tag,
+ * a failed engine job or a full crypto arena still end in the software path. With
+ * --bench, both paths per message length; the engine is OpenSSL here, so only the
+ * software path and the overhead around the engine say something about the device,
+ * the self test benchmarks (BENCH_CCM_*) measure both on the device.
+ */
+
+#define MAX_LEN 600
+
+static const unsigned char key[16] = {
+    0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e, 0x4f
+};
+
+static unsigned char plain[MAX_LEN];
+static unsigned char add[32];
+static unsigned char nonce[13];
+
+static void fill(unsigned char *buf, size_t len, unsigned int *seed) {
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        buf[i] = (unsigned char) rand_r(seed);
+    }
+}
+
+// Encrypts with one path and decrypts with both, in place when asked
+static void roundtrip(mbedtls_ccm_context *hw, mbedtls_ccm_context *sw, size_t len,
+                      size_t iv_len, size_t add_len, size_t tag_len, int in_place) {
+    unsigned char hwOut[MAX_LEN];
+    unsigned char swOut[MAX_LEN];
+    unsigned char opened[MAX_LEN];
+    unsigned char hwTag[16];
+    unsigned char swTag[16];
+
+    memcpy(hwOut, plain, len);
+    CHECK_EQ(mbedtls_ccm_encrypt_and_tag(hw, len, nonce, iv_len, add, add_len,
+                                         in_place ? hwOut : plain, hwOut, hwTag, tag_len), 0);
+    CHECK_EQ(mbedtls_ccm_encrypt_and_tag(sw, len, nonce, iv_len, add, add_len,
+                                         plain, swOut, swTag, tag_len), 0);
+    CHECK(memcmp(hwOut, swOut, len) == 0);
+    CHECK(memcmp(hwTag, swTag, tag_len) == 0);
+
+    memcpy(opened, hwOut, len);
+    CHECK_EQ(mbedtls_ccm_auth_decrypt(hw, len, nonce, iv_len, add, add_len,
+                                      in_place ? opened : hwOut, opened, hwTag, tag_len), 0);
+    CHECK(memcmp(opened, plain, len) == 0);
+    CHECK_EQ(mbedtls_ccm_auth_decrypt(sw, len, nonce, iv_len, add, add_len,
+                                      swOut, opened, swTag, tag_len), 0);
+    CHECK(memcmp(opened, plain, len) == 0);
+}
+
+static void test_paths_agree() {
+    static const size_t lengths[] = { 1, 15, 16, 17, 32, 33, 48, 128, 136, 255, 512, MAX_LEN };
+    static const size_t tags[] = { 4, 8, 16 };
+    mbedtls_ccm_context hw;
+    mbedtls_ccm_context sw;
+    mbedtls_ccm_stats stats;
+    crypto_arena_stats_t arena;
+    unsigned int seed = 1;
+    size_t l;
+    size_t t;
+    int in_place;
+
+    mbedtls_ccm_init(&hw);
+    mbedtls_ccm_init(&sw);
+    CHECK_EQ(mbedtls_ccm_setkey(&hw, MBEDTLS_CIPHER_ID_AES, key, 128), 0);
+    CHECK_EQ(mbedtls_ccm_setkey(&sw, MBEDTLS_CIPHER_ID_AES, key, 128), 0);
+    mbedtls_ccm_set_hardware(&sw, 0);
+    mbedtls_ccm_reset_stats();
+
+    for (l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+        for (t = 0; t < sizeof(tags) / sizeof(tags[0]); t++) {
+            for (in_place = 0; in_place <= 1; in_place++) {
+                fill(plain, lengths[l], &seed);
+                fill(add, sizeof(add), &seed);
+                fill(nonce, sizeof(nonce), &seed);
+                roundtrip(&hw, &sw, lengths[l], 13, (l % 3) * 11, tags[t], in_place);
+                roundtrip(&hw, &sw, lengths[l], 12, 0, tags[t], in_place);
+            }
+        }
+    }
+
+    // Every engine operation stayed on the engine, whatever its length
+    mbedtls_ccm_get_stats(&stats);
+    CHECK_EQ(stats.fallbacks, 0);
+    CHECK_EQ(stats.hw_ops, 2 * 2 * 2 * (sizeof(tags) / sizeof(tags[0])) *
+                           (sizeof(lengths) / sizeof(lengths[0])));
+
+    // Nonces the engine has no length field for
+    mbedtls_ccm_reset_stats();
+    roundtrip(&hw, &sw, 64, 11, 0, 8, 1);
+    mbedtls_ccm_get_stats(&stats);
+    CHECK_EQ(stats.hw_ops, 0);
+
+    mbedtls_ccm_free(&hw);
+    mbedtls_ccm_free(&sw);
+
+    crypto_arena_get_stats(&arena);
+    CHECK_EQ(arena.used, 0);
+}
+
+static void test_fallbacks() {
+    mbedtls_ccm_context ctx;
+    mbedtls_ccm_stats stats;
+    crypto_arena_stats_t arena;
+    unsigned char sealed[256];
+    unsigned char tag[8];
+    unsigned char opened[256];
+    unsigned int seed = 7;
+    void *hog;
+
+    fill(plain, sizeof(sealed), &seed);
+    fill(nonce, sizeof(nonce), &seed);
+    mbedtls_ccm_init(&ctx);
+    CHECK_EQ(mbedtls_ccm_setkey(&ctx, MBEDTLS_CIPHER_ID_AES, key, 128), 0);
+    CHECK_EQ(mbedtls_ccm_encrypt_and_tag(&ctx, sizeof(sealed), nonce, 13, NULL, 0, plain, sealed,
+                                         tag, sizeof(tag)), 0);
+
+    // A forged tag fails on both paths and leaves nothing behind
+    mbedtls_ccm_reset_stats();
+    tag[0] ^= 1;
+    memset(opened, 0xAA, sizeof(opened));
+    CHECK_EQ(mbedtls_ccm_auth_decrypt(&ctx, sizeof(sealed), nonce, 13, NULL, 0, sealed, opened,
+                                      tag, sizeof(tag)), MBEDTLS_ERR_CCM_AUTH_FAILED);
+    CHECK_EQ(opened[0] | opened[sizeof(opened) - 1], 0);
+    tag[0] ^= 1;
+    mbedtls_ccm_get_stats(&stats);
+    CHECK_EQ(stats.fallbacks, 1);
+
+    // A failed engine job is done again in software
+    mbedtls_ccm_reset_stats();
+    host_ccm_fail = true;
+    CHECK_EQ(mbedtls_ccm_auth_decrypt(&ctx, sizeof(sealed), nonce, 13, NULL, 0, sealed, opened,
+                                      tag, sizeof(tag)), 0);
+    host_ccm_fail = false;
+    CHECK(memcmp(opened, plain, sizeof(opened)) == 0);
+    mbedtls_ccm_get_stats(&stats);
+    CHECK_EQ(stats.fallbacks, 1);
+    CHECK_EQ(stats.sw_ops, 1);
+
+    // No room in the arena for the bounce buffer, the short ones still bounce on the stack
+    crypto_arena_get_stats(&arena);
+    hog = crypto_arena_calloc(1, arena.largest_free - 64);
+    CHECK(hog != NULL);
+    mbedtls_ccm_reset_stats();
+    CHECK_EQ(mbedtls_ccm_auth_decrypt(&ctx, sizeof(sealed), nonce, 13, NULL, 0, sealed, opened,
+                                      tag, sizeof(tag)), 0);
+    CHECK(memcmp(opened, plain, sizeof(opened)) == 0);
+    memcpy(opened, plain, 16);
+    CHECK_EQ(mbedtls_ccm_encrypt_and_tag(&ctx, 16, nonce, 13, NULL, 0, opened, opened,
+                                         tag, sizeof(tag)), 0);
+    mbedtls_ccm_get_stats(&stats);
+    CHECK_EQ(stats.fallbacks, 1);
+    CHECK_EQ(stats.hw_ops, 1);
+    crypto_arena_free(hog);
+
+    mbedtls_ccm_free(&ctx);
+    crypto_arena_get_stats(&arena);
+    CHECK_EQ(arena.used, 0);
+}
+
+static double time_op(mbedtls_ccm_context *ctx, size_t len, int decrypt, long rounds) {
+    static unsigned char buf[MAX_LEN];
+    unsigned char tag[8];
+    uint64_t start;
+    long i;
+
+    memcpy(buf, plain, len);
+    mbedtls_ccm_encrypt_and_tag(ctx, len, nonce, 13, NULL, 0, buf, buf, tag, sizeof(tag));
+    start = host_ns();
+    for (i = 0; i < rounds; i++) {
+        if (decrypt) {
+            mbedtls_ccm_auth_decrypt(ctx, len, nonce, 13, NULL, 0, buf, plain, tag, sizeof(tag));
+        }
+        else {
+            mbedtls_ccm_encrypt_and_tag(ctx, len, nonce, 13, NULL, 0, buf, buf, tag, sizeof(tag));
+        }
+    }
+    return (double) (host_ns() - start) / rounds;
+}
+
+static void bench() {
+    static const size_t lengths[] = { 16, 128, 512 };
+    const long rounds = 20000;
+    mbedtls_ccm_context hw;
+    mbedtls_ccm_context sw;
+    double hwEncrypt;
+    double hwDecrypt;
+    double swEncrypt;
+    double swDecrypt;
+    long jobs;
+    size_t l;
+
+    mbedtls_ccm_init(&hw);
+    mbedtls_ccm_init(&sw);
+    mbedtls_ccm_setkey(&hw, MBEDTLS_CIPHER_ID_AES, key, 128);
+    mbedtls_ccm_setkey(&sw, MBEDTLS_CIPHER_ID_AES, key, 128);
+    mbedtls_ccm_set_hardware(&sw, 0);
+
+    for (l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+        hwEncrypt = time_op(&hw, lengths[l], 0, rounds);
+        hwDecrypt = time_op(&hw, lengths[l], 1, rounds);
+        jobs = host_crypto_jobs;
+        swEncrypt = time_op(&sw, lengths[l], 0, rounds);
+        jobs = (host_crypto_jobs - jobs) / rounds;
+        swDecrypt = time_op(&sw, lengths[l], 1, rounds);
+        printf("bench: %3u bytes, encrypt in place engine %.0f ns, software %.0f ns "
+               "(%ld AES blocks), decrypt engine %.0f ns, software %.0f ns\n",
+               (unsigned int) lengths[l], hwEncrypt, swEncrypt, jobs, hwDecrypt, swDecrypt);
+    }
+
+    mbedtls_ccm_free(&hw);
+    mbedtls_ccm_free(&sw);
+}
+
+int main(int argc, char **argv) {
+    test_paths_agree();
+    test_fallbacks();
+    if (host_bench(argc, argv)) {
+        bench();
+    }
+    return host_report("ccm");
+}
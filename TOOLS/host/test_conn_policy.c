@@ -0,0 +1,403 @@
+#include "host.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <ti/sysbios/knl/Clock.h>
+
+#include "bcomdef.h"
+#include "peripheral.h"
+#include "conn_policy.h"
+
+/*
+ * conn_policy against a central stand-in that answers a parameter request the way the
+ * link layer does: the request goes out on the next event the device listens to, the
+ * new parameters apply 6 connection events later, a rejection comes back one event after
+ * the request and a central that ignores it is given up on after the 30 s the GAP Role
+ * waits. The central picks the longest interval it is offered. The policy clock runs
+ * conn_policy_process() right away, as the application task would.
+ *
+ * The tests go through a switch to the fast parameters and back, back to back
+ * challenges, rejections with their retries, a central that never answers and a
+ * challenge while the idle request is out. Then the simulation runs an hour of
+ * challenges at different rates and prints, per rate, the radio duty cycle (the
+ * connection events the device listened to, against the 10 ms link it used to keep) and
+ * the latency the policy adds: how long until a challenge written on the idle link is
+ * heard, and how long until the fast parameters are in place.
+ */
+
+#define TICKS_PER_MS            (1000 / 10)
+#define TICKS_PER_INTERVAL      125     // 1.25 ms
+#define INSTANT_EVENTS          6
+#define GAPROLE_TIMEOUT_MS      30000
+#define GAPROLE_PAUSE_MS        6000    // DEFAULT_CONN_PAUSE_PERIPHERAL
+
+// The policy rounds its clock up to the next millisecond
+#define IDLE_TIMEOUT_TICKS      ((CONN_POLICY_IDLE_TIMEOUT_MS + 1) * TICKS_PER_MS)
+
+// The central's defaults, 30 ms without latency
+#define CENTRAL_INTERVAL        24
+#define CENTRAL_LATENCY         0
+
+typedef enum central_reply {
+    CENTRAL_ACCEPT = 0,
+    CENTRAL_REJECT,
+    CENTRAL_SILENT
+} central_reply_t;
+
+static central_reply_t central = CENTRAL_ACCEPT;
+static bStatus_t sendStatus = SUCCESS;
+static uint16_t linkInterval = 0;
+static uint16_t linkLatency = 0;
+static uint16_t askedInterval;
+static uint16_t askedLatency;
+static int sent = 0;
+
+static Clock_Struct answerClock;
+static Clock_Struct gapRoleClock;
+
+static uint32_t event_ticks(uint16_t interval, uint16_t latency) {
+    return (uint32_t) interval * TICKS_PER_INTERVAL * (latency + 1);
+}
+
+bStatus_t GAPRole_SendUpdateParam(uint16_t minConnInterval, uint16_t maxConnInterval,
+                                  uint16_t latency, uint16_t connTimeout, uint8_t handleFailure) {
+    uint32_t wait = event_ticks(linkInterval, linkLatency);
+
+    if (sendStatus != SUCCESS) {
+        return sendStatus;
+    }
+    if ((linkInterval >= minConnInterval) && (linkInterval <= maxConnInterval) && (linkLatency == latency)) {
+        return bleInvalidRange;
+    }
+    // One request at a time
+    CHECK(!Clock_isActive(Clock_handle(&answerClock)));
+
+    sent++;
+    askedInterval = maxConnInterval;
+    askedLatency = latency;
+    switch (central) {
+        case CENTRAL_ACCEPT:
+            wait += INSTANT_EVENTS * event_ticks(linkInterval, 0);
+            break;
+        case CENTRAL_REJECT:
+            wait += event_ticks(linkInterval, 0);
+            break;
+        case CENTRAL_SILENT:
+            wait = GAPROLE_TIMEOUT_MS * TICKS_PER_MS;
+            break;
+    }
+    Clock_setTimeout(Clock_handle(&answerClock), wait);
+    Clock_start(Clock_handle(&answerClock));
+    return SUCCESS;
+}
+
+static void apply(uint16_t interval, uint16_t latency) {
+    linkInterval = interval;
+    linkLatency = latency;
+    conn_policy_param_updated(interval, latency);
+}
+
+static void answer(UArg arg) {
+    switch (central) {
+        case CENTRAL_ACCEPT:
+            apply(askedInterval, askedLatency);
+            break;
+        case CENTRAL_REJECT:
+            conn_policy_param_update_failed(true);
+            break;
+        case CENTRAL_SILENT:
+            conn_policy_param_update_failed(false);
+            break;
+    }
+}
+
+// The GAP Role's own request for the desired parameters, a few seconds into the link
+static void gap_role_update(UArg arg) {
+    apply(CONN_POLICY_IDLE_MAX_INTERVAL, CONN_POLICY_IDLE_SLAVE_LATENCY);
+}
+
+static void policy_clock(UArg arg) {
+    conn_policy_process();
+}
+
+static void connect() {
+    central = CENTRAL_ACCEPT;
+    sendStatus = SUCCESS;
+    linkInterval = CENTRAL_INTERVAL;
+    linkLatency = CENTRAL_LATENCY;
+    conn_policy_connected(linkInterval, linkLatency);
+    Clock_start(Clock_handle(&gapRoleClock));
+}
+
+static void disconnect() {
+    Clock_stop(Clock_handle(&answerClock));
+    Clock_stop(Clock_handle(&gapRoleClock));
+    conn_policy_disconnected();
+    linkInterval = 0;
+    linkLatency = 0;
+}
+
+// Connected and settled on the idle parameters, with fresh stats
+static void connect_idle() {
+    connect();
+    host_advance(GAPROLE_PAUSE_MS * TICKS_PER_MS);
+    CHECK_EQ(linkInterval, CONN_POLICY_IDLE_MAX_INTERVAL);
+    conn_policy_reset_stats();
+    sent = 0;
+}
+
+static conn_policy_stats_t stats() {
+    conn_policy_stats_t s;
+
+    conn_policy_get_stats(&s);
+    return s;
+}
+
+// From a request to the central's new parameters on a link on the given ones
+static uint32_t switch_ticks(uint16_t interval, uint16_t latency) {
+    return event_ticks(interval, latency) + INSTANT_EVENTS * event_ticks(interval, 0);
+}
+
+static void test_switch() {
+    conn_policy_stats_t s;
+    uint32_t idleToFast = switch_ticks(CONN_POLICY_IDLE_MAX_INTERVAL, CONN_POLICY_IDLE_SLAVE_LATENCY);
+    uint32_t fastToIdle = switch_ticks(CONN_POLICY_FAST_MAX_INTERVAL, CONN_POLICY_FAST_SLAVE_LATENCY);
+    uint32_t start;
+
+    connect();
+    // Nothing is asked for before the GAP Role's own update
+    host_advance(GAPROLE_PAUSE_MS * TICKS_PER_MS - 1);
+    CHECK_EQ(sent, 0);
+    CHECK_EQ(stats().mode, CONN_POLICY_MODE_IDLE);
+    host_advance(1);
+    conn_policy_reset_stats();
+
+    start = host_ticks();
+    conn_policy_activity(CONN_POLICY_SIGN);
+    CHECK_EQ(sent, 1);
+    s = stats();
+    CHECK_EQ(s.wanted, CONN_POLICY_MODE_FAST);
+    CHECK(s.pending);
+    CHECK_EQ(s.wake_latency_us, CONN_POLICY_IDLE_MAX_INTERVAL * 1250 * (CONN_POLICY_IDLE_SLAVE_LATENCY + 1));
+    host_advance(idleToFast);
+    s = stats();
+    CHECK_EQ(s.mode, CONN_POLICY_MODE_FAST);
+    CHECK_EQ(s.last_switch_ticks, idleToFast);
+    CHECK_EQ(s.wake_latency_us, CONN_POLICY_FAST_MAX_INTERVAL * 1250);
+
+    // Back to idle once nothing happened for the timeout
+    host_advance(start + IDLE_TIMEOUT_TICKS - host_ticks() - 1);
+    CHECK_EQ(sent, 1);
+    host_advance(1);
+    CHECK_EQ(sent, 2);
+    CHECK_EQ(stats().wanted, CONN_POLICY_MODE_IDLE);
+    host_advance(fastToIdle);
+    s = stats();
+    CHECK_EQ(s.mode, CONN_POLICY_MODE_IDLE);
+    CHECK_EQ(s.interval, CONN_POLICY_IDLE_MAX_INTERVAL);
+    CHECK_EQ(s.requests, 2);
+    CHECK_EQ(s.updates, 2);
+    CHECK_EQ(s.fast_ticks, IDLE_TIMEOUT_TICKS - idleToFast + fastToIdle);
+    CHECK_EQ(s.fast_ticks + s.idle_ticks, host_ticks() - start);
+    // The events listened to follow from the time on each set of parameters
+    CHECK_EQ(s.conn_events, s.fast_ticks / event_ticks(CONN_POLICY_FAST_MAX_INTERVAL, 0) +
+                            s.idle_ticks / event_ticks(CONN_POLICY_IDLE_MAX_INTERVAL,
+                                                       CONN_POLICY_IDLE_SLAVE_LATENCY));
+    disconnect();
+}
+
+static void test_back_to_back() {
+    int i;
+
+    connect_idle();
+    // A challenge a second keeps the link fast with the one request
+    for (i = 0; i < 10; i++) {
+        conn_policy_activity(CONN_POLICY_BATCH);
+        host_advance(1000 * TICKS_PER_MS);
+    }
+    CHECK_EQ(sent, 1);
+    CHECK_EQ(stats().mode, CONN_POLICY_MODE_FAST);
+    host_advance(IDLE_TIMEOUT_TICKS);
+    CHECK_EQ(sent, 2);
+    CHECK_EQ(stats().activities[CONN_POLICY_BATCH], 10);
+    disconnect();
+}
+
+static void test_rejected() {
+    conn_policy_stats_t s;
+    uint32_t start;
+
+    connect_idle();
+    central = CENTRAL_REJECT;
+    start = host_ticks();
+    conn_policy_activity(CONN_POLICY_SIGN);
+    // Another challenge keeps the link wanted fast through the retries
+    while (host_ticks() - start < (CONN_POLICY_MAX_RETRIES + 1) * CONN_POLICY_RETRY_MS * TICKS_PER_MS) {
+        host_advance(1000 * TICKS_PER_MS);
+        conn_policy_activity(CONN_POLICY_SIGN);
+    }
+    s = stats();
+    CHECK_EQ(s.requests, CONN_POLICY_MAX_RETRIES + 1);
+    CHECK_EQ(s.rejections, CONN_POLICY_MAX_RETRIES + 1);
+    CHECK_EQ(s.mode, CONN_POLICY_MODE_IDLE);
+    CHECK(!s.pending);
+
+    // Once the link goes idle, the idle parameters are already there
+    host_advance(IDLE_TIMEOUT_TICKS);
+    s = stats();
+    CHECK_EQ(s.wanted, CONN_POLICY_MODE_IDLE);
+    CHECK_EQ(s.requests, CONN_POLICY_MAX_RETRIES + 1);
+
+    // A new transaction starts over with its own retries
+    central = CENTRAL_ACCEPT;
+    conn_policy_activity(CONN_POLICY_SIGN);
+    host_advance(switch_ticks(CONN_POLICY_IDLE_MAX_INTERVAL, CONN_POLICY_IDLE_SLAVE_LATENCY));
+    CHECK_EQ(stats().mode, CONN_POLICY_MODE_FAST);
+
+    // The stack refusing to send is retried the same way
+    sendStatus = bleNoResources;
+    host_advance(IDLE_TIMEOUT_TICKS);
+    CHECK_EQ(stats().send_errors, 1);
+    sendStatus = SUCCESS;
+    host_advance(CONN_POLICY_RETRY_MS * TICKS_PER_MS +
+                 switch_ticks(CONN_POLICY_FAST_MAX_INTERVAL, CONN_POLICY_FAST_SLAVE_LATENCY));
+    CHECK_EQ(stats().mode, CONN_POLICY_MODE_IDLE);
+    CHECK_EQ(linkInterval, CONN_POLICY_IDLE_MAX_INTERVAL);
+    disconnect();
+}
+
+static void test_silent() {
+    conn_policy_stats_t s;
+
+    connect_idle();
+    central = CENTRAL_SILENT;
+    conn_policy_activity(CONN_POLICY_SIGN);
+    // The idle timeout passes while the request is out, nothing else is sent
+    host_advance(GAPROLE_TIMEOUT_MS * TICKS_PER_MS - 1);
+    s = stats();
+    CHECK_EQ(s.wanted, CONN_POLICY_MODE_IDLE);
+    CHECK(s.pending);
+    CHECK_EQ(sent, 1);
+    host_advance(1);
+    s = stats();
+    CHECK_EQ(s.timeouts, 1);
+    CHECK(!s.pending);
+    // The link never left the idle parameters the policy now wants
+    CHECK_EQ(sent, 1);
+    host_advance(10 * CONN_POLICY_RETRY_MS * TICKS_PER_MS);
+    CHECK_EQ(sent, 1);
+    disconnect();
+}
+
+static void test_activity_while_pending() {
+    conn_policy_stats_t s;
+
+    connect_idle();
+    conn_policy_activity(CONN_POLICY_SIGN);
+    host_advance(IDLE_TIMEOUT_TICKS);
+    CHECK_EQ(sent, 2);
+    CHECK(stats().pending);
+
+    // The idle parameters are on the way, the next challenge asks for fast right after
+    conn_policy_activity(CONN_POLICY_SIGN);
+    CHECK_EQ(sent, 2);
+    host_advance(switch_ticks(CONN_POLICY_FAST_MAX_INTERVAL, CONN_POLICY_FAST_SLAVE_LATENCY));
+    CHECK_EQ(sent, 3);
+    host_advance(switch_ticks(CONN_POLICY_IDLE_MAX_INTERVAL, CONN_POLICY_IDLE_SLAVE_LATENCY));
+    s = stats();
+    CHECK_EQ(s.mode, CONN_POLICY_MODE_FAST);
+    CHECK_EQ(s.max_switch_ticks, switch_ticks(CONN_POLICY_FAST_MAX_INTERVAL, CONN_POLICY_FAST_SLAVE_LATENCY) +
+                                 switch_ticks(CONN_POLICY_IDLE_MAX_INTERVAL, CONN_POLICY_IDLE_SLAVE_LATENCY));
+    disconnect();
+
+    // Nothing runs once the link is gone
+    host_advance(CONN_POLICY_RETRY_MS * TICKS_PER_MS);
+    CHECK_EQ(sent, 3);
+}
+
+/*
+ * An hour of challenges `periodMs` apart on average, `burst` of them 200 ms apart each
+ * time, on the idle link the GAP Role settled on
+ */
+static void simulate(const char *name, uint32_t periodMs, int burst) {
+    const uint32_t duration = 3600u * 1000 * TICKS_PER_MS;
+    conn_policy_stats_t s;
+    unsigned int seed = periodMs;
+    uint32_t start;
+    uint32_t gap;
+    uint32_t wakeUs;
+    uint32_t maxWakeUs = 0;
+    uint64_t switchTicks = 0;
+    uint32_t maxSwitchTicks = 0;
+    int transactions = 0;
+    int switches = 0;
+    int i;
+    double eventsPerSecond;
+    double oldEventsPerSecond = 1000000.0 / (CONN_POLICY_FAST_MIN_INTERVAL * 1250);
+
+    connect_idle();
+    start = host_ticks();
+    while (host_ticks() - start < duration) {
+        // Anywhere from half to one and a half periods after the last
+        gap = (periodMs / 2 + (uint32_t) rand_r(&seed) % (periodMs + 1)) * TICKS_PER_MS;
+        host_advance(gap);
+
+        s = stats();
+        // The write lands anywhere within the events the device sleeps through
+        wakeUs = s.wake_latency_us;
+        if (wakeUs > maxWakeUs) {
+            maxWakeUs = wakeUs;
+        }
+        for (i = 0; i < burst; i++) {
+            conn_policy_activity((burst > 1) ? CONN_POLICY_BATCH : CONN_POLICY_SIGN);
+            host_advance(200 * TICKS_PER_MS);
+        }
+        transactions++;
+        if (s.mode != CONN_POLICY_MODE_FAST) {
+            // The next challenge is drawn once the link is fast
+            while (stats().mode != CONN_POLICY_MODE_FAST) {
+                host_advance(TICKS_PER_MS);
+            }
+            s = stats();
+            switches++;
+            switchTicks += s.last_switch_ticks;
+            if (s.last_switch_ticks > maxSwitchTicks) {
+                maxSwitchTicks = s.last_switch_ticks;
+            }
+        }
+    }
+    s = stats();
+    disconnect();
+
+    eventsPerSecond = s.conn_events / ((double) (s.fast_ticks + s.idle_ticks) / (1000 * TICKS_PER_MS));
+    printf("simulation: %-14s %4.1f events/s (%4.1f%% of the 10 ms link), fast %4.1f%% of the time, "
+           "%4d requests for %5d transactions, write heard within %3u ms, fast link after %3.0f ms "
+           "(max %3u ms)\n", name, eventsPerSecond, 100.0 * eventsPerSecond / oldEventsPerSecond,
+           100.0 * s.fast_ticks / (s.fast_ticks + s.idle_ticks), (int) s.requests, transactions,
+           maxWakeUs / 1000, switches ? (double) switchTicks / switches / TICKS_PER_MS : 0.0,
+           maxSwitchTicks / TICKS_PER_MS);
+    CHECK_EQ(s.send_errors + s.rejections + s.timeouts, 0);
+    CHECK(s.fast_ticks + s.idle_ticks >= duration);
+}
+
+int main(int argc, char **argv) {
+    Clock_Params params;
+
+    Clock_Params_init(&params);
+    Clock_construct(&answerClock, answer, 0, &params);
+    Clock_construct(&gapRoleClock, gap_role_update, GAPROLE_PAUSE_MS * TICKS_PER_MS, &params);
+    conn_policy_init(policy_clock, 0);
+
+    test_switch();
+    test_back_to_back();
+    test_rejected();
+    test_silent();
+    test_activity_while_pending();
+
+    simulate("every 1 s", 1000, 1);
+    simulate("every 10 s", 10000, 1);
+    simulate("every minute", 60000, 1);
+    simulate("every 10 min", 600000, 1);
+    simulate("5 every minute", 60000, 5);
+    return host_report("conn_policy");
+}
@@ -0,0 +1,191 @@
+#include "host.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "crypto_arena.h"
+
+/*
+ * crypto_arena under random allocations and frees in random order, with sizes from a
+ * few bytes to the whole arena. Every block comes back zeroed and aligned and keeps
+ * what was written to it until it is freed, so no two blocks overlap. A request fails
+ * only when the largest free block is too small for it, the stats add up after every
+ * step, and once everything is freed the arena is one block again.
+ *
+ * With --bench, the cost of an allocation and its free with a dozen blocks in use, as
+ * during a signature.
+ */
+
+#define SLOTS           32
+#define STEPS           200000
+
+typedef struct slot {
+    uint8_t *ptr;
+    size_t len;
+    uint8_t fill;
+} slot_t;
+
+static slot_t slots[SLOTS];
+static unsigned int seed = 1;
+
+static crypto_arena_stats_t stats() {
+    crypto_arena_stats_t s;
+
+    crypto_arena_get_stats(&s);
+    return s;
+}
+
+static size_t random_len() {
+    switch (rand_r(&seed) % 8) {
+        case 0:
+            return 1 + rand_r(&seed) % CRYPTO_ARENA_SIZE;
+        case 1:
+        case 2:
+            return 1 + rand_r(&seed) % 1024;
+        default:
+            // Mostly the limbs and contexts of a signature
+            return 1 + rand_r(&seed) % 256;
+    }
+}
+
+static bool is_filled(const slot_t *slot) {
+    size_t i;
+
+    for (i = 0; i < slot->len; i++) {
+        if (slot->ptr[i] != slot->fill) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void release(slot_t *slot) {
+    CHECK(is_filled(slot));
+    crypto_arena_free(slot->ptr);
+    slot->ptr = NULL;
+}
+
+static void test_edges() {
+    crypto_arena_stats_t s = stats();
+    void *ptr;
+
+    CHECK(crypto_arena_calloc(0, 16) == NULL);
+    CHECK(crypto_arena_calloc(16, 0) == NULL);
+    CHECK(crypto_arena_calloc(CRYPTO_ARENA_SIZE, CRYPTO_ARENA_SIZE) == NULL);
+    CHECK(crypto_arena_calloc((size_t) -1 / 2 + 2, 2) == NULL);
+    CHECK(crypto_arena_calloc(1, CRYPTO_ARENA_SIZE + 1) == NULL);
+    crypto_arena_free(NULL);
+    CHECK_EQ(stats().used, s.used);
+
+    // The whole arena less one header fits in one block
+    ptr = crypto_arena_calloc(1, s.largest_free);
+    CHECK(ptr != NULL);
+    CHECK_EQ(stats().largest_free, 0);
+    CHECK(crypto_arena_calloc(1, 1) == NULL);
+    crypto_arena_free(ptr);
+    CHECK_EQ(stats().used, 0);
+    CHECK_EQ(stats().largest_free, s.largest_free);
+}
+
+static void test_fuzz() {
+    crypto_arena_stats_t before = stats();
+    crypto_arena_stats_t s;
+    uint32_t allocs = 0;
+    uint32_t failures = 0;
+    uint32_t live = 0;
+    uint32_t maxLive = 0;
+    slot_t *slot;
+    size_t len;
+    int step;
+    int i;
+
+    for (step = 0; step < STEPS; step++) {
+        slot = &slots[rand_r(&seed) % SLOTS];
+
+        if (slot->ptr) {
+            release(slot);
+            live--;
+        }
+        else {
+            len = random_len();
+            s = stats();
+            slot->ptr = crypto_arena_calloc(1, len);
+            if (slot->ptr) {
+                allocs++;
+                live++;
+                if (live > maxLive) {
+                    maxLive = live;
+                }
+                CHECK(((uintptr_t) slot->ptr % CRYPTO_ARENA_ALIGN) == 0);
+                slot->len = len;
+                slot->fill = (uint8_t) (0x5A ^ step);
+                slot->fill = slot->fill ? slot->fill : 1;
+                for (i = 0; i < (int) len; i++) {
+                    CHECK(slot->ptr[i] == 0);
+                    if (slot->ptr[i] != 0) {
+                        break;
+                    }
+                }
+                memset(slot->ptr, slot->fill, len);
+            }
+            else {
+                // First fit takes any block that is big enough
+                failures++;
+                CHECK(s.largest_free < len);
+            }
+        }
+
+        s = stats();
+        CHECK(s.used <= s.size);
+        CHECK(s.peak >= s.used);
+        CHECK(s.largest_free <= s.size - s.used);
+        CHECK_EQ(s.allocs - s.frees, live);
+    }
+
+    for (i = 0; i < SLOTS; i++) {
+        if (slots[i].ptr) {
+            release(&slots[i]);
+        }
+    }
+    s = stats();
+    CHECK_EQ(s.used, 0);
+    CHECK_EQ(s.largest_free, before.largest_free);
+    CHECK_EQ(s.allocs - before.allocs, allocs);
+    CHECK_EQ(s.failures - before.failures, failures);
+    printf("fuzz: %d steps, %u blocks handed out, %u requests too big for the largest hole, "
+           "up to %u blocks at once, peak %u of %u bytes, whole again\n", STEPS,
+           (unsigned int) allocs, (unsigned int) failures, (unsigned int) maxLive,
+           (unsigned int) s.peak, (unsigned int) s.size);
+}
+
+static void bench() {
+    const long rounds = 2000000;
+    void *held[12];
+    uint64_t start;
+    void *ptr;
+    long r;
+    int i;
+
+    for (i = 0; i < 12; i++) {
+        held[i] = crypto_arena_calloc(1, 128 + 16 * i);
+    }
+    start = host_ns();
+    for (r = 0; r < rounds; r++) {
+        ptr = crypto_arena_calloc(1, 64 + r % 256);
+        crypto_arena_free(ptr);
+    }
+    printf("bench: calloc and free %.1f ns with 12 blocks in use\n",
+           (double) (host_ns() - start) / rounds);
+    for (i = 0; i < 12; i++) {
+        crypto_arena_free(held[i]);
+    }
+}
+
+int main(int argc, char **argv) {
+    test_edges();
+    test_fuzz();
+    if (host_bench(argc, argv)) {
+        bench();
+    }
+    return host_report("crypto_arena");
+}
@@ -0,0 +1,260 @@
+#include "host.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <inc/hw_types.h>
+#include <inc/hw_memmap.h>
+#include <inc/hw_cpu_dwt.h>
+
+#include "latency.h"
+#include "signer.h"
+
+/*
+ * latency on the cycle counter model and the Clock: compute stages count the cycles
+ * the core ran, across a wrap of the counter too, blocking stages the ticks that went
+ * by. The summaries are the exact count, minimum, average and maximum, and the 99th
+ * percentile is the end of its power of two bucket, also once a bucket filled up and
+ * the histogram was halved. The Diagnostics value holds the summaries in order. The
+ * signer times its seeding, hash, private key operation and verify once per signature.
+ *
+ * The load test times a couple of hundred thousand stages of random length and holds
+ * the summaries against the exact figures. With --bench, the cost of timing a stage,
+ * and the stage histograms of signatures on the host's own clock.
+ */
+
+#define TICKS_PER_MS    (1000 / 10)
+#define LOAD_SAMPLES    200000
+
+static const char *const stageNames[LATENCY_STAGE_COUNT] = {
+    "dispatch", "confirm", "seed", "sha256", "rsa_private", "verify", "notify", "job"
+};
+
+static unsigned int seed = 1;
+static uint32_t samples[LOAD_SAMPLES];
+
+static latency_summary_t summary(latency_stage_t stage) {
+    latency_summary_t s;
+
+    latency_get_summary(stage, &s);
+    return s;
+}
+
+// A compute stage that took `us` of CPU time
+static void compute(latency_stage_t stage, uint32_t us) {
+    uint32_t start = latency_start(stage);
+
+    host_cpu_cycles(us * HOST_CPU_MHZ);
+    latency_stop(stage, start);
+}
+
+static void test_stages() {
+    latency_summary_t s;
+    uint32_t start;
+
+    latency_reset();
+    compute(LATENCY_SHA256, 250);
+    s = summary(LATENCY_SHA256);
+    CHECK_EQ(s.count, 1);
+    CHECK_EQ(s.min_us, 250);
+    CHECK_EQ(s.avg_us, 250);
+    CHECK_EQ(s.max_us, 250);
+    // The bucket ends past the maximum
+    CHECK_EQ(s.p99_us, 250);
+
+    // The Clock times a wait, the core does not run in it
+    start = latency_start(LATENCY_CONFIRM);
+    host_advance(1500 * TICKS_PER_MS);
+    latency_stop(LATENCY_CONFIRM, start);
+    CHECK_EQ(summary(LATENCY_CONFIRM).max_us, 1500000);
+
+    // Across a wrap of the counter
+    HWREG(CPU_DWT_BASE + CPU_DWT_O_CYCCNT) = 0xFFFFFF00;
+    compute(LATENCY_RSA_PRIVATE, 100);
+    CHECK_EQ(summary(LATENCY_RSA_PRIVATE).max_us, 100);
+
+    // A stage does not see the others
+    CHECK_EQ(summary(LATENCY_SHA256).count, 1);
+    CHECK_EQ(summary(LATENCY_VERIFY).count, 0);
+    latency_reset();
+    CHECK_EQ(summary(LATENCY_CONFIRM).count, 0);
+}
+
+static void test_percentile() {
+    latency_summary_t s;
+    int i;
+
+    // 99 in a hundred at 100 us, the percentile ends their bucket
+    latency_reset();
+    for (i = 0; i < 990; i++) {
+        compute(LATENCY_VERIFY, 100);
+    }
+    for (i = 0; i < 10; i++) {
+        compute(LATENCY_VERIFY, 5000);
+    }
+    s = summary(LATENCY_VERIFY);
+    CHECK_EQ(s.count, 1000);
+    CHECK_EQ(s.min_us, 100);
+    CHECK_EQ(s.avg_us, (990 * 100 + 10 * 5000) / 1000);
+    CHECK_EQ(s.max_us, 5000);
+    CHECK_EQ(s.p99_us, 128);
+
+    // One more slow one and it is in the slow bucket, which ends past the maximum
+    compute(LATENCY_VERIFY, 5000);
+    CHECK_EQ(summary(LATENCY_VERIFY).p99_us, 5000);
+
+    // A full bucket halves them all, the shape stays
+    latency_reset();
+    for (i = 0; i < 100000; i++) {
+        compute(LATENCY_NOTIFY, (i % 200 == 199) ? 3000 : 100);
+    }
+    s = summary(LATENCY_NOTIFY);
+    CHECK_EQ(s.count, 100000);
+    CHECK_EQ(s.p99_us, 128);
+    CHECK_EQ(s.max_us, 3000);
+}
+
+static uint32_t get_u32(const uint8_t *buf) {
+    return buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((uint32_t) buf[3] << 24);
+}
+
+static void test_serialize() {
+    uint8_t buf[LATENCY_DIAG_LEN];
+    latency_summary_t s;
+    const uint8_t *p;
+    int stage;
+
+    latency_reset();
+    for (stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+        if (stage != LATENCY_DISPATCH) {
+            compute((latency_stage_t) stage, 10 * (stage + 1));
+        }
+    }
+    CHECK_EQ(latency_serialize(buf), LATENCY_DIAG_LEN);
+    CHECK_EQ(buf[0], LATENCY_DIAG_VERSION);
+    CHECK_EQ(buf[1], LATENCY_STAGE_COUNT);
+    for (stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+        s = summary((latency_stage_t) stage);
+        p = buf + 2 + stage * sizeof(latency_summary_t);
+        CHECK_EQ(get_u32(p), s.count);
+        CHECK_EQ(get_u32(p + 4), s.min_us);
+        CHECK_EQ(get_u32(p + 8), s.avg_us);
+        CHECK_EQ(get_u32(p + 12), s.max_us);
+        CHECK_EQ(get_u32(p + 16), s.p99_us);
+    }
+    CHECK_EQ(get_u32(buf + 2), 0);
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *) a;
+    uint32_t y = *(const uint32_t *) b;
+
+    return (x > y) - (x < y);
+}
+
+static void test_load() {
+    latency_summary_t s;
+    uint64_t sum = 0;
+    uint32_t exactP99;
+    uint32_t r;
+    int i;
+
+    latency_reset();
+    for (i = 0; i < LOAD_SAMPLES; i++) {
+        // Mostly quick, a tail of slow ones and a few stalls
+        r = rand_r(&seed) % 1000;
+        if (r < 950) {
+            samples[i] = 50 + rand_r(&seed) % 150;
+        }
+        else if (r < 995) {
+            samples[i] = 1000 + rand_r(&seed) % 2000;
+        }
+        else {
+            samples[i] = 20000 + rand_r(&seed) % 30000;
+        }
+        sum += samples[i];
+        compute(LATENCY_RSA_PRIVATE, samples[i]);
+    }
+
+    qsort(samples, LOAD_SAMPLES, sizeof(uint32_t), compare_u32);
+    exactP99 = samples[(LOAD_SAMPLES * 99 + 99) / 100 - 1];
+    s = summary(LATENCY_RSA_PRIVATE);
+    CHECK_EQ(s.count, LOAD_SAMPLES);
+    CHECK_EQ(s.min_us, samples[0]);
+    CHECK_EQ(s.max_us, samples[LOAD_SAMPLES - 1]);
+    CHECK_EQ(s.avg_us, sum / LOAD_SAMPLES);
+    // The end of the bucket the exact percentile is in
+    CHECK(s.p99_us >= exactP99);
+    CHECK(s.p99_us < 2 * exactP99);
+    printf("load: %d stages, min %u avg %u max %u us, p99 %u us for an exact %u us\n",
+           LOAD_SAMPLES, s.min_us, s.avg_us, s.max_us, s.p99_us, exactP99);
+}
+
+static int sign() {
+    unsigned char signature[MBEDTLS_MPI_MAX_SIZE];
+    size_t len = sizeof(signature);
+
+    return RSA_sign((const unsigned char *) "challenge", 9, signature, &len);
+}
+
+static void test_signer() {
+    int i;
+
+    latency_reset();
+    initialize_TRNG();
+    RSA_init();
+    for (i = 0; i < 3; i++) {
+        CHECK_EQ(sign(), 0);
+    }
+    // Seeded once, the rest every time
+    CHECK_EQ(summary(LATENCY_SEED).count, 1);
+    CHECK_EQ(summary(LATENCY_SHA256).count, 3);
+    CHECK_EQ(summary(LATENCY_RSA_PRIVATE).count, 3);
+    CHECK_EQ(summary(LATENCY_VERIFY).count, 3);
+}
+
+static void bench() {
+    const long rounds = 2000000;
+    const int signatures = 50;
+    latency_summary_t s;
+    uint64_t start;
+    long r;
+    int stage;
+
+    latency_reset();
+    start = host_ns();
+    for (r = 0; r < rounds; r++) {
+        latency_stop(LATENCY_SHA256, latency_start(LATENCY_SHA256));
+    }
+    printf("bench: compute stage start and stop %.1f ns\n", (double) (host_ns() - start) / rounds);
+    start = host_ns();
+    for (r = 0; r < rounds; r++) {
+        latency_stop(LATENCY_JOB, latency_start(LATENCY_JOB));
+    }
+    printf("bench: blocking stage start and stop %.1f ns\n", (double) (host_ns() - start) / rounds);
+
+    // The host's clock through the cycle counter, what the stages of a signature take here
+    host_dwt_realtime = true;
+    latency_reset();
+    for (r = 0; r < signatures; r++) {
+        sign();
+    }
+    host_dwt_realtime = false;
+    for (stage = LATENCY_SHA256; stage <= LATENCY_VERIFY; stage++) {
+        s = summary((latency_stage_t) stage);
+        printf("bench: %d signatures, %s count %u min %u avg %u p99 %u max %u us\n", signatures,
+               stageNames[stage], s.count, s.min_us, s.avg_us, s.p99_us, s.max_us);
+    }
+}
+
+int main(int argc, char **argv) {
+    latency_init();
+    test_stages();
+    test_percentile();
+    test_serialize();
+    test_load();
+    test_signer();
+    if (host_bench(argc, argv)) {
+        bench();
+    }
+    return host_report("latency");
+}
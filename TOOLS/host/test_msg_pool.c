@@ -0,0 +1,183 @@
+#include "host.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <ti/sysbios/hal/Hwi.h>
+
+#include "icall.h"
+#include "msg_pool.h"
+
+/*
+ * msg_pool: blocks come from the pool first and the ICall heap after, go back to
+ * where they came from, and no block is handed out twice while threads standing in
+ * for callbacks take and return them at once. With --bench, the cost of a block from
+ * the pool against one from the heap.
+ */
+
+#define BLOCK_SIZE   14     // Not a multiple of the word size
+#define BLOCK_COUNT  6
+#define THREADS      4
+#define STRESS_OPS   200000
+
+MSG_POOL_STORAGE(storage, BLOCK_SIZE, BLOCK_COUNT);
+static msg_pool_t pool;
+
+static void test_pool_then_heap() {
+    void *blocks[BLOCK_COUNT + 2];
+    msg_pool_stats_t stats;
+    uint8_t i;
+
+    msg_pool_init(&pool, storage, BLOCK_SIZE, BLOCK_COUNT);
+    for (i = 0; i < BLOCK_COUNT; i++) {
+        blocks[i] = msg_pool_alloc(&pool);
+        CHECK((uint8_t *) blocks[i] >= (uint8_t *) storage);
+        CHECK((uint8_t *) blocks[i] < (uint8_t *) storage + sizeof(storage));
+        CHECK_EQ(((uintptr_t) blocks[i]) % sizeof(void *), 0);
+        memset(blocks[i], 0xA0 + i, BLOCK_SIZE);
+    }
+    CHECK_EQ(host_icall_in_use, 0);
+
+    // Dry, the heap takes over
+    blocks[BLOCK_COUNT] = msg_pool_alloc(&pool);
+    CHECK(blocks[BLOCK_COUNT] != NULL);
+    CHECK_EQ(host_icall_in_use, BLOCK_SIZE);
+
+    host_icall_fail = true;
+    blocks[BLOCK_COUNT + 1] = msg_pool_alloc(&pool);
+    host_icall_fail = false;
+    CHECK(blocks[BLOCK_COUNT + 1] == NULL);
+
+    msg_pool_get_stats(&pool, &stats);
+    CHECK_EQ(stats.allocs, BLOCK_COUNT);
+    CHECK_EQ(stats.heap_allocs, 1);
+    CHECK_EQ(stats.failures, 1);
+    CHECK_EQ(stats.in_use, BLOCK_COUNT);
+    CHECK_EQ(stats.max_in_use, BLOCK_COUNT);
+
+    // No block was written over by another
+    for (i = 0; i < BLOCK_COUNT; i++) {
+        CHECK_EQ(((uint8_t *) blocks[i])[BLOCK_SIZE - 1], 0xA0 + i);
+    }
+
+    for (i = 0; i <= BLOCK_COUNT + 1; i++) {
+        msg_pool_free(&pool, blocks[i]);
+    }
+    CHECK_EQ(host_icall_in_use, 0);
+    msg_pool_get_stats(&pool, &stats);
+    CHECK_EQ(stats.frees, BLOCK_COUNT);
+    CHECK_EQ(stats.in_use, 0);
+
+    // Stats restart from the blocks still out
+    blocks[0] = msg_pool_alloc(&pool);
+    msg_pool_reset_stats(&pool);
+    msg_pool_get_stats(&pool, &stats);
+    CHECK_EQ(stats.allocs, 0);
+    CHECK_EQ(stats.in_use, 1);
+    msg_pool_free(&pool, blocks[0]);
+    msg_pool_get_stats(&pool, &stats);
+    CHECK_EQ(stats.in_use, 0);
+}
+
+// Every block holds the id of the thread that has it, a second owner overwrites it
+static void *stress_thread(void *arg) {
+    uintptr_t id = (uintptr_t) arg;
+    uint8_t *held[3] = { NULL, NULL, NULL };
+    unsigned int seed = (unsigned int) id;
+    long failures = 0;
+    int op;
+    int slot;
+
+    for (op = 0; op < STRESS_OPS; op++) {
+        slot = rand_r(&seed) % 3;
+        if (held[slot]) {
+            if ((held[slot][0] != id) || (held[slot][BLOCK_SIZE - 1] != id)) {
+                failures++;
+            }
+            msg_pool_free(&pool, held[slot]);
+            held[slot] = NULL;
+        }
+        else {
+            held[slot] = msg_pool_alloc(&pool);
+            if (held[slot]) {
+                memset(held[slot], (int) id, BLOCK_SIZE);
+            }
+        }
+    }
+    for (slot = 0; slot < 3; slot++) {
+        msg_pool_free(&pool, held[slot]);
+    }
+    return (void *) failures;
+}
+
+static void test_stress() {
+    pthread_t threads[THREADS];
+    msg_pool_stats_t stats;
+    void *failures;
+    uintptr_t i;
+
+    msg_pool_init(&pool, storage, BLOCK_SIZE, BLOCK_COUNT);
+    for (i = 0; i < THREADS; i++) {
+        pthread_create(&threads[i], NULL, stress_thread, (void *) (i + 1));
+    }
+    for (i = 0; i < THREADS; i++) {
+        pthread_join(threads[i], &failures);
+        CHECK_EQ((long) failures, 0);
+    }
+
+    msg_pool_get_stats(&pool, &stats);
+    CHECK_EQ(stats.in_use, 0);
+    CHECK_EQ(stats.allocs, stats.frees);
+    CHECK(stats.max_in_use <= BLOCK_COUNT);
+    CHECK_EQ(host_icall_in_use, 0);
+    printf("stress: %d threads, %u pool and %u heap blocks\n", THREADS,
+           (unsigned int) stats.allocs, (unsigned int) stats.heap_allocs);
+}
+
+static void bench() {
+    const long rounds = 2000000;
+    uint64_t start;
+    double poolNs;
+    double heapNs;
+    double lockNs;
+    void *block;
+    UInt key;
+    long i;
+
+    msg_pool_init(&pool, storage, BLOCK_SIZE, BLOCK_COUNT);
+    start = host_ns();
+    for (i = 0; i < rounds; i++) {
+        block = msg_pool_alloc(&pool);
+        msg_pool_free(&pool, block);
+    }
+    poolNs = (double) (host_ns() - start) / rounds;
+
+    start = host_ns();
+    for (i = 0; i < rounds; i++) {
+        block = ICall_malloc(BLOCK_SIZE);
+        ICall_free(block);
+    }
+    heapNs = (double) (host_ns() - start) / rounds;
+
+    // The pool takes the interrupt lock twice a round, a mutex here and a few cycles on
+    // the device
+    start = host_ns();
+    for (i = 0; i < rounds; i++) {
+        key = Hwi_disable();
+        Hwi_restore(key);
+    }
+    lockNs = (double) (host_ns() - start) / rounds;
+
+    printf("bench: alloc+free pool %.1f ns (%.1f ns of it the lock), heap %.1f ns\n",
+           poolNs, 2 * lockNs, heapNs);
+}
+
+int main(int argc, char **argv) {
+    test_pool_then_heap();
+    test_stress();
+    if (host_bench(argc, argv)) {
+        bench();
+    }
+    return host_report("msg_pool");
+}
@@ -0,0 +1,180 @@
+#include "host.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <osal_snv.h>
+
+#include "mbedtls/entropy.h"
+#include "nv_seed.h"
+#include "signer.h"
+#include "trng_pool.h"
+
+/*
+ * nv_seed on the SNV stand-in, each boot of the application in a process of its own so
+ * only the SNV items outlive it: the first boot seeds from the TRNG alone and stores a
+ * seed, the next ones mix the stored seed in and replace it once per boot, a record that
+ * does not read back intact counts for nothing, and a failed SNV write fails the seeding
+ * until SNV works again. With --bench, boot to first signature with and without a
+ * stored seed, and how many boots one SNV page compaction takes.
+ */
+
+static void boot(void (*fn)()) {
+    pid_t pid;
+    int status;
+
+    fflush(stdout);
+    fflush(stderr);
+    pid = fork();
+    if (pid == 0) {
+        host_failures = 0;
+        fn();
+        exit(host_failures ? 1 : 0);
+    }
+    if ((pid < 0) || (waitpid(pid, &status, 0) != pid) || !WIFEXITED(status) ||
+        (WEXITSTATUS(status) != 0)) {
+        fprintf(stderr, "boot failed\n");
+        host_failures++;
+    }
+}
+
+static nv_seed_stats_t stats() {
+    nv_seed_stats_t s;
+
+    nv_seed_get_stats(&s);
+    return s;
+}
+
+static int sign() {
+    unsigned char signature[MBEDTLS_MPI_MAX_SIZE];
+    size_t len = sizeof(signature);
+
+    return RSA_sign((const unsigned char *) "challenge", 9, signature, &len);
+}
+
+static void start() {
+    initialize_TRNG();
+    RSA_init();
+}
+
+static unsigned char storedSeed[80];
+
+static bool read_item(unsigned char *item) {
+    return osal_snv_read(NV_SEED_SNV_ID, sizeof(storedSeed), item) == SUCCESS;
+}
+
+static void first_boot() {
+    CHECK(!nv_seed_stored());
+    start();
+    CHECK_EQ(is_RSA_read(), RSA_STATE_READY);
+    CHECK(stats().empty_reads > 0);
+    CHECK_EQ(stats().writes, 1);
+    CHECK_EQ(stats().sequence, 1);
+    CHECK_EQ(sign(), 0);
+    CHECK_EQ(host_snv_stats().writes, 1);
+}
+
+static void second_boot() {
+    unsigned char item[sizeof(storedSeed)];
+    mbedtls_entropy_context entropy;
+    unsigned char out[32];
+    uint32_t sequence;
+    long snvWrites = host_snv_stats().writes;
+
+    CHECK(nv_seed_stored());
+    sequence = stats().sequence;
+    CHECK(read_item(storedSeed));
+    start();
+    CHECK_EQ(stats().empty_reads, 0);
+    CHECK_EQ(stats().failures, 0);
+    CHECK_EQ(stats().writes, 1);
+    CHECK_EQ(stats().sequence, sequence + 1);
+    CHECK(read_item(item));
+    CHECK(memcmp(item, storedSeed, sizeof(item)) != 0);
+
+    // Another entropy context in the same boot leaves SNV alone
+    CHECK_EQ(sign(), 0);
+    mbedtls_entropy_init(&entropy);
+    CHECK_EQ(mbedtls_entropy_func(&entropy, out, sizeof(out)), 0);
+    mbedtls_entropy_free(&entropy);
+    CHECK_EQ(stats().skipped, 1);
+    CHECK_EQ(host_snv_stats().writes, snvWrites + 1);
+}
+
+static void corrupted_boot() {
+    CHECK(!nv_seed_stored());
+    start();
+    CHECK_EQ(stats().writes, 1);
+    CHECK_EQ(stats().sequence, 1);
+    CHECK(nv_seed_stored());
+}
+
+static void failing_boot() {
+    host_snv_fail = true;
+    start();
+    CHECK_EQ(stats().failures, 1);
+    CHECK(sign() != 0);
+
+    // The next signature seeds again
+    host_snv_fail = false;
+    CHECK_EQ(sign(), 0);
+    CHECK_EQ(stats().writes, 1);
+}
+
+static void test_boots() {
+    host_snv_erase();
+    boot(first_boot);
+    boot(second_boot);
+    CHECK_EQ(host_snv_stats().writes, 2);
+
+    host_snv_corrupt(NV_SEED_SNV_ID, 20);
+    boot(corrupted_boot);
+    boot(failing_boot);
+    boot(second_boot);
+}
+
+static void timed_boot() {
+    uint32_t start = host_ticks();
+    uint64_t startNs = host_ns();
+    bool stored = nv_seed_stored();
+    long numbers;
+
+    initialize_TRNG();
+    RSA_init();
+    numbers = host_trng_numbers;
+    CHECK_EQ(sign(), 0);
+    printf("bench: %s seed, first signature after %u ticks, %ld TRNG numbers waited for, "
+           "%.2f ms on the host\n", stored ? "stored" : "no", (unsigned int) (host_ticks() - start),
+           numbers, (double) (host_ns() - startNs) / 1000000);
+}
+
+static void count_boot() {
+    initialize_TRNG();
+    RSA_init();
+}
+
+static void bench() {
+    const int boots = 200;
+    int i;
+
+    host_snv_erase();
+    boot(timed_boot);
+    boot(timed_boot);
+
+    host_snv_erase();
+    for (i = 0; i < boots; i++) {
+        boot(count_boot);
+    }
+    printf("bench: %d boots, %ld SNV writes, %ld page compactions, %ld bytes programmed\n",
+           boots, host_snv_stats().writes, host_snv_stats().erases,
+           host_snv_stats().programmed);
+}
+
+int main(int argc, char **argv) {
+    test_boots();
+    if (host_bench(argc, argv)) {
+        bench();
+    }
+    return host_report("nv_seed");
+}
@@ -0,0 +1,243 @@
+#include "host.h"
+
+#include <string.h>
+
+// The tables are static, the test takes them from the source
+#include "oid.c"
+
+/*
+ * oid: the lookups give what the linear walks of upstream mbed TLS give, for every row
+ * of every table, for each row with a byte flipped, cut short or made longer, and for
+ * every md and pk value in the reverse direction. test_oid_full does the same with all
+ * digests, ECDSA, the EC groups and X.509 enabled, so every row of the reverse indexes
+ * is covered, not only the ones the shipped config builds. With --bench, the time of a
+ * lookup both ways.
+ */
+
+#ifndef HOST_OID_NAME
+#define HOST_OID_NAME "oid"
+#endif
+
+// Upstream FN_OID_TYPED_FROM_ASN1
+#define REF_FROM_ASN1( TYPE_T, NAME, LIST )                                 \
+static const TYPE_T *ref_ ## NAME( const mbedtls_asn1_buf *oid )            \
+{                                                                           \
+    const TYPE_T *p = LIST;                                                 \
+    const mbedtls_oid_descriptor_t *cur = (const mbedtls_oid_descriptor_t *) p; \
+    if( p == NULL || oid == NULL ) return( NULL );                          \
+    while( cur->asn1 != NULL ) {                                            \
+        if( cur->asn1_len == oid->len &&                                    \
+            memcmp( cur->asn1, oid->p, oid->len ) == 0 ) {                  \
+            return( p );                                                    \
+        }                                                                   \
+        p++;                                                                \
+        cur = (const mbedtls_oid_descriptor_t *) p;                         \
+    }                                                                       \
+    return( NULL );                                                         \
+}
+
+// Looks every row up as it is, with each byte flipped, one byte short and one longer
+#define CHECK_FROM_ASN1( TYPE_T, NAME, LIST )                               \
+REF_FROM_ASN1( TYPE_T, NAME, LIST )                                         \
+static int check_ ## NAME()                                                 \
+{                                                                           \
+    const TYPE_T *row;                                                      \
+    const mbedtls_oid_descriptor_t *desc;                                   \
+    unsigned char buf[64];                                                  \
+    mbedtls_asn1_buf oid;                                                   \
+    size_t i;                                                               \
+    int rows = 0;                                                           \
+    oid.p = buf;                                                            \
+    for( row = LIST; ( desc = (const mbedtls_oid_descriptor_t *) row )->asn1; row++ ) { \
+        memcpy( buf, desc->asn1, desc->asn1_len );                          \
+        oid.len = desc->asn1_len;                                           \
+        CHECK( oid_ ## NAME ## _from_asn1( &oid ) == ref_ ## NAME( &oid ) ); \
+        CHECK( ref_ ## NAME( &oid ) != NULL );                              \
+        for( i = 0; i < oid.len; i++ ) {                                    \
+            buf[i] ^= 0x01;                                                 \
+            CHECK( oid_ ## NAME ## _from_asn1( &oid ) == ref_ ## NAME( &oid ) ); \
+            buf[i] ^= 0x81;                                                 \
+            CHECK( oid_ ## NAME ## _from_asn1( &oid ) == ref_ ## NAME( &oid ) ); \
+            buf[i] ^= 0x80;                                                 \
+        }                                                                   \
+        oid.len--;                                                          \
+        CHECK( oid_ ## NAME ## _from_asn1( &oid ) == ref_ ## NAME( &oid ) ); \
+        buf[oid.len + 1] = 0x01;                                            \
+        oid.len += 2;                                                       \
+        CHECK( oid_ ## NAME ## _from_asn1( &oid ) == ref_ ## NAME( &oid ) ); \
+        rows++;                                                             \
+    }                                                                       \
+    oid.len = 0;                                                            \
+    CHECK( oid_ ## NAME ## _from_asn1( &oid ) == NULL );                    \
+    CHECK( oid_ ## NAME ## _from_asn1( NULL ) == NULL );                    \
+    return( rows );                                                         \
+}
+
+#if defined(MBEDTLS_X509_USE_C) || defined(MBEDTLS_X509_CREATE_C)
+CHECK_FROM_ASN1(oid_x520_attr_t, x520_attr, oid_x520_attr_type)
+CHECK_FROM_ASN1(oid_x509_ext_t, x509_ext, oid_x509_ext)
+CHECK_FROM_ASN1(mbedtls_oid_descriptor_t, ext_key_usage, oid_ext_key_usage)
+#endif
+CHECK_FROM_ASN1(oid_sig_alg_t, sig_alg, oid_sig_alg)
+CHECK_FROM_ASN1(oid_pk_alg_t, pk_alg, oid_pk_alg)
+#if defined(MBEDTLS_ECP_C)
+CHECK_FROM_ASN1(oid_ecp_grp_t, grp_id, oid_ecp_grp)
+#endif
+#if defined(MBEDTLS_CIPHER_C)
+CHECK_FROM_ASN1(oid_cipher_alg_t, cipher_alg, oid_cipher_alg)
+#endif
+CHECK_FROM_ASN1(oid_md_alg_t, md_alg, oid_md_alg)
+#if defined(MBEDTLS_PKCS12_C)
+CHECK_FROM_ASN1(oid_pkcs12_pbe_alg_t, pkcs12_pbe_alg, oid_pkcs12_pbe_alg)
+#endif
+
+// The upstream reverse lookups, walking the lists the indexes replace
+static FN_OID_GET_OID_BY_ATTR1(ref_oid_get_oid_by_md, oid_md_alg_t, oid_md_alg,
+                               mbedtls_md_type_t, md_alg)
+static FN_OID_GET_OID_BY_ATTR2(ref_oid_get_oid_by_sig_alg, oid_sig_alg_t, oid_sig_alg,
+                               mbedtls_pk_type_t, pk_alg, mbedtls_md_type_t, md_alg)
+
+#define MD_LAST     (MBEDTLS_MD_RIPEMD160 + 2)
+#define PK_LAST     (MBEDTLS_PK_RSASSA_PSS + 2)
+
+// pk -2 is the lookup by md alone
+
+static int check_reverse() {
+    const char *oid;
+    const char *refOid;
+    size_t len;
+    size_t refLen;
+    int ret;
+    int refRet;
+    int md;
+    int pk;
+    int found = 0;
+
+    for (md = -1; md <= MD_LAST; md++) {
+        for (pk = -2; pk <= PK_LAST; pk++) {
+            oid = refOid = NULL;
+            len = refLen = 0;
+            if (pk == -2) {
+                ret = mbedtls_oid_get_oid_by_md((mbedtls_md_type_t) md, &oid, &len);
+                refRet = ref_oid_get_oid_by_md((mbedtls_md_type_t) md, &refOid, &refLen);
+            }
+            else {
+                ret = mbedtls_oid_get_oid_by_sig_alg((mbedtls_pk_type_t) pk, (mbedtls_md_type_t) md,
+                                                     &oid, &len);
+                refRet = ref_oid_get_oid_by_sig_alg((mbedtls_pk_type_t) pk, (mbedtls_md_type_t) md,
+                                                    &refOid, &refLen);
+            }
+            CHECK_EQ(ret, refRet);
+            CHECK(oid == refOid);
+            CHECK_EQ(len, refLen);
+            found += (ret == 0);
+        }
+    }
+    return found;
+}
+
+static void test_equivalence() {
+    const oid_sig_alg_t *sig;
+    const oid_md_alg_t *md;
+    int rows = 0;
+    int reverse;
+    int expected = 0;
+
+#if defined(MBEDTLS_X509_USE_C) || defined(MBEDTLS_X509_CREATE_C)
+    rows += check_x520_attr();
+    rows += check_x509_ext();
+    rows += check_ext_key_usage();
+#endif
+    rows += check_sig_alg();
+    rows += check_pk_alg();
+#if defined(MBEDTLS_ECP_C)
+    rows += check_grp_id();
+#endif
+#if defined(MBEDTLS_CIPHER_C)
+    rows += check_cipher_alg();
+#endif
+    rows += check_md_alg();
+#if defined(MBEDTLS_PKCS12_C)
+    rows += check_pkcs12_pbe_alg();
+#endif
+
+    // Every (pk, md) and md a row has is found in reverse, a duplicate only once
+    for (md = oid_md_alg; md->descriptor.asn1; md++) {
+        expected++;
+    }
+    for (sig = oid_sig_alg; sig->descriptor.asn1; sig++) {
+        expected += (sig->descriptor.asn1_len != sizeof(MBEDTLS_OID_RSA_SHA_OBS) - 1) ||
+                    (memcmp(sig->descriptor.asn1, MBEDTLS_OID_RSA_SHA_OBS, sig->descriptor.asn1_len) != 0);
+    }
+    reverse = check_reverse();
+    CHECK_EQ(reverse, expected);
+    printf("%s: %d rows forward, %d reverse\n", HOST_OID_NAME, rows, reverse);
+}
+
+static volatile size_t sink;
+
+#define TIME_LOOKUPS(EXPR, ROUNDS, COUNT)                                   \
+    do {                                                                    \
+        uint64_t _start = host_ns();                                        \
+        long _r;                                                            \
+        for (_r = 0; _r < (ROUNDS); _r++) {                                 \
+            EXPR;                                                           \
+        }                                                                   \
+        elapsed = (double) (host_ns() - _start) / ((ROUNDS) * (COUNT));     \
+    } while (0)
+
+static void bench() {
+    const long rounds = 200000;
+    mbedtls_asn1_buf oids[16];
+    const oid_sig_alg_t *sig;
+    const char *oid;
+    size_t len;
+    int count = 0;
+    int i;
+    int md;
+    double elapsed;
+    double fast;
+
+    for (sig = oid_sig_alg; sig->descriptor.asn1 && (count < 16); sig++, count++) {
+        oids[count].p = (unsigned char *) sig->descriptor.asn1;
+        oids[count].len = sig->descriptor.asn1_len;
+    }
+
+    TIME_LOOKUPS(for (i = 0; i < count; i++) sink += (size_t) oid_sig_alg_from_asn1(&oids[i]),
+                 rounds, count);
+    fast = elapsed;
+    TIME_LOOKUPS(for (i = 0; i < count; i++) sink += (size_t) ref_sig_alg(&oids[i]), rounds, count);
+    printf("bench: %s sig_alg from OID, shortcut %.1f ns, walk %.1f ns (%d rows)\n", HOST_OID_NAME,
+           fast, elapsed, count);
+
+    TIME_LOOKUPS(for (md = 0; md <= MBEDTLS_MD_SHA512; md++)
+                     sink += mbedtls_oid_get_oid_by_md((mbedtls_md_type_t) md, &oid, &len),
+                 rounds, MBEDTLS_MD_SHA512 + 1);
+    fast = elapsed;
+    TIME_LOOKUPS(for (md = 0; md <= MBEDTLS_MD_SHA512; md++)
+                     sink += ref_oid_get_oid_by_md((mbedtls_md_type_t) md, &oid, &len),
+                 rounds, MBEDTLS_MD_SHA512 + 1);
+    printf("bench: %s OID by md, index %.1f ns, walk %.1f ns\n", HOST_OID_NAME,
+           fast, elapsed);
+
+    TIME_LOOKUPS(for (md = 0; md <= MBEDTLS_MD_SHA512; md++)
+                     sink += mbedtls_oid_get_oid_by_sig_alg(MBEDTLS_PK_RSA,
+                                                            (mbedtls_md_type_t) md, &oid, &len),
+                 rounds, MBEDTLS_MD_SHA512 + 1);
+    fast = elapsed;
+    TIME_LOOKUPS(for (md = 0; md <= MBEDTLS_MD_SHA512; md++)
+                     sink += ref_oid_get_oid_by_sig_alg(MBEDTLS_PK_RSA,
+                                                        (mbedtls_md_type_t) md, &oid, &len),
+                 rounds, MBEDTLS_MD_SHA512 + 1);
+    printf("bench: %s OID by RSA sig_alg, index %.1f ns, walk %.1f ns\n", HOST_OID_NAME,
+           fast, elapsed);
+}
+
+
+int main(int argc, char **argv) {
+    test_equivalence();
+    if (host_bench(argc, argv)) {
+        bench();
+    }
+    return host_report(HOST_OID_NAME);
+}
@@ -0,0 +1,4 @@
+// test_oid with every table row oid.c has, see sim/config_oid_full.h
+#define HOST_OID_NAME "oid_full"
+
+#include "test_oid.c"
@@ -0,0 +1,149 @@
+#include "host.h"
+
+#include <string.h>
+
+#include "self_test.h"
+#include "signer.h"
+
+/*
+ * self_test built with SIGNER_SELF_TEST, on the crypto, TRNG and Power stand-ins: the
+ * self test of every mbedTLS module passes, the CTR_DRBG one with the AES-128 vectors
+ * of this configuration, and every benchmark runs all its iterations. Nothing can be
+ * read before a run, afterwards the header and the records come out the same however
+ * the reads are split, and a read past the end copies nothing.
+ *
+ * With --bench, a run on the host's own clock through the cycle counter, one line per
+ * case with what an iteration took, in the order TOOLS/self_test_report.py prints them.
+ */
+
+#define SELF_TEST_CASE_NAME(name, label, bytes) label,
+static const char *const caseNames[SELF_TEST_CASE_COUNT] = {
+    SELF_TEST_CASES(SELF_TEST_CASE_NAME)
+};
+#undef SELF_TEST_CASE_NAME
+
+#define SELF_TEST_CASE_BYTES(name, label, bytes) bytes,
+static const uint16_t caseBytes[SELF_TEST_CASE_COUNT] = {
+    SELF_TEST_CASES(SELF_TEST_CASE_BYTES)
+};
+#undef SELF_TEST_CASE_BYTES
+
+#define TOTAL_LEN   (SELF_TEST_HEADER_LEN + SELF_TEST_CASE_COUNT * SELF_TEST_RECORD_LEN)
+
+typedef struct record {
+    int32_t status;
+    uint16_t iterations;
+    uint32_t cycles;
+    uint32_t us;
+} record_t;
+
+static uint8_t results[TOTAL_LEN];
+
+static uint16_t get_u16(const uint8_t *buf) {
+    return buf[0] | (buf[1] << 8);
+}
+
+static uint32_t get_u32(const uint8_t *buf) {
+    return get_u16(buf) | ((uint32_t) get_u16(buf + 2) << 16);
+}
+
+static record_t record(int id) {
+    const uint8_t *p = results + SELF_TEST_HEADER_LEN + id * SELF_TEST_RECORD_LEN;
+    record_t r;
+
+    r.status = (int32_t) get_u32(p + 1);
+    r.iterations = get_u16(p + 5);
+    r.cycles = get_u32(p + 7);
+    r.us = get_u32(p + 11);
+    return r;
+}
+
+static void read_all() {
+    CHECK_EQ(self_test_len(), TOTAL_LEN);
+    CHECK_EQ(self_test_read(0, results, sizeof(results)), TOTAL_LEN);
+}
+
+static void test_run() {
+    uint8_t buf[8];
+    record_t r;
+    int id;
+
+    CHECK_EQ(self_test_len(), 0);
+    CHECK_EQ(self_test_read(0, buf, sizeof(buf)), 0);
+
+    CHECK(self_test_run());
+    read_all();
+    CHECK_EQ(results[0], SELF_TEST_VERSION);
+    CHECK_EQ(results[1], SELF_TEST_CASE_COUNT);
+    CHECK_EQ(results[3], HOST_CPU_MHZ);
+
+    for (id = 0; id < SELF_TEST_CASE_COUNT; id++) {
+        r = record(id);
+        CHECK_EQ(results[SELF_TEST_HEADER_LEN + id * SELF_TEST_RECORD_LEN], id);
+        CHECK_EQ(r.status, 0);
+        if (r.status != 0) {
+            printf("%s failed with %d\n", caseNames[id], (int) r.status);
+        }
+        CHECK(r.iterations > 0);
+    }
+    // The self tests run once, the benchmarks as often as they were set up to
+    CHECK_EQ(record(SELF_TEST_CTR_DRBG).iterations, 1);
+    CHECK_EQ(record(BENCH_CTR_DRBG_32).iterations, 16);
+    CHECK_EQ(record(BENCH_RSA_VERIFY).iterations, 4);
+}
+
+static void test_read() {
+    uint8_t buf[TOTAL_LEN];
+    uint16_t offset;
+    uint16_t copied;
+    uint16_t chunk;
+
+    // Reads of every length from 1 to a record and a half, across the boundaries
+    for (chunk = 1; chunk <= SELF_TEST_RECORD_LEN * 3 / 2; chunk++) {
+        memset(buf, 0, sizeof(buf));
+        for (offset = 0; offset < TOTAL_LEN; offset += copied) {
+            copied = self_test_read(offset, buf + offset,
+                                    (offset + chunk <= TOTAL_LEN) ? chunk : TOTAL_LEN - offset);
+            CHECK(copied > 0);
+            if (copied == 0) {
+                break;
+            }
+        }
+        CHECK(memcmp(buf, results, TOTAL_LEN) == 0);
+    }
+
+    CHECK_EQ(self_test_read(TOTAL_LEN, buf, sizeof(buf)), 0);
+    CHECK_EQ(self_test_read(TOTAL_LEN - 2, buf, sizeof(buf)), 2);
+}
+
+static void bench() {
+    record_t r;
+    int id;
+
+    host_dwt_realtime = true;
+    self_test_run();
+    host_dwt_realtime = false;
+    read_all();
+
+    for (id = 0; id < SELF_TEST_CASE_COUNT; id++) {
+        r = record(id);
+        if (r.status != 0) {
+            printf("bench: %s %u bytes failed with %d\n", caseNames[id], caseBytes[id],
+                   (int) r.status);
+            continue;
+        }
+        printf("bench: %s %u bytes %u iterations, %.1f us each\n", caseNames[id], caseBytes[id],
+               r.iterations, (double) r.cycles / HOST_CPU_MHZ / r.iterations);
+    }
+}
+
+int main(int argc, char **argv) {
+    initialize_TRNG();
+    RSA_init();
+    test_run();
+    test_read();
+    if (host_bench(argc, argv)) {
+        bench();
+    }
+    return host_report("self_test");
+}
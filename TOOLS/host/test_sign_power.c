@@ -0,0 +1,214 @@
+#include "host.h"
+
+#include <string.h>
+#include <ti/drivers/power/PowerCC26XX.h>
+#include <inc/hw_types.h>
+#include <inc/hw_memmap.h>
+#include <inc/hw_cpu_dwt.h>
+#include <inc/hw_cpu_scs.h>
+
+#include "latency.h"
+#include "sign_power.h"
+#include "signer.h"
+#include "trng_pool.h"
+
+/*
+ * sign_power on the Power stand-in and the cycle counter model: a burst holds standby
+ * off and the crypto module powered once however deep it nests, and counts the CPU
+ * time the core ran in it and how long standby was held off. The cycle counter is
+ * enabled again when a debugger left it off, for bursts and latency stages alike.
+ *
+ * Around signatures, standby is only held off while they compute or the TRNG refills
+ * the pool, the crypto module is taken once per signature and the TRNG once per
+ * harvest, not per read, and every set has its release. The constraint timeline of a
+ * signature is printed. With --bench, the cost of a burst.
+ */
+
+#define SIGNATURES      20
+
+static sign_power_stats_t stats() {
+    sign_power_stats_t s;
+
+    sign_power_get_stats(&s);
+    return s;
+}
+
+static bool is_standby_held() {
+    return (Power_getConstraintMask() & (1u << PowerCC26XX_SB_DISALLOW)) != 0;
+}
+
+static bool is_harvesting() {
+    trng_pool_stats_t s;
+
+    trng_pool_get_stats(&s);
+    return s.running;
+}
+
+static void fill_up() {
+    int ticks = 0;
+
+    while (is_harvesting() && (ticks++ < 10000)) {
+        host_advance(1);
+    }
+    CHECK(!is_harvesting());
+}
+
+static int sign() {
+    unsigned char signature[MBEDTLS_MPI_MAX_SIZE];
+    size_t len = sizeof(signature);
+
+    return RSA_sign((const unsigned char *) "challenge", 9, signature, &len);
+}
+
+static long count_sets(bool isConstraint, uint8_t id) {
+    const host_power_event_t *events;
+    long count = host_power_timeline(&events);
+    long sets = 0;
+    long i;
+
+    CHECK(count <= HOST_POWER_EVENTS);
+    for (i = 0; (i < count) && (i < HOST_POWER_EVENTS); i++) {
+        if ((events[i].isConstraint == isConstraint) && (events[i].id == id) && events[i].isSet) {
+            sets++;
+        }
+    }
+    return sets;
+}
+
+static void test_burst() {
+    const host_power_event_t *events;
+    sign_power_stats_t s;
+
+    fill_up();
+    host_power_clear();
+    sign_power_reset_stats();
+
+    sign_power_begin();
+    CHECK(is_standby_held());
+    CHECK_EQ(Power_getDependencyCount(PowerCC26XX_PERIPH_CRYPTO), 1);
+    sign_power_begin();
+    host_cpu_cycles(2000 * HOST_CPU_MHZ);
+    host_advance(300);
+    sign_power_end();
+    // Only the outermost one lets go
+    CHECK(is_standby_held());
+    sign_power_end();
+    CHECK(!is_standby_held());
+    CHECK_EQ(Power_getDependencyCount(PowerCC26XX_PERIPH_CRYPTO), 0);
+
+    // One set and one release of each, the full pool needed no harvest
+    CHECK_EQ(host_power_timeline(&events), 4);
+    CHECK(events[0].isConstraint && events[0].isSet && (events[0].id == PowerCC26XX_SB_DISALLOW));
+    CHECK((!events[1].isConstraint) && events[1].isSet && (events[1].id == PowerCC26XX_PERIPH_CRYPTO));
+    CHECK((!events[2].isConstraint) && (!events[2].isSet));
+    CHECK(events[3].isConstraint && (!events[3].isSet) && (events[3].count == 0));
+
+    s = stats();
+    CHECK_EQ(s.bursts, 1);
+    CHECK_EQ(s.active_us_total, 2000);
+    CHECK_EQ(s.held_us_total, 3000);
+
+    // An end without a begin changes nothing
+    sign_power_end();
+    CHECK_EQ(stats().bursts, 1);
+}
+
+static void test_counter_reenabled() {
+    latency_summary_t summary;
+    uint32_t before;
+    uint32_t start;
+
+    // The model stops with TRCENA like the device
+    HWREG(CPU_SCS_BASE + CPU_SCS_O_DEMCR) &= ~CPU_SCS_DEMCR_TRCENA;
+    before = HWREG(CPU_DWT_BASE + CPU_DWT_O_CYCCNT);
+    host_cpu_cycles(1000);
+    CHECK_EQ(HWREG(CPU_DWT_BASE + CPU_DWT_O_CYCCNT), before);
+
+    // A debugger let go between bursts
+    sign_power_reset_stats();
+    sign_power_begin();
+    host_cpu_cycles(500 * HOST_CPU_MHZ);
+    sign_power_end();
+    CHECK_EQ(stats().active_us_total, 500);
+
+    // And between stages
+    HWREG(CPU_SCS_BASE + CPU_SCS_O_DEMCR) &= ~CPU_SCS_DEMCR_TRCENA;
+    HWREG(CPU_DWT_BASE + CPU_DWT_O_CTRL) &= ~CPU_DWT_CTRL_CYCCNTENA;
+    latency_reset();
+    start = latency_start(LATENCY_SHA256);
+    host_cpu_cycles(300 * HOST_CPU_MHZ);
+    latency_stop(LATENCY_SHA256, start);
+    latency_get_summary(LATENCY_SHA256, &summary);
+    CHECK_EQ(summary.max_us, 300);
+}
+
+static void test_signatures() {
+    unsigned char drain[TRNG_POOL_SIZE];
+    trng_pool_stats_t before;
+    trng_pool_stats_t after;
+    int i;
+
+    fill_up();
+    trng_pool_get_stats(&before);
+    host_power_clear();
+    sign_power_reset_stats();
+
+    for (i = 0; i < SIGNATURES; i++) {
+        if (i == 1) {
+            host_power_log = stdout;
+        }
+        // Every other one while the TRNG refills the pool
+        if (i % 2) {
+            trng_pool_read(drain, sizeof(drain), 0);
+        }
+        CHECK_EQ(sign(), 0);
+        host_power_log = NULL;
+
+        // Idle until the next challenge, standby only held off for the TRNG
+        CHECK_EQ(Power_getDependencyCount(PowerCC26XX_PERIPH_CRYPTO), 0);
+        CHECK(is_standby_held() == is_harvesting());
+        fill_up();
+        CHECK(!is_standby_held());
+        host_advance(1000);
+    }
+
+    trng_pool_get_stats(&after);
+    CHECK_EQ(stats().bursts, SIGNATURES);
+    // Batched: the crypto module once per signature, the TRNG once per harvest
+    CHECK_EQ(count_sets(false, PowerCC26XX_PERIPH_CRYPTO), SIGNATURES);
+    CHECK_EQ(count_sets(false, PowerCC26XX_PERIPH_TRNG), after.harvests - before.harvests);
+    CHECK_EQ(count_sets(true, PowerCC26XX_SB_DISALLOW),
+             SIGNATURES + (after.harvests - before.harvests));
+    CHECK_EQ(Power_getConstraintMask(), 0);
+    printf("signatures: %d, standby held off %u us in all, %u harvests, %ld power events\n",
+           SIGNATURES, (unsigned int) stats().held_us_total,
+           (unsigned int) (after.harvests - before.harvests), host_power_timeline(NULL));
+}
+
+static void bench() {
+    const long rounds = 1000000;
+    uint64_t start;
+    long r;
+
+    fill_up();
+    start = host_ns();
+    for (r = 0; r < rounds; r++) {
+        sign_power_begin();
+        sign_power_end();
+        host_power_clear();
+    }
+    printf("bench: burst begin and end %.1f ns\n", (double) (host_ns() - start) / rounds);
+}
+
+int main(int argc, char **argv) {
+    latency_init();
+    initialize_TRNG();
+    RSA_init();
+    test_burst();
+    test_counter_reenabled();
+    test_signatures();
+    if (host_bench(argc, argv)) {
+        bench();
+    }
+    return host_report("sign_power");
+}
@@ -0,0 +1,341 @@
+#include "host.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "bcomdef.h"
+#include "sign_session.h"
+
+/*
+ * sign_session with SIGN_SESSION_MAX clients at once: a client past the last session
+ * is turned away until one closes, the challenge is copied when it is written, a client
+ * has one job of one kind waiting and a sealed job keeps the nonce it started with.
+ *
+ * The load test runs the signer the way the application does, one job at a time that
+ * takes the user one to three seconds to confirm, against clients that write whenever
+ * they like and drop their links now and then. Every job signs the challenge its client
+ * wrote last before the job started, and no client waits longer than one job of every
+ * client. While every client always has a job waiting, they are served strictly in turn.
+ * With --bench, the cost of a submit, next and finish.
+ */
+
+#define TICKS_PER_MS    (1000 / 10)
+#define CLIENTS         SIGN_SESSION_MAX
+#define MIN_JOB_MS      1000
+#define MAX_JOB_MS      3000
+
+typedef struct client {
+    uint16_t connHandle;
+    bool isUp;
+    bool isWaiting;
+    uint32_t waitingSince;  // When the oldest challenge not yet started was written
+    uint32_t nextWrite;
+    uint32_t written;
+    uint32_t served;
+    uint8_t latest[USER_CHALLANGE_CHAR_LENGTH];
+} client_t;
+
+static client_t clients[CLIENTS];
+static uint16_t nextHandle = 0;
+static unsigned int seed = 1;
+
+// The signer, one job at a time
+static bool isRunning = false;
+static uint16_t runningHandle;
+static uint32_t doneAt;
+
+static uint32_t now_ms() {
+    return host_ticks() / TICKS_PER_MS;
+}
+
+static uint32_t random_ms(uint32_t min, uint32_t max) {
+    return min + (uint32_t) rand_r(&seed) % (max - min + 1);
+}
+
+static void make_challenge(uint8_t *challenge, uint16_t connHandle, uint32_t n) {
+    uint8_t i;
+
+    for (i = 0; i < USER_CHALLANGE_CHAR_LENGTH; i++) {
+        challenge[i] = (uint8_t) (connHandle * 31 + n * 7 + i);
+    }
+}
+
+static sign_session_stats_t stats() {
+    sign_session_stats_t s;
+
+    sign_session_get_stats(&s);
+    return s;
+}
+
+static void test_sessions_full() {
+    uint8_t challenge[USER_CHALLANGE_CHAR_LENGTH];
+    uint16_t handle;
+    uint8_t kind;
+    uint8_t i;
+
+    sign_session_reset_stats();
+    make_challenge(challenge, 0, 0);
+    for (i = 0; i < CLIENTS; i++) {
+        CHECK(sign_session_submit(i, challenge));
+    }
+    CHECK_EQ(stats().sessions, CLIENTS);
+    CHECK(!sign_session_submit(CLIENTS, challenge));
+    CHECK_EQ(stats().rejected, 1);
+    CHECK(!sign_session_submit(INVALID_CONNHANDLE, challenge));
+
+    // A closed session makes room, its job goes with it
+    sign_session_close(1);
+    CHECK_EQ(stats().abandoned, 1);
+    CHECK(sign_session_submit(CLIENTS, challenge));
+
+    while (sign_session_next(&handle, &kind, challenge)) {
+        sign_session_finish(handle, true);
+    }
+    for (i = 0; i <= CLIENTS; i++) {
+        sign_session_close(i);
+    }
+    CHECK_EQ(stats().sessions, 0);
+    CHECK_EQ(stats().completed, CLIENTS);
+}
+
+static void test_copy_and_kinds() {
+    uint8_t challenge[USER_CHALLANGE_CHAR_LENGTH];
+    uint8_t written[USER_CHALLANGE_CHAR_LENGTH];
+    uint8_t nonce[SEALED_NONCE_LENGTH];
+    uint8_t got[SEALED_NONCE_LENGTH];
+    uint16_t handle;
+    uint8_t kind;
+
+    sign_session_reset_stats();
+
+    // The session keeps its own copy, a later write to the profile's buffer changes nothing
+    make_challenge(written, 7, 1);
+    memcpy(challenge, written, sizeof(challenge));
+    CHECK(sign_session_submit(7, challenge));
+    memset(challenge, 0, sizeof(challenge));
+    CHECK(sign_session_next(&handle, &kind, challenge));
+    CHECK_EQ(handle, 7);
+    CHECK_EQ(kind, SIGN_JOB_CHALLENGE);
+    CHECK(memcmp(challenge, written, sizeof(challenge)) == 0);
+
+    // While it runs the client may queue one more, a bulk job waits behind it
+    CHECK(sign_session_submit_bulk(7));
+    CHECK(!sign_session_submit(7, written));
+    CHECK(!sign_session_next(&handle, &kind, challenge));
+    sign_session_finish(7, true);
+    CHECK(sign_session_next(&handle, &kind, challenge));
+    CHECK_EQ(kind, SIGN_JOB_BULK);
+    sign_session_finish(7, false);
+
+    // A sealed job keeps the nonce it started with while the next one queues
+    memset(nonce, 0xA5, sizeof(nonce));
+    CHECK(sign_session_submit_sealed(7, written, nonce));
+    CHECK(sign_session_next(&handle, &kind, challenge));
+    CHECK_EQ(kind, SIGN_JOB_SEALED);
+    memset(nonce, 0x5A, sizeof(nonce));
+    CHECK(sign_session_submit_sealed(7, written, nonce));
+    CHECK(sign_session_nonce(7, got));
+    CHECK_EQ(got[0], 0xA5);
+    sign_session_finish(7, true);
+    CHECK(sign_session_next(&handle, &kind, challenge));
+    CHECK(sign_session_nonce(7, got));
+    CHECK_EQ(got[0], 0x5A);
+
+    // Finishing after the link dropped counts the job once
+    sign_session_close(7);
+    sign_session_finish(7, true);
+    CHECK_EQ(stats().abandoned, 1);
+    CHECK_EQ(stats().completed, 2);
+    CHECK_EQ(stats().failed, 1);
+    CHECK_EQ(stats().sessions, 0);
+}
+
+static void connect(client_t *client) {
+    client->connHandle = nextHandle++;
+    client->isUp = true;
+    client->isWaiting = false;
+    client->nextWrite = now_ms() + random_ms(0, 1000);
+}
+
+static void client_write(client_t *client) {
+    make_challenge(client->latest, client->connHandle, client->written);
+    CHECK(sign_session_submit(client->connHandle, client->latest));
+    client->written++;
+    if (!client->isWaiting) {
+        client->isWaiting = true;
+        client->waitingSince = now_ms();
+    }
+}
+
+static client_t *find_client(uint16_t connHandle) {
+    uint8_t i;
+
+    for (i = 0; i < CLIENTS; i++) {
+        if (clients[i].isUp && (clients[i].connHandle == connHandle)) {
+            return &clients[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Runs the clients and the signer for `seconds`. Clients write `minGap` to `maxGap` ms
+ * apart and drop their link with the given chance per second. Served connection handles
+ * go to `order` if given.
+ */
+static uint32_t run_load(uint32_t seconds, uint32_t minGap, uint32_t maxGap, int dropPerMille,
+                         uint16_t *order, uint32_t orderLen, uint32_t *maxWaitMs) {
+    uint8_t challenge[USER_CHALLANGE_CHAR_LENGTH];
+    uint32_t end = now_ms() + seconds * 1000;
+    uint32_t jobs = 0;
+    uint32_t wait;
+    uint16_t handle;
+    uint8_t kind;
+    client_t *client;
+    uint8_t i;
+
+    while (now_ms() < end) {
+        host_advance(TICKS_PER_MS);
+
+        for (i = 0; i < CLIENTS; i++) {
+            client = &clients[i];
+            if (!client->isUp) {
+                connect(client);
+            }
+            if ((now_ms() % 1000 == 0) && ((rand_r(&seed) % 1000) < dropPerMille)) {
+                sign_session_close(client->connHandle);
+                client->isUp = false;
+                continue;
+            }
+            if (now_ms() >= client->nextWrite) {
+                client_write(client);
+                client->nextWrite = now_ms() + random_ms(minGap, maxGap);
+            }
+        }
+
+        if (isRunning && (now_ms() >= doneAt)) {
+            // One in ten is declined, the signer does not care whose link is still up
+            sign_session_finish(runningHandle, (rand_r(&seed) % 10) != 0);
+            isRunning = false;
+        }
+        if ((!isRunning) && sign_session_next(&handle, &kind, challenge)) {
+            client = find_client(handle);
+            CHECK(client != NULL);
+            CHECK_EQ(kind, SIGN_JOB_CHALLENGE);
+            if (client) {
+                // The newest challenge of the client, however many it wrote meanwhile
+                CHECK(memcmp(challenge, client->latest, sizeof(challenge)) == 0);
+                CHECK(client->isWaiting);
+                wait = now_ms() - client->waitingSince;
+                if (wait > *maxWaitMs) {
+                    *maxWaitMs = wait;
+                }
+                client->isWaiting = false;
+                client->served++;
+            }
+            if (order && (jobs < orderLen)) {
+                order[jobs] = handle;
+            }
+            jobs++;
+            isRunning = true;
+            runningHandle = handle;
+            doneAt = now_ms() + random_ms(MIN_JOB_MS, MAX_JOB_MS);
+        }
+    }
+    return jobs;
+}
+
+static void close_all() {
+    uint8_t i;
+
+    for (i = 0; i < CLIENTS; i++) {
+        if (clients[i].isUp) {
+            sign_session_close(clients[i].connHandle);
+            clients[i].isUp = false;
+        }
+    }
+    if (isRunning) {
+        sign_session_finish(runningHandle, true);
+        isRunning = false;
+    }
+}
+
+static void test_load() {
+    sign_session_stats_t s;
+    uint16_t order[400];
+    uint32_t maxWait = 0;
+    uint32_t jobs;
+    uint32_t written = 0;
+    uint32_t i;
+
+    // Everyone always has a job waiting: strictly in turn
+    sign_session_reset_stats();
+    jobs = run_load(600, 50, 200, 0, order, 400, &maxWait);
+    CHECK(jobs >= 200);
+    for (i = CLIENTS; i < jobs && i < 400; i++) {
+        if (order[i] != order[i - CLIENTS]) {
+            CHECK(!"clients not served in turn");
+            break;
+        }
+    }
+    CHECK(maxWait <= CLIENTS * MAX_JOB_MS + 1);
+    close_all();
+    printf("load: %d clients always waiting, %u jobs, longest wait %u ms (at most %u)\n",
+           CLIENTS, jobs, maxWait, CLIENTS * MAX_JOB_MS);
+
+    // An hour of clients that write when they like and drop their links
+    sign_session_reset_stats();
+    maxWait = 0;
+    for (i = 0; i < CLIENTS; i++) {
+        clients[i].written = 0;
+        clients[i].served = 0;
+    }
+    jobs = run_load(3600, 500, 15000, 20, NULL, 0, &maxWait);
+    for (i = 0; i < CLIENTS; i++) {
+        written += clients[i].written;
+    }
+    s = stats();
+    CHECK_EQ(s.submitted, written);
+    CHECK_EQ(s.started, jobs);
+    CHECK_EQ(s.rejected, 0);
+    CHECK(maxWait <= CLIENTS * MAX_JOB_MS + 1);
+    // Every challenge started, was replaced, went with its link or still waits
+    CHECK(s.submitted >= s.started + s.replaced);
+    CHECK(s.submitted <= s.started + s.replaced + s.abandoned + s.queued);
+    printf("load: %d clients for an hour, %u challenges, %u signed, %u declined, %u replaced, "
+           "%u dropped with their link, longest wait %u ms\n", CLIENTS, (unsigned int) s.submitted,
+           (unsigned int) s.completed, (unsigned int) s.failed, (unsigned int) s.replaced,
+           (unsigned int) s.abandoned, maxWait);
+    close_all();
+    CHECK_EQ(stats().sessions, 0);
+}
+
+static void bench() {
+    uint8_t challenge[USER_CHALLANGE_CHAR_LENGTH];
+    const long rounds = 1000000;
+    uint64_t start;
+    uint16_t handle;
+    uint8_t kind;
+    long r;
+
+    make_challenge(challenge, 0, 0);
+    start = host_ns();
+    for (r = 0; r < rounds; r++) {
+        sign_session_submit((uint16_t) (r % CLIENTS), challenge);
+        if (sign_session_next(&handle, &kind, challenge)) {
+            sign_session_finish(handle, true);
+        }
+    }
+    printf("bench: submit, next and finish %.1f ns with %d sessions\n",
+           (double) (host_ns() - start) / rounds, CLIENTS);
+}
+
+int main(int argc, char **argv) {
+    test_sessions_full();
+    test_copy_and_kinds();
+    test_load();
+    if (host_bench(argc, argv)) {
+        bench();
+    }
+    return host_report("sign_session");
+}
@@ -0,0 +1,234 @@
+#include "host.h"
+
+#include <string.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/drivers/power/PowerCC26XX.h>
+#include <inc/hw_types.h>
+#include <inc/hw_memmap.h>
+#include <inc/hw_trng.h>
+#include <driverlib/trng.h>
+
+#include "trng_pool.h"
+
+/*
+ * trng_pool on the TRNG stand-in: the interrupt fills the pool with both words of
+ * every number and powers the TRNG down once it is full, reads are served without
+ * waiting and start a harvest below the low water mark, an empty pool waits, a stalled
+ * harvest is armed again, a dead source times out, repeats are dropped and an FRO
+ * shutdown is repaired. Every Power_set*() has its release. With --bench, the cost of
+ * a read and how often the TRNG powers up to serve a stream of reads.
+ */
+
+// Bytes of the TRNG's number stream the pool handed out so far
+static long streamPos = 0;
+
+static void check_stream(const unsigned char *buf, size_t len) {
+    uint64_t number;
+    size_t i;
+
+    for (i = 0; i < len; i++, streamPos++) {
+        number = host_trng_number(streamPos / 8);
+        if (buf[i] != (unsigned char) (number >> (8 * (streamPos % 8)))) {
+            CHECK(!"byte differs from the TRNG's stream");
+            return;
+        }
+    }
+}
+
+static trng_pool_stats_t stats() {
+    trng_pool_stats_t s;
+
+    trng_pool_get_stats(&s);
+    return s;
+}
+
+static bool is_powered() {
+    bool sb = (Power_getConstraintMask() & (1u << PowerCC26XX_SB_DISALLOW)) != 0;
+    int dependency = Power_getDependencyCount(PowerCC26XX_PERIPH_TRNG);
+
+    // The constraint and the dependency go together
+    CHECK_EQ(dependency, sb ? 1 : 0);
+    return sb && host_trng_enabled();
+}
+
+static void fill_up() {
+    int ticks = 0;
+
+    while (stats().running && (ticks++ < 1000)) {
+        host_advance(1);
+    }
+    CHECK_EQ(stats().fill, TRNG_POOL_SIZE);
+    CHECK(!is_powered());
+}
+
+static size_t drain() {
+    unsigned char buf[TRNG_POOL_SIZE];
+
+    return trng_pool_read(buf, sizeof(buf), 0);
+}
+
+static void test_fill() {
+    trng_pool_init();
+    CHECK(is_powered());
+    CHECK(stats().running);
+
+    // One number a tick, eight bytes each
+    host_advance(TRNG_POOL_SIZE / 8 - 1);
+    CHECK(is_powered());
+    host_advance(1);
+    CHECK_EQ(stats().numbers, TRNG_POOL_SIZE / 8);
+    CHECK_EQ(stats().fill, TRNG_POOL_SIZE);
+    CHECK_EQ(stats().harvests, 1);
+    CHECK(!stats().running);
+    CHECK(!is_powered());
+
+    host_advance(100);
+    CHECK_EQ(host_trng_numbers, TRNG_POOL_SIZE / 8);
+}
+
+static void test_read() {
+    unsigned char buf[TRNG_POOL_SIZE];
+    uint32_t start = host_ticks();
+
+    // Served from the pool, no time passes and the TRNG stays off above the low water mark
+    CHECK_EQ(trng_pool_read(buf, 32, 100), 32);
+    check_stream(buf, 32);
+    CHECK_EQ(host_ticks(), start);
+    CHECK(!is_powered());
+
+    CHECK_EQ(trng_pool_read(buf, 40, 100), 40);
+    check_stream(buf, 40);
+    CHECK_EQ(host_ticks(), start);
+    CHECK_EQ(stats().fill, TRNG_POOL_SIZE - 72);
+    CHECK(is_powered());
+    CHECK_EQ(stats().harvests, 2);
+    CHECK_EQ(stats().underruns, 0);
+
+    fill_up();
+    CHECK_EQ(trng_pool_read(buf, TRNG_POOL_SIZE, 100), TRNG_POOL_SIZE);
+    check_stream(buf, TRNG_POOL_SIZE);
+    CHECK_EQ(stats().fill_min, 0);
+}
+
+static void test_underrun() {
+    unsigned char buf[8];
+    uint32_t start;
+
+    // The last read emptied the pool and started a harvest, no number is in yet
+    CHECK_EQ(stats().fill, 0);
+    CHECK(is_powered());
+    start = host_ticks();
+    CHECK_EQ(trng_pool_read(buf, sizeof(buf), 100), sizeof(buf));
+    check_stream(buf, sizeof(buf));
+    CHECK_EQ(host_ticks() - start, 1);
+    CHECK_EQ(stats().underruns, 1);
+    CHECK_EQ(stats().timeouts, 0);
+    fill_up();
+}
+
+static void test_stall() {
+    unsigned char buf[TRNG_POOL_SIZE];
+    uint32_t stallTicks = (TRNG_POOL_STALL_MS * 1000) / Clock_tickPeriod;
+    uint32_t start;
+
+    trng_pool_reset_stats();
+    CHECK_EQ(drain(), TRNG_POOL_SIZE);
+    CHECK(is_powered());
+
+    // The stack's TRNG driver turns it off in the middle of the harvest
+    TRNGIntDisable(TRNG_NUMBER_READY | TRNG_FRO_SHUTDOWN);
+    TRNGDisable();
+    start = host_ticks();
+    CHECK_EQ(trng_pool_read(buf, 8, stallTicks + 10), 8);
+    CHECK_EQ(host_ticks() - start, stallTicks + 10 + 1);
+    CHECK_EQ(stats().stalls, 1);
+    CHECK_EQ(stats().underruns, 1);
+    CHECK_EQ(stats().timeouts, 0);
+    CHECK(is_powered());
+    fill_up();
+}
+
+static void test_timeout() {
+    unsigned char buf[8];
+    uint32_t start;
+
+    trng_pool_reset_stats();
+    CHECK_EQ(drain(), TRNG_POOL_SIZE);
+    host_trng_dead = true;
+    start = host_ticks();
+
+    // Both attempts wait out the timeout, the harvest is too young to count as stalled
+    CHECK_EQ(trng_pool_read(buf, sizeof(buf), 100), 0);
+    CHECK_EQ(host_ticks() - start, 200);
+    CHECK_EQ(stats().timeouts, 1);
+    CHECK_EQ(stats().stalls, 0);
+    CHECK(is_powered());
+
+    host_trng_dead = false;
+    fill_up();
+}
+
+static void test_repeats() {
+    trng_pool_reset_stats();
+    CHECK_EQ(drain(), TRNG_POOL_SIZE);
+    host_trng_stuck = true;
+    host_advance(50);
+
+    // The first number is new, the rest repeat it and never reach the pool
+    CHECK_EQ(stats().numbers, 50);
+    CHECK_EQ(stats().repeats, 49);
+    CHECK_EQ(stats().fill, 8);
+    CHECK(is_powered());
+
+    host_trng_stuck = false;
+    fill_up();
+}
+
+static void test_fro_alarm() {
+    trng_pool_reset_stats();
+    CHECK_EQ(drain(), TRNG_POOL_SIZE);
+    host_trng_fro_alarm(0x05);
+
+    CHECK_EQ(stats().fro_alarms, 1);
+    CHECK_EQ(HWREG(TRNG_BASE + TRNG_O_ALARMSTOP), 0);
+    CHECK_EQ(HWREG(TRNG_BASE + TRNG_O_FRODETUNE), 0x05);
+    CHECK_EQ(HWREG(TRNG_BASE + TRNG_O_FROEN) & 0x05, 0x05);
+    CHECK_EQ(TRNGStatusGet() & TRNG_FRO_SHUTDOWN, 0);
+    CHECK(is_powered());
+    fill_up();
+}
+
+static void bench() {
+    const long reads = 100000;
+    unsigned char buf[32];
+    uint64_t elapsed = 0;
+    uint64_t start;
+    long i;
+
+    fill_up();
+    trng_pool_reset_stats();
+    for (i = 0; i < reads; i++) {
+        start = host_ns();
+        trng_pool_read(buf, sizeof(buf), 100);
+        elapsed += host_ns() - start;
+        // A seed every 10 ms
+        host_advance(1000);
+    }
+    printf("bench: read of %u bytes %.0f ns, %u power-ups of the TRNG for %ld reads, "
+           "%u underruns\n", (unsigned int) sizeof(buf), (double) elapsed / reads,
+           (unsigned int) stats().harvests, reads, (unsigned int) stats().underruns);
+}
+
+int main(int argc, char **argv) {
+    test_fill();
+    test_read();
+    test_underrun();
+    test_stall();
+    test_timeout();
+    test_repeats();
+    test_fro_alarm();
+    if (host_bench(argc, argv)) {
+        bench();
+    }
+    return host_report("trng_pool");
+}
@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+"""Turns the self test results read from the Diagnostics value into CSV lines.
+
+The case names come from Application/self_test.h, so the report always matches
+the firmware built from the same tree. The value is read from a file, raw bytes or
+the hex a BLE tool shows, or from stdin with "-":
+
+    echo "01 19 03 30 ..." | TOOLS/self_test_report.py -
+"""
+
+import argparse
+import os
+import re
+import string
+import struct
+import sys
+
+HEADER = struct.Struct('<BBBB')  # version, case count, configuration bits, CPU MHz
+RECORD = struct.Struct('<BiHII')  # id, status, iterations, cycles, microseconds
+VERSION = 1
+CASE = re.compile(r'X\(\s*(\w+)\s*,\s*"([^"]*)"\s*,\s*(\d+)\s*\)')
+CONFIG_BITS = ((0x01, 'aes_alt'), (0x02, 'rsa_no_crt'), (0x04, 'sha256_smaller'))
+
+DEFAULT_CASES = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                             '..', 'Application', 'self_test.h')
+
+
+def load_cases(path):
+    with open(path) as f:
+        return [(name, label, int(size)) for name, label, size in CASE.findall(f.read())]
+
+
+def load_value(data):
+    text = data.decode('ascii', 'replace').strip()
+    if text and all(c in string.hexdigits + string.whitespace + ':-' for c in text):
+        return bytes.fromhex(re.sub(r'[\s:-]', '', text))
+    return data
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('value', help='Diagnostics value, - for stdin')
+    parser.add_argument('--cases', default=DEFAULT_CASES, help='self_test.h to take the cases from')
+    options = parser.parse_args()
+
+    cases = load_cases(options.cases)
+    if options.value == '-':
+        data = sys.stdin.buffer.read()
+    else:
+        with open(options.value, 'rb') as f:
+            data = f.read()
+    data = load_value(data)
+
+    if len(data) < HEADER.size:
+        sys.exit('no results, was the firmware built with SIGNER_SELF_TEST?')
+    version, count, config, mhz = HEADER.unpack_from(data)
+    if version != VERSION:
+        sys.exit('results are version %d, this report reads version %d' % (version, VERSION))
+
+    flags = [name for bit, name in CONFIG_BITS if config & bit]
+    print('# cpu_mhz=%d config=%s' % (mhz, '+'.join(flags) or 'none'))
+    print('case,bytes,status,iterations,cycles,us,cycles_per_op,us_per_op,cycles_per_byte')
+    for i in range(count):
+        offset = HEADER.size + i * RECORD.size
+        if offset + RECORD.size > len(data):
+            print('# %d cases missing, read the whole value' % (count - i))
+            break
+        case_id, status, iterations, cycles, us = RECORD.unpack_from(data, offset)
+        if case_id < len(cases):
+            _, label, size = cases[case_id]
+        else:
+            label, size = 'case_%d' % case_id, 0
+
+        per_op = cycles / iterations if iterations else 0
+        us_per_op = us / iterations if iterations else 0
+        per_byte = '%.1f' % (per_op / size) if size and iterations else ''
+        print('%s,%d,%d,%d,%d,%d,%.0f,%.1f,%s' % (label, size, status, iterations, cycles, us,
+                                                   per_op, us_per_op, per_byte))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+"""Turns the binary trace records the device sends back into log lines.
+
+The formats come from Application/trace_events.h, so the decoder always matches
+the firmware built from the same tree. Records are read from a capture file, or
+from stdin with "-":
+
+    cat /dev/ttyACM0 | TOOLS/trace_decode.py -
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+SYNC_BYTE = 0xA5
+RECORD = struct.Struct('<IHHii')  # timestamp, id, seq, args[2]
+EVENT = re.compile(r'X\(\s*(\w+)\s*,\s*TRACE_LEVEL_(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)')
+CONVERSION = re.compile(r'%[-+ #0]*\d*([dux])')
+
+DEFAULT_EVENTS = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                              '..', 'Application', 'trace_events.h')
+
+
+def load_events(path):
+    with open(path) as f:
+        return [m.groups() for m in EVENT.finditer(f.read())]
+
+
+def render(fmt, args):
+    values = []
+    for conversion, arg in zip(CONVERSION.findall(fmt), args):
+        values.append(arg & 0xFFFFFFFF if conversion in 'ux' else arg)
+    return fmt % tuple(values)
+
+
+def records(data):
+    i = 0
+    while i + 1 + RECORD.size + 1 <= len(data):
+        # A sync byte inside a record fails the checksum, the bytes of the record
+        # and the checksum after it add up to zero
+        if data[i] != SYNC_BYTE or sum(data[i + 1:i + 2 + RECORD.size]) & 0xFF:
+            # Lost the framing, look for the next record
+            i += 1
+            continue
+        yield RECORD.unpack_from(data, i + 1)
+        i += 1 + RECORD.size + 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('capture', help='binary capture, - for stdin')
+    parser.add_argument('--events', default=DEFAULT_EVENTS, help='trace_events.h to take the formats from')
+    parser.add_argument('--tick-us', type=float, default=10.0, help='Clock_tickPeriod of the firmware')
+    options = parser.parse_args()
+
+    events = load_events(options.events)
+    if options.capture == '-':
+        data = sys.stdin.buffer.read()
+    else:
+        with open(options.capture, 'rb') as f:
+            data = f.read()
+
+    expected = None
+    for timestamp, event_id, seq, arg0, arg1 in records(data):
+        if expected is not None and seq != expected:
+            print('... %d records lost' % ((seq - expected) & 0xFFFF))
+        expected = (seq + 1) & 0xFFFF
+
+        ms = timestamp * options.tick_us / 1000.0
+        if event_id < len(events):
+            name, level, fmt = events[event_id]
+            text = render(fmt, (arg0, arg1))
+        else:
+            level, text = '?', 'unknown event %d (%d, %d)' % (event_id, arg0, arg1)
+        print('%10.2f ms %-5s %s' % (ms, level, text))
+
+
+if __name__ == '__main__':
+    main()